@@ -0,0 +1,71 @@
+// Aggregations run with 'parallelism' give the same results as those run on a single thread.
+
+var t = db.jstests_aggregation_parallelism;
+t.drop();
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 20000; i++) {
+    bulk.insert({_id: i, g: i % 7, n: i, tags: ["a" + (i % 3), "b"]});
+}
+assert.writeOK(bulk.execute());
+
+function run(pipeline, parallelism) {
+    var res = t.runCommand("aggregate", {pipeline: pipeline,
+                                         parallelism: parallelism,
+                                         cursor: {}});
+    assert.commandWorked(res);
+    return new DBCommandCursor(db.getMongo(), res).toArray();
+}
+
+function firstStage(pipeline, parallelism) {
+    var res = t.runCommand("aggregate", {pipeline: pipeline,
+                                         parallelism: parallelism,
+                                         explain: true});
+    assert.commandWorked(res);
+    return res.stages[0];
+}
+
+function sortById(docs) {
+    return docs.sort(function(a, b) { return bsonWoCompare({x: a._id}, {x: b._id}); });
+}
+
+var pipelines = [
+    [{$match: {g: {$ne: 3}}}, {$group: {_id: "$g", n: {$sum: 1}, total: {$sum: "$n"},
+                                        mx: {$max: "$n"}, avg: {$avg: "$n"}}}],
+    [{$unwind: "$tags"}, {$group: {_id: "$tags", n: {$sum: 1}}}],
+    [{$project: {g: 1, odd: {$mod: ["$n", 2]}}}, {$match: {odd: 1}}],
+    [{$group: {_id: {g: "$g"}, first: {$min: "$n"}}}, {$sort: {"_id.g": -1}}, {$limit: 3}],
+];
+
+pipelines.forEach(function(pipeline) {
+    var expected = sortById(run(pipeline, 1));
+    assert.eq(expected, sortById(run(pipeline, 4)), tojson(pipeline));
+    assert("$parallelCursor" in firstStage(pipeline, 4), tojson(pipeline));
+    assert.eq(4, firstStage(pipeline, 4).$parallelCursor.parallelism, tojson(pipeline));
+});
+
+// Pipelines which can't be split, or which read a sorted index, use a single thread.
+assert("$cursor" in firstStage([{$sort: {n: 1}}, {$group: {_id: "$g"}}], 4));
+assert("$cursor" in firstStage([{$limit: 10}, {$group: {_id: "$g"}}], 4));
+assert("$cursor" in firstStage([{$group: {_id: "$g"}}], 1));
+
+// The server parameter caps the number of threads.
+assert.commandWorked(db.adminCommand({setParameter: 1, aggregationMaxParallelism: 1}));
+try {
+    assert("$cursor" in firstStage([{$group: {_id: "$g"}}], 4));
+}
+finally {
+    assert.commandWorked(db.adminCommand({setParameter: 1, aggregationMaxParallelism: 16}));
+}
+
+// Errors on the worker threads fail the command.
+var res = t.runCommand("aggregate", {pipeline: [{$project: {x: {$divide: ["$n", 0]}}}],
+                                     parallelism: 2});
+assert.commandFailed(res);
+assert.eq(16608, res.code, tojson(res));
+
+[0, -1, 1.5, "2"].forEach(function(parallelism) {
+    var res = t.runCommand("aggregate", {pipeline: [], parallelism: parallelism});
+    assert.commandFailed(res);
+    assert.eq(28665, res.code, tojson(res));
+});
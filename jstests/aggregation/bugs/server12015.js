@@ -0,0 +1,82 @@
+// SERVER-12015: pipelines which only need indexed fields read them from the index instead of
+// fetching documents.
+load("jstests/libs/analyze_plan.js");
+
+var t = db.jstests_aggregation_server12015;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    assert.writeOK(t.insert({_id: i, a: i % 10, b: i, c: "x" + i, d: [i, i + 1]}));
+}
+assert.commandWorked(t.ensureIndex({a: 1, b: 1}));
+assert.commandWorked(t.ensureIndex({d: 1}));
+
+function cursorStage(pipeline) {
+    var explained = t.runCommand("aggregate", {pipeline: pipeline, explain: true});
+    assert.commandWorked(explained);
+    assert("$cursor" in explained.stages[0], tojson(explained));
+    return explained.stages[0].$cursor;
+}
+
+function assertCovered(pipeline) {
+    var winningPlan = cursorStage(pipeline).queryPlanner.winningPlan;
+    assert(isIndexOnly(winningPlan), tojson(winningPlan));
+}
+
+function assertNotCovered(pipeline) {
+    var winningPlan = cursorStage(pipeline).queryPlanner.winningPlan;
+    assert(!isIndexOnly(winningPlan), tojson(winningPlan));
+}
+
+// A $match and $group over indexed fields. The query has to guarantee every field is present,
+// since the index would return null for a missing one.
+var groupPipeline = [{$match: {a: {$gte: 5}, b: {$gte: 0}}},
+                     {$group: {_id: "$a", total: {$sum: "$b"}}},
+                     {$sort: {_id: 1}}];
+assertCovered(groupPipeline);
+var groups = t.aggregate(groupPipeline).toArray();
+assert.eq(5, groups.length);
+for (var g = 0; g < groups.length; g++) {
+    var a = g + 5;
+    assert.eq({_id: a, total: 10 * a + 450}, groups[g]);
+}
+
+// An index that provides the sort is still used for it.
+var sortPipeline = [{$match: {a: 3, b: {$gte: 0}}}, {$sort: {b: -1}}, {$project: {_id: 0, b: 1}}];
+assertCovered(sortPipeline);
+assert(!("$sort" in t.runCommand("aggregate", {pipeline: sortPipeline, explain: true}).stages[1]));
+assert.eq([{b: 93}, {b: 83}, {b: 73}], t.aggregate(sortPipeline.concat({$limit: 3})).toArray());
+
+// Pipelines which need other fields, whole documents or multikey fields fetch documents.
+assertNotCovered([{$match: {a: 1}}, {$project: {c: 1}}]);
+assertNotCovered([{$match: {a: 1}}]);
+assertNotCovered([{$match: {d: 5}}, {$project: {_id: 0, d: 1}}]);
+assert.eq([{d: [4, 5]}, {d: [5, 6]}],
+          t.aggregate([{$match: {d: 5}}, {$project: {_id: 0, d: 1}}, {$sort: {d: 1}}])
+              .toArray());
+assert.eq(10, t.aggregate([{$match: {a: 1}}, {$project: {c: 1}}]).itcount());
+
+// Fields the query doesn't constrain may be missing, and must stay missing rather than become
+// null, so those pipelines fetch documents.
+assert.writeOK(t.insert({_id: 100, a: 7}));
+var missingPipeline = [{$match: {a: {$gte: 5}}},
+                       {$group: {_id: "$a", bs: {$push: "$b"}, n: {$sum: 1}}},
+                       {$match: {_id: 7}}];
+assertNotCovered(missingPipeline);
+var missingGroup = t.aggregate(missingPipeline).toArray();
+assert.eq(1, missingGroup.length, tojson(missingGroup));
+assert.eq(11, missingGroup[0].n, tojson(missingGroup));
+assert.eq(10, missingGroup[0].bs.length, tojson(missingGroup));
+
+var projectPipeline = [{$match: {a: 7}}, {$project: {_id: 1, b: 1}}, {$match: {_id: 100}}];
+assertNotCovered(projectPipeline);
+assert.eq([{_id: 100}], t.aggregate(projectPipeline).toArray());
+assert.eq([{_id: 100, b: "none"}],
+          t.aggregate([{$match: {a: 7}},
+                       {$project: {b: {$ifNull: ["$b", "none"]}}},
+                       {$match: {_id: 100}}]).toArray());
+
+// Requiring the field again allows the covered plan.
+assertCovered([{$match: {a: 7, b: {$lt: 1000}}}, {$project: {_id: 0, b: 1}}]);
+assert.eq(10, t.aggregate([{$match: {a: 7, b: {$lt: 1000}}}, {$project: {_id: 0, b: 1}}])
+                  .itcount());
@@ -0,0 +1,51 @@
+// Counts over several index intervals, or with a filter on other fields in the index key, are
+// answered from the index without fetching documents.
+load("jstests/libs/analyze_plan.js");
+
+var collName = "jstests_count_multi_interval";
+var t = db[collName];
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    assert.writeOK(t.insert({a: i % 10, b: "x" + i, c: i}));
+}
+assert.writeOK(t.insert({a: [2, 3], b: "y", c: 100}));
+assert.commandWorked(t.ensureIndex({a: 1}));
+assert.commandWorked(t.ensureIndex({c: 1, b: 1}));
+
+function checkCount(query) {
+    var expected = t.find(query).hint({$natural: 1}).itcount();
+    assert.eq(expected, t.count(query), tojson(query));
+
+    var explain = db.runCommand({explain: {count: collName, query: query},
+                                 verbosity: "executionStats"});
+    assert.commandWorked(explain);
+    assert(planHasStage(explain.queryPlanner.winningPlan, "COUNT_SCAN"), tojson(explain));
+    assert.eq(0, explain.executionStats.totalDocsExamined, tojson(explain));
+    assert.eq(expected, explain.executionStats.executionStages.nCounted, tojson(explain));
+    return explain;
+}
+
+// Several intervals on a multikey index.  The document with a: [2, 3] is counted once.
+checkCount({a: {$in: [2, 3, 7]}});
+checkCount({a: {$in: [2, 3]}});
+checkCount({a: {$in: [0, 9]}});
+
+// Several intervals on a compound index.
+checkCount({c: {$in: [1, 50, 100]}, b: {$in: ["x1", "x50", "x51"]}});
+checkCount({c: {$gte: 10, $lte: 20}, b: {$gt: "x15"}});
+
+// A predicate which isn't used for the bounds, but can be answered from the index key.
+var explain = checkCount({c: {$in: [11, 21, 22, 31]}, b: /1$/});
+var countScan = explain.executionStats.executionStages.inputStage;
+assert.eq("COUNT_SCAN", countScan.stage, tojson(explain));
+assert.eq(1, countScan.keysFilteredOut, tojson(explain));
+assert("indexBounds" in countScan, tojson(explain));
+
+// A predicate which needs the document is still answered by fetching.
+explain = db.runCommand({explain: {count: collName, query: {a: {$in: [1, 2]}, c: {$lt: 50}}},
+                         verbosity: "executionStats"});
+assert.commandWorked(explain);
+assert(!planHasStage(explain.queryPlanner.winningPlan, "COUNT_SCAN"), tojson(explain));
+assert.eq(t.find({a: {$in: [1, 2]}, c: {$lt: 50}}).itcount(),
+          t.count({a: {$in: [1, 2]}, c: {$lt: 50}}));
@@ -0,0 +1,94 @@
+// $near searches around the same point, or near it, reuse the density estimate of the first one,
+// and explain reports how many index cells each search interval covered.
+
+var t = db.geo_near_density_cache;
+t.drop();
+
+for (var i = 0; i < 500; i++) {
+    var dx = (i % 25) * 0.001;
+    var dy = Math.floor(i / 25) * 0.001;
+    assert.writeOK(t.insert({_id: i, a: i % 2, loc: [10 + dx, 20 + dy],
+                             geo: {type: "Point", coordinates: [10 + dx, 20 + dy]}}));
+}
+assert.commandWorked(t.ensureIndex({loc: "2d"}));
+assert.commandWorked(t.ensureIndex({geo: "2dsphere", a: 1}));
+
+function nearStage(query) {
+    var explain = t.find(query).limit(20).explain("executionStats");
+    var stage = explain.executionStats.executionStages;
+    while (stage.stage !== "GEO_NEAR_2D" && stage.stage !== "GEO_NEAR_2DSPHERE") {
+        assert(stage.inputStage, tojson(explain));
+        stage = stage.inputStage;
+    }
+    return stage;
+}
+
+function checkNear(query, expectedIds) {
+    var first = nearStage(query);
+    assert(first.searchIntervals.length > 0, tojson(first));
+    first.searchIntervals.forEach(function(interval) {
+        assert.gt(interval.numCoveringCells, 0, tojson(first));
+    });
+
+    // The second search starts from the same cell, so it skips the estimate.
+    var second = nearStage(query);
+    assert.eq(true, second.cachedDensityEstimate, tojson(second));
+
+    // The results don't depend on where the estimate came from.
+    var ids = t.find(query).limit(20).toArray().map(function(doc) { return doc._id; });
+    assert.eq(expectedIds, ids, tojson(query));
+}
+
+var point = [10.0121, 20.0101];
+var expected2d = t.find({loc: {$near: point}}).limit(20).toArray()
+                  .map(function(doc) { return doc._id; });
+checkNear({loc: {$near: point}}, expected2d);
+
+var sphereQuery = {geo: {$nearSphere: {$geometry: {type: "Point", coordinates: point}}}};
+var expectedSphere = t.find(sphereQuery).limit(20).toArray()
+                      .map(function(doc) { return doc._id; });
+checkNear(sphereQuery, expectedSphere);
+
+// Bounds on the other fields of the index are part of the cached region.
+sphereQuery.a = 1;
+var withA = nearStage(sphereQuery);
+assert.eq(false, withA.cachedDensityEstimate, tojson(withA));
+
+// Changing the indexes clears the cache.
+assert.commandWorked(t.ensureIndex({a: 1}));
+var afterIndexBuild = nearStage({loc: {$near: point}});
+assert.eq(false, afterIndexBuild.cachedDensityEstimate, tojson(afterIndexBuild));
+
+// Building or dropping an index resets the cache.
+function resetDensityCache() {
+    assert.commandWorked(t.ensureIndex({c: 1}));
+    assert.commandWorked(t.dropIndex({c: 1}));
+}
+
+function nearIds(query) {
+    return t.find(query).limit(20).toArray().map(function(doc) { return doc._id; });
+}
+
+// Both points are away from the documents, so the estimator finds them in a cell which contains
+// both points. The cells the estimator starts from are far smaller and differ.
+var pointA = [10.06, 20.03];
+var pointB = [10.062, 20.0314];
+
+function checkNearbyPoint(makeQuery) {
+    resetDensityCache();
+    var expectedB = nearIds(makeQuery(pointB));
+
+    resetDensityCache();
+    var first = nearStage(makeQuery(pointA));
+    assert.eq(false, first.cachedDensityEstimate, tojson(first));
+    var nearby = nearStage(makeQuery(pointB));
+    assert.eq(true, nearby.cachedDensityEstimate, tojson(nearby));
+    assert.eq(expectedB, nearIds(makeQuery(pointB)));
+}
+
+checkNearbyPoint(function(point) {
+    return {loc: {$near: point}};
+});
+checkNearbyPoint(function(point) {
+    return {geo: {$nearSphere: {$geometry: {type: "Point", coordinates: point}}}};
+});
@@ -0,0 +1,62 @@
+// Tests {_id: {$in: [...]}} queries, which look the documents up with the ID_MULTI_GET stage.
+load("jstests/libs/analyze_plan.js");
+
+var t = db.jstests_id_multi_get;
+t.drop();
+
+// Insert in an order which differs from _id order.
+for (var i = 99; i >= 0; i--) {
+    assert.writeOK(t.insert({_id: i, x: i % 10}));
+}
+assert.writeOK(t.insert({_id: "str", x: -1}));
+assert.writeOK(t.insert({_id: {a: 1}, x: -2}));
+
+function ids(cursor) {
+    return cursor.toArray().map(function(doc) { return doc._id; });
+}
+
+var query = {_id: {$in: [42, 7, 1000, 7, "str", {a: 1}, 3]}};
+
+var explain = t.find(query).explain();
+assert(planHasStage(explain.queryPlanner.winningPlan, "ID_MULTI_GET"), tojson(explain));
+
+// Unsorted: every document once, in no particular order.
+var result = ids(t.find(query));
+assert.eq(5, result.length, tojson(result));
+assert.eq([3, 7, 42, "str", {a: 1}].sort(), result.sort());
+
+// Sorted by _id.
+assert.eq([3, 7, 42, "str", {a: 1}], ids(t.find(query).sort({_id: 1})));
+assert.eq([{a: 1}, "str", 42, 7, 3], ids(t.find(query).sort({_id: -1})));
+explain = t.find(query).sort({_id: 1}).explain();
+assert(!planHasStage(explain.queryPlanner.winningPlan, "SORT"), tojson(explain));
+
+// Limits, projections and counts.
+assert.eq([3, 7], ids(t.find(query).sort({_id: 1}).limit(-2)));
+assert.eq(5, t.find(query).itcount());
+assert.eq(5, t.find(query).count());
+assert.eq({_id: 42, x: 2}, t.findOne({_id: {$in: [42]}}));
+assert.eq({x: 2}, t.findOne({_id: {$in: [42]}}, {_id: 0, x: 1}));
+assert.eq(0, t.find({_id: {$in: []}}).itcount());
+
+// A query the _id index can cover is left to the planner.
+explain = t.find(query, {_id: 1}).explain();
+assert(!planHasStage(explain.queryPlanner.winningPlan, "ID_MULTI_GET"), tojson(explain));
+
+// So are $in values which aren't exact matches.
+explain = t.find({_id: {$in: [1, /^s/]}}).explain();
+assert(!planHasStage(explain.queryPlanner.winningPlan, "ID_MULTI_GET"), tojson(explain));
+assert.eq([1, "str"], ids(t.find({_id: {$in: [1, /^s/]}}).sort({_id: 1})));
+
+// Updates and removes.
+assert.writeOK(t.update({_id: {$in: [1, 2, 500]}}, {$set: {updated: true}}, {multi: true}));
+assert.eq(2, t.count({updated: true}));
+assert.writeOK(t.remove({_id: {$in: [1, 2, 3]}}));
+assert.eq(0, t.count({_id: {$in: [1, 2, 3]}}));
+
+// A large request.
+var many = [];
+for (var i = 0; i < 5000; i++) {
+    many.push(i % 200);
+}
+assert.eq(97, t.find({_id: {$in: many}}).itcount());
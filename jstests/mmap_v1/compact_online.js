@@ -0,0 +1,75 @@
+// compact with online: true moves documents into earlier free space a few at a time, keeps the
+// indexes consistent, and resumes from its saved progress.
+
+var t = db.compact_online;
+t.drop();
+
+var progress = db.getSiblingDB("local").compact.progress;
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 2000; i++) {
+    bulk.insert({_id: i, a: i, s: new Array(1 + (i % 7) * 20).join("x")});
+}
+assert.writeOK(bulk.execute());
+assert.commandWorked(t.ensureIndex({a: 1}, {unique: true}));
+
+// Leave holes at the start of the collection.
+assert.writeOK(t.remove({_id: {$lt: 1000, $mod: [2, 0]}}));
+var expected = t.find().sort({_id: 1}).toArray();
+
+function checkContents() {
+    assert.eq(expected, t.find().sort({_id: 1}).toArray());
+    assert.eq(expected, t.find().hint({a: 1}).sort({a: 1}).toArray());
+    assert.eq(expected.length, t.find().hint({$natural: 1}).itcount());
+    assert(t.validate(true).valid, tojson(t.validate(true)));
+}
+
+var lastBefore = t.find().sort({$natural: -1}).limit(1).next()._id;
+
+assert.commandWorked(db.adminCommand({setParameter: 1, compactOnlineBatchSize: 50}));
+var res = t.runCommand("compact", {online: true});
+assert.commandWorked(res);
+assert.eq(false, res.resumed, tojson(res));
+assert.gte(res.examined, expected.length, tojson(res));
+assert.gt(res.moved, 0, tojson(res));
+assert.eq(0, progress.count({_id: t.getFullName()}));
+checkContents();
+
+// Documents from the end of the collection moved into the holes.
+assert.neq(lastBefore, t.find().sort({$natural: -1}).limit(1).next()._id);
+
+// A saved position is picked up by the next run.
+assert.writeOK(progress.insert({_id: t.getFullName(), next: {_id: 500}, examined: 1234,
+                                moved: 5}));
+res = t.runCommand("compact", {online: true});
+assert.commandWorked(res);
+assert.eq(true, res.resumed, tojson(res));
+assert.gte(res.examined, 1234, tojson(res));
+assert.gte(res.moved, 5, tojson(res));
+assert.eq(0, progress.count({_id: t.getFullName()}));
+checkContents();
+
+// A saved position whose document is gone starts over from the end.
+assert.writeOK(progress.insert({_id: t.getFullName(), next: {_id: "missing"}, examined: 0,
+                                moved: 0}));
+res = t.runCommand("compact", {online: true});
+assert.commandWorked(res);
+assert.gte(res.examined, expected.length, tojson(res));
+checkContents();
+
+// Throttling doesn't change the result.
+assert.commandWorked(db.adminCommand({setParameter: 1, compactOnlineSleepMillis: 1}));
+assert.commandWorked(t.runCommand("compact", {online: true}));
+checkContents();
+assert.commandWorked(db.adminCommand({setParameter: 1, compactOnlineSleepMillis: 10}));
+assert.commandWorked(db.adminCommand({setParameter: 1, compactOnlineBatchSize: 100}));
+
+assert.commandFailed(t.runCommand("compact", {online: true, paddingFactor: 1.5}));
+assert.commandFailed(db.runCommand({compact: "compact_online_missing", online: true}));
+
+db.compact_online_capped.drop();
+assert.commandWorked(db.createCollection("compact_online_capped", {capped: true, size: 4096}));
+assert.commandFailed(db.runCommand({compact: "compact_online_capped", online: true}));
+db.compact_online_capped.drop();
+
+t.drop();
@@ -0,0 +1,69 @@
+// Tests that full-time diagnostic data capture samples the server and writes the samples to
+// the diagnostic.data directory under the dbpath.
+(function() {
+    "use strict";
+
+    var baseDir = "jstests_ftdc";
+    var dbpath = MongoRunner.dataPath + baseDir + "/";
+    var dataDir = dbpath + "diagnostic.data";
+
+    var conn = MongoRunner.runMongod({
+        dbpath: dbpath,
+        setParameter: "diagnosticDataCollectionSamplesPerChunk=10"});
+    assert.neq(null, conn, "mongod failed to start");
+    var admin = conn.getDB("admin");
+
+    assert.commandWorked(admin.runCommand({setParameter: 1,
+                                           diagnosticDataCollectionPeriodMillis: 100}));
+
+    // The latest sample holds serverStatus, bracketed by the times it was taken.
+    var res;
+    assert.soon(function() {
+        res = admin.runCommand({getDiagnosticData: 1});
+        assert.commandWorked(res);
+        return res.data.hasOwnProperty("serverStatus");
+    }, "no diagnostic data was collected");
+    assert.eq(undefined, res.data.replSetGetStatus, tojson(res.data));
+    assert.lte(res.data.start, res.data.end, tojson(res.data));
+    assert.eq(conn.getDB("test").serverStatus().pid, res.data.serverStatus.pid);
+
+    // A full chunk of samples is written out.
+    function metricsFiles() {
+        var files;
+        try {
+            files = listFiles(dataDir);
+        }
+        catch (e) {
+            // Not created yet.
+            return [];
+        }
+        return files.filter(function(f) {
+            return f.baseName.indexOf("metrics.") == 0;
+        });
+    }
+    assert.soon(function() {
+        var files = metricsFiles();
+        return files.length > 0 && files[0].size > 0;
+    }, "no diagnostic data file was written");
+
+    // Collection can be turned off, and settings of the wrong type are rejected.
+    assert.commandWorked(admin.runCommand({setParameter: 1,
+                                           diagnosticDataCollectionEnabled: false}));
+    assert.commandFailed(admin.runCommand({setParameter: 1,
+                                           diagnosticDataCollectionPeriodMillis: "x"}));
+
+    // A clean shutdown writes out the samples not yet on disk.
+    assert.commandWorked(admin.runCommand({setParameter: 1,
+                                           diagnosticDataCollectionEnabled: true}));
+    var sizeBefore = 0;
+    metricsFiles().forEach(function(f) { sizeBefore += f.size; });
+    var lastSample = admin.runCommand({getDiagnosticData: 1}).data.start;
+    assert.soon(function() {
+        return admin.runCommand({getDiagnosticData: 1}).data.start > lastSample;
+    });
+    MongoRunner.stopMongod(conn.port);
+
+    var sizeAfter = 0;
+    metricsFiles().forEach(function(f) { sizeAfter += f.size; });
+    assert.gt(sizeAfter, sizeBefore);
+})();
@@ -0,0 +1,44 @@
+// Test that replica set members negotiate message compression in the isMaster handshake and
+// that replication traffic is compressed, with the counters in serverStatus.network.
+(function() {
+    "use strict";
+
+    var replTest = new ReplSetTest({
+        name: "network_compression",
+        nodes: 2,
+        nodeOptions: {setParameter: "networkMessageCompressors=snappy,zlib"}
+    });
+    replTest.startSet();
+    replTest.initiate();
+
+    var primary = replTest.getPrimary();
+    var coll = primary.getDB("test").network_compression;
+    var doc = {padding: new Array(16 * 1024).join("x")};
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert(doc));
+    }
+    replTest.awaitReplication();
+
+    // The secondary fetched the oplog over a connection that negotiated snappy.
+    var primaryStats = primary.getDB("admin").serverStatus().network.compression.snappy;
+    assert.gt(primaryStats.compressor.bytesIn, 0, tojson(primaryStats));
+    assert.lt(primaryStats.compressor.bytesOut, primaryStats.compressor.bytesIn,
+              tojson(primaryStats));
+
+    var secondary = replTest.getSecondary();
+    var secondaryStats = secondary.getDB("admin").serverStatus().network.compression.snappy;
+    assert.gt(secondaryStats.decompressor.bytesIn, 0, tojson(secondaryStats));
+    assert.gt(secondaryStats.decompressor.bytesOut, secondaryStats.decompressor.bytesIn,
+              tojson(secondaryStats));
+
+    // A client which does not ask for compression gets none.
+    var res = primary.getDB("admin").runCommand({isMaster: 1});
+    assert.commandWorked(res);
+    assert(!res.hasOwnProperty("compression"), tojson(res));
+
+    res = primary.getDB("admin").runCommand({isMaster: 1, compression: ["lz4", "zlib"]});
+    assert.commandWorked(res);
+    assert.eq(["zlib"], res.compression, tojson(res));
+
+    replTest.stopSet();
+})();
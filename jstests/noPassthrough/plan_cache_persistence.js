@@ -0,0 +1,45 @@
+// Test that cached plan choices are persisted to local.system.plancache and restored into the
+// plan cache when mongod restarts.
+(function() {
+    "use strict";
+    var options = {setParameter: "planCachePersistIntervalSecs=1"};
+    var conn = MongoRunner.runMongod(options);
+    assert.neq(null, conn, "mongod failed to start");
+
+    var coll = conn.getDB("test").plan_cache_persistence;
+    coll.drop();
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    assert.commandWorked(coll.ensureIndex({b: 1}));
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert({a: i, b: i % 10}));
+    }
+
+    // Two candidate indexes, so the winning plan is cached.
+    assert.eq(1, coll.find({a: 5, b: 5}).itcount());
+    var shapes = coll.getPlanCache().listQueryShapes();
+    assert.eq(1, shapes.length, tojson(shapes));
+
+    var persisted = conn.getDB("local").system.plancache;
+    assert.soon(function() {
+                    return persisted.find({ns: coll.getFullName()}).itcount() === 1;
+                },
+                "plan cache entry was not persisted");
+
+    MongoRunner.stopMongod(conn);
+    conn = MongoRunner.runMongod({restart: conn, setParameter: options.setParameter});
+    assert.neq(null, conn, "mongod failed to restart");
+    coll = conn.getDB("test").plan_cache_persistence;
+
+    var metrics = conn.getDB("admin").serverStatus().metrics.query.planCache;
+    assert.eq(1, metrics.restored, tojson(metrics));
+
+    // The restored choice is used without running a new trial period.
+    shapes = coll.getPlanCache().listQueryShapes();
+    assert.eq(1, shapes.length, tojson(shapes));
+    assert.eq(1, coll.find({a: 5, b: 5}).itcount());
+    metrics = conn.getDB("admin").serverStatus().metrics.query.planCache;
+    assert.eq(1, metrics.hits.warm, tojson(metrics));
+    assert.eq(0, metrics.hits.cold, tojson(metrics));
+
+    MongoRunner.stopMongod(conn);
+})();
@@ -0,0 +1,58 @@
+// Databases and collections opened on several threads at startup, or opened lazily on first use,
+// have the same contents, and serverStatus reports how long each phase of startup took.
+(function() {
+    "use strict";
+    var conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, "mongod failed to start");
+
+    var numDbs = 5;
+    var numColls = 4;
+    function forEachColl(conn, fn) {
+        for (var i = 0; i < numDbs; i++) {
+            for (var j = 0; j < numColls; j++) {
+                fn(conn.getDB("startup_load_" + i)["c" + j], i, j);
+            }
+        }
+    }
+
+    forEachColl(conn, function(coll, i, j) {
+        for (var k = 0; k < 10; k++) {
+            assert.writeOK(coll.insert({_id: k, db: i, coll: j}));
+        }
+        assert.commandWorked(coll.ensureIndex({db: 1, coll: 1}));
+    });
+    var cappedDb = conn.getDB("startup_load_0");
+    assert.commandWorked(cappedDb.createCollection("capped", {capped: true, size: 4096}));
+    assert.writeOK(cappedDb.capped.insert({x: 1}));
+
+    function checkRestart(setParameter) {
+        MongoRunner.stopMongod(conn);
+        conn = MongoRunner.runMongod({restart: conn, setParameter: setParameter});
+        assert.neq(null, conn, "mongod failed to restart with " + setParameter);
+
+        var startup = conn.getDB("admin").serverStatus().metrics.startup;
+        ["storageEngineInitMillis", "repairMillis", "openDatabasesMillis",
+         "checkDatabasesMillis"].forEach(function(field) {
+            assert.gte(startup[field], 0, tojson(startup));
+        });
+
+        forEachColl(conn, function(coll, i, j) {
+            assert.eq(10, coll.find({db: i, coll: j}).itcount(), coll.getFullName());
+            assert.eq(10, coll.find({db: i, coll: j}).hint({db: 1, coll: 1}).itcount(),
+                      coll.getFullName());
+        });
+        assert.eq(1, conn.getDB("startup_load_0").capped.find().itcount());
+
+        // Writes to a collection which hasn't been read since the restart.
+        var coll = conn.getDB("startup_load_1").c3;
+        assert.writeOK(coll.insert({_id: "new"}));
+        assert.eq(11, coll.count());
+        assert.writeOK(coll.remove({_id: "new"}));
+    }
+
+    checkRestart("startupLoadThreads=1");
+    checkRestart("startupLoadThreads=8");
+    checkRestart("lazyOpenRecordStores=true");
+
+    MongoRunner.stopMongod(conn);
+}());
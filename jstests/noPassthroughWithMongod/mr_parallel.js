@@ -0,0 +1,92 @@
+// Tests the parallel mapReduce mode, which maps and reduces on several threads and spills emits
+// to sorted files instead of an incremental collection.
+(function() {
+    "use strict";
+
+    var coll = db.mr_parallel;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 20000; i++) {
+        // mix ints and doubles so that equal keys of different types meet in one partition
+        bulk.insert({_id: i, key: (i % 2 == 0) ? NumberInt(i % 500) : (i % 500), value: 1,
+                     pad: new Array(64).join("x")});
+    }
+    assert.writeOK(bulk.execute());
+
+    function map() {
+        emit(this.key, {count: this.value});
+    }
+
+    function reduce(key, values) {
+        var res = {count: 0};
+        values.forEach(function(v) { res.count += v.count; });
+        return res;
+    }
+
+    function finalize(key, value) {
+        value.finalized = true;
+        return value;
+    }
+
+    function check(results) {
+        assert.eq(500, results.length, tojson(results.slice(0, 5)));
+        results.forEach(function(r) {
+            assert.eq(40, r.value.count, tojson(r));
+            assert(r.value.finalized, tojson(r));
+        });
+    }
+
+    // Inline output.
+    var res = coll.runCommand("mapReduce", {map: map, reduce: reduce, finalize: finalize,
+                                            out: {inline: 1}, parallelism: 4, verbose: true});
+    assert.commandWorked(res);
+    check(res.results);
+    assert.eq(20000, res.counts.input);
+    assert.eq(20000, res.counts.emit);
+    assert.eq(500, res.counts.output);
+    assert.eq("parallel", res.timing.mode);
+    assert.eq(4, res.parallel.threads);
+    ["mapMillis", "spillMillis", "sortMillis", "reduceMillis"].forEach(function(phase) {
+        assert.gte(res.parallel.timing[phase], 0, phase + ": " + tojson(res.parallel));
+    });
+
+    // Results match the single threaded path.
+    var serial = coll.runCommand("mapReduce", {map: map, reduce: reduce, finalize: finalize,
+                                               out: {inline: 1}});
+    assert.commandWorked(serial);
+    assert.eq(undefined, serial.parallel);
+    assert.eq(serial.results.length, res.results.length);
+    for (var i = 0; i < serial.results.length; i++) {
+        assert.eq(serial.results[i]._id, res.results[i]._id);
+        assert.eq(serial.results[i].value, res.results[i].value);
+    }
+
+    // Output to a collection, with a query.
+    var out = db.mr_parallel_out;
+    out.drop();
+    res = coll.runCommand("mapReduce", {map: map, reduce: reduce, out: out.getName(),
+                                        query: {_id: {$lt: 10000}}, parallelism: 3});
+    assert.commandWorked(res);
+    assert.eq(500, out.count());
+    out.find().forEach(function(r) { assert.eq(20, r.value.count, tojson(r)); });
+
+    // The map function can't use the database in parallel mode.
+    assert.commandFailed(coll.runCommand("mapReduce", {
+        map: function() { db.mr_parallel.findOne(); emit(this.key, 1); },
+        reduce: function(k, v) { return Array.sum(v); },
+        out: {inline: 1}, parallelism: 2}));
+
+    // sort and limit fall back to a single thread.
+    res = coll.runCommand("mapReduce", {map: map, reduce: reduce, out: {inline: 1},
+                                        sort: {_id: 1}, limit: 1000, parallelism: 4});
+    assert.commandWorked(res);
+    assert.eq(undefined, res.parallel);
+    assert.eq(500, res.results.length);
+
+    assert.commandFailed(coll.runCommand("mapReduce", {map: map, reduce: reduce, out: {inline: 1},
+                                                       parallelism: 0}));
+
+    coll.drop();
+    out.drop();
+})();
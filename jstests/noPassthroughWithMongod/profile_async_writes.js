@@ -0,0 +1,57 @@
+// Tests that profile entries written in the background are visible to later reads of
+// system.profile, and that entries which do not fit in the write buffer are dropped and counted.
+(function() {
+    "use strict";
+
+    var testDB = db.getSiblingDB("profile_async_writes");
+    testDB.dropDatabase();
+    var coll = testDB.coll;
+
+    function profilerMetrics() {
+        return testDB.serverStatus().metrics.profiler;
+    }
+
+    function getParam() {
+        var res = testDB.adminCommand({getParameter: 1, profileWriteBufferSizeBytes: 1});
+        assert.commandWorked(res);
+        return res.profileWriteBufferSizeBytes;
+    }
+
+    function setParam(value) {
+        assert.commandWorked(testDB.adminCommand({setParameter: 1,
+                                                  profileWriteBufferSizeBytes: value}));
+    }
+
+    testDB.setProfilingLevel(2);
+
+    for (var i = 0; i < 50; i++) {
+        assert.writeOK(coll.insert({_id: i}));
+        assert.eq(1, coll.find({_id: i}).itcount());
+    }
+
+    // Reads of system.profile wait for the entries of earlier operations.
+    assert.eq(50, testDB.system.profile.find({op: "insert", ns: coll.getFullName()}).itcount());
+    assert.eq(50, testDB.system.profile.count({op: "insert", ns: coll.getFullName()}));
+
+    var metrics = profilerMetrics();
+    assert.gte(metrics.written, 50, tojson(metrics));
+    assert.gte(metrics.batches, 1, tojson(metrics));
+
+    // With a buffer too small for any entry, entries are dropped instead of written.
+    var originalSize = getParam();
+    setParam(1);
+    try {
+        var droppedBefore = profilerMetrics().dropped;
+        for (var i = 0; i < 10; i++) {
+            assert.eq(1, coll.find({_id: i, dropped: {$exists: false}}).itcount());
+        }
+        assert.gte(profilerMetrics().dropped - droppedBefore, 10);
+        assert.eq(0, testDB.system.profile.count({"query.dropped": {$exists: true}}));
+    }
+    finally {
+        setParam(originalSize);
+    }
+
+    testDB.setProfilingLevel(0);
+    testDB.dropDatabase();
+})();
@@ -0,0 +1,46 @@
+// Tests that server side JavaScript reuses pooled scopes and their compiled functions, and that
+// serverStatus reports it.
+(function() {
+    "use strict";
+
+    var coll = db.scripting_scope_pool;
+    coll.drop();
+    for (var i = 0; i < 10; i++) {
+        assert.writeOK(coll.insert({_id: i, a: i}));
+    }
+
+    function scriptingMetrics() {
+        return db.serverStatus().metrics.scripting;
+    }
+
+    var where = "function() { return this.a > 4; }";
+
+    // Warm up the pool.
+    assert.eq(5, coll.find({$where: where}).itcount());
+    var before = scriptingMetrics();
+
+    for (var i = 0; i < 20; i++) {
+        assert.eq(5, coll.find({$where: where}).itcount());
+    }
+
+    var after = scriptingMetrics();
+    assert.gte(after.scopes.reused - before.scopes.reused, 19, tojson(after));
+    assert.lte(after.scopes.created - before.scopes.created, 1, tojson(after));
+    assert.gte(after.functionCache.hits - before.functionCache.hits, 19, tojson(after));
+    assert.gte(after.functionCache.compileMicros, 0, tojson(after));
+
+    // A function that fails to compile is not cached, and fails every time.
+    for (var i = 0; i < 2; i++) {
+        assert.throws(function() {
+            coll.find({$where: "function() { return this.a > ; }"}).itcount();
+        });
+    }
+
+    // New code is compiled.
+    before = scriptingMetrics();
+    assert.eq(1, coll.find({$where: "function() { return this.a == 3; }"}).itcount());
+    after = scriptingMetrics();
+    assert.gte(after.functionCache.misses - before.functionCache.misses, 1, tojson(after));
+
+    coll.drop();
+})();
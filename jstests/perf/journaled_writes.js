@@ -0,0 +1,49 @@
+/**
+ *  Throughput and latency of inserts with j: true as the number of concurrent writers grows.
+ *  Writers waiting for the journal at the same time share a flush, so throughput should keep
+ *  growing with the number of writers until the disk is saturated.
+ */
+
+var collection_name = "journaled_writes";
+var seconds = 5;
+
+function runWriters(dbConn, parallel) {
+    var t = dbConn[collection_name];
+    t.drop();
+
+    var ops = [{op: "command", ns: dbConn.getName(),
+                command: {insert: collection_name, documents: [{x: 1}],
+                          writeConcern: {j: true}}}];
+    var benchArgs = {ops: ops, parallel: parallel, seconds: seconds,
+                     host: dbConn.getMongo().host};
+    if (jsTest.options().auth) {
+        benchArgs['db'] = 'admin';
+        benchArgs['username'] = jsTest.options().adminUser;
+        benchArgs['password'] = jsTest.options().adminPassword;
+    }
+    return benchRun(benchArgs);
+}
+
+var status = db.serverStatus();
+if (!status.storageEngine || status.storageEngine.name != "wiredTiger") {
+    print("skipping journaled_writes.js: needs the wiredTiger storage engine");
+}
+else {
+    for (var parallel = 1; parallel <= 256; parallel *= 2) {
+        var before = db.serverStatus();
+        var res = runWriters(db, parallel);
+        var after = db.serverStatus();
+        assert.eq(0, res.errCount, tojson(res));
+
+        var flushes = after.wiredTiger.groupCommit.flushes -
+                      before.wiredTiger.groupCommit.flushes;
+        var waits = after.wiredTiger.groupCommit.waits - before.wiredTiger.groupCommit.waits;
+        print("journaled_writes: " + parallel + " writers, " + res.insert + " inserts/sec, " +
+              (flushes > 0 ? waits / flushes : 0) + " waits per journal flush");
+    }
+
+    var end = db.serverStatus();
+    print("journaled_writes: j: true latency " + tojson(end.metrics.getLastError.journalMicros));
+    print("journaled_writes: group commit " + tojson(end.wiredTiger.groupCommit));
+    db[collection_name].drop();
+}
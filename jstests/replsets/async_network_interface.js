@@ -0,0 +1,44 @@
+// Test that a replica set whose members run their replication commands on the asynchronous
+// network interface elects a primary, replicates, and elects a new primary when it steps down.
+(function() {
+    "use strict";
+    var name = "async_network_interface";
+    var replTest = new ReplSetTest({name: name,
+                                    nodes: 3,
+                                    oplogSize: 5,
+                                    nodeOptions: {setParameter: "replAsyncNetworkInterface=true"}});
+    replTest.startSet();
+    replTest.initiate();
+
+    var master = replTest.getMaster();
+    assert.commandWorked(master.adminCommand({getParameter: 1, replAsyncNetworkInterface: 1}));
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(master.getDB("foo").bar.insert({_id: i},
+                                                      {writeConcern: {w: 3, wtimeout: 60000}}));
+    }
+    replTest.awaitReplication();
+
+    // Heartbeats keep every member's view of the others current.
+    replTest.nodes.forEach(function(node) {
+        var status = node.adminCommand({replSetGetStatus: 1});
+        assert.commandWorked(status);
+        status.members.forEach(function(member) {
+            assert.eq(1, member.health, tojson(status));
+        });
+    });
+
+    jsTestLog("Stepping down " + master.host);
+    try {
+        master.adminCommand({replSetStepDown: 60, force: true});
+    }
+    catch (e) {
+        // The step down closes the connection.
+    }
+    var newMaster = replTest.getMaster();
+    assert.neq(master.host, newMaster.host);
+    assert.writeOK(newMaster.getDB("foo").bar.insert({_id: 100},
+                                                     {writeConcern: {w: 3, wtimeout: 60000}}));
+    assert.eq(101, newMaster.getDB("foo").bar.count());
+
+    replTest.stopSet();
+})();
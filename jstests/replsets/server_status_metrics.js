@@ -10,6 +10,10 @@ function testSecondaryMetrics(secondary, opCount, offset) {
     assert(ss.metrics.repl.network.getmores.totalMillis > 0, "no getmores time")
     assert.eq(ss.metrics.repl.network.ops, opCount + offset, "wrong number of ops retrieved")
     assert(ss.metrics.repl.network.bytes > 0, "zero or missing network bytes")
+    assert(ss.metrics.repl.network.fetchLatencyMillis.num > 0, "no fetch latency histogram")
+    assert.eq(ss.metrics.repl.network.batchSizeOps.total, ss.metrics.repl.network.ops,
+              "batch size histogram does not match ops retrieved")
+    assert(ss.metrics.repl.network.batchSizeBytes.num > 0, "no batch bytes histogram")
 
     assert(ss.metrics.repl.buffer.count >= 0, "buffer count missing")
     assert(ss.metrics.repl.buffer.sizeBytes >= 0, "size (bytes)] missing")
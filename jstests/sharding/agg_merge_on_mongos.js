@@ -0,0 +1,115 @@
+//
+// Tests that the merging part of a sharded aggregation runs on mongos when
+// aggregationMergeOnMongos is set, and on the primary shard otherwise.
+//
+(function() {
+'use strict';
+
+var st = new ShardingTest({ shards : 2, mongos : 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var coll = mongos.getCollection( "foo.bar" );
+
+assert.commandWorked( admin.runCommand({ enableSharding : coll.getDB() + "" }) );
+st.ensurePrimaryShard( coll.getDB().getName(), 'shard0000' );
+assert.commandWorked( admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }) );
+assert.commandWorked( admin.runCommand({ split : coll + "", middle : { _id : 50 } }) );
+assert.commandWorked( admin.runCommand({ moveChunk : coll + "",
+                                         find : { _id : 50 },
+                                         to : 'shard0001' }) );
+
+for ( var i = 0; i < 100; i++ ) {
+    assert.writeOK( coll.insert({ _id : i, g : i % 10 }) );
+}
+
+function runChecks() {
+    // Streaming merge-sort of the shard cursors.
+    var sorted = coll.aggregate([ { $sort : { _id : -1 } } ]).toArray();
+    assert.eq( 100, sorted.length );
+    for ( var i = 0; i < sorted.length; i++ ) {
+        assert.eq( 99 - i, sorted[i]._id );
+    }
+
+    // $skip and $limit are applied by the merger.
+    var page = coll.aggregate([ { $sort : { _id : 1 } }, { $skip : 45 }, { $limit : 10 } ])
+                   .toArray();
+    assert.eq( 10, page.length );
+    assert.eq( 45, page[0]._id );
+    assert.eq( 54, page[9]._id );
+
+    // Partial $group results from each shard are merged.
+    var groups = coll.aggregate([ { $group : { _id : "$g", n : { $sum : 1 } } },
+                                  { $sort : { _id : 1 } } ]).toArray();
+    assert.eq( 10, groups.length );
+    groups.forEach( function( g ) { assert.eq( 10, g.n ); } );
+
+    // Old-style inline results.
+    var res = coll.getDB().runCommand({ aggregate : coll.getName(),
+                                        pipeline : [ { $match : { g : 3 } } ] });
+    assert.commandWorked( res );
+    assert.eq( 10, res.result.length );
+}
+
+function mergeType( pipeline, options ) {
+    var cmd = { aggregate : coll.getName(), pipeline : pipeline, explain : true };
+    for ( var opt in options ) {
+        cmd[opt] = options[opt];
+    }
+    var res = coll.getDB().runCommand( cmd );
+    assert.commandWorked( res );
+    return res.mergeType;
+}
+
+var groupPipeline = [ { $group : { _id : "$g", n : { $sum : 1 } } } ];
+
+// Default: merge on the primary shard.
+assert.eq( "primaryShard", mergeType( groupPipeline ) );
+runChecks();
+
+assert.commandWorked( admin.runCommand({ setParameter : 1, aggregationMergeOnMongos : true }) );
+
+assert.eq( "mongos", mergeType( groupPipeline ) );
+runChecks();
+
+// Stages that need a mongod or may spill to disk are still merged on the primary shard.
+assert.eq( "primaryShard", mergeType( groupPipeline, { allowDiskUse : true } ) );
+assert.eq( "primaryShard", mergeType( [ { $out : "agg_out" } ] ) );
+coll.aggregate([ { $match : { g : 1 } }, { $out : "agg_out" } ]);
+assert.eq( 10, coll.getDB().agg_out.count() );
+
+// maxTimeMS is enforced while merging on mongos. The fail point makes the merge exceed its time
+// limit at the first check, which happens after enough documents have flowed through it.
+var exceededTimeLimit = 50;
+for ( var i = 100; i < 300; i++ ) {
+    assert.writeOK( coll.insert({ _id : i, g : i % 10 }) );
+}
+assert.commandWorked( admin.runCommand({ configureFailPoint : "mongosMergeMaxTimeAlwaysTimeOut",
+                                         mode : "alwaysOn" }) );
+
+[ [ { $group : { _id : "$_id" } } ],
+  [ { $sort : { _id : 1 } } ] ].forEach( function( pipeline ) {
+    assert.commandFailedWithCode( coll.getDB().runCommand({ aggregate : coll.getName(),
+                                                            pipeline : pipeline,
+                                                            cursor : {},
+                                                            maxTimeMS : 60 * 1000 }),
+                                  exceededTimeLimit );
+    assert.commandFailedWithCode( coll.getDB().runCommand({ aggregate : coll.getName(),
+                                                            pipeline : pipeline,
+                                                            maxTimeMS : 60 * 1000 }),
+                                  exceededTimeLimit );
+
+    // Without maxTimeMS there is no time limit to exceed.
+    var res = coll.getDB().runCommand({ aggregate : coll.getName(),
+                                        pipeline : pipeline,
+                                        cursor : {} });
+    assert.commandWorked( res );
+    assert.eq( 300, res.cursor.firstBatch.length );
+});
+
+assert.commandWorked( admin.runCommand({ configureFailPoint : "mongosMergeMaxTimeAlwaysTimeOut",
+                                         mode : "off" }) );
+
+st.stop();
+})();
@@ -0,0 +1,68 @@
+//
+// Tests that range deletion removes orphaned documents in batches, honors its rate limit and
+// reports its progress in serverStatus.
+//
+(function() {
+'use strict';
+
+var st = new ShardingTest({ shards : 2, mongos : 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var coll = mongos.getCollection( "foo.bar" );
+
+assert.commandWorked( admin.runCommand({ enableSharding : coll.getDB() + "" }) );
+st.ensurePrimaryShard( coll.getDB().getName(), 'shard0000' );
+assert.commandWorked( admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }) );
+assert.commandWorked( admin.runCommand({ split : coll + "", middle : { _id : 0 } }) );
+assert.commandWorked( admin.runCommand({ moveChunk : coll + "",
+                                         find : { _id : 0 },
+                                         to : 'shard0001',
+                                         _waitForDelete : true }) );
+
+var shard0Admin = st.shard0.getDB( "admin" );
+var shard0Coll = st.shard0.getCollection( coll + "" );
+
+function metrics() {
+    return shard0Admin.serverStatus().metrics.rangeDeleter;
+}
+
+// 200 orphans in the chunk owned by shard0001.
+var bulk = shard0Coll.initializeUnorderedBulkOp();
+for ( var i = 0; i < 200; i++ ) {
+    bulk.insert({ _id : i });
+}
+assert.writeOK( bulk.execute() );
+
+assert.commandWorked( shard0Admin.runCommand({ setParameter : 1, rangeDeleterBatchSize : 16 }) );
+assert.commandWorked( shard0Admin.runCommand({ setParameter : 1,
+                                               rangeDeleterMaxDocsPerSecond : 1000 }) );
+
+var before = metrics();
+var start = new Date();
+var result = shard0Admin.runCommand({ cleanupOrphaned : coll + "" });
+while ( result.ok && result.stoppedAtKey ) {
+    result = shard0Admin.runCommand({ cleanupOrphaned : coll + "",
+                                      startingFromKey : result.stoppedAtKey });
+}
+assert.commandWorked( result );
+var elapsed = new Date() - start;
+
+assert.eq( 0, shard0Coll.count() );
+var after = metrics();
+printjson( after );
+assert.eq( 200, after.docsDeleted - before.docsDeleted, tojson( after ) );
+assert.eq( Math.ceil( 200 / 16 ), after.batches - before.batches, tojson( after ) );
+
+// 200 documents at 1000 per second take at least about 200ms.
+assert.gte( elapsed, 150, "deletion was not throttled" );
+assert.gt( after.throttleMillis, before.throttleMillis, tojson( after ) );
+
+var section = shard0Admin.serverStatus({ rangeDeleter : 1 }).rangeDeleter;
+printjson( section );
+assert.eq( 0, section.queuedRanges, tojson( section ) );
+assert( section.hasOwnProperty( "deletesInProgress" ), tojson( section ) );
+
+st.stop();
+})();
@@ -0,0 +1,81 @@
+//
+// Tests that documents from an index scan over shard key ranges owned entirely by a shard are not
+// filter-checked one by one, while scans that reach unowned ranges still drop orphans.
+//
+(function() {
+'use strict';
+
+var st = new ShardingTest({ shards : 2, mongos : 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var coll = mongos.getCollection( "foo.bar" );
+
+assert.commandWorked( admin.runCommand({ enableSharding : coll.getDB() + "" }) );
+st.ensurePrimaryShard( coll.getDB().getName(), 'shard0000' );
+assert.commandWorked( admin.runCommand({ shardCollection : coll + "", key : { x : 1 } }) );
+assert.commandWorked( admin.runCommand({ split : coll + "", middle : { x : 50 } }) );
+assert.commandWorked( admin.runCommand({ moveChunk : coll + "",
+                                         find : { x : 50 },
+                                         to : 'shard0001' }) );
+
+for ( var i = 0; i < 100; i++ ) {
+    assert.writeOK( coll.insert({ _id : i, x : i }) );
+}
+
+// An orphan on shard0000, in the range owned by shard0001.
+assert.writeOK( st.shard0.getCollection( coll + "" ).insert({ _id : "orphan", x : 60 }) );
+
+// Sums the stats of the SHARDING_FILTER stages in an explain.
+function filterStats( query ) {
+    var explain = coll.find( query ).explain( "executionStats" );
+    var totals = { chunkSkips : 0, docsChecked : 0, docsNotChecked : 0 };
+    function visit( stage ) {
+        if ( stage.stage == "SHARDING_FILTER" ) {
+            totals.chunkSkips += stage.chunkSkips;
+            totals.docsChecked += stage.docsChecked;
+            totals.docsNotChecked += stage.docsNotChecked;
+        }
+        if ( stage.inputStage ) {
+            visit( stage.inputStage );
+        }
+        (stage.inputStages || []).forEach( visit );
+        (stage.shards || []).forEach( function( shard ) { visit( shard.executionStages ); } );
+    }
+    visit( explain.executionStats.executionStages );
+    return totals;
+}
+
+// Entirely inside the chunk owned by shard0000.
+assert.eq( 10, coll.find({ x : { $gte : 10, $lt : 20 } }).itcount() );
+var stats = filterStats({ x : { $gte : 10, $lt : 20 } });
+assert.eq( 0, stats.docsChecked, tojson( stats ) );
+assert.eq( 10, stats.docsNotChecked, tojson( stats ) );
+
+assert.eq( 3, coll.find({ x : { $in : [ 1, 5, 9 ] } }).itcount() );
+stats = filterStats({ x : { $in : [ 1, 5, 9 ] } });
+assert.eq( 0, stats.docsChecked, tojson( stats ) );
+assert.eq( 3, stats.docsNotChecked, tojson( stats ) );
+
+// Entirely inside the chunk owned by shard0001.
+assert.eq( 15, coll.find({ x : { $gte : 55, $lt : 70 } }).itcount() );
+stats = filterStats({ x : { $gte : 55, $lt : 70 } });
+assert.eq( 0, stats.docsChecked, tojson( stats ) );
+assert.eq( 15, stats.docsNotChecked, tojson( stats ) );
+
+// Spans both chunks: every document is checked and shard0000 drops the orphan.
+assert.eq( 30, coll.find({ x : { $gte : 40, $lt : 70 } }).itcount() );
+stats = filterStats({ x : { $gte : 40, $lt : 70 } });
+assert.eq( 1, stats.chunkSkips, tojson( stats ) );
+assert.eq( 31, stats.docsChecked, tojson( stats ) );
+assert.eq( 0, stats.docsNotChecked, tojson( stats ) );
+
+// Not bounded by the shard key.
+assert.eq( 100, coll.find({ y : { $exists : false } }).itcount() );
+stats = filterStats({ y : { $exists : false } });
+assert.eq( 1, stats.chunkSkips, tojson( stats ) );
+assert.eq( 101, stats.docsChecked, tojson( stats ) );
+
+st.stop();
+})();
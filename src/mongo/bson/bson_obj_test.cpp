@@ -298,4 +298,35 @@ namespace {
         ASSERT_EQUALS( count , 1 + 2 + 3 );
     }
 
+    TEST(BSONElementHasherWithoutField, ConsistentWithCompare) {
+        const BSONElementHasherWithoutField hasher;
+        const BSONElementEqWithoutField eq;
+
+        BSONObj nums = BSON("a" << 5 << "b" << 5LL << "c" << 5.0 << "d" << 5.5);
+        ASSERT(eq(nums["a"], nums["b"]));
+        ASSERT(eq(nums["a"], nums["c"]));
+        ASSERT_EQUALS(hasher(nums["a"]), hasher(nums["b"]));
+        ASSERT_EQUALS(hasher(nums["a"]), hasher(nums["c"]));
+        ASSERT(!eq(nums["a"], nums["d"]));
+
+        // Field names, including those of the outer element, don't matter.
+        BSONObj objs = BSON("x" << BSON("f" << 1) << "y" << BSON("f" << 1.0));
+        ASSERT(eq(objs["x"], objs["y"]));
+        ASSERT_EQUALS(hasher(objs["x"]), hasher(objs["y"]));
+
+        // NaNs compare equal to each other.
+        BSONObj nans = BSON("a" << std::numeric_limits<double>::quiet_NaN()
+                            << "b" << -std::numeric_limits<double>::quiet_NaN());
+        ASSERT(eq(nans["a"], nans["b"]));
+        ASSERT_EQUALS(hasher(nans["a"]), hasher(nans["b"]));
+
+        // Strings and symbols of the same value are equal.
+        BSONObjBuilder bob;
+        bob.append("s", "abc");
+        bob.appendSymbol("t", "abc");
+        BSONObj strs = bob.obj();
+        ASSERT(eq(strs["s"], strs["t"]));
+        ASSERT_EQUALS(hasher(strs["s"]), hasher(strs["t"]));
+    }
+
 } // unnamed namespace
@@ -35,6 +35,8 @@
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/bits.h"
+#include "mongo/util/assert_util.h"
 
 namespace mongo {
 
@@ -372,9 +374,192 @@ namespace mongo {
             return Status::OK();
         }
 
+        // Objects nested deeper than this are left to validateBSONIterative().
+        const int kMaxFastValidationDepth = 32;
+
+        /**
+         * Returns the first NUL in [pos, end), or NULL if there is none.  Field names are mostly
+         * shorter than the setup cost of memchr(), so scans a word at a time instead.
+         */
+        inline const char* findCStringEnd(const char* pos, const char* end) {
+            while (end - pos >= static_cast<ptrdiff_t>(sizeof(uint64_t))) {
+                // Read little endian, so that the first byte is the least significant one. The
+                // lowest bit set in "zeroes" then always marks the first NUL.
+                const uint64_t word = ConstDataView(pos).read<LittleEndian<uint64_t>>();
+                const uint64_t zeroes =
+                    (word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL;
+                if (zeroes) {
+                    return pos + countTrailingZeros64(zeroes) / 8;
+                }
+                pos += sizeof(uint64_t);
+            }
+            for (; pos < end; ++pos) {
+                if (*pos == 0) {
+                    return pos;
+                }
+            }
+            return NULL;
+        }
+
+        inline int32_t readInt32(const char* pos) {
+            return ConstDataView(pos).read<LittleEndian<int32_t>>();
+        }
+
     }  // namespace
 
-    Status validateBSON( const char* originalBuffer, uint64_t maxLength ) {
+    /**
+     * Checks the structure of the document in "buffer" without building any error messages,
+     * keeping no state but the end of each enclosing object.
+     *
+     * Returns false as soon as something is wrong, and also for the rare types it does not
+     * handle (DBRef and CodeWScope) and for very deep nesting, so that validateBSONIterative()
+     * can decide those and describe any problem.  Only accepts documents that
+     * validateBSONIterative() accepts: every element has to fit within its enclosing
+     * object, leaving room for that object's terminating EOO.
+     */
+    bool validateBSONFast(const char* buffer, uint64_t maxLength) {
+        if (maxLength < static_cast<uint64_t>(BSONObj::kMinBSONLength)) {
+            return false;
+        }
+        const int32_t topSize = readInt32(buffer);
+        if (topSize < BSONObj::kMinBSONLength || static_cast<uint64_t>(topSize) > maxLength) {
+            return false;
+        }
+
+        const char* enclosingEnds[kMaxFastValidationDepth];
+        int depth = 0;
+
+        const char* pos = buffer + sizeof(int32_t);
+        const char* end = buffer + topSize;
+
+        // Loop invariant: pos < end.
+        while (true) {
+            const signed char type = *pos++;
+
+            if (type == EOO) {
+                if (pos != end) {
+                    return false;
+                }
+                if (depth == 0) {
+                    return true;
+                }
+                end = enclosingEnds[--depth];
+                if (pos >= end) {
+                    return false;
+                }
+                continue;
+            }
+
+            const char* nameEnd = findCStringEnd(pos, end);
+            if (!nameEnd) {
+                return false;
+            }
+            pos = nameEnd + 1;
+
+            // What is left of the enclosing object, which must still hold its EOO.
+            const size_t remaining = end - pos;
+            if (remaining == 0) {
+                return false;
+            }
+
+            size_t valueSize;
+            switch (type) {
+            case MinKey:
+            case MaxKey:
+            case jstNULL:
+            case Undefined:
+                valueSize = 0;
+                break;
+
+            case Bool:
+                valueSize = 1;
+                break;
+
+            case NumberInt:
+                valueSize = sizeof(int32_t);
+                break;
+
+            case NumberDouble:
+            case NumberLong:
+            case bsonTimestamp:
+            case Date:
+                valueSize = sizeof(int64_t);
+                break;
+
+            case jstOID:
+                valueSize = OID::kOIDSize;
+                break;
+
+            case Code:
+            case Symbol:
+            case String: {
+                if (remaining <= sizeof(int32_t)) {
+                    return false;
+                }
+                const int32_t size = readInt32(pos);
+                if (size <= 0 || static_cast<size_t>(size) >= remaining - sizeof(int32_t)) {
+                    return false;
+                }
+                valueSize = sizeof(int32_t) + size;
+                if (pos[valueSize - 1] != 0) {
+                    return false;
+                }
+                break;
+            }
+
+            case BinData: {
+                if (remaining <= sizeof(int32_t)) {
+                    return false;
+                }
+                const int32_t size = readInt32(pos);
+                if (size < 0) {
+                    return false;
+                }
+                // Length, subtype and data.
+                valueSize = sizeof(int32_t) + 1 + static_cast<size_t>(size);
+                break;
+            }
+
+            case RegEx: {
+                const char* patternEnd = findCStringEnd(pos, end);
+                if (!patternEnd) {
+                    return false;
+                }
+                const char* optionsEnd = findCStringEnd(patternEnd + 1, end);
+                if (!optionsEnd) {
+                    return false;
+                }
+                valueSize = optionsEnd + 1 - pos;
+                break;
+            }
+
+            case Object:
+            case Array: {
+                if (depth == kMaxFastValidationDepth || remaining <= sizeof(int32_t)) {
+                    return false;
+                }
+                const int32_t size = readInt32(pos);
+                if (size < BSONObj::kMinBSONLength || static_cast<size_t>(size) >= remaining) {
+                    return false;
+                }
+                enclosingEnds[depth++] = end;
+                end = pos + size;
+                pos += sizeof(int32_t);
+                continue;
+            }
+
+            default:
+                return false;
+            }
+
+            if (valueSize >= remaining) {
+                return false;
+            }
+            pos += valueSize;
+        }
+    }
+
+    Status validateBSONFull( const char* originalBuffer, uint64_t maxLength ) {
         if ( maxLength < 5 ) {
             return Status( ErrorCodes::InvalidBSON, "bson data has to be at least 5 bytes" );
         }
@@ -383,6 +568,17 @@ namespace mongo {
         return validateBSONIterative( &buf );
     }
 
+    Status validateBSON( const char* originalBuffer, uint64_t maxLength ) {
+        // Almost everything is valid, so check that quickly and only walk the document again
+        // when it is not, to find out what is wrong with it.
+        if ( validateBSONFast( originalBuffer, maxLength ) ) {
+            dassert( validateBSONFull( originalBuffer, maxLength ).isOK() );
+            return Status::OK();
+        }
+
+        return validateBSONFull( originalBuffer, maxLength );
+    }
+
     Status Validator<BSONObj>::validateLoad(const char* ptr, size_t length) {
         return validateBSON(ptr, length);
     }
@@ -45,6 +45,16 @@ namespace mongo {
      */
     Status validateBSON( const char* buf, uint64_t maxLength );
 
+    /**
+     * The two checks validateBSON() is made of, exposed for testing.
+     *
+     * validateBSONFast() returns true only for documents validateBSONFull() accepts, but may
+     * return false for some valid ones (DBRef, CodeWScope, very deep nesting). Only
+     * validateBSONFull() explains what is wrong with a document.
+     */
+    bool validateBSONFast( const char* buf, uint64_t maxLength );
+    Status validateBSONFull( const char* buf, uint64_t maxLength );
+
     template<> struct Validator<BSONObj> {
         static Status validateLoad(const char* ptr, size_t length);
         static Status validateStore(const BSONObj& toStore);
@@ -308,4 +308,107 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize()));
     }
 
+
+    TEST(BSONValidateFast, FieldNamesOfEveryLength) {
+        // Field names end at every offset of the word at a time scan.
+        for (int len = 0; len < 24; ++len) {
+            const std::string name(len, 'f');
+            const BSONObj x = BSON(name << 1 << "after" << "x");
+            ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+
+            // Without its NUL the name runs into the value and the element after it.
+            BSONObj mine = x.copy();
+            char* data = const_cast<char*>(mine.objdata());
+            data[4 + 1 + len] = 'g';
+            ASSERT_NOT_OK(validateBSON(mine.objdata(), mine.objsize()));
+        }
+    }
+
+    TEST(BSONValidateFast, DeeplyNested) {
+        // Deeper than the fast path tracks.
+        BSONObj x = BSON("x" << 1);
+        for (int i = 0; i < 100; ++i) {
+            x = BSON("a" << x << "b" << BSON_ARRAY(i));
+        }
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+
+        // Give the innermost "x" an invalid type.
+        BSONObj mine = x.copy();
+        char* data = const_cast<char*>(mine.objdata());
+        const size_t pos = std::string(data, mine.objsize()).find(std::string("\x10x\0", 3));
+        ASSERT_NOT_EQUALS(std::string::npos, pos);
+        data[pos] = 0x7f;
+        ASSERT_NOT_OK(validateBSON(mine.objdata(), mine.objsize()));
+    }
+
+    TEST(BSONValidateFast, RareTypes) {
+        BSONObjBuilder b;
+        b.appendCodeWScope("cws", "return x;", BSON("x" << 1));
+        b.appendDBRef("ref", "coll", OID("01234567890123456789aaaa"));
+        b.appendSymbol("sym", "s");
+        b.appendCode("code", "function() {}");
+        b.appendMinKey("min");
+        b.appendMaxKey("max");
+        b.appendUndefined("u");
+        const BSONObj x = b.obj();
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+
+        const BSONObj nested = BSON("o" << x);
+        ASSERT_OK(validateBSON(nested.objdata(), nested.objsize()));
+    }
+
+    TEST(BSONValidateFast, TruncatedBuffer) {
+        const BSONObj x = BSON("_id" << OID("01234567890123456789aaaa") <<
+                               "s" << "a string" <<
+                               "bin" << BSONBinData("\x69\xb7", 2, BinDataGeneral) <<
+                               "re" << BSONRegEx("^a", "i") <<
+                               "o" << BSON("d" << 1.5 << "a" << BSON_ARRAY(1 << 2LL)));
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+        for (int len = 0; len < x.objsize(); ++len) {
+            ASSERT_NOT_OK(validateBSON(x.objdata(), len));
+        }
+    }
+
+    TEST(BSONValidateFast, MutatedDocuments) {
+        // The fast check has to agree with the full one on every mutation of a document that
+        // only has types it handles.
+        const BSONObj original = BSON("_id" << 7 <<
+                                      "name" << "a name that is long enough" <<
+                                      "n" << 5LL <<
+                                      "d" << Date_t::fromMillisSinceEpoch(44) <<
+                                      "ts" << Timestamp(1, 2) <<
+                                      "bin" << BSONBinData("\x69\xb7", 2, BinDataGeneral) <<
+                                      "re" << BSONRegEx("^a", "i") <<
+                                      "o" << BSON("x" << true << "y" << BSONNULL) <<
+                                      "a" << BSON_ARRAY("p" << 2.5 << BSONObj()));
+        ASSERT_TRUE(validateBSONFast(original.objdata(), original.objsize()));
+
+        const char values[] = {0, 1, 2, 3, 5, 0x7f, char(0x80), char(0xff)};
+        int numValid = 0;
+        for (int i = 0; i < original.objsize(); ++i) {
+            for (size_t v = 0; v < sizeof(values); ++v) {
+                BSONObj mine = original.copy();
+                const_cast<char*>(mine.objdata())[i] = values[v];
+
+                const bool fast = validateBSONFast(mine.objdata(), mine.objsize());
+                const Status full = validateBSONFull(mine.objdata(), mine.objsize());
+                ASSERT_EQUALS(full.isOK(), fast);
+                ASSERT_EQUALS(full.isOK(), validateBSON(mine.objdata(), mine.objsize()).isOK());
+                if (full.isOK()) {
+                    ++numValid;
+                }
+            }
+        }
+
+        // Some mutations, e.g. of string contents, leave the document valid.
+        ASSERT_GREATER_THAN(numValid, 0);
+    }
+
+    TEST(BSONValidateFast, FastRejectsRareTypes) {
+        const BSONObj x = BSON("cws" << BSONCodeWScope("return x;", BSON("x" << 1)));
+        ASSERT_FALSE(validateBSONFast(x.objdata(), x.objsize()));
+        ASSERT_OK(validateBSONFull(x.objdata(), x.objsize()));
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+    }
+
 }
@@ -943,16 +943,13 @@ namespace mongo {
         return -1;
     }
  
-    size_t BSONElement::Hasher::operator()(const BSONElement& elem) const {
-        size_t hash = 0;
-
-        boost::hash_combine(hash, elem.canonicalType());
-
-        const StringData fieldName = elem.fieldNameStringData();
-        if (!fieldName.empty()) {
-            boost::hash_combine(hash, StringData::Hasher()(fieldName));
-        }
+namespace {
 
+    /**
+     * Combines the value of 'elem' into 'hash', such that elements of the same canonical type
+     * which compare equal have the same hash.
+     */
+    void hashElementValue(const BSONElement& elem, size_t* hash) {
         switch (elem.type()) {
             // Order of types is the same as in compareElementValues().
 
@@ -965,15 +962,15 @@ namespace mongo {
             break;
 
         case mongo::Bool:
-            boost::hash_combine(hash, elem.boolean());
+            boost::hash_combine(*hash, elem.boolean());
             break;
 
         case mongo::bsonTimestamp:
-            boost::hash_combine(hash, elem.timestamp().asULL());
+            boost::hash_combine(*hash, elem.timestamp().asULL());
             break;
 
         case mongo::Date:
-            boost::hash_combine(hash, elem.date().asInt64());
+            boost::hash_combine(*hash, elem.date().asInt64());
             break;
 
         case mongo::NumberDouble:
@@ -985,49 +982,71 @@ namespace mongo {
             // SERVER-16851
             const double dbl = elem.numberDouble();
             if (std::isnan(dbl)) {
-                boost::hash_combine(hash, std::numeric_limits<double>::quiet_NaN());
+                boost::hash_combine(*hash, std::numeric_limits<double>::quiet_NaN());
             }
             else {
-                boost::hash_combine(hash, dbl);
+                boost::hash_combine(*hash, dbl);
             }
             break;
         }
 
         case mongo::jstOID:
-            elem.__oid().hash_combine(hash);
+            elem.__oid().hash_combine(*hash);
             break;
 
         case mongo::Code:
         case mongo::Symbol:
         case mongo::String:
-            boost::hash_combine(hash, StringData::Hasher()(elem.valueStringData()));
+            boost::hash_combine(*hash, StringData::Hasher()(elem.valueStringData()));
             break;
 
         case mongo::Object:
         case mongo::Array:
-            boost::hash_combine(hash, BSONObj::Hasher()(elem.embeddedObject()));
+            boost::hash_combine(*hash, BSONObj::Hasher()(elem.embeddedObject()));
             break;
 
         case mongo::DBRef:
         case mongo::BinData:
             // All bytes of the value are required to be identical.
-            boost::hash_combine(hash, StringData::Hasher()(StringData(elem.value(),
-                                                                      elem.valuesize())));
+            boost::hash_combine(*hash, StringData::Hasher()(StringData(elem.value(),
+                                                                       elem.valuesize())));
             break;
 
         case mongo::RegEx:
-            boost::hash_combine(hash, StringData::Hasher()(elem.regex()));
-            boost::hash_combine(hash, StringData::Hasher()(elem.regexFlags()));
+            boost::hash_combine(*hash, StringData::Hasher()(elem.regex()));
+            boost::hash_combine(*hash, StringData::Hasher()(elem.regexFlags()));
             break;
 
         case mongo::CodeWScope: {
-            boost::hash_combine(hash, StringData::Hasher()(
+            boost::hash_combine(*hash, StringData::Hasher()(
                                         StringData(elem.codeWScopeCode(),
                                                    elem.codeWScopeCodeLen())));
-            boost::hash_combine(hash, BSONObj::Hasher()(elem.codeWScopeObject()));
+            boost::hash_combine(*hash, BSONObj::Hasher()(elem.codeWScopeObject()));
             break;
         }
         }
+    }
+
+} // namespace
+
+    size_t BSONElement::Hasher::operator()(const BSONElement& elem) const {
+        size_t hash = 0;
+
+        boost::hash_combine(hash, elem.canonicalType());
+
+        const StringData fieldName = elem.fieldNameStringData();
+        if (!fieldName.empty()) {
+            boost::hash_combine(hash, StringData::Hasher()(fieldName));
+        }
+
+        hashElementValue(elem, &hash);
+        return hash;
+    }
+
+    size_t BSONElementHasherWithoutField::operator()(const BSONElement& elem) const {
+        size_t hash = 0;
+        boost::hash_combine(hash, elem.canonicalType());
+        hashElementValue(elem, &hash);
         return hash;
     }
 
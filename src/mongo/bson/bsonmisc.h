@@ -42,6 +42,21 @@ namespace mongo {
         }
     };
 
+    /**
+     * Hash and equality functors for unordered containers of elements that agree with
+     * BSONElementCmpWithoutField: field names are ignored and numbers of different types that
+     * compare equal hash equally.
+     */
+    struct BSONElementHasherWithoutField {
+        size_t operator()( const BSONElement& e ) const;
+    };
+
+    struct BSONElementEqWithoutField {
+        bool operator()( const BSONElement &l, const BSONElement &r ) const {
+            return l.woCompare( r, false ) == 0;
+        }
+    };
+
     class BSONObjCmp {
     public:
         BSONObjCmp( const BSONObj &order = BSONObj() ) : _order( order ) {}
@@ -546,6 +546,16 @@ namespace mongo {
             return BSONObj(SharedBuffer::takeOwnership(holderPrefixedData));
         }
 
+        /** Makes this object owned by sharing 'buffer', which must hold this object's data.
+         *  Lets many objects which live in one buffer (e.g. a batch received from the network)
+         *  outlive it without each being copied by getOwned().
+         */
+        BSONObj& shareOwnershipWith(const SharedBuffer& buffer) {
+            verify( buffer.get() );
+            _ownedBuffer = buffer;
+            return *this;
+        }
+
         /// members for Sorter
         struct SorterDeserializeSettings {}; // unused
         void serializeForSorter(BufBuilder& buf) const { buf.appendBuf(objdata(), objsize()); }
@@ -56,6 +56,7 @@
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/log.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/password_digest.h"
@@ -975,13 +976,36 @@ namespace {
         int sslModeVal = sslGlobalParams.sslMode.load();
         if (sslModeVal == SSLParams::SSLMode_preferSSL ||
             sslModeVal == SSLParams::SSLMode_requireSSL) {
-            return p->secure( sslManager(), _server.host() );
+            if (!p->secure( sslManager(), _server.host() )) {
+                return false;
+            }
         }
 #endif
 
+        _negotiateCompression();
         return true;
     }
 
+    void DBClientConnection::_negotiateCompression() {
+        BSONObjBuilder isMasterCmd;
+        isMasterCmd.append("isMaster", 1);
+        if (!appendCompressorsForHandshake(&isMasterCmd)) {
+            return;
+        }
+
+        try {
+            BSONObj info;
+            if (runCommand("admin", isMasterCmd.obj(), info)) {
+                p->setCompressor(compressorFromHandshakeReply(info));
+            }
+        }
+        catch (const DBException& ex) {
+            // Not fatal here, the connection failure surfaces on its first real use.
+            LOG(1) << "could not negotiate message compression with " << toString()
+                   << ": " << ex.toString();
+        }
+    }
+
     void DBClientConnection::logout(const string& dbname, BSONObj& info){
         authCache.erase(dbname);
         runCommand(dbname, BSON("logout" << 1), info);
@@ -261,7 +261,13 @@ namespace mongo {
         if ( cursorId == 0 )
             return false;
 
-        requestMore();
+        if ( opts & QueryOption_Exhaust ) {
+            // The server sends the next batch without being asked.
+            exhaustReceiveMore();
+        }
+        else {
+            requestMore();
+        }
         return batch.pos < batch.nReturned;
     }
 
@@ -1128,6 +1128,9 @@ namespace mongo {
         double _so_timeout;
         bool _connect( std::string& errmsg );
 
+        // Agrees on a message compressor with the server, if compression is enabled.
+        void _negotiateCompression();
+
         static AtomicInt32 _numConnections;
         static bool _lazyKillCursor; // lazy means we piggy back kill cursors on next op
 
@@ -55,6 +55,10 @@ namespace mongo {
 
 namespace {
     const std::string ADMIN_DBNAME = "admin";
+
+    // Upper bound on the number of resources whose authorized actions a session caches.  Sessions
+    // that touch more distinct resources than this simply start the cache over.
+    const size_t kMaxAuthorizedActionsCacheSize = 256;
 }  // namespace
 
     AuthorizationSession::AuthorizationSession(
@@ -494,6 +498,7 @@ namespace {
 
     void AuthorizationSession::_refreshUserInfoAsNeeded(OperationContext* txn) {
         AuthorizationManager& authMan = getAuthorizationManager();
+        bool usersChanged = false;
         UserSet::iterator it = _authenticatedUsers.begin();
         while (it != _authenticatedUsers.end()) {
             User* user = *it;
@@ -510,6 +515,7 @@ namespace {
                     // Success! Replace the old User object with the updated one.
                     fassert(17067, _authenticatedUsers.replaceAt(it, updatedUser) == user);
                     authMan.releaseUser(user);
+                    usersChanged = true;
                     LOG(1) << "Updated session cache of user information for " << name;
                     break;
                 }
@@ -517,6 +523,7 @@ namespace {
                     // User does not exist anymore; remove it from _authenticatedUsers.
                     fassert(17068, _authenticatedUsers.removeAt(it) == user);
                     authMan.releaseUser(user);
+                    usersChanged = true;
                     log() << "Removed deleted user " << name <<
                         " from session cache of user information.";
                     continue;  // No need to advance "it" in this case.
@@ -531,10 +538,13 @@ namespace {
             }
             ++it;
         }
-        _buildAuthenticatedRolesVector();
+        if (usersChanged) {
+            _buildAuthenticatedRolesVector();
+        }
     }
 
     void AuthorizationSession::_buildAuthenticatedRolesVector() {
+        _authorizedActionsCache.clear();
         _authenticatedRoleNames.clear();
         for (UserSet::iterator it = _authenticatedUsers.begin();
                 it != _authenticatedUsers.end();
@@ -548,43 +558,67 @@ namespace {
         }
     }
 
-    bool AuthorizationSession::_isAuthorizedForPrivilege(const Privilege& privilege) {
-        const ResourcePattern& target(privilege.getResourcePattern());
+    ActionSet AuthorizationSession::_getAuthorizedActionsForResource(
+            const ResourcePattern& target) {
+        AuthorizedActionsCache::const_iterator cached = _authorizedActionsCache.find(target);
+        if (cached != _authorizedActionsCache.end())
+            return cached->second;
 
         ResourcePattern resourceSearchList[resourceSearchListCapacity];
         const int resourceSearchListLength = buildResourceSearchList(target, resourceSearchList);
 
+        ActionSet authorizedActions;
+        for (UserSet::iterator it = _authenticatedUsers.begin();
+                it != _authenticatedUsers.end(); ++it) {
+            User* user = *it;
+            for (int i = 0; i < resourceSearchListLength; ++i) {
+                authorizedActions.addAllActionsFromSet(
+                        user->getActionsForResource(resourceSearchList[i]));
+            }
+        }
+
+        if (_authorizedActionsCache.size() >= kMaxAuthorizedActionsCacheSize) {
+            _authorizedActionsCache.clear();
+        }
+        _authorizedActionsCache[target] = authorizedActions;
+        return authorizedActions;
+    }
+
+    bool AuthorizationSession::_isAuthorizedForPrivilege(const Privilege& privilege) {
+        const ResourcePattern& target(privilege.getResourcePattern());
+
         ActionSet unmetRequirements = privilege.getActions();
 
+        // The default privileges depend on the state of the current connection, such as whether
+        // the localhost exception applies, so only the privileges of the authenticated users go
+        // through the cache.
         PrivilegeVector defaultPrivileges = getDefaultPrivileges();
-        for (PrivilegeVector::iterator it = defaultPrivileges.begin();
-                it != defaultPrivileges.end(); ++it) {
+        if (!defaultPrivileges.empty()) {
+            ResourcePattern resourceSearchList[resourceSearchListCapacity];
+            const int resourceSearchListLength =
+                buildResourceSearchList(target, resourceSearchList);
 
-            for (int i = 0; i < resourceSearchListLength; ++i) {
-                if (!(it->getResourcePattern() == resourceSearchList[i]))
-                    continue;
+            for (PrivilegeVector::iterator it = defaultPrivileges.begin();
+                    it != defaultPrivileges.end(); ++it) {
 
-                ActionSet userActions = it->getActions();
-                unmetRequirements.removeAllActionsFromSet(userActions);
+                for (int i = 0; i < resourceSearchListLength; ++i) {
+                    if (!(it->getResourcePattern() == resourceSearchList[i]))
+                        continue;
 
-                if (unmetRequirements.empty())
-                    return true;
-            }
-        }
+                    ActionSet userActions = it->getActions();
+                    unmetRequirements.removeAllActionsFromSet(userActions);
 
-        for (UserSet::iterator it = _authenticatedUsers.begin();
-                it != _authenticatedUsers.end(); ++it) {
-            User* user = *it;
-            for (int i = 0; i < resourceSearchListLength; ++i) {
-                ActionSet userActions = user->getActionsForResource(resourceSearchList[i]);
-                unmetRequirements.removeAllActionsFromSet(userActions);
-
-                if (unmetRequirements.empty())
-                    return true;
+                    if (unmetRequirements.empty())
+                        return true;
+                }
             }
         }
 
-        return false;
+        if (_authenticatedUsers.begin() == _authenticatedUsers.end())
+            return false;
+
+        unmetRequirements.removeAllActionsFromSet(_getAuthorizedActionsForResource(target));
+        return unmetRequirements.empty();
     }
 
     void AuthorizationSession::setImpersonatedUserData(std::vector<UserName> usernames,
@@ -42,6 +42,7 @@
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/auth/user_set.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
     class ClientBasic;
@@ -252,8 +253,15 @@ namespace mongo {
         // Builds a vector of all roles held by users who are authenticated on this connection. The
         // vector is stored in _authenticatedRoleNames. This function is called when users are
         // logged in or logged out, as well as when the user cache is determined to be out of date.
+        // Since the set of privileges held by the session changes at exactly those times, this
+        // also empties _authorizedActionsCache.
         void _buildAuthenticatedRolesVector();
 
+        // Returns the union of the actions that all authenticated users are granted on "target",
+        // through any of the resource patterns that match it.  Answers from
+        // _authorizedActionsCache when possible, and populates it otherwise.
+        ActionSet _getAuthorizedActionsForResource(const ResourcePattern& target);
+
         // Checks if this connection is authorized for the given Privilege, ignoring whether or not
         // we should even be doing authorization checks in general.  Note: this may acquire a read
         // lock on the admin database (to update out-of-date user privilege information).
@@ -267,6 +275,15 @@ namespace mongo {
         // users set is changed.
         std::vector<RoleName> _authenticatedRoleNames;
 
+        // Cache of the actions that _authenticatedUsers are granted on each resource this session
+        // has recently checked, so repeated checks on the same namespace skip the walk over every
+        // user's privileges.  User objects never change once built; the AuthorizationManager
+        // marks them invalid instead, and _refreshUserInfoAsNeeded() then replaces them in
+        // _authenticatedUsers.  So emptying this whenever _authenticatedUsers changes keeps it in
+        // step with user and role updates without consulting the AuthorizationManager.
+        typedef unordered_map<ResourcePattern, ActionSet> AuthorizedActionsCache;
+        AuthorizedActionsCache _authorizedActionsCache;
+
         // A vector of impersonated UserNames and a vector of those users' RoleNames.
         // These are used in the auditing system. They are not used for authz checks.
         std::vector<UserName> _impersonatedUserNames;
@@ -39,6 +39,7 @@
 #include "mongo/stdx/memory.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/map_util.h"
+#include "mongo/util/mongoutils/str.h"
 
 #define ASSERT_NULL(EXPR) ASSERT_FALSE(EXPR)
 #define ASSERT_NON_NULL(EXPR) ASSERT_TRUE(EXPR)
@@ -450,5 +451,106 @@ namespace {
                             testFooCollResource, ActionType::insert));
     }
 
+    TEST_F(AuthorizationSessionTest, CachedDecisionsMatchRequestedActions) {
+        ASSERT_OK(managerState->insertPrivilegeDocument(&_txn,
+                BSON("user" << "spencer" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("role" << "read" <<
+                                                "db" << "test"))),
+                BSONObj()));
+        ASSERT_OK(authzSession->addAndAuthorizeUser(&_txn, UserName("spencer", "test")));
+
+        ActionSet findAndInsert;
+        findAndInsert.addAction(ActionType::find);
+        findAndInsert.addAction(ActionType::insert);
+
+        // The same resource is checked repeatedly, for different sets of actions.
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(authzSession->isAuthorizedForActionsOnResource(
+                                testFooCollResource, ActionType::find));
+            ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                                 testFooCollResource, ActionType::insert));
+            ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                                 testFooCollResource, findAndInsert));
+            ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                                 otherFooCollResource, ActionType::find));
+        }
+
+        // Granting more privileges to the user is observed on the next request.
+        int ignored;
+        managerState->remove(
+                &_txn,
+                AuthorizationManager::usersCollectionNamespace,
+                BSONObj(),
+                BSONObj(),
+                &ignored);
+        ASSERT_OK(managerState->insertPrivilegeDocument(&_txn,
+                BSON("user" << "spencer" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("role" << "readWrite" <<
+                                                "db" << "test"))),
+                BSONObj()));
+        authzManager->invalidateUserCache();
+        authzSession->startRequest(&_txn);
+        ASSERT_TRUE(authzSession->isAuthorizedForActionsOnResource(
+                            testFooCollResource, findAndInsert));
+        ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                             otherFooCollResource, ActionType::find));
+    }
+
+    TEST_F(AuthorizationSessionTest, CachedDecisionsWithManyUsersAndRoles) {
+        const int numUsers = 4;
+        const int numDatabases = 25;
+
+        // Each user holds read, readWrite and dbAdmin on every database.
+        BSONArrayBuilder roles;
+        for (int db = 0; db < numDatabases; ++db) {
+            const std::string dbName = str::stream() << "db" << db;
+            roles.append(BSON("role" << "read" << "db" << dbName));
+            roles.append(BSON("role" << "readWrite" << "db" << dbName));
+            roles.append(BSON("role" << "dbAdmin" << "db" << dbName));
+        }
+        const BSONArray rolesArray = roles.arr();
+
+        for (int u = 0; u < numUsers; ++u) {
+            const std::string dbName = str::stream() << "userdb" << u;
+            ASSERT_OK(managerState->insertPrivilegeDocument(&_txn,
+                    BSON("user" << "user" <<
+                         "db" << dbName <<
+                         "credentials" << BSON("MONGODB-CR" << "a") <<
+                         "roles" << rolesArray),
+                    BSONObj()));
+            ASSERT_OK(authzSession->addAndAuthorizeUser(&_txn, UserName("user", dbName)));
+        }
+
+        const NamespaceString namespaces[] = {
+            NamespaceString("db0.foo"),
+            NamespaceString("db12.bar"),
+            NamespaceString("db24.baz"),
+            NamespaceString("unknown.foo"),
+        };
+        const int numNamespaces = sizeof(namespaces) / sizeof(namespaces[0]);
+
+        // Several requests, so that decisions cached by one request are checked against the
+        // roles again by the next.
+        for (int request = 0; request < 3; ++request) {
+            authzSession->startRequest(&_txn);
+            for (int i = 0; i < 2 * numNamespaces; ++i) {
+                const NamespaceString& ns = namespaces[i % numNamespaces];
+                const bool known = ns.db() != "unknown";
+                ASSERT_EQUALS(known, authzSession->isAuthorizedForActionsOnNamespace(
+                                             ns, ActionType::find));
+                ASSERT_EQUALS(known, authzSession->isAuthorizedForActionsOnNamespace(
+                                             ns, ActionType::insert));
+                ASSERT_EQUALS(known, authzSession->isAuthorizedForActionsOnNamespace(
+                                             ns, ActionType::createIndex));
+                ASSERT_FALSE(authzSession->isAuthorizedForActionsOnNamespace(
+                                     ns, ActionType::shutdown));
+            }
+        }
+    }
+
 }  // namespace
 }  // namespace mongo
@@ -232,6 +232,22 @@ namespace mongo {
 
         StatusWith<CompactStats> compact(OperationContext* txn, const CompactOptions* options);
 
+        /**
+         * Moves the document at 'loc' into free space nearer the start of the collection, if the
+         * record store has any that fits it, and returns its location afterwards ('loc' if it
+         * stayed put). Unlike compact(), only needs the collection locked in MODE_IX, so that
+         * a collection can be compacted a few documents at a time.
+         *
+         * Only supported if the record store supports compact() and doesn't compact in place.
+         */
+        StatusWith<RecordId> relocateRecord(OperationContext* txn, const RecordId& loc);
+
+        /**
+         * Makes up to 'maxRecords' of the spaces relocateRecord() left behind available to
+         * inserts again, and returns how many. Called in batches once a pass is done.
+         */
+        size_t releaseRelocatedSpace(OperationContext* txn, size_t maxRecords);
+
         /**
          * removes all documents as fast as possible
          * indexes before and after will be the same
@@ -198,4 +198,28 @@ namespace mongo {
         return StatusWith<CompactStats>( stats );
     }
 
+    StatusWith<RecordId> Collection::relocateRecord( OperationContext* txn,
+                                                     const RecordId& loc ) {
+        dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
+        invariant(_recordStore->compactSupported() && !_recordStore->compactsInPlace());
+
+        // This calls back into Collection::recordStoreGoingToMove if the document moves, which
+        // removes the old location from all indexes.
+        StatusWith<RecordId> newLocation = _recordStore->relocateRecord( txn, loc, this );
+        if ( !newLocation.isOK() || newLocation.getValue() == loc )
+            return newLocation;
+
+        const BSONObj doc = _recordStore->dataFor( txn, newLocation.getValue() ).toBson();
+        Status s = _indexCatalog.indexRecord( txn, doc, newLocation.getValue() );
+        if ( !s.isOK() )
+            return StatusWith<RecordId>( s );
+
+        return newLocation;
+    }
+
+    size_t Collection::releaseRelocatedSpace( OperationContext* txn, size_t maxRecords ) {
+        dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
+        return _recordStore->releaseRelocatedSpace( txn, maxRecords );
+    }
+
 }  // namespace mongo
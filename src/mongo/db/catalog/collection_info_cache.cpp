@@ -50,7 +50,8 @@ namespace mongo {
         : _collection( collection ),
           _keysComputed( false ),
           _planCache(new PlanCache(collection->ns().ns())),
-          _querySettings(new QuerySettings()) { }
+          _querySettings(new QuerySettings()),
+          _geoNearDensityCache(new GeoNearDensityCache()) { }
 
     void CollectionInfoCache::reset( OperationContext* txn ) {
         LOG(1) << _collection->ns().ns() << ": clearing plan cache - collection info cache reset";
@@ -130,12 +131,18 @@ namespace mongo {
         if (NULL != _planCache.get()) {
             _planCache->notifyOfWriteOp();
         }
+        if (NULL != _geoNearDensityCache.get()) {
+            _geoNearDensityCache->notifyOfWriteOp();
+        }
     }
 
     void CollectionInfoCache::clearQueryCache() {
         if (NULL != _planCache.get()) {
             _planCache->clear();
         }
+        if (NULL != _geoNearDensityCache.get()) {
+            _geoNearDensityCache->clear();
+        }
     }
 
     PlanCache* CollectionInfoCache::getPlanCache() const {
@@ -146,6 +153,10 @@ namespace mongo {
         return _querySettings.get();
     }
 
+    GeoNearDensityCache* CollectionInfoCache::getGeoNearDensityCache() const {
+        return _geoNearDensityCache.get();
+    }
+
     void CollectionInfoCache::updatePlanCacheIndexEntries(OperationContext* txn) {
         std::vector<IndexEntry> indexEntries;
 
@@ -32,6 +32,7 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include "mongo/db/query/geo_near_density_cache.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
@@ -68,6 +69,11 @@ namespace mongo {
          */
         QuerySettings* getQuerySettings() const;
 
+        /**
+         * Get the density estimates made by $near searches over this collection.
+         */
+        GeoNearDensityCache* getGeoNearDensityCache() const;
+
         // -------------------
 
         /* get set of index keys for this namespace.  handy to quickly check if a given
@@ -102,6 +108,9 @@ namespace mongo {
         // Includes index filters.
         boost::scoped_ptr<QuerySettings> _querySettings;
 
+        // Density estimates for $near searches.  Cleared along with the plan cache.
+        boost::scoped_ptr<GeoNearDensityCache> _geoNearDensityCache;
+
         /**
          * Must be called under exclusive DB lock.
          */
@@ -206,7 +206,7 @@ namespace mutablebson {
         /* Return true if a replica set secondary should go into "recovering"
            (unreadable) state while running this command.
          */
-        virtual bool maintenanceMode() const { return false; }
+        virtual bool maintenanceMode(const BSONObj& cmdObj) const { return false; }
 
         /* Return true if command should be permitted when a replica set secondary is in "recovering"
            (unreadable) state.
@@ -30,6 +30,10 @@
 
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kCommand
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -41,25 +45,246 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
+#include "mongo/db/dbhelpers.h"
 #include "mongo/db/index_builder.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/ops/delete.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/log.h"
+#include "mongo/util/progress_meter.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
     using std::string;
     using std::stringstream;
 
+    namespace {
+
+        // Documents relocated by an online compaction under each lock acquisition.
+        MONGO_EXPORT_SERVER_PARAMETER(compactOnlineBatchSize, int, 100);
+
+        // Pause between batches of an online compaction, to throttle its I/O.
+        MONGO_EXPORT_SERVER_PARAMETER(compactOnlineSleepMillis, int, 10);
+
+        // Where an online compaction saves its progress after each batch, one document per
+        // namespace, so that it can be resumed after an interruption or restart.
+        const char* onlineCompactionProgressNS = "local.compact.progress";
+
+        boost::mutex onlineCompactionsMutex;
+        std::set<std::string> onlineCompactions;
+
+        /**
+         * Marks a namespace as having an online compaction running on it.
+         */
+        class OnlineCompactionRegistration {
+            MONGO_DISALLOW_COPYING(OnlineCompactionRegistration);
+        public:
+            explicit OnlineCompactionRegistration(const std::string& ns) : _ns(ns) {
+                boost::lock_guard<boost::mutex> lk(onlineCompactionsMutex);
+                _registered = onlineCompactions.insert(_ns).second;
+            }
+
+            ~OnlineCompactionRegistration() {
+                if (_registered) {
+                    boost::lock_guard<boost::mutex> lk(onlineCompactionsMutex);
+                    onlineCompactions.erase(_ns);
+                }
+            }
+
+            bool registered() const { return _registered; }
+
+        private:
+            const std::string _ns;
+            bool _registered;
+        };
+
+        BSONObj loadOnlineCompactionProgress(OperationContext* txn, const std::string& ns) {
+            AutoGetCollectionForRead ctx(txn, onlineCompactionProgressNS);
+            BSONObj progress;
+            if (ctx.getCollection()) {
+                Helpers::findOne(txn, ctx.getCollection(), BSON("_id" << ns), progress, true);
+            }
+            return progress.getOwned();
+        }
+
+        /**
+         * Creates the progress collection if it doesn't exist yet. This is the only time that
+         * saving progress takes the local database in MODE_X, which blocks oplog writes.
+         */
+        void createOnlineCompactionProgressCollection(OperationContext* txn) {
+            {
+                ScopedTransaction transaction(txn, MODE_IS);
+                AutoGetDb autoDb(txn, "local", MODE_IS);
+                if (autoDb.getDb() && autoDb.getDb()->getCollection(onlineCompactionProgressNS)) {
+                    return;
+                }
+            }
+
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetOrCreateDb autoDb(txn, "local", MODE_X);
+                Database* db = autoDb.getDb();
+                if (!db->getCollection(onlineCompactionProgressNS)) {
+                    WriteUnitOfWork wunit(txn);
+                    invariant(db->createCollection(txn, onlineCompactionProgressNS));
+                    wunit.commit();
+                }
+            } MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn,
+                                                  "createOnlineCompactionProgressCollection",
+                                                  onlineCompactionProgressNS);
+        }
+
+        void saveOnlineCompactionProgress(OperationContext* txn, const BSONObj& progress) {
+            createOnlineCompactionProgressCollection(txn);
+
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetDb autoDb(txn, "local", MODE_IX);
+                Lock::CollectionLock collLock(txn->lockState(),
+                                              onlineCompactionProgressNS,
+                                              MODE_X);
+                // An upsert into a missing collection would need local in MODE_X. If someone
+                // dropped the collection since it was created, skip this save; the next batch
+                // creates it again.
+                if (!autoDb.getDb() || !autoDb.getDb()->getCollection(onlineCompactionProgressNS)) {
+                    return;
+                }
+                Helpers::upsert(txn, onlineCompactionProgressNS, progress);
+            } MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn,
+                                                  "saveOnlineCompactionProgress",
+                                                  onlineCompactionProgressNS);
+        }
+
+        void clearOnlineCompactionProgress(OperationContext* txn, const std::string& ns) {
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetDb autoDb(txn, "local", MODE_IX);
+                Lock::CollectionLock collLock(txn->lockState(),
+                                              onlineCompactionProgressNS,
+                                              MODE_X);
+                if (!autoDb.getDb() || !autoDb.getDb()->getCollection(onlineCompactionProgressNS)) {
+                    return;
+                }
+                deleteObjects(txn,
+                              autoDb.getDb(),
+                              onlineCompactionProgressNS,
+                              BSON("_id" << ns),
+                              PlanExecutor::YIELD_MANUAL,
+                              true);
+            } MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn,
+                                                  "clearOnlineCompactionProgress",
+                                                  onlineCompactionProgressNS);
+        }
+
+        /**
+         * Relocates the next 'batchSize' documents of an online compaction, which scans the
+         * collection from its end towards its start. The batch starts at the document whose _id
+         * is 'resumeId', or at the end of the collection if 'resumeId' is empty or that document
+         * is gone. On return 'resumeId' holds the _id of the document the next batch starts at,
+         * or is empty if the scan has reached the start of the collection.
+         */
+        Status relocateOnlineCompactionBatch(OperationContext* txn,
+                                             const NamespaceString& ns,
+                                             size_t batchSize,
+                                             BSONObj* resumeId,
+                                             long long* examined,
+                                             long long* moved) {
+            ScopedTransaction transaction(txn, MODE_IX);
+            AutoGetDb autoDb(txn, ns.db(), MODE_IX);
+            Lock::CollectionLock collLock(txn->lockState(), ns.ns(), MODE_IX);
+
+            Database* const db = autoDb.getDb();
+            Collection* const collection = db ? db->getCollection(ns) : NULL;
+            if (!collection) {
+                return Status(ErrorCodes::NamespaceNotFound,
+                              "collection dropped during online compaction");
+            }
+
+            RecordId start;
+            if (!resumeId->isEmpty()) {
+                start = Helpers::findById(txn, collection, *resumeId);
+            }
+
+            // Collect the batch before moving anything, so that the scan doesn't run into the
+            // documents it moves. One more location than the batch tells where the next batch
+            // starts.
+            std::vector<RecordId> locs;
+            {
+                boost::scoped_ptr<RecordIterator> it(
+                    collection->getIterator(txn, start, CollectionScanParams::BACKWARD));
+                while (!it->isEOF() && locs.size() <= batchSize) {
+                    locs.push_back(it->getNext());
+                }
+            }
+
+            if (locs.size() > batchSize) {
+                *resumeId = collection->docFor(txn, locs.back()).value()["_id"].wrap();
+                locs.pop_back();
+            }
+            else {
+                *resumeId = BSONObj();
+            }
+
+            for (size_t i = 0; i < locs.size(); ++i) {
+                WriteUnitOfWork wunit(txn);
+                StatusWith<RecordId> newLocation = collection->relocateRecord(txn, locs[i]);
+                if (!newLocation.isOK())
+                    return newLocation.getStatus();
+                wunit.commit();
+
+                ++*examined;
+                if (newLocation.getValue() != locs[i])
+                    ++*moved;
+            }
+
+            return Status::OK();
+        }
+
+        /**
+         * Returns the space the documents moved by an online compaction left behind to the
+         * record store's free space, 'batchSize' records at a time.
+         */
+        void releaseOnlineCompactionSpace(OperationContext* txn,
+                                          const NamespaceString& ns,
+                                          size_t batchSize) {
+            while (true) {
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetDb autoDb(txn, ns.db(), MODE_IX);
+                Lock::CollectionLock collLock(txn->lockState(), ns.ns(), MODE_IX);
+
+                Database* const db = autoDb.getDb();
+                Collection* const collection = db ? db->getCollection(ns) : NULL;
+                if (!collection) {
+                    return;
+                }
+
+                WriteUnitOfWork wunit(txn);
+                const size_t released = collection->releaseRelocatedSpace(txn, batchSize);
+                wunit.commit();
+                if (released < batchSize) {
+                    return;
+                }
+            }
+        }
+
+    } // namespace
+
     class CompactCmd : public Command {
     public:
         virtual bool isWriteCommandForConfigServer() const { return false; }
         virtual bool adminOnly() const { return false; }
         virtual bool slaveOk() const { return true; }
-        virtual bool maintenanceMode() const { return true; }
+        virtual bool maintenanceMode(const BSONObj& cmdObj) const {
+            // An online compaction leaves the collection available, so a secondary running one
+            // can stay readable.
+            return !cmdObj["online"].trueValue();
+        }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
                                            std::vector<Privilege>* out) {
@@ -71,9 +296,11 @@ namespace mongo {
             help << "compact collection\n"
                 "warning: this operation locks the database and is slow. you can cancel with killOp()\n"
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
-                "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
+                "  [paddingFactor:<num>], [paddingBytes:<num>], [online:<bool>] }\n"
                 "  force - allows to run on a replica set primary\n"
-                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
+                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n"
+                "  online - move documents into free space a few at a time without blocking the\n"
+                "           collection. resumes where an interrupted online compact stopped\n";
         }
         CompactCmd() : Command("compact") { }
 
@@ -95,8 +322,11 @@ namespace mongo {
                          BSONObjBuilder& result) {
             const std::string nsToCompact = parseNsCollectionRequired(db, cmdObj);
 
+            const bool online = cmdObj["online"].trueValue();
+
             repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
-            if (replCoord->getMemberState().primary() && !cmdObj["force"].trueValue()) {
+            if (replCoord->getMemberState().primary() && !cmdObj["force"].trueValue() &&
+                    !online) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
@@ -114,6 +344,10 @@ namespace mongo {
                 return false;
             }
 
+            if ( online ) {
+                return runOnline( txn, ns, cmdObj, errmsg, result );
+            }
+
             CompactOptions compactOptions;
 
             if ( cmdObj["preservePadding"].trueValue() ) {
@@ -184,6 +418,123 @@ namespace mongo {
 
             return true;
         }
+
+    private:
+        bool runOnline(OperationContext* txn,
+                       const NamespaceString& ns,
+                       const BSONObj& cmdObj,
+                       string& errmsg,
+                       BSONObjBuilder& result) {
+            if ( cmdObj.hasElement( "preservePadding" ) ||
+                 cmdObj.hasElement( "paddingFactor" ) ||
+                 cmdObj.hasElement( "paddingBytes" ) ) {
+                errmsg = "cannot mix online with preservePadding|paddingFactor|paddingBytes";
+                return false;
+            }
+
+            if ( ns.ns() == onlineCompactionProgressNS ) {
+                errmsg = "can't compact the online compaction progress collection";
+                return false;
+            }
+
+            long long numRecords = 0;
+            {
+                AutoGetCollectionForRead ctx(txn, ns.ns());
+                Collection* collection = ctx.getCollection();
+                if ( !collection ) {
+                    errmsg = "namespace does not exist";
+                    return false;
+                }
+
+                if ( collection->isCapped() ) {
+                    errmsg = "cannot compact a capped collection";
+                    return false;
+                }
+
+                const RecordStore* rs = collection->getRecordStore();
+                if ( !rs->compactSupported() || rs->compactsInPlace() ) {
+                    errmsg = str::stream() << "online compaction is not supported by record store: "
+                                           << rs->name();
+                    return false;
+                }
+
+                // Progress is tracked by _id, so that it survives documents moving.
+                if ( !collection->getIndexCatalog()->findIdIndex( txn ) ) {
+                    errmsg = "online compaction needs an _id index";
+                    return false;
+                }
+
+                numRecords = collection->numRecords( txn );
+            }
+
+            OnlineCompactionRegistration registration( ns.ns() );
+            if ( !registration.registered() ) {
+                errmsg = "an online compaction is already running on this collection";
+                return false;
+            }
+
+            const BSONObj progress = loadOnlineCompactionProgress( txn, ns.ns() );
+            const bool resumed = !progress.isEmpty();
+            BSONObj resumeId = progress["next"].isABSONObj() ? progress["next"].Obj()
+                                                             : BSONObj();
+            long long examined = progress["examined"].numberLong();
+            long long moved = progress["moved"].numberLong();
+
+            if ( resumed ) {
+                log() << "compact " << ns << " resuming online after " << examined
+                      << " documents";
+            }
+            else {
+                log() << "compact " << ns << " begin online";
+            }
+
+            ProgressMeterHolder pm(*txn->setMessage("compact (online)",
+                                                    "Online Compaction Progress",
+                                                    numRecords));
+            pm.hit( examined );
+
+            while ( true ) {
+                txn->checkForInterrupt();
+
+                const long long examinedBefore = examined;
+                Status status = relocateOnlineCompactionBatch(txn,
+                                                              ns,
+                                                              std::max(1, compactOnlineBatchSize),
+                                                              &resumeId,
+                                                              &examined,
+                                                              &moved);
+                if ( !status.isOK() ) {
+                    if ( status.code() == ErrorCodes::NamespaceNotFound )
+                        clearOnlineCompactionProgress( txn, ns.ns() );
+                    return appendCommandStatus( result, status );
+                }
+                pm.hit( examined - examinedBefore );
+
+                if ( resumeId.isEmpty() )
+                    break;
+
+                saveOnlineCompactionProgress( txn, BSON( "_id" << ns.ns() <<
+                                                         "next" << resumeId <<
+                                                         "examined" << examined <<
+                                                         "moved" << moved ) );
+
+                const int sleepMillis = compactOnlineSleepMillis;
+                if ( sleepMillis > 0 )
+                    sleepmillis( sleepMillis );
+            }
+
+            releaseOnlineCompactionSpace( txn, ns, std::max(1, compactOnlineBatchSize) );
+            clearOnlineCompactionProgress( txn, ns.ns() );
+            pm.finished();
+
+            log() << "compact " << ns << " end online, moved " << moved << " of " << examined
+                  << " documents examined";
+
+            result.append( "resumed", resumed );
+            result.append( "examined", examined );
+            result.append( "moved", moved );
+            return true;
+        }
     };
     static CompactCmd compactCmd;
 
@@ -32,6 +32,7 @@
 
 #include "mongo/db/commands/mr.h"
 
+#include <algorithm>
 #include <boost/scoped_ptr.hpp>
 
 #include "mongo/client/connpool.h"
@@ -43,6 +44,7 @@
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/mr_parallel.h"
 #include "mongo/db/db.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbhelpers.h"
@@ -57,6 +59,7 @@
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/range_preserver.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/catalog/catalog_cache.h"
 #include "mongo/s/chunk_manager.h"
 #include "mongo/s/collection_metadata.h"
@@ -80,6 +83,9 @@ namespace mongo {
     using std::stringstream;
     using std::vector;
 
+    // upper bound on the 'parallelism' option of mapReduce
+    MONGO_EXPORT_SERVER_PARAMETER(internalMapReduceMaxParallelism, int, 16);
+
     namespace mr {
 
         AtomicUInt32 Config::JOB_NUMBER;
@@ -93,7 +99,11 @@ namespace mongo {
         }
 
         void JSFunction::init( State * state ) {
-            _scope = state->scope();
+            init( state->scope() );
+        }
+
+        void JSFunction::init( Scope * scope ) {
+            _scope = scope;
             verify( _scope );
             _scope->init( &_wantedScope );
 
@@ -105,8 +115,12 @@ namespace mongo {
         }
 
         void JSMapper::init( State * state ) {
-            _func.init( state );
-            _params = state->config().mapParams;
+            init( state->scope() , state->config().mapParams );
+        }
+
+        void JSMapper::init( Scope * scope , const BSONObj& params ) {
+            _func.init( scope );
+            _params = params;
         }
 
         /**
@@ -315,6 +329,17 @@ namespace mongo {
                     mapParams = cmdObj["mapparams"].embeddedObjectUserCheck();
                 }
 
+                functionCode = cmdObj.filterFieldsUndotted(
+                                    BSON( "map" << 1 << "reduce" << 1 << "finalize" << 1 ) , true );
+            }
+
+            parallelism = 1;
+            if ( cmdObj.hasField( "parallelism" ) ) {
+                BSONElement p = cmdObj["parallelism"];
+                uassert( 28663 , "parallelism has to be a positive number" ,
+                         p.isNumber() && p.numberLong() > 0 );
+                parallelism = static_cast<int>( std::min( p.numberLong() ,
+                        static_cast<long long>( internalMapReduceMaxParallelism ) ) );
             }
 
             {
@@ -931,6 +956,21 @@ namespace mongo {
             insert( _config.tempNamespace , res );
         }
 
+        void State::addFinalResult( const BSONObj& res ) {
+            if ( _onDisk ) {
+                insert( _config.tempNamespace , res );
+                return;
+            }
+
+            _size += _add( _temp.get() , res );
+            verify( _dupCount == 0 );
+        }
+
+        void State::addCounts( long long numEmits , long long numReduces ) {
+            _numEmits += numEmits;
+            _config.reducer->numReduces += numReduces;
+        }
+
         BSONObj _nativeToTemp( const BSONObj& args, void* data ) {
             State* state = (State*) data;
             BSONObjIterator it(args);
@@ -1216,25 +1256,27 @@ namespace mongo {
             }
         }
 
-        /**
-         * emit that will be called by js function
-         */
-        BSONObj fast_emit( const BSONObj& args, void* data ) {
+        BSONObj emitArgsToTuple( const BSONObj& args ) {
             uassert( 10077 , "fast_emit takes 2 args" , args.nFields() == 2 );
             uassert( 13069 , "an emit can't be more than half max bson size" , args.objsize() < ( BSONObjMaxUserSize / 2 ) );
-            
-            State* state = (State*) data;
+
             if ( args.firstElement().type() == Undefined ) {
                 BSONObjBuilder b( args.objsize() );
                 b.appendNull( "" );
                 BSONObjIterator i( args );
                 i.next();
                 b.append( i.next() );
-                state->emit( b.obj() );
-            }
-            else {
-                state->emit( args );
+                return b.obj();
             }
+            return args;
+        }
+
+        /**
+         * emit that will be called by js function
+         */
+        BSONObj fast_emit( const BSONObj& args, void* data ) {
+            State* state = (State*) data;
+            state->emit( emitArgsToTuple( args ) );
             return BSONObj();
         }
 
@@ -1345,11 +1387,23 @@ namespace mongo {
                     }
                 }
 
+                // in parallel mode emits spill to the partitions' sort files, so there is no
+                // need for an inc collection
+                boost::scoped_ptr<ParallelMapReduce> parallel;
+                if (ParallelMapReduce::canRunInParallel(config)) {
+                    state._useIncremental = false;
+                }
+
                 try {
                     state.init();
                     state.prepTempCollection();
                     ON_BLOCK_EXIT_OBJ(state, &State::dropTempCollections);
 
+                    if (ParallelMapReduce::canRunInParallel(config)) {
+                        parallel.reset(new ParallelMapReduce(txn, &state));
+                        parallel->start();
+                    }
+
                     int progressTotal = 0;
                     bool showTotal = true;
                     if ( state.config().filter.isEmpty() ) {
@@ -1430,6 +1484,17 @@ namespace mongo {
                                 }
                             }
 
+                            if (parallel) {
+                                // the workers map and spill on their own
+                                parallel->map(o);
+                                numInputs++;
+                                pm.hit();
+                                if (numInputs % 100 == 0) {
+                                    txn->checkForInterrupt();
+                                }
+                                continue;
+                            }
+
                             // do map
                             if ( config.verbose ) mt.reset();
                             config.mapper->map( o );
@@ -1485,6 +1550,11 @@ namespace mongo {
 
                     txn->checkForInterrupt();
 
+                    if (parallel) {
+                        parallel->finishMapPhase();
+                        state.addCounts(parallel->numEmits(), 0);
+                    }
+
                     // update counters
                     countsBuilder.appendNumber("input", numInputs);
                     countsBuilder.appendNumber( "emit" , state.numEmits() );
@@ -1497,17 +1567,25 @@ namespace mongo {
                     op->setMessage("m/r: (2/3) final reduce in memory",
                                    "M/R: (2/3) Final In-Memory Reduce Progress");
                     Timer rt;
-                    // do reduce in memory
-                    // this will be the last reduce needed for inline mode
-                    state.reduceInMemory();
-                    // if not inline: dump the in memory map to inc collection, all data is on disk
-                    state.dumpToInc();
-                    // final reduce
-                    state.finalReduce(op , pm );
+                    if (parallel) {
+                        parallel->reduce(op, pm);
+                        state.addCounts(0, parallel->numReduces());
+                    }
+                    else {
+                        // do reduce in memory
+                        // this will be the last reduce needed for inline mode
+                        state.reduceInMemory();
+                        // if not inline: dump the in memory map to inc collection, all data is
+                        // on disk
+                        state.dumpToInc();
+                        // final reduce
+                        state.finalReduce(op , pm );
+                    }
                     reduceTime += rt.micros();
                     countsBuilder.appendNumber( "reduce" , state.numReduces() );
                     timingBuilder.appendNumber("reduceTime", reduceTime / 1000);
-                    timingBuilder.append( "mode" , state.jsMode() ? "js" : "mixed" );
+                    timingBuilder.append( "mode" ,
+                                          parallel ? "parallel" : state.jsMode() ? "js" : "mixed" );
 
                     long long finalCount = state.postProcessCollection(txn, op, pm);
                     state.appendResults( result );
@@ -1517,6 +1595,11 @@ namespace mongo {
                     countsBuilder.appendNumber( "output" , finalCount );
                     if ( config.verbose ) result.append( "timing" , timingBuilder.obj() );
                     result.append( "counts" , countsBuilder.obj() );
+                    if (parallel) {
+                        BSONObjBuilder parallelBuilder(result.subobjStart("parallel"));
+                        parallel->appendStats(&parallelBuilder);
+                        parallelBuilder.done();
+                    }
 
                     if ( finalCount == 0 && shouldHaveData ) {
                         result.append( "cmd" , cmd );
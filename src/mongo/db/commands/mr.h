@@ -104,6 +104,11 @@ namespace mongo {
 
             virtual void init( State * state );
 
+            /**
+             * compiles the function in the given scope, which is not owned
+             */
+            void init( Scope * scope );
+
             Scope * scope() const { return _scope; }
             ScriptingFunction func() const { return _func; }
 
@@ -121,6 +126,7 @@ namespace mongo {
             JSMapper( const BSONElement & code ) : _func( "_map" , code ) {}
             virtual void map( const BSONObj& o );
             virtual void init( State * state );
+            void init( Scope * scope , const BSONObj& params );
 
         private:
             JSFunction _func;
@@ -131,6 +137,7 @@ namespace mongo {
         public:
             JSReducer( const BSONElement& code ) : _func( "_reduce" , code ) {}
             virtual void init( State * state );
+            void init( Scope * scope ) { _func.init( scope ); }
 
             virtual BSONObj reduce( const BSONList& tuples );
             virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
@@ -152,6 +159,7 @@ namespace mongo {
             JSFinalizer( const BSONElement& code ) : _func( "_finalize" , code ) {}
             virtual BSONObj finalize( const BSONObj& o );
             virtual void init( State * state ) { _func.init( state ); }
+            void init( Scope * scope ) { _func.init( scope ); }
         private:
             JSFunction _func;
 
@@ -200,6 +208,10 @@ namespace mongo {
             BSONObj mapParams;
             BSONObj scopeSetup;
 
+            // owned copy of the map, reduce and finalize code, so that each thread of a parallel
+            // job can compile its own copy of the functions
+            BSONObj functionCode;
+
             // output tables
             std::string incLong;
             std::string tempNamespace;
@@ -231,6 +243,9 @@ namespace mongo {
             // true when called from mongos to do phase-1 of M/R
             bool shardedFirstPass;
 
+            // number of threads to map and reduce with, 1 for the single threaded path
+            int parallelism;
+
             static AtomicUInt32 JOB_NUMBER;
         }; // end MRsetup
 
@@ -290,6 +305,17 @@ namespace mongo {
 
             void finalReduce( CurOp * op , ProgressMeterHolder& pm );
 
+            /**
+             * Stores a fully reduced and finalized {_id: key, value: val} result produced outside
+             * of this State, i.e. by the parallel execution mode. Keys must be unique.
+             */
+            void addFinalResult( const BSONObj& res );
+
+            /**
+             * Accounts for emits and reduces done outside of this State.
+             */
+            void addCounts( long long numEmits , long long numReduces );
+
             // ------- cleanup/data positioning ----------
 
             /**
@@ -368,6 +394,11 @@ namespace mongo {
             ScriptingFunction _reduceAndFinalizeAndInsert;
         };
 
+        /**
+         * Validates the arguments of a call to emit() and returns them as a (key, value) tuple
+         */
+        BSONObj emitArgsToTuple( const BSONObj& args );
+
         BSONObj fast_emit( const BSONObj& args, void* data );
         BSONObj _bailFromJS( const BSONObj& args, void* data );
 
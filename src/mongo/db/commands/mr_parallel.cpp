@@ -0,0 +1,598 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kCommand
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/commands/mr_parallel.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/hasher.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/scripting/engine.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using boost::shared_ptr;
+    using std::string;
+    using std::vector;
+
+    namespace mr {
+
+        /**
+         * Spilled tuples are sorted under their key, wrapped in its own object, so that they
+         * can be grouped by key for the reduce.
+         */
+        typedef Sorter<BSONObj, BSONObj> TupleSorter;
+
+        class TupleSorterComparison {
+        public:
+            int operator()(const TupleSorter::Data& lhs, const TupleSorter::Data& rhs) const {
+                return lhs.first.firstElement().woCompare(rhs.first.firstElement(), false);
+            }
+        };
+
+    namespace {
+
+        // number of input documents handed to a worker at a time
+        const size_t kBatchSize = 100;
+
+        // batches queued per worker before the scan waits for the workers
+        const size_t kQueuedBatchesPerWorker = 4;
+
+        // reduced results queued before the workers wait for them to be stored
+        const size_t kMaxQueuedResults = 1000;
+
+        // memory shared by all partitions before they spill to disk
+        const size_t kSortMemoryBytes = 100 * 1024 * 1024;
+
+    } // namespace
+
+        struct ParallelMapReduce::Partition {
+            boost::mutex mutex;  // protects adding to the sorter during the map phase
+            boost::scoped_ptr<TupleSorter> sorter;
+        };
+
+        /**
+         * A thread with its own JS scope which maps batches of input documents and then reduces
+         * one partition.
+         */
+        class ParallelMapReduce::Worker {
+            MONGO_DISALLOW_COPYING(Worker);
+        public:
+            Worker(ParallelMapReduce* parent, size_t id)
+                : _parent(parent),
+                  _id(id),
+                  _threadName(str::stream() << "mrWorker" << id),
+                  _size(0),
+                  _dupCount(0),
+                  _numEmits(0),
+                  _numReduces(0),
+                  _numSpilled(0),
+                  _spillMicros(0),
+                  _sortMicros(0) {
+            }
+
+            void start() {
+                _thread.reset(new boost::thread(stdx::bind(&Worker::run, this)));
+            }
+
+            void join() {
+                if (_thread)
+                    _thread->join();
+            }
+
+            // only valid once the corresponding phase is over
+            long long numEmits() const { return _numEmits; }
+            long long numReduces() const { return _numReduces; }
+            long long numSpilled() const { return _numSpilled; }
+            long long spillMicros() const { return _spillMicros; }
+            long long sortMicros() const { return _sortMicros; }
+
+        private:
+            static BSONObj _emit(const BSONObj& args, void* data) {
+                Worker* worker = static_cast<Worker*>(data);
+                worker->_numEmits++;
+                worker->_size += worker->_add(&worker->_temp, emitArgsToTuple(args));
+                return BSONObj();
+            }
+
+            void run() {
+                Client::initThread(_threadName.c_str());
+                AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+                OperationContextImpl txn;
+                _parent->_registerWorkerOp(txn.getOpID());
+
+                Status status = Status::OK();
+                try {
+                    _run(&txn);
+                }
+                catch (const DBException& e) {
+                    status = e.toStatus();
+                }
+                catch (const std::exception& e) {
+                    status = Status(ErrorCodes::InternalError, e.what());
+                }
+
+                if (_reducer)
+                    _numReduces = _reducer->numReduces;
+                _temp.clear();
+                _mapper.reset();
+                _reducer.reset();
+                _finalizer.reset();
+                // the scope goes back to the pool and must not outlive the operation
+                _scope.reset();
+
+                if (!status.isOK()) {
+                    LOG(1) << "M/R: " << _threadName << " failed: " << status;
+                }
+                _parent->_workerDone(status);
+            }
+
+            void _run(OperationContext* txn) {
+                const Config& config = _parent->_state->config();
+
+                _scope.reset(globalScriptEngine->getPooledScope(
+                                txn, config.dbname, _parent->_scopeType).release());
+                if ( ! config.scopeSetup.isEmpty() )
+                    _scope->init( &config.scopeSetup );
+
+                _mapper.reset(new JSMapper(config.functionCode["map"]));
+                _mapper->init(_scope.get(), config.mapParams);
+                _reducer.reset(new JSReducer(config.functionCode["reduce"]));
+                _reducer->init(_scope.get());
+                if (config.finalizer) {
+                    _finalizer.reset(new JSFinalizer(config.functionCode["finalize"]));
+                    _finalizer->init(_scope.get());
+                }
+                _scope->injectNative("emit", _emit, this);
+
+                // workers run with internal privileges, so user code must not reach the database
+                Scope::NoDBAccess no = _scope->disableDBAccess(
+                                            "can't access db inside a parallel map/reduce");
+
+                BSONList batch;
+                while (_parent->_nextBatch(&batch)) {
+                    for (BSONList::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+                        _mapper->map(*it);
+                        _reduceAndSpillIfNeeded(config);
+                    }
+                    batch.clear();
+                    txn->checkForInterrupt();
+                }
+
+                // everything left in memory goes to the partitions, which are reduced in turn
+                _reduceInMemory();
+                _spill();
+                _parent->_waitForMapPhase();
+
+                _reducePartition(txn);
+            }
+
+            long _add(InMemory* im, const BSONObj& tuple) {
+                BSONList& all = (*im)[tuple];
+                all.push_back(tuple);
+                if (all.size() > 1) {
+                    ++_dupCount;
+                }
+                return tuple.objsize() + 16;
+            }
+
+            /**
+             * Same policy as State::reduceAndSpillInMemoryStateIfNeeded(), with the partitions
+             * taking the place of the inc collection.
+             */
+            void _reduceAndSpillIfNeeded(const Config& config) {
+                if (_size <= config.maxInMemSize &&
+                        _dupCount <= (_temp.size() * config.reduceTriggerRatio)) {
+                    return;
+                }
+
+                long oldSize = _size;
+                _reduceInMemory();
+                if (_size > config.maxInMemSize || _size > oldSize / 2) {
+                    _spill();
+                }
+            }
+
+            void _reduceInMemory() {
+                InMemory reduced;
+                long size = 0;
+                _dupCount = 0;
+
+                for (InMemory::iterator i = _temp.begin(); i != _temp.end(); ++i) {
+                    BSONList& all = i->second;
+                    size += _add(&reduced, all.size() == 1 ? all[0] : _reducer->reduce(all));
+                }
+
+                _temp.swap(reduced);
+                _size = size;
+            }
+
+            void _spill() {
+                if (_temp.empty())
+                    return;
+
+                Timer t;
+                vector<BSONList> tuplesByPartition(_parent->_numWorkers);
+                for (InMemory::iterator i = _temp.begin(); i != _temp.end(); ++i) {
+                    BSONList& partition = tuplesByPartition[_parent->_partitionFor(i->first)];
+                    partition.insert(partition.end(), i->second.begin(), i->second.end());
+                    _numSpilled += i->second.size();
+                }
+                _temp.clear();
+                _size = 0;
+                _dupCount = 0;
+
+                _parent->_spill(&tuplesByPartition);
+                _spillMicros += t.micros();
+            }
+
+            /**
+             * Sorts this worker's partition and hands back one final result per key.
+             */
+            void _reducePartition(OperationContext* txn) {
+                Timer t;
+                boost::scoped_ptr<TupleSorter::Iterator> it(
+                                            _parent->_partition(_id)->sorter->done());
+                _sortMicros = t.micros();
+
+                BSONObj key;
+                BSONList all;
+                BSONList results;
+                while (it->more()) {
+                    TupleSorter::Data data = it->next();
+                    if (!all.empty() &&
+                            data.first.firstElement().woCompare(key.firstElement(), false) != 0) {
+                        results.push_back(_reducer->finalReduce(all, _finalizer.get()));
+                        all.clear();
+
+                        if (results.size() >= kBatchSize) {
+                            _parent->_addResults(&results);
+                            txn->checkForInterrupt();
+                        }
+                    }
+
+                    if (all.empty())
+                        key = data.first.getOwned();
+                    all.push_back(data.second.getOwned());
+                }
+
+                if (!all.empty())
+                    results.push_back(_reducer->finalReduce(all, _finalizer.get()));
+                _parent->_addResults(&results);
+            }
+
+            ParallelMapReduce* const _parent;
+            const size_t _id;
+            const string _threadName;
+            boost::scoped_ptr<boost::thread> _thread;
+
+            boost::scoped_ptr<Scope> _scope;
+            boost::scoped_ptr<JSMapper> _mapper;
+            boost::scoped_ptr<JSReducer> _reducer;
+            boost::scoped_ptr<JSFinalizer> _finalizer;
+
+            InMemory _temp;
+            long _size; // bytes in _temp
+            long _dupCount; // number of duplicate key entries
+
+            long long _numEmits;
+            long long _numReduces;
+            long long _numSpilled;
+            long long _spillMicros;
+            long long _sortMicros;
+        };
+
+        ParallelMapReduce::ParallelMapReduce(OperationContext* txn, State* state)
+            : _txn(txn),
+              _state(state),
+              _numWorkers(state->config().parallelism),
+              _scopeType("mapreduce" + AuthorizationSession::get(ClientBasic::getCurrent())
+                                                        ->getAuthenticatedUserNamesToken()),
+              _inputDone(false),
+              _numMapping(0),
+              _numRunning(0),
+              _status(Status::OK()),
+              _mapMillis(0),
+              _reduceMillis(0) {
+
+            invariant(_numWorkers > 0);
+
+            const SortOptions opts = SortOptions()
+                                        .TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                        .ExtSortAllowed()
+                                        .MaxMemoryUsageBytes(kSortMemoryBytes / _numWorkers);
+
+            for (int i = 0; i < _numWorkers; i++) {
+                shared_ptr<Partition> partition(new Partition());
+                partition->sorter.reset(TupleSorter::make(opts, TupleSorterComparison()));
+                _partitions.push_back(partition);
+                _workers.push_back(shared_ptr<Worker>(new Worker(this, i)));
+            }
+        }
+
+        ParallelMapReduce::~ParallelMapReduce() {
+            vector<unsigned int> workerOps;
+            {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                if (_numRunning > 0) {
+                    if (_status.isOK()) {
+                        _status = Status(ErrorCodes::Interrupted, "map/reduce was aborted");
+                    }
+                    workerOps = _workerOps;
+                }
+                _cv.notify_all();
+            }
+
+            // interrupt workers that are busy running JS
+            for (size_t i = 0; i < workerOps.size(); i++) {
+                getGlobalServiceContext()->killOperation(workerOps[i]);
+            }
+
+            for (size_t i = 0; i < _workers.size(); i++) {
+                _workers[i]->join();
+            }
+        }
+
+        bool ParallelMapReduce::canRunInParallel(const Config& config) {
+            return config.parallelism > 1
+                && !config.jsMode
+                && config.sort.isEmpty()
+                && config.limit == 0;
+        }
+
+        void ParallelMapReduce::start() {
+            {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                _numMapping = _numWorkers;
+                _numRunning = _numWorkers;
+            }
+
+            _timer.reset();
+            for (size_t i = 0; i < _workers.size(); i++) {
+                _workers[i]->start();
+            }
+        }
+
+        void ParallelMapReduce::map(const BSONObj& doc) {
+            _batch.push_back(doc.getOwned());
+            if (_batch.size() >= kBatchSize) {
+                _pushBatch();
+            }
+        }
+
+        void ParallelMapReduce::finishMapPhase() {
+            if (!_batch.empty()) {
+                _pushBatch();
+            }
+
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _inputDone = true;
+            _cv.notify_all();
+            while (_status.isOK() && _numMapping > 0) {
+                _wait(lk);
+            }
+            _checkFailed();
+
+            _mapMillis = _timer.millis();
+        }
+
+        void ParallelMapReduce::reduce(CurOp* op, ProgressMeterHolder& pm) {
+            invariant(!_txn->lockState()->isLocked());
+
+            Timer t;
+            verify(pm == op->setMessage("m/r: (3/3) parallel reduce",
+                                        "M/R: (3/3) Parallel Reduce Progress",
+                                        1));
+            pm->showTotal(false);
+
+            BSONList results;
+            while (true) {
+                {
+                    boost::unique_lock<boost::mutex> lk(_mutex);
+                    while (_status.isOK() && _output.empty() && _numRunning > 0) {
+                        _wait(lk);
+                    }
+                    _checkFailed();
+
+                    if (_output.empty())
+                        break;
+
+                    results.swap(_output);
+                    _cv.notify_all();
+                }
+
+                for (BSONList::const_iterator it = results.begin(); it != results.end(); ++it) {
+                    _state->addFinalResult(*it);
+                    pm.hit();
+                }
+                results.clear();
+                _txn->checkForInterrupt();
+            }
+            pm.finished();
+
+            for (size_t i = 0; i < _workers.size(); i++) {
+                _workers[i]->join();
+            }
+
+            _reduceMillis = t.millis();
+        }
+
+        long long ParallelMapReduce::numEmits() const {
+            long long n = 0;
+            for (size_t i = 0; i < _workers.size(); i++) {
+                n += _workers[i]->numEmits();
+            }
+            return n;
+        }
+
+        long long ParallelMapReduce::numReduces() const {
+            long long n = 0;
+            for (size_t i = 0; i < _workers.size(); i++) {
+                n += _workers[i]->numReduces();
+            }
+            return n;
+        }
+
+        void ParallelMapReduce::appendStats(BSONObjBuilder* builder) const {
+            long long numSpilled = 0;
+            long long spillMicros = 0;
+            long long sortMicros = 0;
+            for (size_t i = 0; i < _workers.size(); i++) {
+                numSpilled += _workers[i]->numSpilled();
+                spillMicros += _workers[i]->spillMicros();
+                sortMicros += _workers[i]->sortMicros();
+            }
+
+            builder->append("threads", _numWorkers);
+            builder->appendNumber("spilled", numSpilled);
+
+            // map and reduce are wall clock times, spill and sort are summed over the workers
+            BSONObjBuilder timing(builder->subobjStart("timing"));
+            timing.appendNumber("mapMillis", _mapMillis);
+            timing.appendNumber("spillMillis", spillMicros / 1000);
+            timing.appendNumber("sortMillis", sortMicros / 1000);
+            timing.appendNumber("reduceMillis", _reduceMillis);
+            timing.done();
+        }
+
+        void ParallelMapReduce::_registerWorkerOp(unsigned int opId) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _workerOps.push_back(opId);
+        }
+
+        bool ParallelMapReduce::_nextBatch(BSONList* batch) {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            while (_status.isOK() && _input.empty() && !_inputDone) {
+                _cv.wait(lk);
+            }
+            _checkFailed();
+
+            if (_input.empty())
+                return false;
+
+            batch->swap(_input.front());
+            _input.pop_front();
+            _cv.notify_all();
+            return true;
+        }
+
+        void ParallelMapReduce::_spill(vector<BSONList>* tuplesByPartition) {
+            for (size_t i = 0; i < tuplesByPartition->size(); i++) {
+                const BSONList& tuples = (*tuplesByPartition)[i];
+                if (tuples.empty())
+                    continue;
+
+                Partition* partition = _partitions[i].get();
+                boost::lock_guard<boost::mutex> lk(partition->mutex);
+                for (BSONList::const_iterator it = tuples.begin(); it != tuples.end(); ++it) {
+                    partition->sorter->add(it->firstElement().wrap(), *it);
+                }
+            }
+        }
+
+        size_t ParallelMapReduce::_partitionFor(const BSONObj& tuple) const {
+            // keys that compare equal hash equally, so each key is reduced by a single worker
+            const unsigned long long hash =
+                BSONElementHasher::hash64(tuple.firstElement(),
+                                          BSONElementHasher::DEFAULT_HASH_SEED);
+            return hash % _numWorkers;
+        }
+
+        void ParallelMapReduce::_waitForMapPhase() {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _numMapping--;
+            _cv.notify_all();
+            while (_status.isOK() && _numMapping > 0) {
+                _cv.wait(lk);
+            }
+            _checkFailed();
+        }
+
+        void ParallelMapReduce::_addResults(BSONList* results) {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            while (_status.isOK()
+                    && !_output.empty()
+                    && _output.size() + results->size() > kMaxQueuedResults) {
+                _cv.wait(lk);
+            }
+            _checkFailed();
+
+            _output.insert(_output.end(), results->begin(), results->end());
+            results->clear();
+            _cv.notify_all();
+        }
+
+        void ParallelMapReduce::_workerDone(const Status& status) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _numRunning--;
+            if (!status.isOK() && _status.isOK()) {
+                _status = status;
+            }
+            _cv.notify_all();
+        }
+
+        void ParallelMapReduce::_checkFailed() {
+            uassertStatusOK(_status);
+        }
+
+        void ParallelMapReduce::_pushBatch() {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            while (_status.isOK() && _input.size() >= kQueuedBatchesPerWorker * _numWorkers) {
+                _wait(lk);
+            }
+            _checkFailed();
+
+            _input.push_back(BSONList());
+            _input.back().swap(_batch);
+            _cv.notify_all();
+        }
+
+        void ParallelMapReduce::_wait(boost::unique_lock<boost::mutex>& lk) {
+            _cv.timed_wait(lk, boost::posix_time::milliseconds(100));
+            _txn->checkForInterrupt();
+        }
+
+    } // namespace mr
+} // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::BSONObj, mongo::mr::TupleSorterComparison);
@@ -0,0 +1,168 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/db/commands/mr.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class CurOp;
+    class OperationContext;
+    class ProgressMeterHolder;
+
+    namespace mr {
+
+        /**
+         * Runs the map and reduce phases of a map/reduce job on several threads.
+         *
+         * The thread that owns the State scans the input and hands documents to the workers in
+         * batches. Each worker maps them in its own JS scope, combining emits in a private
+         * in-memory map which is reduced when it grows and, if that is not enough, spilled into
+         * hash partitions of the emitted keys. Partitions are external Sorters, so spilled data
+         * goes to files under the dbpath rather than to an incremental collection. Once every
+         * worker is done mapping, worker i sorts, reduces and finalizes partition i, and the
+         * owning thread stores the results through the State.
+         *
+         * Only mixed mode jobs without sort or limit can run in parallel, see canRunInParallel().
+         * Map functions can't access the database in this mode.
+         */
+        class ParallelMapReduce {
+            MONGO_DISALLOW_COPYING(ParallelMapReduce);
+        public:
+            /**
+             * 'txn' and 'state' must outlive this object. state->init() must have been called.
+             */
+            ParallelMapReduce(OperationContext* txn, State* state);
+
+            /**
+             * Interrupts and joins any workers that are still running.
+             */
+            ~ParallelMapReduce();
+
+            static bool canRunInParallel(const Config& config);
+
+            /**
+             * Starts the worker threads.
+             */
+            void start();
+
+            /**
+             * Queues an input document for mapping. Blocks while the workers are behind, and
+             * throws if one of them failed.
+             */
+            void map(const BSONObj& doc);
+
+            /**
+             * Waits until every queued document has been mapped and spilled into a partition.
+             */
+            void finishMapPhase();
+
+            /**
+             * Reduces and finalizes all partitions, storing the results through the State.
+             * Must be called without any locks held.
+             */
+            void reduce(CurOp* op, ProgressMeterHolder& pm);
+
+            long long numEmits() const;
+            long long numReduces() const;
+
+            /**
+             * Appends the number of threads and the time spent in each phase.
+             */
+            void appendStats(BSONObjBuilder* builder) const;
+
+        private:
+            class Worker;
+            struct Partition;
+
+            // ---- called by workers -----
+
+            void _registerWorkerOp(unsigned int opId);
+            bool _nextBatch(BSONList* batch);
+            void _spill(std::vector<BSONList>* tuplesByPartition);
+            size_t _partitionFor(const BSONObj& tuple) const;
+            Partition* _partition(size_t i) { return _partitions[i].get(); }
+            void _waitForMapPhase();
+            void _addResults(BSONList* results);
+            void _workerDone(const Status& status);
+
+            /**
+             * Throws the first worker failure. Must be called with _mutex held.
+             */
+            void _checkFailed();
+
+            void _pushBatch();
+
+            /**
+             * Waits for a change signaled on _cv by the workers, checking for interruption of
+             * the job while waiting.
+             */
+            void _wait(boost::unique_lock<boost::mutex>& lk);
+
+            OperationContext* const _txn;
+            State* const _state;
+            const int _numWorkers;
+            const std::string _scopeType;
+
+            std::vector<boost::shared_ptr<Worker> > _workers;
+            std::vector<boost::shared_ptr<Partition> > _partitions;
+
+            // only touched by the thread that owns the State
+            BSONList _batch;
+
+            mutable boost::mutex _mutex;
+            boost::condition_variable _cv;  // signaled on any change of the fields below
+
+            std::deque<BSONList> _input;
+            bool _inputDone;
+            BSONList _output;
+            int _numMapping;
+            int _numRunning;
+            std::vector<unsigned int> _workerOps;
+            Status _status;  // first failure, aborts the job
+
+            Timer _timer;
+            long long _mapMillis;
+            long long _reduceMillis;
+        };
+
+    } // namespace mr
+} // namespace mongo
@@ -158,4 +158,32 @@ namespace {
                                       "mydb2", "", "", false, mr::Config::INMEMORY);
     }
 
+    /**
+     * Tests for the 'parallelism' option of mr::Config.
+     */
+    TEST(ConfigParallelismTest, ParseParallelism) {
+        const char* base = "mapReduce: 'mycoll', map: 'function() {}', reduce: 'function() {}', "
+                           "out: {inline: 1}";
+
+        // Single threaded unless requested.
+        ASSERT_EQUALS(1, mr::Config("mydb", fromjson(str::stream() << "{" << base << "}"))
+                             .parallelism);
+        ASSERT_EQUALS(4, mr::Config("mydb",
+                                    fromjson(str::stream() << "{" << base << ", parallelism: 4}"))
+                             .parallelism);
+
+        // Capped by internalMapReduceMaxParallelism.
+        ASSERT_EQUALS(16, mr::Config("mydb",
+                                     fromjson(str::stream() << "{" << base
+                                                            << ", parallelism: 1000}"))
+                              .parallelism);
+
+        ASSERT_THROWS(mr::Config("mydb",
+                                 fromjson(str::stream() << "{" << base << ", parallelism: 0}")),
+                      UserException);
+        ASSERT_THROWS(mr::Config("mydb",
+                                 fromjson(str::stream() << "{" << base << ", parallelism: 'a'}")),
+                      UserException);
+    }
+
 }  // namespace
@@ -60,7 +60,7 @@ namespace mongo {
         virtual bool isWriteCommandForConfigServer() const { return false; }
         virtual bool adminOnly() const { return false; }
         virtual bool slaveOk() const { return true; }
-        virtual bool maintenanceMode() const { return true; }
+        virtual bool maintenanceMode(const BSONObj& cmdObj) const { return true; }
         virtual void help( stringstream& help ) const {
             help << "touch collection\n"
                 "Page in all pages of memory containing every extent for the given collection\n"
@@ -41,6 +41,7 @@
 #include <signal.h>
 #include <string>
 
+#include "mongo/base/counter.h"
 #include "mongo/base/init.h"
 #include "mongo/base/initializer.h"
 #include "mongo/base/status.h"
@@ -55,12 +56,14 @@
 #include "mongo/db/catalog/index_key_validate.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/db.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/dbwebserver.h"
+#include "mongo/db/ftdc/ftdc_mongod.h"
 #include "mongo/db/service_context_d.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/index_names.h"
@@ -74,8 +77,10 @@
 #include "mongo/db/op_observer.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/plan_cache_persistence.h"
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repair_database.h"
+#include "mongo/db/repl/network_interface_async.h"
 #include "mongo/db/repl/network_interface_impl.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_settings.h"
@@ -94,7 +99,9 @@
 #include "mongo/db/ttl.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/scripting/engine.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/cmdline_utils/censor_cmdline.h"
 #include "mongo/util/concurrency/task.h"
@@ -104,6 +111,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/net/ssl_options.h"
 #include "mongo/util/ntservice.h"
 #include "mongo/util/options_parser/startup_options.h"
 #include "mongo/util/quick_exit.h"
@@ -114,6 +122,7 @@
 #include "mongo/util/startup_test.h"
 #include "mongo/util/text.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 #include "mongo/util/version.h"
 
 #if !defined(_WIN32)
@@ -147,6 +156,21 @@ namespace mongo {
 
     Timer startupSrandTimer;
 
+    // How long each phase of startup took, in milliseconds.
+    static Counter64 startupStorageEngineMillis;
+    static Counter64 startupRepairMillis;
+    static Counter64 startupOpenDatabasesMillis;
+    static Counter64 startupCheckDatabasesMillis;
+
+    static ServerStatusMetricField<Counter64> displayStartupStorageEngineMillis(
+            "startup.storageEngineInitMillis", &startupStorageEngineMillis);
+    static ServerStatusMetricField<Counter64> displayStartupRepairMillis(
+            "startup.repairMillis", &startupRepairMillis);
+    static ServerStatusMetricField<Counter64> displayStartupOpenDatabasesMillis(
+            "startup.openDatabasesMillis", &startupOpenDatabasesMillis);
+    static ServerStatusMetricField<Counter64> displayStartupCheckDatabasesMillis(
+            "startup.checkDatabasesMillis", &startupCheckDatabasesMillis);
+
     QueryResult::View emptyMoreResult(long long);
 
     class MyMessageHandler : public MessageHandler {
@@ -291,28 +315,123 @@ namespace mongo {
         return 0;
     }
 
+    /**
+     * Opens every 'step'th database of 'dbNames', starting with 'first'. Databases whose files
+     * are in a format this version can't use are left for repairDatabasesAndCheckVersion() to
+     * report. Errors are returned through 'status'.
+     */
+    static void openDatabases(OperationContext* txn,
+                              const vector<string>* dbNames,
+                              size_t first,
+                              size_t step,
+                              Status* status) {
+        StorageEngine* storageEngine = getGlobalServiceContext()->getGlobalStorageEngine();
+
+        try {
+            for (size_t i = first; i < dbNames->size(); i += step) {
+                const string& dbName = (*dbNames)[i];
+                LOG(1) << "    Opening database: " << dbName << endl;
+
+                ScopedTransaction transaction(txn, MODE_IX);
+                Lock::DBLock lk(txn->lockState(), dbName, MODE_X);
+                if (!storageEngine->getDatabaseCatalogEntry(txn, dbName)
+                        ->currentFilesCompatible(txn)) {
+                    continue;
+                }
+
+                invariant(dbHolder().openDb(txn, dbName));
+            }
+        }
+        catch (const DBException& e) {
+            *status = e.toStatus();
+        }
+    }
+
+    static void openDatabasesOnNewThread(const vector<string>* dbNames,
+                                         size_t first,
+                                         size_t step,
+                                         Status* status) {
+        const string desc = str::stream() << "startupOpenDatabases" << first;
+        Client::initThread(desc.c_str());
+
+        OperationContextImpl txn;
+        openDatabases(&txn, dbNames, first, step, status);
+    }
+
+    /**
+     * Opens all of 'dbNames' using up to storageGlobalParams.startupLoadThreads threads. Must be
+     * called before any client can connect, without holding any locks. 'txn' is only used if
+     * there is a single thread.
+     */
+    static void openDatabasesInParallel(OperationContext* txn, const vector<string>& dbNames) {
+        const size_t maxThreads = std::max(1, storageGlobalParams.startupLoadThreads);
+        const size_t numThreads = std::max(size_t(1), std::min(dbNames.size(), maxThreads));
+
+        vector<Status> statuses(numThreads, Status::OK());
+        if (numThreads == 1) {
+            openDatabases(txn, &dbNames, 0, 1, &statuses[0]);
+        }
+        else {
+            vector<boost::shared_ptr<stdx::thread> > threads;
+            for (size_t i = 0; i < numThreads; i++) {
+                threads.push_back(boost::shared_ptr<stdx::thread>(
+                    new stdx::thread(stdx::bind(&openDatabasesOnNewThread,
+                                                &dbNames,
+                                                i,
+                                                numThreads,
+                                                &statuses[i]))));
+            }
+            for (size_t i = 0; i < threads.size(); i++) {
+                threads[i]->join();
+            }
+        }
+
+        for (size_t i = 0; i < statuses.size(); i++) {
+            uassertStatusOK(statuses[i]);
+        }
+    }
+
     static void repairDatabasesAndCheckVersion() {
         LOG(1) << "enter repairDatabases (to check pdfile version #)" << endl;
 
         OperationContextImpl txn;
-        ScopedTransaction transaction(&txn, MODE_X);
-        Lock::GlobalWrite lk(txn.lockState());
-
         vector<string> dbNames;
 
         StorageEngine* storageEngine = getGlobalServiceContext()->getGlobalStorageEngine();
-        storageEngine->listDatabases( &dbNames );
 
-        // Repair all databases first, so that we do not try to open them if they are in bad shape
-        if (storageGlobalParams.repair) {
-            for (vector<string>::const_iterator i = dbNames.begin(); i != dbNames.end(); ++i) {
-                const string dbName = *i;
-                LOG(1) << "    Repairing database: " << dbName << endl;
+        {
+            ScopedTransaction transaction(&txn, MODE_X);
+            Lock::GlobalWrite lk(txn.lockState());
+
+            storageEngine->listDatabases( &dbNames );
+
+            // Repair all databases first, so that we do not try to open them if they are in bad
+            // shape
+            if (storageGlobalParams.repair) {
+                Timer repairTimer;
+                for (vector<string>::const_iterator i = dbNames.begin(); i != dbNames.end(); ++i) {
+                    const string dbName = *i;
+                    LOG(1) << "    Repairing database: " << dbName << endl;
 
-                fassert(18506, repairDatabase(&txn, storageEngine, dbName));
+                    fassert(18506, repairDatabase(&txn, storageEngine, dbName));
+                }
+                startupRepairMillis.increment(repairTimer.millis());
+                log() << "repaired " << dbNames.size() << " databases in "
+                      << repairTimer.millis() << "ms";
             }
         }
 
+        // No client can connect yet, so the databases can be opened on several threads, each only
+        // locking the database it opens. The checks below then find them already open.
+        Timer openTimer;
+        openDatabasesInParallel(&txn, dbNames);
+        startupOpenDatabasesMillis.increment(openTimer.millis());
+        log() << "opened " << dbNames.size() << " databases in " << openTimer.millis() << "ms";
+
+        Timer checkTimer;
+        ScopedTransaction transaction(&txn, MODE_X);
+        Lock::GlobalWrite lk(txn.lockState());
+
         const repl::ReplSettings& replSettings =
             repl::getGlobalReplicationCoordinator()->getSettings();
 
@@ -390,6 +509,9 @@ namespace mongo {
             }
         }
 
+        startupCheckDatabasesMillis.increment(checkTimer.millis());
+        log() << "checked " << dbNames.size() << " databases in " << checkTimer.millis() << "ms";
+
         LOG(1) << "done repairDatabases" << endl;
     }
 
@@ -441,7 +563,13 @@ namespace mongo {
             }
         }
 
-        getGlobalServiceContext()->setGlobalStorageEngine(storageGlobalParams.engine);
+        {
+            Timer storageEngineTimer;
+            getGlobalServiceContext()->setGlobalStorageEngine(storageGlobalParams.engine);
+            startupStorageEngineMillis.increment(storageEngineTimer.millis());
+            log() << "initialized storage engine " << storageGlobalParams.engine << " in "
+                  << storageEngineTimer.millis() << "ms";
+        }
         getGlobalServiceContext()->setOpObserver(stdx::make_unique<OpObserver>());
 
         const repl::ReplSettings& replSettings =
@@ -586,10 +714,13 @@ namespace mongo {
                 startTTLBackgroundJob();
             }
 
+            startPlanCachePersistence(&txn);
         }
 
         startClientCursorMonitor();
 
+        startMongoDFTDC();
+
         PeriodicTask::startRunningPeriodicTasks();
 
         logStartup();
@@ -746,12 +877,29 @@ static void startupConfigActions(const std::vector<std::string>& args) {
 #endif
 }
 
-MONGO_INITIALIZER_WITH_PREREQUISITES(CreateReplicationManager, ("SetGlobalEnvironment"))
+static repl::ReplicationExecutor::NetworkInterface* makeReplNetworkInterface() {
+    if (!repl::replAsyncNetworkInterface) {
+        return new repl::NetworkInterfaceImpl;
+    }
+#ifdef MONGO_CONFIG_SSL
+    // The asynchronous network interface reads and writes the sockets itself.
+    const int sslMode = sslGlobalParams.sslMode.load();
+    if (sslMode == SSLParams::SSLMode_preferSSL || sslMode == SSLParams::SSLMode_requireSSL) {
+        warning() << "replAsyncNetworkInterface is not supported with SSL, using the "
+                  << "thread pool network interface for replication";
+        return new repl::NetworkInterfaceImpl;
+    }
+#endif
+    return new repl::NetworkInterfaceAsync;
+}
+
+MONGO_INITIALIZER_WITH_PREREQUISITES(CreateReplicationManager,
+                                     ("SetGlobalEnvironment", "EndStartupOptionStorage"))
         (InitializerContext* context) {
     repl::ReplicationCoordinatorImpl* replCoord = new repl::ReplicationCoordinatorImpl(
             getGlobalReplSettings(),
             new repl::ReplicationCoordinatorExternalStateImpl,
-            new repl::NetworkInterfaceImpl,
+            makeReplNetworkInterface(),
             new repl::TopologyCoordinatorImpl(Seconds(repl::maxSyncSourceLagSecs)),
             static_cast<int64_t>(curTimeMillis64()));
     repl::setGlobalReplicationCoordinator(replCoord);
@@ -218,7 +218,7 @@ namespace mongo {
         virtual bool slaveOk() const {
             return true;
         }
-        virtual bool maintenanceMode() const { return true; }
+        virtual bool maintenanceMode(const BSONObj& cmdObj) const { return true; }
         virtual void help( stringstream& help ) const {
             help << "repair database.  also compacts. note: slow.";
         }
@@ -355,6 +355,10 @@ namespace mongo {
                  int options,
                  string& errmsg,
                  BSONObjBuilder& result) {
+            // Entries of operations profiled at the old level are written before the level
+            // changes.
+            waitForProfileWrites(txn);
+
             // Needs to be locked exclusively, because creates the system.profile collection
             // in the local database.
             ScopedTransaction transaction(txn, MODE_IX);
@@ -1296,6 +1300,13 @@ namespace {
             return;
         }
 
+        // Commands that read or drop the profile collection should see the entries of every
+        // operation that finished before them.
+        const BSONElement firstArg = interposedCmd.firstElement();
+        if (firstArg.type() == String && firstArg.valueStringData() == "system.profile") {
+            waitForProfileWrites(txn);
+        }
+
         repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
 
         bool iAmPrimary = replCoord->canAcceptWritesForDatabase(dbname);
@@ -1357,7 +1368,7 @@ namespace {
 
         CurOp::get(txn)->setCommand(command);
 
-        if (command->maintenanceMode()) {
+        if (command->maintenanceMode(interposedCmd)) {
             mmSetter.reset(new MaintenanceModeSetter);
         }
 
@@ -37,9 +37,11 @@
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
 
+#include "mongo/base/counter.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/index_create.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/db.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -59,6 +61,7 @@
 #include "mongo/db/range_arithmetic.h"
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/db/write_concern_options.h"
@@ -66,6 +69,7 @@
 #include "mongo/s/shard_key_pattern.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -310,6 +314,109 @@ namespace mongo {
         return true;
     }
 
+    namespace {
+
+        // Number of documents removeRange() deletes in each write unit of work.
+        MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterBatchSize, int, 128);
+
+        // Upper bound on the rate at which removeRange() deletes documents; 0 means unbounded.
+        MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxDocsPerSecond, int, 0);
+
+        // When this node is a replica set primary, removeRange() pauses between batches while
+        // the majority committed optime trails the node's last optime by more than this many
+        // seconds; 0 disables the check.
+        MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxReplicationLagSecs, int, 0);
+
+        Counter64 rangeDeleterDocsDeleted;
+        Counter64 rangeDeleterBatches;
+        Counter64 rangeDeleterReplicationWaitMillis;
+        Counter64 rangeDeleterThrottleMillis;
+
+        ServerStatusMetricField<Counter64> displayRangeDeleterDocsDeleted(
+                                                "rangeDeleter.docsDeleted",
+                                                &rangeDeleterDocsDeleted );
+        ServerStatusMetricField<Counter64> displayRangeDeleterBatches(
+                                                "rangeDeleter.batches",
+                                                &rangeDeleterBatches );
+        ServerStatusMetricField<Counter64> displayRangeDeleterReplicationWaitMillis(
+                                                "rangeDeleter.replicationWaitMillis",
+                                                &rangeDeleterReplicationWaitMillis );
+        ServerStatusMetricField<Counter64> displayRangeDeleterThrottleMillis(
+                                                "rangeDeleter.throttleMillis",
+                                                &rangeDeleterThrottleMillis );
+
+        /**
+         * Returns how many seconds the majority committed optime trails this node's last optime,
+         * or 0 if that isn't known, e.g. because this node is not a replica set primary.
+         */
+        long long getReplicationLagSecs() {
+            repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
+            if (replCoord->getReplicationMode() != repl::ReplicationCoordinator::modeReplSet) {
+                return 0;
+            }
+
+            const repl::OpTime lastCommitted = replCoord->getLastCommittedOpTime();
+            if (lastCommitted.isNull()) {
+                return 0;
+            }
+
+            return std::max(0LL, replCoord->getMyLastOptime().getSecs() - lastCommitted.getSecs());
+        }
+
+        /**
+         * Blocks, without holding any locks, until replication lag is back within
+         * rangeDeleterMaxReplicationLagSecs or this node can no longer write to 'ns'.  Returns
+         * the time spent waiting.
+         */
+        Milliseconds waitForReplicationLagBudget(OperationContext* txn, const string& ns) {
+            const long long maxLagSecs = rangeDeleterMaxReplicationLagSecs;
+            if (maxLagSecs <= 0) {
+                return Milliseconds(0);
+            }
+
+            Timer waitTimer;
+            bool logged = false;
+            while (getReplicationLagSecs() > maxLagSecs &&
+                   repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(ns)) {
+                if (!logged) {
+                    LOG(1) << "range deletion in " << ns << " waiting for replication lag to "
+                           << "drop below " << maxLagSecs << " seconds";
+                    logged = true;
+                }
+                txn->checkForInterrupt();
+                sleepmillis(100);
+            }
+
+            const Milliseconds waited(waitTimer.millis());
+            rangeDeleterReplicationWaitMillis.increment(durationCount<Milliseconds>(waited));
+            return waited;
+        }
+
+        /**
+         * Sleeps for as long as it takes to bring the average rate of 'numDeleted' documents
+         * since 'rangeTimer' started back down to rangeDeleterMaxDocsPerSecond.
+         */
+        void throttleRangeDeletion(OperationContext* txn,
+                                   long long numDeleted,
+                                   const Timer& rangeTimer) {
+            const long long maxDocsPerSecond = rangeDeleterMaxDocsPerSecond;
+            if (maxDocsPerSecond <= 0) {
+                return;
+            }
+
+            const long long targetMillis = numDeleted * 1000 / maxDocsPerSecond;
+            const long long sleepMillis = targetMillis - rangeTimer.millis();
+            if (sleepMillis <= 0) {
+                return;
+            }
+
+            txn->checkForInterrupt();
+            sleepmillis(sleepMillis);
+            rangeDeleterThrottleMillis.increment(sleepMillis);
+        }
+
+    } // namespace
+
     long long Helpers::removeRange( OperationContext* txn,
                                     const KeyRange& range,
                                     bool maxInclusive,
@@ -352,10 +459,14 @@ namespace mongo {
                << " with write concern: " << writeConcern.toBSON() << endl;
 
         long long numDeleted = 0;
-        
+        bool done = false;
+
         Milliseconds millisWaitingForReplication{0};
 
-        while ( 1 ) {
+        while ( !done ) {
+            const int batchSize = std::max( 1, rangeDeleterBatchSize );
+            int batchDeleted = 0;
+
             // Scoping for write lock.
             {
                 OldClientWriteContext ctx(txn, ns);
@@ -367,39 +478,51 @@ namespace mongo {
                     collection->getIndexCatalog()->findIndexByKeyPattern( txn,
                                                                           indexKeyPattern.toBSON() );
 
-                auto_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn, collection, desc,
-                                                                       min, max,
-                                                                       maxInclusive,
-                                                                       InternalPlanner::FORWARD,
-                                                                       InternalPlanner::IXSCAN_FETCH));
-                exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
-
-                RecordId rloc;
-                BSONObj obj;
-                PlanExecutor::ExecState state;
-                // This may yield so we cannot touch nsd after this.
-                state = exec->getNext(&obj, &rloc);
-                exec.reset();
-                if (PlanExecutor::IS_EOF == state) { break; }
-
-                if (PlanExecutor::DEAD == state) {
-                    warning(LogComponent::kSharding) << "cursor died: aborting deletion for "
-                              << min << " to " << max << " in " << ns
-                              << endl;
-                    break;
-                }
-
-                if (PlanExecutor::FAILURE == state) {
-                    warning(LogComponent::kSharding) << "cursor error while trying to delete "
-                              << min << " to " << max
-                              << " in " << ns << ": "
-                              << WorkingSetCommon::toStatusString(obj) << endl;
-                    break;
+                // Collect the next batch without yielding, so that the locations stay valid
+                // until they are deleted below under the same lock.
+                std::vector<RecordId> locs;
+                std::vector<BSONObj> objs;
+                {
+                    auto_ptr<PlanExecutor> exec(
+                        InternalPlanner::indexScan(txn, collection, desc,
+                                                   min, max,
+                                                   maxInclusive,
+                                                   InternalPlanner::FORWARD,
+                                                   InternalPlanner::IXSCAN_FETCH));
+
+                    RecordId rloc;
+                    BSONObj obj;
+                    while ( static_cast<int>( locs.size() ) < batchSize ) {
+                        PlanExecutor::ExecState state = exec->getNext(&obj, &rloc);
+                        if (PlanExecutor::IS_EOF == state) {
+                            done = true;
+                            break;
+                        }
+
+                        if (PlanExecutor::DEAD == state) {
+                            warning(LogComponent::kSharding) << "cursor died: aborting deletion for "
+                                      << min << " to " << max << " in " << ns
+                                      << endl;
+                            done = true;
+                            break;
+                        }
+
+                        if (PlanExecutor::FAILURE == state) {
+                            warning(LogComponent::kSharding) << "cursor error while trying to delete "
+                                      << min << " to " << max
+                                      << " in " << ns << ": "
+                                      << WorkingSetCommon::toStatusString(obj) << endl;
+                            done = true;
+                            break;
+                        }
+
+                        verify(PlanExecutor::ADVANCED == state);
+                        locs.push_back(rloc);
+                        objs.push_back(obj.getOwned());
+                    }
                 }
 
-                verify(PlanExecutor::ADVANCED == state);
-
-                WriteUnitOfWork wuow(txn);
+                if (locs.empty()) { break; }
 
                 if ( onlyRemoveOrphanedDocs ) {
                     // Do a final check in the write lock to make absolutely sure that our
@@ -413,23 +536,30 @@ namespace mongo {
                     // In write lock, so will be the most up-to-date version
                     CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
 
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        ShardKeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractShardKeyFromDoc(obj);
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
-                    }
-                    else {
-                        docIsOrphan = false;
-                    }
-
-                    if ( !docIsOrphan ) {
-                        warning(LogComponent::kSharding)
-                                  << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
-                        break;
+                    for ( size_t i = 0; i < objs.size(); ++i ) {
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            ShardKeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractShardKeyFromDoc(objs[i]);
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning(LogComponent::kSharding)
+                                      << "aborting migration cleanup for chunk " << min << " to " << max
+                                      << ( metadataNow ? (string) " at document " + objs[i].toString() : "" )
+                                      << ", collection " << ns << " has changed " << endl;
+
+                            // Still delete the orphans that come before it in the range.
+                            locs.resize(i);
+                            objs.resize(i);
+                            done = true;
+                            break;
+                        }
                     }
                 }
 
@@ -440,19 +570,26 @@ namespace mongo {
                     return numDeleted;
                 }
 
-                if ( callback )
-                    callback->goingToDelete( obj );
+                WriteUnitOfWork wuow(txn);
+                for ( size_t i = 0; i < locs.size(); ++i ) {
+                    if ( callback )
+                        callback->goingToDelete( objs[i] );
 
-                BSONObj deletedId;
-                collection->deleteDocument( txn, rloc, false, false, &deletedId );
+                    BSONObj deletedId;
+                    collection->deleteDocument( txn, locs[i], false, false, &deletedId );
+                }
                 wuow.commit();
-                numDeleted++;
+
+                batchDeleted = static_cast<int>( locs.size() );
+                numDeleted += batchDeleted;
+                rangeDeleterDocsDeleted.increment( batchDeleted );
+                rangeDeleterBatches.increment();
             }
 
-            // TODO remove once the yielding below that references this timer has been removed
-            Timer secondaryThrottleTime;
+            if ( batchDeleted == 0 )
+                continue;
 
-            if (writeConcern.shouldWaitForOtherNodes() && numDeleted > 0) {
+            if (writeConcern.shouldWaitForOtherNodes()) {
                 repl::ReplicationCoordinator::StatusAndDuration replStatus =
                         repl::getGlobalReplicationCoordinator()->awaitReplication(
                                 txn,
@@ -467,9 +604,15 @@ namespace mongo {
                     massertStatusOK(replStatus.status);
                 }
                 millisWaitingForReplication += replStatus.duration;
+                rangeDeleterReplicationWaitMillis.increment(
+                        durationCount<Milliseconds>(replStatus.duration) );
             }
+
+            millisWaitingForReplication += waitForReplicationLagBudget( txn, ns );
+
+            throttleRangeDeletion( txn, numDeleted, rangeRemoveTimer );
         }
-        
+
         if (writeConcern.shouldWaitForOtherNodes())
             log(LogComponent::kSharding)
                   << "Helpers::removeRangeUnlocked time spent waiting for replication: "
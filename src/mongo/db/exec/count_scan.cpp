@@ -29,6 +29,7 @@
 #include "mongo/db/exec/count_scan.h"
 
 #include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/index/index_descriptor.h"
 
@@ -42,11 +43,14 @@ namespace mongo {
 
     CountScan::CountScan(OperationContext* txn,
                          const CountScanParams& params,
-                         WorkingSet* workingSet)
+                         WorkingSet* workingSet,
+                         const MatchExpression* filter)
         : _txn(txn),
           _workingSet(workingSet),
           _descriptor(params.descriptor),
           _iam(params.descriptor->getIndexCatalog()->getIndex(params.descriptor)),
+          _needSeek(false),
+          _filter(filter),
           _shouldDedup(params.descriptor->isMultikey(txn)),
           _params(params),
           _commonStats(kStageType) {
@@ -55,10 +59,32 @@ namespace mongo {
         _specificStats.isMultiKey = _params.descriptor->isMultikey(txn);
         _specificStats.indexVersion = _params.descriptor->version();
 
-        // endKey must be after startKey in index order since we only do forward scans.
-        dassert(_params.startKey.woCompare(_params.endKey,
-                                           Ordering::make(params.descriptor->keyPattern()),
-                                           /*compareFieldNames*/false) <= 0);
+        if (_params.bounds.size() > 0) {
+            _specificStats.indexBounds = _params.bounds.toBSON();
+        }
+        else {
+            // endKey must be after startKey in index order since we only do forward scans.
+            dassert(_params.startKey.woCompare(_params.endKey,
+                                               Ordering::make(params.descriptor->keyPattern()),
+                                               /*compareFieldNames*/false) <= 0);
+        }
+    }
+
+    boost::optional<IndexKeyEntry> CountScan::initCountScan() {
+        _cursor = _iam->newCursor(_txn);
+
+        if (_params.bounds.size() == 0) {
+            _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
+            return _cursor->seek(_params.startKey, _params.startKeyInclusive);
+        }
+
+        _checker.reset(new IndexBoundsChecker(&_params.bounds,
+                                              _params.descriptor->keyPattern(),
+                                              1));
+        if (!_checker->getStartSeekPoint(&_seekPoint)) {
+            return boost::none;
+        }
+        return _cursor->seek(_seekPoint);
     }
 
 
@@ -72,18 +98,19 @@ namespace mongo {
         boost::optional<IndexKeyEntry> entry;
         const bool needInit = !_cursor;
         try {
-            // We don't care about the keys.
-            const auto kWantLoc = SortedDataInterface::Cursor::kWantLoc;
+            // We only care about the keys if we have to check them against the bounds or filter.
+            const auto parts = (_checker || _filter) ? SortedDataInterface::Cursor::kKeyAndLoc
+                                                     : SortedDataInterface::Cursor::kWantLoc;
 
             if (needInit) {
                 // First call to work().  Perform cursor init.
-                _cursor = _iam->newCursor(_txn);
-                _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
-
-                entry = _cursor->seek(_params.startKey, _params.startKeyInclusive, kWantLoc);
+                entry = initCountScan();
+            }
+            else if (_needSeek) {
+                entry = _cursor->seek(_seekPoint);
             }
             else {
-                entry = _cursor->next(kWantLoc);
+                entry = _cursor->next(parts);
             }
         }
         catch (const WriteConflictException& wce) {
@@ -97,12 +124,37 @@ namespace mongo {
 
         ++_specificStats.keysExamined;
 
+        _needSeek = false;
+        if (entry && _checker) {
+            switch (_checker->checkKey(entry->key, &_seekPoint)) {
+            case IndexBoundsChecker::VALID:
+                break;
+
+            case IndexBoundsChecker::DONE:
+                entry = boost::none;
+                break;
+
+            case IndexBoundsChecker::MUST_ADVANCE:
+                _needSeek = true;
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+        }
+
         if (!entry) {
             _commonStats.isEOF = true;
             _cursor.reset();
             return PlanStage::IS_EOF;
         }
 
+        // The filter is applied before deduplicating, as another key for the same document may
+        // pass it.
+        if (_filter && !Filter::passes(entry->key, _params.descriptor->keyPattern(), _filter)) {
+            ++_specificStats.keysFilteredOut;
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
         if (_shouldDedup && !_returned.insert(entry->loc).second) {
             // *loc was already in _returned.
             ++_commonStats.needTime;
@@ -121,7 +173,14 @@ namespace mongo {
     void CountScan::saveState() {
         _txn = NULL;
         ++_commonStats.yields;
-        if (_cursor) _cursor->savePositioned();
+        if (!_cursor) return;
+
+        if (_needSeek) {
+            _cursor->saveUnpositioned();
+            return;
+        }
+
+        _cursor->savePositioned();
     }
 
     void CountScan::restoreState(OperationContext* opCtx) {
@@ -159,6 +218,13 @@ namespace mongo {
     }
 
     PlanStageStats* CountScan::getStats() {
+        // Add a BSON representation of the filter to the stats tree, if there is one.
+        if (NULL != _filter) {
+            BSONObjBuilder bob;
+            _filter->toBSON(&bob);
+            _commonStats.filter = bob.obj();
+        }
+
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_COUNT_SCAN));
 
         CountScanStats* countStats = new CountScanStats(_specificStats);
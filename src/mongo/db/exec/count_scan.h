@@ -35,6 +35,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
 #include "mongo/platform/unordered_set.h"
 
@@ -55,19 +56,29 @@ namespace mongo {
 
         BSONObj endKey;
         bool endKeyInclusive;
+
+        // If this has any fields the scan counts the keys in these bounds, which may have several
+        // intervals, instead of those between 'startKey' and 'endKey'.
+        IndexBounds bounds;
     };
 
     /**
-     * Used by the count command.  Scans an index from a start key to an end key.  Does not create
-     * any WorkingSetMember(s) for any of the data, instead returning ADVANCED to indicate to the
-     * caller that another result should be counted.
+     * Used by the count command.  Scans an index from a start key to an end key, or through a set
+     * of index bounds.  Does not create any WorkingSetMember(s) for any of the data, instead
+     * returning ADVANCED to indicate to the caller that another result should be counted.
+     *
+     * If there is a filter, only the keys which pass it are counted.  The filter must be
+     * answerable from the index key alone.
      *
      * Only created through the getExecutorCount path, as count is the only operation that doesn't
      * care about its data.
      */
     class CountScan : public PlanStage {
     public:
-        CountScan(OperationContext* txn, const CountScanParams& params, WorkingSet* workingSet);
+        CountScan(OperationContext* txn,
+                  const CountScanParams& params,
+                  WorkingSet* workingSet,
+                  const MatchExpression* filter = NULL);
         virtual ~CountScan() { }
 
         virtual StageState work(WorkingSetID* out);
@@ -89,6 +100,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Positions the cursor at the first key to count, returning that key if there is one.
+         */
+        boost::optional<IndexKeyEntry> initCountScan();
+
         // transactional context for read locks. Not owned by us
         OperationContext* _txn;
 
@@ -101,6 +117,17 @@ namespace mongo {
 
         std::unique_ptr<SortedDataInterface::Cursor> _cursor;
 
+        // Only used when scanning several intervals.  Tells us when we've left the current
+        // interval and where the next one starts.
+        boost::scoped_ptr<IndexBoundsChecker> _checker;
+        IndexSeekPoint _seekPoint;
+
+        // True if the cursor must be moved to '_seekPoint' before reading the next key.
+        bool _needSeek;
+
+        // Keys must pass this filter to be counted.  Not owned by us.
+        const MatchExpression* _filter;
+
         // Could our index have duplicates?  If so, we use _returned to dedup.
         bool _shouldDedup;
         unordered_set<RecordId, RecordId::Hasher> _returned;
@@ -93,6 +93,10 @@ namespace mongo {
             delete iterator;
         }
 
+        virtual const BSONObj* getBSONObj() const {
+            return _wsm->hasObj() ? &_wsm->obj.value() : NULL;
+        }
+
     private:
         WorkingSetMember* _wsm;
     };
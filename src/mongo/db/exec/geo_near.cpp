@@ -35,6 +35,7 @@
 #include "third_party/s2/s2regionintersection.h"
 
 #include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/working_set_computed_data.h"
@@ -44,6 +45,7 @@
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/query/expression_index.h"
 #include "mongo/db/query/expression_index_knobs.h"
+#include "mongo/db/query/geo_near_density_cache.h"
 #include "mongo/db/index/expression_params.h"
 #include "mongo/util/log.h"
 
@@ -280,7 +282,8 @@ namespace mongo {
     class GeoNear2DStage::DensityEstimator {
     public:
         DensityEstimator(const IndexDescriptor* twoDindex, const GeoNearParams* nearParams) :
-                _twoDIndex(twoDindex), _nearParams(nearParams), _currentLevel(0)
+                _twoDIndex(twoDindex), _nearParams(nearParams), _currentLevel(0), _startLevel(0),
+                _foundDocuments(false)
         {
             GeoHashConverter::Parameters hashParams;
             Status status = GeoHashConverter::parseParameters(_twoDIndex->infoObj(),
@@ -295,6 +298,28 @@ namespace mongo {
             // we have to start to find documents at most GeoHash::kMaxBits - 1. Thus the finest
             // search area is 16 * finest cell area at GeoHash::kMaxBits.
             _currentLevel = std::max(0u, hashParams.bits - 1u);
+            _startLevel = _currentLevel;
+            // The estimate also depends on the bounds of any other fields in the index.
+            _boundsToken = _nearParams->baseBounds.toString();
+        }
+
+        /**
+         * Appends the regions an earlier search may have cached an estimate for this query
+         * under: those of every cell containing the query point, finest first.
+         */
+        void appendCacheRegions(vector<string>* regions) const {
+            for (unsigned level = _startLevel + 1; level-- > 0;) {
+                regions->push_back(regionAt(level));
+            }
+        }
+
+        /**
+         * Once work() has returned IS_EOF, the region to cache its estimate under: the cell at
+         * the level where documents turned up.  Empty if none did, because the estimate would
+         * then be keyed by the coarsest cell and answer every later search on the index.
+         */
+        string getFoundRegion() const {
+            return _foundDocuments ? regionAt(_currentLevel) : string();
         }
 
         PlanStage::StageState work(OperationContext* txn,
@@ -310,12 +335,20 @@ namespace mongo {
     private:
         void buildIndexScan(OperationContext* txn, WorkingSet* workingSet, Collection* collection);
 
+        // The cell at 'level' containing the query point, and the bounds on the other fields.
+        string regionAt(unsigned level) const {
+            return str::stream() << _centroidCell.parent(level).toString() << ' ' << _boundsToken;
+        }
+
         const IndexDescriptor* _twoDIndex;  // Not owned here.
         const GeoNearParams* _nearParams;  // Not owned here.
         scoped_ptr<IndexScan> _indexScan;
         scoped_ptr<GeoHashConverter> _converter;
         GeoHash _centroidCell;
         unsigned _currentLevel;
+        unsigned _startLevel;
+        string _boundsToken;
+        bool _foundDocuments;
     };
 
     // Initialize the internal states
@@ -395,6 +428,7 @@ namespace mongo {
             return PlanStage::IS_EOF;
         } else if (state == PlanStage::ADVANCED) {
             // Found a document at current level.
+            _foundDocuments = true;
             *estimatedDistance = _converter->sizeEdge(_currentLevel);
             // Clean up working set.
             workingSet->free(workingSetID);
@@ -433,13 +467,32 @@ namespace mongo {
                                                      Collection* collection,
                                                      WorkingSetID* out)
     {
+        GeoNearDensityCache* densityCache = collection->infoCache()->getGeoNearDensityCache();
+
+        double estimatedDistance;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
         if (!_densityEstimator) {
             _densityEstimator.reset(new DensityEstimator(_twoDIndex, &_nearParams));
+
+            // An earlier search from a cell containing the query point may have made the
+            // estimate already.
+            vector<string> regions;
+            _densityEstimator->appendCacheRegions(&regions);
+            if (densityCache->getFirst(_twoDIndex->indexName(), regions, &estimatedDistance)) {
+                getNearStats()->cachedDensityEstimate = true;
+                state = PlanStage::IS_EOF;
+            }
         }
 
-        double estimatedDistance;
-        PlanStage::StageState state = _densityEstimator->work(txn, workingSet, collection, out,
-                                                              &estimatedDistance);
+        if (!getNearStats()->cachedDensityEstimate) {
+            state = _densityEstimator->work(txn, workingSet, collection, out, &estimatedDistance);
+            if (state == PlanStage::IS_EOF) {
+                const string region = _densityEstimator->getFoundRegion();
+                if (!region.empty()) {
+                    densityCache->add(_twoDIndex->indexName(), region, estimatedDistance);
+                }
+            }
+        }
 
         if (state == PlanStage::IS_EOF) {
             // 2d index only works with legacy points as centroid. $nearSphere will project
@@ -869,11 +922,13 @@ namespace mongo {
                                                     docMatcher,
                                                     collection));
 
-        return StatusWith<CoveredInterval*>(new CoveredInterval(fetcher,
-                                                                true,
-                                                                nextBounds.getInner(),
-                                                                nextBounds.getOuter(),
-                                                                isLastInterval));
+        CoveredInterval* interval = new CoveredInterval(fetcher,
+                                                        true,
+                                                        nextBounds.getInner(),
+                                                        nextBounds.getOuter(),
+                                                        isLastInterval);
+        interval->numCoveringCells = coveredIntervals.intervals.size();
+        return StatusWith<CoveredInterval*>(interval);
     }
 
     StatusWith<double> GeoNear2DStage::computeDistance(WorkingSetMember* member) {
@@ -1017,7 +1072,8 @@ namespace mongo {
     class GeoNear2DSphereStage::DensityEstimator {
     public:
         DensityEstimator(const IndexDescriptor* s2Index, const GeoNearParams* nearParams) :
-            _s2Index(s2Index), _nearParams(nearParams), _currentLevel(0)
+            _s2Index(s2Index), _nearParams(nearParams), _currentLevel(0), _startLevel(0),
+            _foundDocuments(false)
         {
             S2IndexingParams params;
             ExpressionParams::parse2dsphereParams(_s2Index->infoObj(), &params);
@@ -1026,6 +1082,28 @@ namespace mongo {
             // search area is 16 * finest cell area at S2::kMaxCellLevel, which is less than
             // (1.4 inch X 1.4 inch) on the earth.
             _currentLevel = std::max(0, params.finestIndexedLevel - 1);
+            _startLevel = _currentLevel;
+            // The estimate also depends on the bounds of any other fields in the index.
+            _boundsToken = _nearParams->baseBounds.toString();
+        }
+
+        /**
+         * Appends the regions an earlier search may have cached an estimate for this query
+         * under: those of every cell containing the query point, finest first.
+         */
+        void appendCacheRegions(vector<string>* regions) const {
+            for (int level = _startLevel; level >= 0; --level) {
+                regions->push_back(regionAt(level));
+            }
+        }
+
+        /**
+         * Once work() has returned IS_EOF, the region to cache its estimate under: the cell at
+         * the level where documents turned up.  Empty if none did, because the estimate would
+         * then be keyed by a whole face and answer most later searches on the index.
+         */
+        string getFoundRegion() const {
+            return _foundDocuments ? regionAt(_currentLevel) : string();
         }
 
         // Search for a document in neighbors at current level.
@@ -1043,9 +1121,18 @@ namespace mongo {
     private:
         void buildIndexScan(OperationContext* txn, WorkingSet* workingSet, Collection* collection);
 
+        // The cell at 'level' containing the query point, and the bounds on the other fields.
+        string regionAt(int level) const {
+            const S2CellId cell = _nearParams->nearQuery->centroid->cell.id().parent(level);
+            return str::stream() << cell.toString() << ' ' << _boundsToken;
+        }
+
         const IndexDescriptor* _s2Index; // Not owned here.
         const GeoNearParams* _nearParams; // Not owned here.
         int _currentLevel;
+        int _startLevel;
+        string _boundsToken;
+        bool _foundDocuments;
         scoped_ptr<IndexScan> _indexScan;
     };
 
@@ -1127,6 +1214,7 @@ namespace mongo {
             return PlanStage::IS_EOF;
         } else if (state == PlanStage::ADVANCED) {
             // We found something!
+            _foundDocuments = true;
             *estimatedDistance = S2::kAvgEdge.GetValue(_currentLevel) * kRadiusOfEarthInMeters;
             // Clean up working set.
             workingSet->free(workingSetID);
@@ -1165,13 +1253,32 @@ namespace mongo {
                                                            Collection* collection,
                                                            WorkingSetID* out)
     {
+        GeoNearDensityCache* densityCache = collection->infoCache()->getGeoNearDensityCache();
+
+        double estimatedDistance;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
         if (!_densityEstimator) {
             _densityEstimator.reset(new DensityEstimator(_s2Index, &_nearParams));
+
+            // An earlier search from a cell containing the query point may have made the
+            // estimate already.
+            vector<string> regions;
+            _densityEstimator->appendCacheRegions(&regions);
+            if (densityCache->getFirst(_s2Index->indexName(), regions, &estimatedDistance)) {
+                getNearStats()->cachedDensityEstimate = true;
+                state = PlanStage::IS_EOF;
+            }
         }
 
-        double estimatedDistance;
-        PlanStage::StageState state = _densityEstimator->work(txn, workingSet, collection, out,
-                                                              &estimatedDistance);
+        if (!getNearStats()->cachedDensityEstimate) {
+            state = _densityEstimator->work(txn, workingSet, collection, out, &estimatedDistance);
+            if (state == PlanStage::IS_EOF) {
+                const string region = _densityEstimator->getFoundRegion();
+                if (!region.empty()) {
+                    densityCache->add(_s2Index->indexName(), region, estimatedDistance);
+                }
+            }
+        }
 
         if (state == IS_EOF) {
             // We find a document in 4 neighbors at current level, but didn't at previous level.
@@ -1282,11 +1389,13 @@ namespace mongo {
         // FetchStage owns index scan
         FetchStage* fetcher(new FetchStage(txn, workingSet, scan, _nearParams.filter, collection));
 
-        return StatusWith<CoveredInterval*>(new CoveredInterval(fetcher,
-                                                                true,
-                                                                nextBounds.getInner(),
-                                                                nextBounds.getOuter(),
-                                                                isLastInterval));
+        CoveredInterval* interval = new CoveredInterval(fetcher,
+                                                        true,
+                                                        nextBounds.getInner(),
+                                                        nextBounds.getOuter(),
+                                                        isLastInterval);
+        interval->numCoveringCells = coveredIntervals->intervals.size();
+        return StatusWith<CoveredInterval*>(interval);
     }
 
     StatusWith<double> GeoNear2DSphereStage::computeDistance(WorkingSetMember* member) {
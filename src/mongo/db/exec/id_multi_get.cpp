@@ -0,0 +1,467 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/id_multi_get.h"
+
+#include <algorithm>
+
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/storage/record_fetcher.h"
+
+namespace mongo {
+
+    using std::auto_ptr;
+    using std::string;
+    using std::vector;
+
+namespace {
+
+    const char* outputOrderName(IDMultiGetStage::OutputOrder order) {
+        switch (order) {
+        case IDMultiGetStage::kStorageOrder: return "storage";
+        case IDMultiGetStage::kAscendingKeyOrder: return "ascending";
+        case IDMultiGetStage::kDescendingKeyOrder: return "descending";
+        case IDMultiGetStage::kRequestOrder: return "request";
+        }
+        MONGO_UNREACHABLE;
+    }
+
+    IDMultiGetStage::OutputOrder outputOrderForSort(const BSONObj& sort) {
+        if (sort.isEmpty()) {
+            return IDMultiGetStage::kStorageOrder;
+        }
+        return sort.firstElement().number() > 0 ? IDMultiGetStage::kAscendingKeyOrder
+                                                : IDMultiGetStage::kDescendingKeyOrder;
+    }
+
+    /**
+     * Orders positions in a vector of index keys by the keys they refer to.
+     */
+    class KeyPositionLessThan {
+    public:
+        explicit KeyPositionLessThan(const vector<BSONObj>& keys) : _keys(keys) { }
+
+        bool operator()(size_t lhs, size_t rhs) const {
+            return _keys[lhs].woCompare(_keys[rhs], BSONObj(), false) < 0;
+        }
+
+    private:
+        const vector<BSONObj>& _keys;
+    };
+
+    /**
+     * Tells whether two positions in a vector of index keys refer to equal keys.
+     */
+    class KeyPositionEquals {
+    public:
+        explicit KeyPositionEquals(const vector<BSONObj>& keys) : _keys(keys) { }
+
+        bool operator()(size_t lhs, size_t rhs) const {
+            return _keys[lhs].woCompare(_keys[rhs], BSONObj(), false) == 0;
+        }
+
+    private:
+        const vector<BSONObj>& _keys;
+    };
+
+}  // namespace
+
+    // static
+    const char* IDMultiGetStage::kStageType = "ID_MULTI_GET";
+
+    IDMultiGetStage::IDMultiGetStage(OperationContext* txn, const Collection* collection,
+                                     CanonicalQuery* query, WorkingSet* ws)
+        : _txn(txn),
+          _collection(collection),
+          _workingSet(ws),
+          _order(outputOrderForSort(query->getParsed().getSort())),
+          _nextKey(0),
+          _iam(NULL),
+          _needSeek(true),
+          _nextEntry(0),
+          _idBeingPagedIn(WorkingSet::INVALID_ID),
+          _commonStats(kStageType) {
+        init(query->getQueryObj()["_id"].Obj()["$in"].Obj());
+    }
+
+    IDMultiGetStage::IDMultiGetStage(OperationContext* txn, const Collection* collection,
+                                     const BSONObj& ids, OutputOrder order, WorkingSet* ws)
+        : _txn(txn),
+          _collection(collection),
+          _workingSet(ws),
+          _order(order),
+          _nextKey(0),
+          _iam(NULL),
+          _needSeek(true),
+          _nextEntry(0),
+          _idBeingPagedIn(WorkingSet::INVALID_ID),
+          _commonStats(kStageType) {
+        init(ids);
+    }
+
+    IDMultiGetStage::~IDMultiGetStage() { }
+
+    void IDMultiGetStage::init(const BSONObj& ids) {
+        _specificStats.outputOrder = outputOrderName(_order);
+
+        const IndexCatalog* catalog = _collection->getIndexCatalog();
+        IndexDescriptor* idDesc = catalog->findIdIndex(_txn);
+        if (NULL == idDesc) {
+            return;
+        }
+        _iam = catalog->getIndex(idDesc);
+
+        vector<BSONObj> keys;
+        keys.reserve(ids.nFields());
+        BSONObjIterator it(ids);
+        while (it.more()) {
+            BSONObjBuilder bob;
+            bob.appendAs(it.next(), "");
+            keys.push_back(bob.obj());
+        }
+
+        // Sort and remove duplicates. The stable sort leaves the first occurrence of each _id at
+        // the front of its run of duplicates, so unique() keeps its position in the request.
+        vector<size_t> order(keys.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), KeyPositionLessThan(keys));
+        order.erase(std::unique(order.begin(), order.end(), KeyPositionEquals(keys)),
+                    order.end());
+
+        // Renumber the keys we kept so that '_keys' is still in request order.
+        vector<size_t> requestOrder(order);
+        std::sort(requestOrder.begin(), requestOrder.end());
+        vector<size_t> renumbered(keys.size());
+        _keys.reserve(requestOrder.size());
+        for (size_t i = 0; i < requestOrder.size(); ++i) {
+            renumbered[requestOrder[i]] = i;
+            _keys.push_back(keys[requestOrder[i]]);
+        }
+        _keyOrder.reserve(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            _keyOrder.push_back(renumbered[order[i]]);
+        }
+
+        _specificStats.keysRequested = _keys.size();
+    }
+
+    bool IDMultiGetStage::isEOF() {
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn) {
+            // We asked the parent for a page-in, but still haven't had a chance to return the
+            // paged in document
+            return false;
+        }
+
+        return _nextKey == _keyOrder.size() && _nextEntry == _entries.size();
+    }
+
+    PlanStage::StageState IDMultiGetStage::work(WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by work() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        if (isEOF()) {
+            _commonStats.isEOF = true;
+            return PlanStage::IS_EOF;
+        }
+
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn) {
+            WorkingSetID id = _idBeingPagedIn;
+            _idBeingPagedIn = WorkingSet::INVALID_ID;
+            WorkingSetMember* member = _workingSet->get(id);
+
+            invariant(WorkingSetCommon::fetchIfUnfetched(_txn, member, _collection));
+
+            ++_commonStats.advanced;
+            *out = id;
+            return PlanStage::ADVANCED;
+        }
+
+        try {
+            if (_nextKey < _keyOrder.size()) {
+                return lookUpNextKey(out);
+            }
+            return fetchNextEntry(out);
+        }
+        catch (const WriteConflictException& wce) {
+            // Retry the _id or record we were working on.
+            _needSeek = true;
+            *out = WorkingSet::INVALID_ID;
+            _commonStats.needYield++;
+            return NEED_YIELD;
+        }
+    }
+
+    // static
+    int IDMultiGetStage::compareKeys(const BSONObj& indexKey, const BSONObj& key) {
+        return indexKey.woCompare(key, BSONObj(), /*compareFieldNames*/false);
+    }
+
+    PlanStage::StageState IDMultiGetStage::lookUpNextKey(WorkingSetID* out) {
+        if (!_cursor) {
+            _cursor = _iam->newCursor(_txn);
+            _needSeek = true;
+        }
+
+        const BSONObj& key = _keys[_keyOrder[_nextKey]];
+
+        if (!_needSeek && _cursorEntry && compareKeys(_cursorEntry->key, key) < 0) {
+            // The requested values are often neighbours in the index, so step once before
+            // paying for a seek. If there is no next entry, none of the remaining values are
+            // in the index.
+            _cursorEntry = _cursor->next();
+            if (_cursorEntry) {
+                ++_specificStats.keysExamined;
+            }
+        }
+
+        if (_needSeek || (_cursorEntry && compareKeys(_cursorEntry->key, key) < 0)) {
+            _cursorEntry = _cursor->seek(key, /*inclusive*/true);
+            _needSeek = false;
+            ++_specificStats.seeks;
+            if (_cursorEntry) {
+                ++_specificStats.keysExamined;
+            }
+        }
+
+        if (_cursorEntry && compareKeys(_cursorEntry->key, key) == 0) {
+            _entries.push_back(Entry(_keyOrder[_nextKey], _cursorEntry->loc));
+        }
+        ++_nextKey;
+
+        if (!_cursorEntry) {
+            // The cursor is past the end of the index, so the remaining values aren't there.
+            _nextKey = _keyOrder.size();
+        }
+
+        if (_nextKey == _keyOrder.size()) {
+            finishLookUp();
+        }
+
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    // static
+    bool IDMultiGetStage::Entry::locLessThan(const Entry& lhs, const Entry& rhs) {
+        return lhs.loc < rhs.loc;
+    }
+
+    // static
+    bool IDMultiGetStage::Entry::keyIndexLessThan(const Entry& lhs, const Entry& rhs) {
+        return lhs.keyIndex < rhs.keyIndex;
+    }
+
+    void IDMultiGetStage::finishLookUp() {
+        _cursor.reset();
+        _cursorEntry = boost::none;
+
+        // The entries are in ascending _id order.
+        switch (_order) {
+        case kStorageOrder:
+            std::sort(_entries.begin(), _entries.end(), Entry::locLessThan);
+            break;
+        case kAscendingKeyOrder:
+            break;
+        case kDescendingKeyOrder:
+            std::reverse(_entries.begin(), _entries.end());
+            break;
+        case kRequestOrder:
+            std::sort(_entries.begin(), _entries.end(), Entry::keyIndexLessThan);
+            break;
+        }
+    }
+
+    PlanStage::StageState IDMultiGetStage::fetchNextEntry(WorkingSetID* out) {
+        Entry& entry = _entries[_nextEntry];
+
+        if (entry.loc.isNull()) {
+            // The record was deleted or moved while we yielded. _id is immutable, so if the
+            // document is still there the _id index leads to it.
+            entry.loc = _iam->findSingle(_txn, _keys[entry.keyIndex]);
+            ++_specificStats.keysExamined;
+            if (entry.loc.isNull()) {
+                ++_nextEntry;
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+        }
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->state = WorkingSetMember::LOC_AND_IDX;
+        member->loc = entry.loc;
+
+        try {
+            // We may need to request a yield while we fetch the document.
+            auto_ptr<RecordFetcher> fetcher(_collection->documentNeedsFetch(_txn, entry.loc));
+            if (NULL != fetcher.get()) {
+                // There's something to fetch. Hand the fetcher off to the WSM, and pass up a
+                // fetch request.
+                ++_nextEntry;
+                ++_specificStats.docsExamined;
+                _idBeingPagedIn = id;
+                member->setFetcher(fetcher.release());
+                *out = id;
+                _commonStats.needYield++;
+                return NEED_YIELD;
+            }
+
+            if (!WorkingSetCommon::fetch(_txn, member, _collection)) {
+                // The record went away since we looked it up.
+                ++_nextEntry;
+                _workingSet->free(id);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+        }
+        catch (const WriteConflictException& wce) {
+            _workingSet->free(id);
+            throw;
+        }
+
+        ++_nextEntry;
+        ++_specificStats.docsExamined;
+        ++_commonStats.advanced;
+        *out = id;
+        return PlanStage::ADVANCED;
+    }
+
+    void IDMultiGetStage::saveState() {
+        _txn = NULL;
+        ++_commonStats.yields;
+        if (_cursor) {
+            // We seek to the next requested _id after the yield.
+            _cursor->saveUnpositioned();
+        }
+    }
+
+    void IDMultiGetStage::restoreState(OperationContext* opCtx) {
+        invariant(_txn == NULL);
+        _txn = opCtx;
+        ++_commonStats.unyields;
+        if (_cursor) {
+            _cursor->restore(opCtx);
+            _needSeek = true;
+        }
+    }
+
+    void IDMultiGetStage::invalidate(OperationContext* txn,
+                                     const RecordId& dl,
+                                     InvalidationType type) {
+        ++_commonStats.invalidates;
+
+        // Since updates can't mutate the '_id' field, we can ignore mutation invalidations.
+        if (INVALIDATION_MUTATION == type) {
+            return;
+        }
+
+        // It's possible that the loc getting invalidated is the one we're about to
+        // fetch. In this case we do a "forced fetch" and put the WSM in owned object state.
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn) {
+            WorkingSetMember* member = _workingSet->get(_idBeingPagedIn);
+            if (member->hasLoc() && (member->loc == dl)) {
+                // Fetch it now and kill the diskloc.
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
+        }
+
+        // Records we have yet to fetch are looked up again by _id.
+        for (size_t i = _nextEntry; i < _entries.size(); ++i) {
+            if (_entries[i].loc == dl) {
+                _entries[i].loc = RecordId();
+            }
+        }
+    }
+
+    // static
+    bool IDMultiGetStage::supportsQuery(const CanonicalQuery& query) {
+        const LiteParsedQuery& parsed = query.getParsed();
+
+        // We always fetch, so leave queries which the _id index can cover to the planner.
+        const ParsedProjection* proj = query.getProj();
+        if (NULL != proj) {
+            if (proj->wantIndexKey()) {
+                return false;
+            }
+            const vector<string>& fields = proj->getRequiredFields();
+            if (!proj->requiresDocument() &&
+                size_t(std::count(fields.begin(), fields.end(), "_id")) == fields.size()) {
+                return false;
+            }
+        }
+
+        // The sort, if any, must be on _id alone.
+        const BSONObj& sort = parsed.getSort();
+        if (!sort.isEmpty() &&
+            (sort.nFields() != 1 ||
+             !str::equals("_id", sort.firstElementFieldName()) ||
+             !sort.firstElement().isNumber())) {
+            return false;
+        }
+
+        return !parsed.showRecordId()
+            && parsed.getHint().isEmpty()
+            && parsed.getMin().isEmpty()
+            && parsed.getMax().isEmpty()
+            && 0 == parsed.getSkip()
+            && 0 == parsed.getMaxScan()
+            && CanonicalQuery::isSimpleIdInQuery(parsed.getFilter())
+            && !parsed.isTailable();
+    }
+
+    vector<PlanStage*> IDMultiGetStage::getChildren() const {
+        vector<PlanStage*> empty;
+        return empty;
+    }
+
+    PlanStageStats* IDMultiGetStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_ID_MULTI_GET));
+        ret->specific.reset(new IDMultiGetStats(_specificStats));
+        return ret.release();
+    }
+
+    const CommonStats* IDMultiGetStage::getCommonStats() const {
+        return &_commonStats;
+    }
+
+    const SpecificStats* IDMultiGetStage::getSpecificStats() const {
+        return &_specificStats;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,190 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/sorted_data_interface.h"
+
+namespace mongo {
+
+    class IndexAccessMethod;
+
+    /**
+     * Returns the documents for a list of _id values, such as the values of an {_id: {$in: [...]}}
+     * query.
+     *
+     * The requested values are sorted and looked up with a single forward cursor over the _id
+     * index, which steps to neighbouring values instead of seeking when it can. The records are
+     * then fetched in the order given by 'OutputOrder'. Records which are deleted or moved while
+     * we yield are looked up again by _id before they are fetched.
+     */
+    class IDMultiGetStage : public PlanStage {
+    public:
+        enum OutputOrder {
+            // Fetch and return the records in RecordId order. This keeps the reads of the
+            // record store sequential; the order of the results is unspecified.
+            kStorageOrder,
+
+            // Return the results sorted by _id, ascending or descending.
+            kAscendingKeyOrder,
+            kDescendingKeyOrder,
+
+            // Return the results in the order their _id first appears in the request.
+            kRequestOrder,
+        };
+
+        /** Takes ownership of all the arguments -collection. */
+        IDMultiGetStage(OperationContext* txn, const Collection* collection,
+                        CanonicalQuery* query, WorkingSet* ws);
+
+        /**
+         * 'ids' holds the requested _id values as the elements of an array or object. Duplicate
+         * values are returned once.
+         */
+        IDMultiGetStage(OperationContext* txn, const Collection* collection,
+                        const BSONObj& ids, OutputOrder order, WorkingSet* ws);
+
+        virtual ~IDMultiGetStage();
+
+        virtual bool isEOF();
+        virtual StageState work(WorkingSetID* out);
+
+        virtual void saveState();
+        virtual void restoreState(OperationContext* opCtx);
+        virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
+
+        /**
+         * Returns true for an exact {_id: {$in: [...]}} query which needs the full documents and
+         * is either unsorted or sorted by _id.
+         */
+        static bool supportsQuery(const CanonicalQuery& query);
+
+        virtual std::vector<PlanStage*> getChildren() const;
+
+        virtual StageType stageType() const { return STAGE_ID_MULTI_GET; }
+
+        PlanStageStats* getStats();
+
+        virtual const CommonStats* getCommonStats() const;
+
+        virtual const SpecificStats* getSpecificStats() const;
+
+        static const char* kStageType;
+
+    private:
+        // A requested _id found in the index.
+        struct Entry {
+            Entry(size_t keyIndex, const RecordId& loc) : keyIndex(keyIndex), loc(loc) { }
+
+            static bool locLessThan(const Entry& lhs, const Entry& rhs);
+            static bool keyIndexLessThan(const Entry& lhs, const Entry& rhs);
+
+            // Position of the _id in '_keys'.
+            size_t keyIndex;
+
+            // Null if the record was deleted or moved since we looked it up.
+            RecordId loc;
+        };
+
+        void init(const BSONObj& ids);
+
+        /**
+         * Looks up the next requested _id in the index, recording an Entry if it is there.
+         */
+        StageState lookUpNextKey(WorkingSetID* out);
+
+        /**
+         * Puts '_entries' in output order once every _id has been looked up.
+         */
+        void finishLookUp();
+
+        /**
+         * Fetches the record of the next Entry.
+         */
+        StageState fetchNextEntry(WorkingSetID* out);
+
+        // Compares an index key to a requested _id, ignoring field names.
+        static int compareKeys(const BSONObj& indexKey, const BSONObj& key);
+
+        // transactional context for read locks. Not owned by us
+        OperationContext* _txn;
+
+        // Not owned here.
+        const Collection* _collection;
+
+        // The WorkingSet we annotate with results.  Not owned by us.
+        WorkingSet* _workingSet;
+
+        const OutputOrder _order;
+
+        // The distinct requested _id values as index keys, in request order.
+        std::vector<BSONObj> _keys;
+
+        // Positions in '_keys', in index order. We look them up in this order.
+        std::vector<size_t> _keyOrder;
+
+        // Position in '_keyOrder' of the next _id to look up.
+        size_t _nextKey;
+
+        // Null if there is no _id index, in which case we return nothing.
+        const IndexAccessMethod* _iam;
+
+        std::unique_ptr<SortedDataInterface::Cursor> _cursor;
+
+        // Where '_cursor' is positioned. Only meaningful if '_needSeek' is false.
+        boost::optional<IndexKeyEntry> _cursorEntry;
+
+        // True if '_cursor' has to be repositioned before it can be stepped.
+        bool _needSeek;
+
+        // The requested _id values we found. In output order once '_nextKey' has reached the end
+        // of '_keyOrder'.
+        std::vector<Entry> _entries;
+
+        // Position in '_entries' of the next record to fetch.
+        size_t _nextEntry;
+
+        // If we want to return a RecordId and it points to something that's not in memory,
+        // we return a "please page this in" result. We add a RecordFetcher given back to us by the
+        // storage engine to the WSM. The RecordFetcher is used by the PlanExecutor when it handles
+        // the fetch request.
+        WorkingSetID _idBeingPagedIn;
+
+        CommonStats _commonStats;
+        IDMultiGetStats _specificStats;
+    };
+
+}  // namespace mongo
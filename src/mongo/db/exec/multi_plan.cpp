@@ -33,21 +33,25 @@
 #include "mongo/db/exec/multi_plan.h"
 
 #include <algorithm>
-#include <math.h>
+#include <cmath>
 
+#include "mongo/base/counter.h"
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -56,6 +60,24 @@ namespace mongo {
     using std::list;
     using std::vector;
 
+    static Counter64 multiPlannerTrials;
+    static Counter64 multiPlannerTrialMicros;
+    static Counter64 multiPlannerTrialWorks;
+    static Counter64 multiPlannerCandidatesEliminated;
+
+    static ServerStatusMetricField<Counter64> displayMultiPlannerTrials(
+                                                    "query.multiPlanner.trials",
+                                                    &multiPlannerTrials );
+    static ServerStatusMetricField<Counter64> displayMultiPlannerTrialMicros(
+                                                    "query.multiPlanner.totalTrialMicros",
+                                                    &multiPlannerTrialMicros );
+    static ServerStatusMetricField<Counter64> displayMultiPlannerTrialWorks(
+                                                    "query.multiPlanner.totalTrialWorks",
+                                                    &multiPlannerTrialWorks );
+    static ServerStatusMetricField<Counter64> displayMultiPlannerCandidatesEliminated(
+                                                    "query.multiPlanner.candidatesEliminated",
+                                                    &multiPlannerCandidatesEliminated );
+
     // static
     const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
@@ -230,14 +252,37 @@ namespace mongo {
 
         size_t numWorks = getTrialPeriodWorks(_txn, _collection);
         size_t numResults = getTrialPeriodNumToReturn(*_query);
+        const long long maxTrialMillis = internalQueryPlanEvaluationMaxTimeMS;
 
         // Work the plans, stopping when a plan hits EOF or returns some
-        // fixed number of results.
+        // fixed number of results, or when we run out of time.
+        Timer trialTimer;
         for (size_t ix = 0; ix < numWorks; ++ix) {
             bool moreToDo = workAllPlans(numResults, yieldPolicy);
             if (!moreToDo) { break; }
+
+            if (maxTrialMillis > 0 && trialTimer.millis() >= maxTrialMillis) {
+                LOG(2) << "Stopping plan selection trial after " << trialTimer.millis()
+                       << "ms and " << (ix + 1) << " works per plan";
+                _specificStats.trialTimeLimitReached = true;
+                break;
+            }
+
+            if (internalQueryPlanEarlyEliminationEnabled) {
+                eliminateDominatedPlans();
+            }
         }
 
+        _specificStats.trialMicros = trialTimer.micros();
+        for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+            _specificStats.trialWorks += _candidates[ix].root->getCommonStats()->works;
+        }
+
+        multiPlannerTrials.increment();
+        multiPlannerTrialMicros.increment(_specificStats.trialMicros);
+        multiPlannerTrialWorks.increment(_specificStats.trialWorks);
+        multiPlannerCandidatesEliminated.increment(_specificStats.candidatesEliminated);
+
         if (_failure) {
             invariant(WorkingSet::INVALID_ID != _statusMemberId);
             WorkingSetMember* member = _candidates[0].ws->get(_statusMemberId);
@@ -325,12 +370,73 @@ namespace mongo {
         return candidateStats.release();
     }
 
+    namespace {
+
+        /**
+         * Returns the radius of the confidence interval around a productivity measured over
+         * 'works' calls to work(). By Hoeffding's inequality the true productivity lies within
+         * this distance of the measured one with probability at least 1 - 'errorRate'.
+         */
+        double productivityRadius(size_t works, double errorRate) {
+            return std::sqrt(std::log(2.0 / errorRate) / (2.0 * works));
+        }
+
+    } // namespace
+
+    void MultiPlanStage::eliminateDominatedPlans() {
+        const size_t minWorks = static_cast<size_t>(
+                                    std::max(1, internalQueryPlanEarlyEliminationMinWorks));
+        const double errorRate = internalQueryPlanEarlyEliminationErrorRate;
+        if (errorRate <= 0 || errorRate >= 1) { return; }
+
+        // Find the active candidate with the highest lower bound on its productivity.
+        double bestLowerBound = 0;
+        int bestIdx = kNoSuchPlan;
+        size_t numActive = 0;
+        for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+            const CandidatePlan& candidate = _candidates[ix];
+            if (candidate.failed || candidate.eliminated) { continue; }
+            ++numActive;
+
+            const CommonStats* common = candidate.root->getCommonStats();
+            if (common->works < minWorks) { return; }
+
+            const double productivity = static_cast<double>(common->advanced) / common->works;
+            const double lowerBound = productivity - productivityRadius(common->works, errorRate);
+            if (lowerBound > bestLowerBound) {
+                bestLowerBound = lowerBound;
+                bestIdx = ix;
+            }
+        }
+
+        if (kNoSuchPlan == bestIdx || numActive < 2) { return; }
+
+        for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+            CandidatePlan& candidate = _candidates[ix];
+            if (candidate.failed || candidate.eliminated) { continue; }
+            if (static_cast<int>(ix) == bestIdx) { continue; }
+            if (candidate.solution->hasBlockingStage) { continue; }
+
+            const CommonStats* common = candidate.root->getCommonStats();
+            const double productivity = static_cast<double>(common->advanced) / common->works;
+            const double upperBound = productivity + productivityRadius(common->works, errorRate);
+            if (upperBound < bestLowerBound) {
+                LOG(2) << "Eliminating candidate plan " << ix << " ("
+                       << Explain::getPlanSummary(candidate.root) << ") after "
+                       << common->works << " works, productivity " << productivity
+                       << " vs. at least " << bestLowerBound << " for candidate " << bestIdx;
+                candidate.eliminated = true;
+                ++_specificStats.candidatesEliminated;
+            }
+        }
+    }
+
     bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy) {
         bool doneWorking = false;
 
         for (size_t ix = 0; ix < _candidates.size(); ++ix) {
             CandidatePlan& candidate = _candidates[ix];
-            if (candidate.failed) { continue; }
+            if (candidate.failed || candidate.eliminated) { continue; }
 
             // Might need to yield between calls to work due to the timer elapsing.
             if (!(tryYield(yieldPolicy)).isOK()) {
@@ -163,6 +163,15 @@ namespace mongo {
          */
         bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+        /**
+         * Stops working any candidate whose productivity (results per call to work()) is, with
+         * high confidence, lower than that of the most productive candidate. Eliminated plans
+         * keep their stats and results so that they are still ranked and can serve as a backup
+         * plan. Plans with a blocking stage are never eliminated, as they produce no results
+         * until the blocking stage has consumed its input.
+         */
+        void eliminateDominatedPlans();
+
         /**
          * Checks whether we need to perform either a timing-based yield or a yield for a document
          * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
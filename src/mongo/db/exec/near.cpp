@@ -68,7 +68,8 @@ namespace mongo {
         dedupCovering(dedupCovering),
         minDistance(minDistance),
         maxDistance(maxDistance),
-        inclusiveMax(inclusiveMax) {
+        inclusiveMax(inclusiveMax),
+        numCoveringCells(0) {
     }
 
 
@@ -187,6 +188,7 @@ namespace mongo {
             _nextIntervalStats->minDistanceAllowed = _nextInterval->minDistance;
             _nextIntervalStats->maxDistanceAllowed = _nextInterval->maxDistance;
             _nextIntervalStats->inclusiveMaxDistanceAllowed = _nextInterval->inclusiveMax;
+            _nextIntervalStats->numCoveringCells = _nextInterval->numCoveringCells;
         }
 
         WorkingSetID nextMemberID;
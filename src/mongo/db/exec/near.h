@@ -231,6 +231,10 @@ namespace mongo {
         const double minDistance;
         const double maxDistance;
         const bool inclusiveMax;
+
+        // How many index cells the covering scans, reported by explain.  Zero if the covering
+        // isn't made of cells.
+        long long numCoveringCells;
     };
 
 }  // namespace mongo
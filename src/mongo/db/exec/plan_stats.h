@@ -245,7 +245,8 @@ namespace mongo {
     struct CountScanStats : public SpecificStats {
         CountScanStats() : indexVersion(0),
                            isMultiKey(false),
-                           keysExamined(0) { }
+                           keysExamined(0),
+                           keysFilteredOut(0) { }
 
         virtual ~CountScanStats() { }
 
@@ -253,6 +254,7 @@ namespace mongo {
             CountScanStats* specific = new CountScanStats(*this);
             // BSON objects have to be explicitly copied.
             specific->keyPattern = keyPattern.getOwned();
+            specific->indexBounds = indexBounds.getOwned();
             return specific;
         }
 
@@ -260,12 +262,18 @@ namespace mongo {
 
         BSONObj keyPattern;
 
+        // Only set when the scan covers several intervals.
+        BSONObj indexBounds;
+
         int indexVersion;
 
         bool isMultiKey;
 
         size_t keysExamined;
 
+        // The number of keys which were not counted because they did not pass the filter.
+        size_t keysFilteredOut;
+
     };
 
     struct DeleteStats : public SpecificStats {
@@ -360,6 +368,35 @@ namespace mongo {
 
     };
 
+    struct IDMultiGetStats : public SpecificStats {
+        IDMultiGetStats() : keysRequested(0),
+                            seeks(0),
+                            keysExamined(0),
+                            docsExamined(0) { }
+
+        virtual ~IDMultiGetStats() { }
+
+        virtual SpecificStats* clone() const {
+            IDMultiGetStats* specific = new IDMultiGetStats(*this);
+            return specific;
+        }
+
+        // The order in which results are returned.
+        std::string outputOrder;
+
+        // Number of distinct _id values requested.
+        size_t keysRequested;
+
+        // Number of times the _id index cursor was repositioned.
+        size_t seeks;
+
+        // Number of entries retrieved from the index.
+        size_t keysExamined;
+
+        // Number of documents retrieved from the collection.
+        size_t docsExamined;
+    };
+
     struct IndexScanStats : public SpecificStats {
         IndexScanStats() : indexVersion(0),
                            direction(1),
@@ -435,11 +472,27 @@ namespace mongo {
     };
 
     struct MultiPlanStats : public SpecificStats {
-        MultiPlanStats() { }
+        MultiPlanStats() : trialWorks(0),
+                           trialMicros(0),
+                           candidatesEliminated(0),
+                           trialTimeLimitReached(false) { }
 
         virtual SpecificStats* clone() const {
             return new MultiPlanStats(*this);
         }
+
+        // The total number of calls to work() made on all candidates during the trial period.
+        size_t trialWorks;
+
+        // Wall-clock time spent in the trial period.
+        long long trialMicros;
+
+        // The number of candidates which stopped being worked before the end of the trial
+        // period because another candidate was clearly more productive.
+        size_t candidatesEliminated;
+
+        // Whether the trial period was cut short by internalQueryPlanEvaluationMaxTimeMS.
+        bool trialTimeLimitReached;
     };
 
     struct OrStats : public SpecificStats {
@@ -525,14 +578,22 @@ namespace mongo {
     };
 
     struct ShardingFilterStats : public SpecificStats {
-        ShardingFilterStats() : chunkSkips(0) { }
+        ShardingFilterStats() : chunkSkips(0), docsChecked(0), docsNotChecked(0) { }
 
         virtual SpecificStats* clone() const {
             ShardingFilterStats* specific = new ShardingFilterStats(*this);
             return specific;
         }
 
+        // Documents dropped because they are not owned by this shard.
         size_t chunkSkips;
+
+        // Documents whose shard key was checked against the chunk ranges.
+        size_t docsChecked;
+
+        // Documents passed without a check, because every shard key the child can produce is
+        // owned by this shard.
+        size_t docsNotChecked;
     };
 
     struct SkipStats : public SpecificStats {
@@ -557,7 +618,8 @@ namespace mongo {
             minDistanceFound(-1),
             maxDistanceFound(-1),
             minDistanceBuffered(-1),
-            maxDistanceBuffered(-1) {
+            maxDistanceBuffered(-1),
+            numCoveringCells(0) {
         }
 
         long long numResultsFound;
@@ -571,12 +633,15 @@ namespace mongo {
         double maxDistanceFound;
         double minDistanceBuffered;
         double maxDistanceBuffered;
+
+        // The number of index cells scanned to cover the interval, if the search uses cells.
+        long long numCoveringCells;
     };
 
     class NearStats : public SpecificStats {
     public:
 
-        NearStats() {}
+        NearStats() : cachedDensityEstimate(false) {}
 
         virtual SpecificStats* clone() const {
             return new NearStats(*this);
@@ -594,6 +659,10 @@ namespace mongo {
         std::vector<IntervalStats> intervalStats;
         std::string indexName;
         BSONObj keyPattern;
+
+        // True if the size of the first interval came from an earlier search around the same
+        // point, rather than from scanning the index.
+        bool cachedDensityEstimate;
     };
 
     struct UpdateStats : public SpecificStats {
@@ -33,7 +33,7 @@
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
-#include "mongo/s/shard_key_pattern.h"
+#include "mongo/db/range_arithmetic.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -47,11 +47,40 @@ namespace mongo {
     ShardFilterStage::ShardFilterStage(const CollectionMetadataPtr& metadata,
                                        WorkingSet* ws,
                                        PlanStage* child)
-        : _ws(ws), _child(child), _commonStats(kStageType), _metadata(metadata) { }
+        : _ws(ws),
+          _child(child),
+          _commonStats(kStageType),
+          _metadata(metadata),
+          _childRangeOwnership(CollectionMetadata::RANGE_PARTIALLY_OWNED) {
+
+        if (_metadata) {
+            _shardKeyPattern.reset(new ShardKeyPattern(_metadata->getKeyPattern()));
+        }
+    }
 
     ShardFilterStage::~ShardFilterStage() { }
 
-    bool ShardFilterStage::isEOF() { return _child->isEOF(); }
+    void ShardFilterStage::setChildShardKeyRange(const BSONObj& minKey, const BSONObj& maxKey) {
+        invariant(0 == _commonStats.works);
+
+        if (!_metadata) {
+            return;
+        }
+
+        _childRangeOwnership = _metadata->getRangeOwnership(minKey, maxKey);
+        LOG(5) << "shard key range " << rangeToString(minKey, maxKey) << " of "
+               << _metadata->getKeyPattern() << " is "
+               << (CollectionMetadata::RANGE_OWNED == _childRangeOwnership ? "owned" :
+                   CollectionMetadata::RANGE_NOT_OWNED == _childRangeOwnership ? "not owned" :
+                   "partially owned");
+    }
+
+    bool ShardFilterStage::isEOF() {
+        if (_metadata && CollectionMetadata::RANGE_NOT_OWNED == _childRangeOwnership) {
+            return true;
+        }
+        return _child->isEOF();
+    }
 
     PlanStage::StageState ShardFilterStage::work(WorkingSetID* out) {
         ++_commonStats.works;
@@ -69,12 +98,15 @@ namespace mongo {
             // If we're sharded make sure that we don't return data that is not owned by us,
             // including pending documents from in-progress migrations and orphaned documents from
             // aborted migrations
-            if (_metadata) {
+            if (_metadata && CollectionMetadata::RANGE_OWNED == _childRangeOwnership) {
+                ++_specificStats.docsNotChecked;
+            }
+            else if (_metadata) {
 
-                ShardKeyPattern shardKeyPattern(_metadata->getKeyPattern());
+                ++_specificStats.docsChecked;
                 WorkingSetMember* member = _ws->get(*out);
                 WorkingSetMatchableDocument matchable(member);
-                BSONObj shardKey = shardKeyPattern.extractShardKeyFromMatchable(matchable);
+                BSONObj shardKey = _shardKeyPattern->extractShardKeyFromMatchable(matchable);
 
                 if (shardKey.isEmpty()) {
 
@@ -103,7 +135,14 @@ namespace mongo {
                               << "document may have been inserted manually into shard";
                 }
 
-                if (!_metadata->keyBelongsToMe(shardKey)) {
+                const bool inLastOwnedRange = !shardKey.isEmpty()
+                                              && !_ownedRangeMax.isEmpty()
+                                              && rangeContains(_ownedRangeMin,
+                                                               _ownedRangeMax,
+                                                               shardKey);
+
+                if (!inLastOwnedRange &&
+                    !_metadata->keyBelongsToMe(shardKey, &_ownedRangeMin, &_ownedRangeMax)) {
                     _ws->free(*out);
                     ++_specificStats.chunkSkips;
                     return PlanStage::NEED_TIME;
@@ -34,6 +34,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
 #include "mongo/s/d_state.h"
+#include "mongo/s/shard_key_pattern.h"
 
 namespace mongo {
 
@@ -77,6 +78,16 @@ namespace mongo {
         ShardFilterStage(const CollectionMetadataPtr& metadata, WorkingSet* ws, PlanStage* child);
         virtual ~ShardFilterStage();
 
+        /**
+         * Tells this stage that every document its child produces has a shard key in the closed
+         * range [minKey, maxKey], e.g. because the child scans an index prefixed by the shard key
+         * within those bounds.  If the metadata owns the whole range no document is checked, and
+         * if it owns none of it the stage is EOF right away.
+         *
+         * Must be called before the first call to work().
+         */
+        void setChildShardKeyRange(const BSONObj& minKey, const BSONObj& maxKey);
+
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
 
@@ -107,6 +118,20 @@ namespace mongo {
         // Note: it is important that this is the metadata from the time this stage is constructed.
         // See class comment for details.
         const CollectionMetadataPtr _metadata;
+
+        // Set if '_metadata' is.
+        boost::scoped_ptr<ShardKeyPattern> _shardKeyPattern;
+
+        // How much of the range of shard keys produced by the child belongs to '_metadata'.
+        // RANGE_PARTIALLY_OWNED, meaning check every document, unless setChildShardKeyRange()
+        // says otherwise.
+        CollectionMetadata::RangeOwnership _childRangeOwnership;
+
+        // The run of owned chunks [_ownedRangeMin, _ownedRangeMax) holding the last shard key
+        // found to belong to us.  Consecutive documents usually fall in the same run, and can
+        // be checked against it without searching the chunk map.
+        BSONObj _ownedRangeMin;
+        BSONObj _ownedRangeMax;
     };
 
 }  // namespace mongo
@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/ftdc/ftdc_compressor.h"
+
+#include <zlib.h>
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/ftdc/ftdc_util.h"
+#include "mongo/db/ftdc/ftdc_varint.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    FTDCCompressor::FTDCCompressor(size_t maxSamplesPerChunk)
+        : _maxSamplesPerChunk(maxSamplesPerChunk) {
+        invariant(maxSamplesPerChunk > 0);
+    }
+
+    Status FTDCCompressor::addSample(const BSONObj& sample, Date_t date, BSONObj* chunk) {
+        *chunk = BSONObj();
+
+        if (_reference.isEmpty()) {
+            _reset(sample, date);
+        }
+        else {
+            _metrics.clear();
+            if (!FTDCBSONUtil::extractMetricsFromDocument(&_reference, sample, &_metrics)) {
+                // A new schema starts a new chunk.
+                Status status = _compress(chunk);
+                if (!status.isOK()) {
+                    return status;
+                }
+                _reset(sample, date);
+            }
+            else {
+                std::vector<long long> deltas(_metrics.size());
+                for (size_t i = 0; i < _metrics.size(); ++i) {
+                    deltas[i] = static_cast<long long>(
+                        static_cast<unsigned long long>(_metrics[i]) -
+                        static_cast<unsigned long long>(_previousMetrics[i]));
+                }
+                _deltas.push_back(std::move(deltas));
+                _previousMetrics.swap(_metrics);
+            }
+        }
+
+        if (chunk->isEmpty() && _deltas.size() + 1 >= _maxSamplesPerChunk) {
+            Status status = _compress(chunk);
+            _reference = BSONObj();
+            return status;
+        }
+        return Status::OK();
+    }
+
+    Status FTDCCompressor::finish(BSONObj* chunk) {
+        *chunk = BSONObj();
+        if (_reference.isEmpty()) {
+            return Status::OK();
+        }
+        Status status = _compress(chunk);
+        _reference = BSONObj();
+        return status;
+    }
+
+    void FTDCCompressor::_reset(const BSONObj& reference, Date_t date) {
+        _reference = reference.getOwned();
+        _referenceDate = date;
+        _referenceMetrics.clear();
+        FTDCBSONUtil::extractMetricsFromDocument(NULL, _reference, &_referenceMetrics);
+        _previousMetrics = _referenceMetrics;
+        _deltas.clear();
+    }
+
+    Status FTDCCompressor::_compress(BSONObj* chunk) {
+        const uint32_t metricCount = _referenceMetrics.size();
+        const uint32_t deltaCount = _deltas.size();
+
+        BufBuilder uncompressed;
+        uncompressed.appendBuf(_reference.objdata(), _reference.objsize());
+        uncompressed.appendNum(metricCount);
+        uncompressed.appendNum(deltaCount);
+
+        // Column major, so that each metric's run of deltas is contiguous.
+        for (uint32_t metric = 0; metric < metricCount; ++metric) {
+            uint32_t zeroes = 0;
+            for (uint32_t sample = 0; sample < deltaCount; ++sample) {
+                const long long delta = _deltas[sample][metric];
+                if (delta == 0) {
+                    ++zeroes;
+                    continue;
+                }
+                if (zeroes) {
+                    FTDCVarInt::append(&uncompressed, 0);
+                    FTDCVarInt::append(&uncompressed, zeroes - 1);
+                    zeroes = 0;
+                }
+                FTDCVarInt::append(&uncompressed, FTDCVarInt::zigzagEncode(delta));
+            }
+            if (zeroes) {
+                FTDCVarInt::append(&uncompressed, 0);
+                FTDCVarInt::append(&uncompressed, zeroes - 1);
+            }
+        }
+
+        // The vendored zlib only has the streaming interface, so deflate in a single call.
+        // Without a stream, deflateBound assumes the most conservative settings.
+        const uLong sourceLength = uncompressed.len();
+        const uLong maxCompressedLength = ::deflateBound(NULL, sourceLength);
+
+        BufBuilder data(sizeof(uint32_t) + maxCompressedLength);
+        data.appendNum(static_cast<uint32_t>(sourceLength));
+        char* dest = data.skip(maxCompressedLength);
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        int ret = ::deflateInit(&stream, Z_DEFAULT_COMPRESSION);
+        if (ret == Z_OK) {
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(uncompressed.buf()));
+            stream.avail_in = sourceLength;
+            stream.next_out = reinterpret_cast<Bytef*>(dest);
+            stream.avail_out = maxCompressedLength;
+            ret = ::deflate(&stream, Z_FINISH);
+            ::deflateEnd(&stream);
+        }
+        if (ret != Z_STREAM_END) {
+            return Status(ErrorCodes::InternalError,
+                          str::stream() << "Failed to compress diagnostic data, zlib error "
+                                        << ret);
+        }
+        const uLong compressedLength = stream.total_out;
+
+        *chunk = FTDCBSONUtil::createBSONMetricChunkDocument(
+            data.buf(), sizeof(uint32_t) + compressedLength, _referenceDate);
+        return Status::OK();
+    }
+
+}  // namespace mongo
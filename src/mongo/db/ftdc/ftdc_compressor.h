@@ -0,0 +1,102 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/bson/util/builder.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    /**
+     * Accumulates samples sharing one schema and packs them into compressed metric chunks.
+     *
+     * The first sample of a chunk is kept verbatim as its reference document.  Every metric of
+     * the samples that follow is stored as the difference from the previous sample, column by
+     * column, so counters that rarely change compress to almost nothing.  The data of a chunk
+     * is laid out as
+     *
+     *     uint32 uncompressed length
+     *     zlib(reference BSON document,
+     *          uint32 metric count,
+     *          uint32 delta count,
+     *          metric count * delta count deltas)
+     *
+     * Each delta is a zigzag-encoded unsigned LEB128 varint, and a run of zero deltas is
+     * written as a zero followed by the length of the run minus one.
+     *
+     * Not thread safe.
+     */
+    class FTDCCompressor {
+        MONGO_DISALLOW_COPYING(FTDCCompressor);
+    public:
+        explicit FTDCCompressor(size_t maxSamplesPerChunk);
+
+        /**
+         * Adds a sample taken at "date".  When the sample completes a chunk, or has a different
+         * schema than the samples before it, the samples gathered so far are returned as a chunk
+         * document in "chunk".  Otherwise "chunk" is left empty.
+         */
+        Status addSample(const BSONObj& sample, Date_t date, BSONObj* chunk);
+
+        /**
+         * Returns the samples gathered so far as a chunk document in "chunk", which is left
+         * empty if there are none.
+         */
+        Status finish(BSONObj* chunk);
+
+        bool hasSamples() const {
+            return !_reference.isEmpty();
+        }
+
+    private:
+        Status _compress(BSONObj* chunk);
+
+        void _reset(const BSONObj& reference, Date_t date);
+
+        const size_t _maxSamplesPerChunk;
+
+        BSONObj _reference;
+        Date_t _referenceDate;
+
+        // Metrics of the reference document and of the last sample added.
+        std::vector<long long> _referenceMetrics;
+        std::vector<long long> _previousMetrics;
+
+        // Deltas from the previous sample, one row per sample after the reference.
+        std::vector<std::vector<long long>> _deltas;
+        std::vector<long long> _metrics;
+    };
+
+}  // namespace mongo
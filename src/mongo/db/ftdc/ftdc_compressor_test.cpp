@@ -0,0 +1,248 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <limits>
+#include <vector>
+
+#include "mongo/bson/timestamp.h"
+#include "mongo/db/ftdc/ftdc_compressor.h"
+#include "mongo/db/ftdc/ftdc_decompressor.h"
+#include "mongo/db/ftdc/ftdc_util.h"
+#include "mongo/db/ftdc/ftdc_varint.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+    using namespace mongo;
+
+    const Date_t kDate = Date_t::fromMillisSinceEpoch(1436000000000LL);
+
+    BSONObj makeSample(long long counter, int gauge, double rate) {
+        return BSON("start" << Date_t::fromMillisSinceEpoch(1436000000000LL + counter) <<
+                    "host" << "example:27017" <<
+                    "opcounters" << BSON("insert" << counter << "query" << 7LL) <<
+                    "connections" << BSON("current" << gauge << "ok" << (gauge % 2 == 0)) <<
+                    "rate" << rate <<
+                    "optime" << Timestamp(1436000000 + counter, 1) <<
+                    "hosts" << BSON_ARRAY(BSON("lag" << gauge) << BSON("lag" << 0)));
+    }
+
+    /**
+     * Adds "samples" to a compressor and returns what decompressing its chunks gives back.
+     */
+    std::vector<BSONObj> roundTrip(const std::vector<BSONObj>& samples,
+                                   size_t maxSamplesPerChunk,
+                                   size_t* numChunks) {
+        FTDCCompressor compressor(maxSamplesPerChunk);
+        std::vector<BSONObj> chunks;
+        BSONObj chunk;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            ASSERT_OK(compressor.addSample(samples[i], kDate, &chunk));
+            if (!chunk.isEmpty()) {
+                chunks.push_back(chunk);
+            }
+        }
+        ASSERT_OK(compressor.finish(&chunk));
+        if (!chunk.isEmpty()) {
+            chunks.push_back(chunk);
+        }
+        ASSERT_FALSE(compressor.hasSamples());
+
+        std::vector<BSONObj> result;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            ASSERT_EQUALS(FTDCBSONUtil::kMetricChunk,
+                          FTDCBSONUtil::getBSONDocumentType(chunks[i]).getValue());
+            StatusWith<std::vector<BSONObj>> docs = FTDCDecompressor::uncompress(chunks[i]);
+            ASSERT_OK(docs.getStatus());
+            result.insert(result.end(), docs.getValue().begin(), docs.getValue().end());
+        }
+        *numChunks = chunks.size();
+        return result;
+    }
+
+    TEST(FTDCVarIntTest, RoundTrip) {
+        const long long values[] = {0, 1, -1, 63, -64, 64, 1LL << 40, -(1LL << 40),
+                                    std::numeric_limits<long long>::max(),
+                                    std::numeric_limits<long long>::min()};
+        BufBuilder builder;
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+            FTDCVarInt::append(&builder, FTDCVarInt::zigzagEncode(values[i]));
+        }
+
+        const char* pos = builder.buf();
+        const char* end = pos + builder.len();
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+            uint64_t encoded;
+            ASSERT_TRUE(FTDCVarInt::read(&pos, end, &encoded));
+            ASSERT_EQUALS(values[i], FTDCVarInt::zigzagDecode(encoded));
+        }
+        ASSERT_TRUE(pos == end);
+
+        uint64_t encoded;
+        ASSERT_FALSE(FTDCVarInt::read(&pos, end, &encoded));
+    }
+
+    TEST(FTDCUtilTest, ExtractAndConstruct) {
+        const BSONObj sample = makeSample(5, 3, 2.5);
+
+        std::vector<long long> metrics;
+        ASSERT_TRUE(FTDCBSONUtil::extractMetricsFromDocument(NULL, sample, &metrics));
+        // start, insert, query, current, ok, rate, optime (2), two lags.
+        ASSERT_EQUALS(10U, metrics.size());
+
+        metrics.clear();
+        ASSERT_TRUE(FTDCBSONUtil::extractMetricsFromDocument(&sample,
+                                                             makeSample(6, 4, 1.75),
+                                                             &metrics));
+
+        // Doubles keep only their integer part.
+        StatusWith<BSONObj> doc = FTDCBSONUtil::constructDocumentFromMetrics(sample, metrics);
+        ASSERT_OK(doc.getStatus());
+        ASSERT_EQUALS(makeSample(6, 4, 1.0), doc.getValue());
+
+        metrics.pop_back();
+        ASSERT_NOT_OK(FTDCBSONUtil::constructDocumentFromMetrics(sample, metrics).getStatus());
+    }
+
+    TEST(FTDCUtilTest, SchemaChanges) {
+        const BSONObj reference = BSON("a" << 1 << "b" << BSON("c" << 2LL));
+        std::vector<long long> metrics;
+
+        ASSERT_TRUE(FTDCBSONUtil::extractMetricsFromDocument(
+            &reference, BSON("a" << 5 << "b" << BSON("c" << 9LL)), &metrics));
+        ASSERT_FALSE(FTDCBSONUtil::extractMetricsFromDocument(
+            &reference, BSON("a" << 5 << "b" << BSON("c" << 9)), &metrics));
+        ASSERT_FALSE(FTDCBSONUtil::extractMetricsFromDocument(
+            &reference, BSON("a" << 5 << "b" << BSON("d" << 9LL)), &metrics));
+        ASSERT_FALSE(FTDCBSONUtil::extractMetricsFromDocument(
+            &reference, BSON("a" << 5), &metrics));
+        ASSERT_FALSE(FTDCBSONUtil::extractMetricsFromDocument(
+            &reference, BSON("a" << 5 << "b" << BSON("c" << 9LL) << "e" << 1), &metrics));
+    }
+
+    TEST(FTDCCompressorTest, RoundTripManyChunks) {
+        std::vector<BSONObj> samples;
+        for (int i = 0; i < 250; ++i) {
+            // Counters that grow, gauges that go up and down, and runs that do not change.
+            samples.push_back(makeSample(i * 1000, (i / 10) % 7 - 3, i % 3 ? 1.0 : -2.0));
+        }
+
+        size_t numChunks;
+        const std::vector<BSONObj> result = roundTrip(samples, 100, &numChunks);
+        ASSERT_EQUALS(3U, numChunks);
+        ASSERT_EQUALS(samples.size(), result.size());
+        for (size_t i = 0; i < samples.size(); ++i) {
+            ASSERT_EQUALS(samples[i], result[i]);
+        }
+    }
+
+    TEST(FTDCCompressorTest, SchemaChangeStartsNewChunk) {
+        std::vector<BSONObj> samples;
+        samples.push_back(BSON("a" << 1 << "b" << 2));
+        samples.push_back(BSON("a" << 2 << "b" << 2));
+        samples.push_back(BSON("a" << 3 << "c" << 2));
+        samples.push_back(BSON("a" << 4 << "c" << 5));
+        samples.push_back(BSON("s" << "no metrics"));
+
+        size_t numChunks;
+        const std::vector<BSONObj> result = roundTrip(samples, 100, &numChunks);
+        ASSERT_EQUALS(3U, numChunks);
+        ASSERT_EQUALS(samples.size(), result.size());
+        for (size_t i = 0; i < samples.size(); ++i) {
+            ASSERT_EQUALS(samples[i], result[i]);
+        }
+    }
+
+    TEST(FTDCCompressorTest, ExtremeValues) {
+        std::vector<BSONObj> samples;
+        samples.push_back(BSON("a" << std::numeric_limits<long long>::min()));
+        samples.push_back(BSON("a" << std::numeric_limits<long long>::max()));
+        samples.push_back(BSON("a" << 0LL));
+        samples.push_back(BSON("a" << std::numeric_limits<long long>::min()));
+
+        size_t numChunks;
+        const std::vector<BSONObj> result = roundTrip(samples, 100, &numChunks);
+        ASSERT_EQUALS(1U, numChunks);
+        ASSERT_EQUALS(samples.size(), result.size());
+        for (size_t i = 0; i < samples.size(); ++i) {
+            ASSERT_EQUALS(samples[i], result[i]);
+        }
+    }
+
+    TEST(FTDCCompressorTest, CompressesUnchangingSamples) {
+        FTDCCompressor compressor(1000);
+        BSONObj chunk;
+        const BSONObj sample = makeSample(1, 2, 3.0);
+        for (int i = 0; i < 999; ++i) {
+            ASSERT_OK(compressor.addSample(sample, kDate, &chunk));
+            ASSERT_TRUE(chunk.isEmpty());
+        }
+        ASSERT_OK(compressor.addSample(sample, kDate, &chunk));
+        ASSERT_FALSE(chunk.isEmpty());
+        ASSERT_FALSE(compressor.hasSamples());
+
+        // A thousand copies take about as much room as one.
+        ASSERT_LESS_THAN(chunk.objsize(), 2 * sample.objsize());
+    }
+
+    TEST(FTDCDecompressorTest, RejectsCorruptChunks) {
+        FTDCCompressor compressor(10);
+        BSONObj chunk;
+        ASSERT_OK(compressor.addSample(makeSample(1, 2, 3.0), kDate, &chunk));
+        ASSERT_OK(compressor.addSample(makeSample(2, 3, 4.0), kDate, &chunk));
+        ASSERT_OK(compressor.finish(&chunk));
+
+        int length;
+        const char* data = chunk[FTDCBSONUtil::kFTDCDataField].binData(length);
+        const std::string good(data, length);
+
+        ASSERT_NOT_OK(FTDCDecompressor::uncompress(BSON("data" << 1)).getStatus());
+
+        for (int cut = 0; cut < length; ++cut) {
+            const BSONObj truncated =
+                FTDCBSONUtil::createBSONMetricChunkDocument(good.data(), cut, kDate);
+            ASSERT_NOT_OK(FTDCDecompressor::uncompress(truncated).getStatus());
+        }
+
+        std::string badLength = good;
+        badLength[3] = 0x7f;
+        ASSERT_NOT_OK(FTDCDecompressor::uncompress(
+            FTDCBSONUtil::createBSONMetricChunkDocument(badLength.data(),
+                                                        badLength.size(),
+                                                        kDate)).getStatus());
+
+        std::string badPayload = good;
+        badPayload[badPayload.size() / 2] ^= 0x5a;
+        ASSERT_NOT_OK(FTDCDecompressor::uncompress(
+            FTDCBSONUtil::createBSONMetricChunkDocument(badPayload.data(),
+                                                        badPayload.size(),
+                                                        kDate)).getStatus());
+    }
+
+}  // namespace
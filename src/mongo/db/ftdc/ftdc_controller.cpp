@@ -0,0 +1,321 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/ftdc/ftdc_controller.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/ftdc/ftdc_util.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(diagnosticDataCollectionEnabled, bool, true);
+    MONGO_EXPORT_SERVER_PARAMETER(diagnosticDataCollectionPeriodMillis, int, 1000);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(diagnosticDataCollectionSamplesPerChunk, int, 300);
+    MONGO_EXPORT_SERVER_PARAMETER(diagnosticDataCollectionFileSizeMB, int, 10);
+    MONGO_EXPORT_SERVER_PARAMETER(diagnosticDataCollectionDirectorySizeMB, int, 100);
+    MONGO_EXPORT_SERVER_PARAMETER(diagnosticDataCollectionMaxOverheadPercent, int, 2);
+
+namespace {
+
+    const char kMetricsFilePrefix[] = "metrics.";
+
+    // Never sample more often than this, whatever the period is set to.
+    const int kMinPeriodMillis = 100;
+
+    stdx::mutex globalControllerMutex;
+    FTDCController* globalController = NULL;
+
+}  // namespace
+
+    FTDCCommandCollector::FTDCCommandCollector(const std::string& name, const BSONObj& cmdObj)
+        : _name(name),
+          _cmdObj(cmdObj.getOwned()) {
+    }
+
+    void FTDCCommandCollector::collect(OperationContext* txn, BSONObjBuilder& builder) {
+        Command* command = Command::findCommand(_cmdObj.firstElementFieldName());
+        if (!command) {
+            return;
+        }
+
+        BSONObj cmdObj = _cmdObj;
+        std::string errmsg;
+        if (!command->run(txn, "admin", cmdObj, 0, errmsg, builder)) {
+            builder.append("errmsg", errmsg);
+        }
+    }
+
+    FTDCController::FTDCController(const boost::filesystem::path& directory,
+                                   OperationContextFactory makeOperationContext)
+        : _directory(directory),
+          _makeOperationContext(makeOperationContext),
+          _compressor(std::max(1, diagnosticDataCollectionSamplesPerChunk)),
+          _stopRequested(false) {
+    }
+
+    void FTDCController::addPeriodicCollector(std::unique_ptr<FTDCCollectorInterface> collector) {
+        _periodicCollectors.push_back(std::move(collector));
+    }
+
+    void FTDCController::addMetadataCollector(std::unique_ptr<FTDCCollectorInterface> collector) {
+        _metadataCollectors.push_back(std::move(collector));
+    }
+
+    BSONObj FTDCController::getMostRecentSample() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _mostRecentSample;
+    }
+
+    void FTDCController::stop() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _stopRequested = true;
+            _stopRequestedCondition.notify_all();
+        }
+        if (getState() != NotStarted) {
+            wait(5000);
+        }
+    }
+
+    void FTDCController::run() {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        while (!inShutdown()) {
+            Timer timer;
+            if (diagnosticDataCollectionEnabled) {
+                _collectAndWrite();
+            }
+            else {
+                _flush();
+            }
+
+            // Stretch the period if collecting took longer than the overhead allows.
+            const long long elapsedMillis = timer.millis();
+            const int maxOverheadPercent =
+                std::min(100, std::max(1, diagnosticDataCollectionMaxOverheadPercent));
+            const long long periodMillis = std::max(
+                static_cast<long long>(std::max(kMinPeriodMillis,
+                                                diagnosticDataCollectionPeriodMillis)),
+                elapsedMillis * 100 / maxOverheadPercent);
+
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            if (_stopRequestedCondition.wait_for(
+                    lk,
+                    Milliseconds(std::max(0LL, periodMillis - elapsedMillis)),
+                    [this] { return _stopRequested; })) {
+                break;
+            }
+        }
+
+        _flush();
+    }
+
+    BSONObj FTDCController::_collect(
+            OperationContext* txn,
+            const std::vector<std::unique_ptr<FTDCCollectorInterface>>& collectors) {
+        BSONObjBuilder builder;
+        builder.appendDate("start", jsTime());
+        for (size_t i = 0; i < collectors.size(); ++i) {
+            BSONObjBuilder sub(builder.subobjStart(collectors[i]->name()));
+            try {
+                collectors[i]->collect(txn, sub);
+            }
+            catch (const DBException& e) {
+                sub.append("errmsg", e.toString());
+            }
+            sub.doneFast();
+        }
+        builder.appendDate("end", jsTime());
+        return builder.obj();
+    }
+
+    void FTDCController::_collectAndWrite() {
+        std::unique_ptr<OperationContext> txn = _makeOperationContext();
+
+        if (_metadata.isEmpty()) {
+            _metadata = _collect(txn.get(), _metadataCollectors);
+        }
+
+        const BSONObj sample = _collect(txn.get(), _periodicCollectors);
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _mostRecentSample = sample;
+        }
+
+        BSONObj chunk;
+        Status status = _compressor.addSample(sample, sample["start"].date(), &chunk);
+        if (status.isOK() && !chunk.isEmpty()) {
+            status = _writeChunk(chunk);
+        }
+        if (!status.isOK()) {
+            warning() << "Failed to write diagnostic data: " << status;
+        }
+    }
+
+    void FTDCController::_flush() {
+        BSONObj chunk;
+        Status status = _compressor.finish(&chunk);
+        if (status.isOK() && !chunk.isEmpty()) {
+            status = _writeChunk(chunk);
+        }
+        if (!status.isOK()) {
+            warning() << "Failed to write diagnostic data: " << status;
+        }
+        _writer.close();
+    }
+
+    Status FTDCController::_writeChunk(const BSONObj& chunk) {
+        if (!_writer.isOpen()) {
+            Status status = _openFile();
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+
+        Status status = _writer.writeDocument(chunk);
+        if (!status.isOK()) {
+            _writer.close();
+            return status;
+        }
+
+        const size_t maxFileSize =
+            static_cast<size_t>(std::max(1, diagnosticDataCollectionFileSizeMB)) * 1024 * 1024;
+        if (_writer.getSize() >= maxFileSize) {
+            _writer.close();
+        }
+        return Status::OK();
+    }
+
+    Status FTDCController::_openFile() {
+        try {
+            boost::filesystem::create_directories(_directory);
+
+            const std::string baseName = kMetricsFilePrefix + terseCurrentTime(false);
+            boost::filesystem::path file = _directory / baseName;
+            for (int i = 1; boost::filesystem::exists(file); ++i) {
+                file = _directory / std::string(str::stream() << baseName << "-" << i);
+            }
+            _currentFile = file;
+        }
+        catch (const boost::filesystem::filesystem_error& e) {
+            return Status(ErrorCodes::FileNotOpen,
+                          str::stream() << "Failed to create diagnostic data file in "
+                                        << _directory.string() << ": " << e.what());
+        }
+
+        Status status = _writer.open(_currentFile);
+        if (!status.isOK()) {
+            return status;
+        }
+
+        status = _writer.writeDocument(
+            FTDCBSONUtil::createBSONMetadataDocument(_metadata, jsTime()));
+        if (!status.isOK()) {
+            _writer.close();
+            return status;
+        }
+
+        _removeOldFiles();
+        return Status::OK();
+    }
+
+    void FTDCController::_removeOldFiles() {
+        const unsigned long long maxDirectorySize =
+            static_cast<unsigned long long>(std::max(1, diagnosticDataCollectionDirectorySizeMB))
+            * 1024 * 1024;
+
+        try {
+            std::vector<boost::filesystem::path> files;
+            unsigned long long directorySize = 0;
+            for (boost::filesystem::directory_iterator it(_directory), end; it != end; ++it) {
+                const boost::filesystem::path& file = it->path();
+                if (!boost::filesystem::is_regular_file(file) ||
+                        file.filename().string().find(kMetricsFilePrefix) != 0) {
+                    continue;
+                }
+                directorySize += boost::filesystem::file_size(file);
+                if (file != _currentFile) {
+                    files.push_back(file);
+                }
+            }
+
+            // File names sort by the time they were created.
+            std::sort(files.begin(), files.end());
+            for (size_t i = 0; i < files.size() && directorySize > maxDirectorySize; ++i) {
+                directorySize -= boost::filesystem::file_size(files[i]);
+                boost::filesystem::remove(files[i]);
+            }
+        }
+        catch (const boost::filesystem::filesystem_error& e) {
+            warning() << "Failed to remove old diagnostic data files from "
+                      << _directory.string() << ": " << e.what();
+        }
+    }
+
+    void startFTDC(std::unique_ptr<FTDCController> controller) {
+        stdx::lock_guard<stdx::mutex> lk(globalControllerMutex);
+        invariant(!globalController);
+
+        log() << "Initializing full-time diagnostic data capture with directory '"
+              << controller->getDirectory().string() << "'";
+
+        // Never deleted, as the thread may still be running at exit.
+        globalController = controller.release();
+        globalController->go();
+    }
+
+    void stopFTDC() {
+        FTDCController* controller = getGlobalFTDCController();
+        if (controller) {
+            controller->stop();
+        }
+    }
+
+    FTDCController* getGlobalFTDCController() {
+        stdx::lock_guard<stdx::mutex> lk(globalControllerMutex);
+        return globalController;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,180 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/ftdc/ftdc_compressor.h"
+#include "mongo/db/ftdc/ftdc_file.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+    class OperationContext;
+
+    /**
+     * A source of diagnostic data, such as a command whose output is captured.
+     */
+    class FTDCCollectorInterface {
+    public:
+        virtual ~FTDCCollectorInterface() {}
+
+        /**
+         * Name of the field of the sample the collected data goes in.
+         */
+        virtual std::string name() const = 0;
+
+        /**
+         * Appends the current data to "builder".  "txn" is NULL on mongos.
+         */
+        virtual void collect(OperationContext* txn, BSONObjBuilder& builder) = 0;
+    };
+
+    /**
+     * Collects the output of running a command against the admin database.
+     */
+    class FTDCCommandCollector : public FTDCCollectorInterface {
+    public:
+        FTDCCommandCollector(const std::string& name, const BSONObj& cmdObj);
+
+        virtual std::string name() const { return _name; }
+
+        virtual void collect(OperationContext* txn, BSONObjBuilder& builder);
+
+    private:
+        const std::string _name;
+        const BSONObj _cmdObj;
+    };
+
+    /**
+     * Full-time diagnostic data capture.
+     *
+     * Samples the periodic collectors every diagnosticDataCollectionPeriodMillis and appends
+     * them, delta compressed, to "metrics.<time>" files in a directory of their own.  Each file
+     * starts with the output of the metadata collectors.  Files are rotated when they reach
+     * diagnosticDataCollectionFileSizeMB, and the oldest ones are removed when the directory
+     * exceeds diagnosticDataCollectionDirectorySizeMB.
+     *
+     * Samples are kept in memory until a chunk of them is complete, so at most
+     * diagnosticDataCollectionSamplesPerChunk samples are lost if the process dies.  A clean
+     * shutdown writes the partial chunk.
+     *
+     * Collecting is throttled so that it takes no more than
+     * diagnosticDataCollectionMaxOverheadPercent of one thread's time.
+     */
+    class FTDCController : public BackgroundJob {
+    public:
+        /**
+         * Makes the operation context each sample is collected with, or returns NULL where
+         * there is none, as on mongos.
+         */
+        typedef stdx::function<std::unique_ptr<OperationContext> ()> OperationContextFactory;
+
+        FTDCController(const boost::filesystem::path& directory,
+                       OperationContextFactory makeOperationContext);
+
+        void addPeriodicCollector(std::unique_ptr<FTDCCollectorInterface> collector);
+
+        void addMetadataCollector(std::unique_ptr<FTDCCollectorInterface> collector);
+
+        /**
+         * Returns the last sample collected, or an empty document if there is none yet.
+         */
+        BSONObj getMostRecentSample() const;
+
+        const boost::filesystem::path& getDirectory() const {
+            return _directory;
+        }
+
+        /**
+         * Stops collecting and writes out the samples not yet on disk.  Waits a short while
+         * for the collector thread to do so.
+         */
+        void stop();
+
+        virtual std::string name() const { return "ftdc"; }
+
+    protected:
+        virtual void run();
+
+    private:
+        BSONObj _collect(OperationContext* txn,
+                         const std::vector<std::unique_ptr<FTDCCollectorInterface>>& collectors);
+
+        void _collectAndWrite();
+
+        Status _writeChunk(const BSONObj& chunk);
+
+        Status _openFile();
+
+        void _flush();
+
+        void _removeOldFiles();
+
+        const boost::filesystem::path _directory;
+        const OperationContextFactory _makeOperationContext;
+
+        std::vector<std::unique_ptr<FTDCCollectorInterface>> _periodicCollectors;
+        std::vector<std::unique_ptr<FTDCCollectorInterface>> _metadataCollectors;
+
+        // Only used by the collector thread.
+        FTDCCompressor _compressor;
+        FTDCFileWriter _writer;
+        boost::filesystem::path _currentFile;
+        BSONObj _metadata;
+
+        mutable stdx::mutex _mutex;
+        stdx::condition_variable _stopRequestedCondition;
+        bool _stopRequested;
+        BSONObj _mostRecentSample;
+    };
+
+    /**
+     * Starts "controller" as the process' diagnostic data collector.
+     */
+    void startFTDC(std::unique_ptr<FTDCController> controller);
+
+    /**
+     * Stops the process' diagnostic data collector, if there is one.  Called on clean shutdown.
+     */
+    void stopFTDC();
+
+    /**
+     * Returns the process' diagnostic data collector, or NULL if none was started.
+     */
+    FTDCController* getGlobalFTDCController();
+
+}  // namespace mongo
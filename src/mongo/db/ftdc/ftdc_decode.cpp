@@ -0,0 +1,105 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * ftdcdecode: prints the contents of full-time diagnostic data capture files as JSON, one
+ * document per line.  Metadata documents are printed as stored, and each metric chunk is
+ * expanded into the samples it holds.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <iostream>
+#include <vector>
+
+#include "mongo/db/ftdc/ftdc_decompressor.h"
+#include "mongo/db/ftdc/ftdc_file.h"
+#include "mongo/db/ftdc/ftdc_util.h"
+
+namespace {
+
+    using namespace mongo;
+
+    bool decodeFile(const char* fileName) {
+        FTDCFileReader reader;
+        Status status = reader.open(fileName);
+        if (!status.isOK()) {
+            std::cerr << status.reason() << std::endl;
+            return false;
+        }
+
+        while (true) {
+            BSONObj doc;
+            StatusWith<bool> more = reader.readNext(&doc);
+            if (!more.isOK()) {
+                std::cerr << more.getStatus().reason() << std::endl;
+                return false;
+            }
+            if (!more.getValue()) {
+                return true;
+            }
+
+            StatusWith<FTDCBSONUtil::FTDCType> type = FTDCBSONUtil::getBSONDocumentType(doc);
+            if (!type.isOK()) {
+                std::cerr << fileName << ": " << type.getStatus().reason() << std::endl;
+                return false;
+            }
+
+            if (type.getValue() == FTDCBSONUtil::kMetadata) {
+                std::cout << doc.jsonString(Strict) << '\n';
+                continue;
+            }
+
+            StatusWith<std::vector<BSONObj>> samples = FTDCDecompressor::uncompress(doc);
+            if (!samples.isOK()) {
+                std::cerr << fileName << ": " << samples.getStatus().reason() << std::endl;
+                return false;
+            }
+            for (size_t i = 0; i < samples.getValue().size(); ++i) {
+                std::cout << samples.getValue()[i].jsonString(Strict) << '\n';
+            }
+        }
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <diagnostic data file>..." << std::endl;
+        return 2;
+    }
+
+    int exitCode = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!decodeFile(argv[i])) {
+            exitCode = 1;
+        }
+    }
+    std::cout.flush();
+    return exitCode;
+}
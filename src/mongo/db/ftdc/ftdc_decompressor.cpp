@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/ftdc/ftdc_decompressor.h"
+
+#include <memory>
+#include <zlib.h>
+
+#include "mongo/base/data_type_endian.h"
+#include "mongo/base/data_view.h"
+#include "mongo/db/ftdc/ftdc_util.h"
+#include "mongo/db/ftdc/ftdc_varint.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace FTDCDecompressor {
+
+namespace {
+
+    // Refuse chunks claiming more than this much data, as only a damaged file would.
+    const uint32_t kMaxUncompressedLength = 64 * 1024 * 1024;
+    const uint32_t kMaxDeltaCount = 1024 * 1024;
+
+    StatusWith<std::vector<BSONObj>> corrupt(const char* what) {
+        return StatusWith<std::vector<BSONObj>>(
+            ErrorCodes::InvalidBSON,
+            str::stream() << "Corrupt diagnostic data chunk: " << what);
+    }
+
+}  // namespace
+
+    StatusWith<std::vector<BSONObj>> uncompress(const BSONObj& chunk) {
+        const BSONElement dataElement = chunk[FTDCBSONUtil::kFTDCDataField];
+        if (dataElement.type() != BinData) {
+            return corrupt("missing data field");
+        }
+
+        int length = 0;
+        const char* data = dataElement.binData(length);
+        if (length < static_cast<int>(sizeof(uint32_t))) {
+            return corrupt("data too short");
+        }
+
+        const uint32_t uncompressedLength =
+            ConstDataView(data).read<LittleEndian<uint32_t>>();
+        if (uncompressedLength > kMaxUncompressedLength) {
+            return corrupt("uncompressed length too large");
+        }
+
+        std::unique_ptr<char[]> buffer(new char[uncompressedLength]);
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        int ret = ::inflateInit(&stream);
+        if (ret == Z_OK) {
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + sizeof(uint32_t)));
+            stream.avail_in = length - sizeof(uint32_t);
+            stream.next_out = reinterpret_cast<Bytef*>(buffer.get());
+            stream.avail_out = uncompressedLength;
+            ret = ::inflate(&stream, Z_FINISH);
+            ::inflateEnd(&stream);
+        }
+        if (ret != Z_STREAM_END || stream.total_out != uncompressedLength) {
+            return corrupt("failed to inflate data");
+        }
+
+        const char* pos = buffer.get();
+        const char* const end = pos + uncompressedLength;
+
+        if (end - pos < 5) {
+            return corrupt("missing reference document");
+        }
+        const int referenceSize = ConstDataView(pos).read<LittleEndian<int32_t>>();
+        if (referenceSize < 5 || referenceSize > end - pos) {
+            return corrupt("invalid reference document length");
+        }
+        const BSONObj reference(pos);
+        if (!reference.valid()) {
+            return corrupt("invalid reference document");
+        }
+        pos += referenceSize;
+
+        if (end - pos < static_cast<ptrdiff_t>(2 * sizeof(uint32_t))) {
+            return corrupt("missing metric counts");
+        }
+        const uint32_t metricCount = ConstDataView(pos).read<LittleEndian<uint32_t>>();
+        pos += sizeof(uint32_t);
+        const uint32_t deltaCount = ConstDataView(pos).read<LittleEndian<uint32_t>>();
+        pos += sizeof(uint32_t);
+
+        std::vector<long long> referenceMetrics;
+        FTDCBSONUtil::extractMetricsFromDocument(NULL, reference, &referenceMetrics);
+        if (referenceMetrics.size() != metricCount) {
+            return corrupt("metric count does not match the reference document");
+        }
+
+        if (deltaCount > kMaxDeltaCount) {
+            return corrupt("delta count too large");
+        }
+
+        std::vector<std::vector<long long>> samples(
+            deltaCount, std::vector<long long>(metricCount));
+
+        for (uint32_t metric = 0; metric < metricCount; ++metric) {
+            long long value = referenceMetrics[metric];
+            for (uint32_t sample = 0; sample < deltaCount; ++sample) {
+                uint64_t encoded;
+                if (!FTDCVarInt::read(&pos, end, &encoded)) {
+                    return corrupt("truncated deltas");
+                }
+
+                if (encoded == 0) {
+                    uint64_t zeroes;
+                    if (!FTDCVarInt::read(&pos, end, &zeroes) ||
+                            zeroes >= static_cast<uint64_t>(deltaCount - sample)) {
+                        return corrupt("invalid run of zero deltas");
+                    }
+                    for (uint64_t i = 0; i <= zeroes; ++i) {
+                        samples[sample++][metric] = value;
+                    }
+                    --sample;
+                    continue;
+                }
+
+                value = static_cast<long long>(
+                    static_cast<unsigned long long>(value) +
+                    static_cast<unsigned long long>(FTDCVarInt::zigzagDecode(encoded)));
+                samples[sample][metric] = value;
+            }
+        }
+
+        if (pos != end) {
+            return corrupt("trailing data");
+        }
+
+        std::vector<BSONObj> docs;
+        docs.reserve(deltaCount + 1);
+        docs.push_back(reference.getOwned());
+        for (uint32_t sample = 0; sample < deltaCount; ++sample) {
+            StatusWith<BSONObj> doc =
+                FTDCBSONUtil::constructDocumentFromMetrics(reference, samples[sample]);
+            if (!doc.isOK()) {
+                return StatusWith<std::vector<BSONObj>>(doc.getStatus());
+            }
+            docs.push_back(doc.getValue());
+        }
+
+        return StatusWith<std::vector<BSONObj>>(std::move(docs));
+    }
+
+}  // namespace FTDCDecompressor
+}  // namespace mongo
@@ -0,0 +1,123 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/ftdc/ftdc_file.h"
+
+#include <iterator>
+
+#include "mongo/base/data_type_endian.h"
+#include "mongo/base/data_view.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    Status FTDCFileWriter::open(const boost::filesystem::path& file) {
+        close();
+
+        _fileName = file.string();
+        _stream.open(_fileName.c_str(), std::ios_base::out | std::ios_base::binary |
+                                        std::ios_base::app);
+        if (!_stream.is_open()) {
+            return Status(ErrorCodes::FileNotOpen,
+                          str::stream() << "Failed to open diagnostic data file " << _fileName);
+        }
+        _stream.seekp(0, std::ios_base::end);
+        _size = _stream.tellp();
+        return Status::OK();
+    }
+
+    Status FTDCFileWriter::writeDocument(const BSONObj& doc) {
+        invariant(_stream.is_open());
+        _stream.write(doc.objdata(), doc.objsize());
+        _stream.flush();
+        if (_stream.fail()) {
+            return Status(ErrorCodes::FileStreamFailed,
+                          str::stream() << "Failed to write to diagnostic data file "
+                                        << _fileName);
+        }
+        _size += doc.objsize();
+        return Status::OK();
+    }
+
+    void FTDCFileWriter::close() {
+        if (_stream.is_open()) {
+            _stream.close();
+        }
+        _stream.clear();
+        _size = 0;
+    }
+
+    Status FTDCFileReader::open(const boost::filesystem::path& file) {
+        _fileName = file.string();
+        std::ifstream stream(_fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+        if (!stream.is_open()) {
+            return Status(ErrorCodes::FileNotOpen,
+                          str::stream() << "Failed to open diagnostic data file " << _fileName);
+        }
+        _data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        if (stream.bad()) {
+            return Status(ErrorCodes::FileStreamFailed,
+                          str::stream() << "Failed to read diagnostic data file " << _fileName);
+        }
+        _pos = 0;
+        return Status::OK();
+    }
+
+    StatusWith<bool> FTDCFileReader::readNext(BSONObj* doc) {
+        const size_t remaining = _data.size() - _pos;
+        if (remaining < sizeof(int32_t)) {
+            return StatusWith<bool>(false);
+        }
+
+        const char* start = _data.data() + _pos;
+        const int32_t size = ConstDataView(start).read<LittleEndian<int32_t>>();
+        if (size < BSONObj::kMinBSONLength) {
+            return StatusWith<bool>(ErrorCodes::InvalidBSON,
+                                    str::stream() << "Invalid document length " << size
+                                                  << " at offset " << _pos << " of "
+                                                  << _fileName);
+        }
+        if (static_cast<size_t>(size) > remaining) {
+            return StatusWith<bool>(false);
+        }
+
+        const BSONObj obj(start);
+        if (!obj.valid()) {
+            return StatusWith<bool>(ErrorCodes::InvalidBSON,
+                                    str::stream() << "Invalid document at offset " << _pos
+                                                  << " of " << _fileName);
+        }
+
+        _pos += size;
+        *doc = obj;
+        return StatusWith<bool>(true);
+    }
+
+}  // namespace mongo
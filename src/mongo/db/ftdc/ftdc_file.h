@@ -0,0 +1,97 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+#include <fstream>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/base/status_with.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * Appends FTDC documents to a file, flushing each one so that a crash loses at most the
+     * document being written.
+     */
+    class FTDCFileWriter {
+        MONGO_DISALLOW_COPYING(FTDCFileWriter);
+    public:
+        FTDCFileWriter() : _size(0) {}
+
+        Status open(const boost::filesystem::path& file);
+
+        Status writeDocument(const BSONObj& doc);
+
+        void close();
+
+        bool isOpen() const {
+            return _stream.is_open();
+        }
+
+        /**
+         * Bytes in the file, including what was there before it was opened.
+         */
+        size_t getSize() const {
+            return _size;
+        }
+
+    private:
+        std::string _fileName;
+        std::ofstream _stream;
+        size_t _size;
+    };
+
+    /**
+     * Reads back the documents written by FTDCFileWriter.
+     */
+    class FTDCFileReader {
+        MONGO_DISALLOW_COPYING(FTDCFileReader);
+    public:
+        FTDCFileReader() : _pos(0) {}
+
+        Status open(const boost::filesystem::path& file);
+
+        /**
+         * Reads the next document of the file into "doc", which stays valid until the reader is
+         * destroyed.  Returns false at the end of the file, including when the last document was
+         * cut short, as happens when the server exits while writing it.
+         */
+        StatusWith<bool> readNext(BSONObj* doc);
+
+    private:
+        std::string _fileName;
+        std::string _data;
+        size_t _pos;
+    };
+
+}  // namespace mongo
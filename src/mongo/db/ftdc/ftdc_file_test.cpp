@@ -0,0 +1,129 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#include "mongo/db/ftdc/ftdc_file.h"
+#include "mongo/db/ftdc/ftdc_util.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+    using namespace mongo;
+
+    const Date_t kDate = Date_t::fromMillisSinceEpoch(1436000000000LL);
+
+    TEST(FTDCFileTest, WriteAndReadBack) {
+        unittest::TempDir tempDir("ftdc_file_test");
+        const boost::filesystem::path file =
+            boost::filesystem::path(tempDir.path()) / "metrics.test";
+
+        const BSONObj metadata =
+            FTDCBSONUtil::createBSONMetadataDocument(BSON("version" << "3.1.4"), kDate);
+        const BSONObj chunk = FTDCBSONUtil::createBSONMetricChunkDocument("abcd", 4, kDate);
+
+        {
+            FTDCFileWriter writer;
+            ASSERT_OK(writer.open(file));
+            ASSERT_OK(writer.writeDocument(metadata));
+            ASSERT_OK(writer.writeDocument(chunk));
+            ASSERT_EQUALS(static_cast<size_t>(metadata.objsize() + chunk.objsize()),
+                          writer.getSize());
+        }
+
+        // Reopening appends.
+        {
+            FTDCFileWriter writer;
+            ASSERT_OK(writer.open(file));
+            ASSERT_EQUALS(static_cast<size_t>(metadata.objsize() + chunk.objsize()),
+                          writer.getSize());
+            ASSERT_OK(writer.writeDocument(chunk));
+        }
+
+        FTDCFileReader reader;
+        ASSERT_OK(reader.open(file));
+
+        BSONObj doc;
+        ASSERT_TRUE(reader.readNext(&doc).getValue());
+        ASSERT_EQUALS(metadata, doc);
+        ASSERT_EQUALS(FTDCBSONUtil::kMetadata, FTDCBSONUtil::getBSONDocumentType(doc).getValue());
+        ASSERT_TRUE(reader.readNext(&doc).getValue());
+        ASSERT_EQUALS(chunk, doc);
+        ASSERT_TRUE(reader.readNext(&doc).getValue());
+        ASSERT_EQUALS(chunk, doc);
+        ASSERT_FALSE(reader.readNext(&doc).getValue());
+    }
+
+    TEST(FTDCFileTest, TruncatedLastDocumentIsIgnored) {
+        unittest::TempDir tempDir("ftdc_file_test");
+        const boost::filesystem::path file =
+            boost::filesystem::path(tempDir.path()) / "metrics.test";
+
+        const BSONObj chunk = FTDCBSONUtil::createBSONMetricChunkDocument("abcd", 4, kDate);
+        {
+            std::ofstream stream(file.string().c_str(), std::ios_base::binary);
+            stream.write(chunk.objdata(), chunk.objsize());
+            stream.write(chunk.objdata(), chunk.objsize() - 3);
+        }
+
+        FTDCFileReader reader;
+        ASSERT_OK(reader.open(file));
+
+        BSONObj doc;
+        ASSERT_TRUE(reader.readNext(&doc).getValue());
+        ASSERT_EQUALS(chunk, doc);
+        ASSERT_FALSE(reader.readNext(&doc).getValue());
+    }
+
+    TEST(FTDCFileTest, CorruptDocumentIsAnError) {
+        unittest::TempDir tempDir("ftdc_file_test");
+        const boost::filesystem::path file =
+            boost::filesystem::path(tempDir.path()) / "metrics.test";
+
+        {
+            std::ofstream stream(file.string().c_str(), std::ios_base::binary);
+            const char bad[] = {2, 0, 0, 0, 0, 0};
+            stream.write(bad, sizeof(bad));
+        }
+
+        FTDCFileReader reader;
+        ASSERT_OK(reader.open(file));
+
+        BSONObj doc;
+        ASSERT_NOT_OK(reader.readNext(&doc).getStatus());
+    }
+
+    TEST(FTDCFileTest, MissingFile) {
+        FTDCFileReader reader;
+        ASSERT_NOT_OK(reader.open("/nonexistent/ftdc/metrics.test"));
+    }
+
+}  // namespace
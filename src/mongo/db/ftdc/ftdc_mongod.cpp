@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/ftdc/ftdc_mongod.h"
+
+#include <boost/filesystem/path.hpp>
+
+#include "mongo/db/ftdc/ftdc_controller.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+
+namespace {
+
+    std::unique_ptr<OperationContext> makeOperationContext() {
+        return stdx::make_unique<OperationContextImpl>();
+    }
+
+}  // namespace
+
+    void startMongoDFTDC() {
+        const boost::filesystem::path directory =
+            boost::filesystem::path(storageGlobalParams.dbpath) / "diagnostic.data";
+
+        std::unique_ptr<FTDCController> controller =
+            stdx::make_unique<FTDCController>(directory, &makeOperationContext);
+
+        controller->addPeriodicCollector(stdx::make_unique<FTDCCommandCollector>(
+            "serverStatus", BSON("serverStatus" << 1 << "tcmalloc" << true)));
+
+        if (repl::getGlobalReplicationCoordinator()->getReplicationMode() ==
+                repl::ReplicationCoordinator::modeReplSet) {
+            controller->addPeriodicCollector(stdx::make_unique<FTDCCommandCollector>(
+                "replSetGetStatus", BSON("replSetGetStatus" << 1)));
+        }
+
+        controller->addMetadataCollector(stdx::make_unique<FTDCCommandCollector>(
+            "buildInfo", BSON("buildInfo" << 1)));
+        controller->addMetadataCollector(stdx::make_unique<FTDCCommandCollector>(
+            "getCmdLineOpts", BSON("getCmdLineOpts" << 1)));
+        controller->addMetadataCollector(stdx::make_unique<FTDCCommandCollector>(
+            "hostInfo", BSON("hostInfo" << 1)));
+
+        startFTDC(std::move(controller));
+    }
+
+}  // namespace mongo
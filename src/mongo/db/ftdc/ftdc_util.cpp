@@ -0,0 +1,245 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/ftdc/ftdc_util.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "mongo/bson/timestamp.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace FTDCBSONUtil {
+
+    const char kFTDCIdField[] = "_id";
+    const char kFTDCTypeField[] = "type";
+    const char kFTDCDocField[] = "doc";
+    const char kFTDCDataField[] = "data";
+
+namespace {
+
+    /**
+     * Converts a double metric to an integer, which is all the precision FTDC keeps.
+     */
+    long long doubleToMetric(double value) {
+        if (std::isnan(value)) {
+            return 0;
+        }
+        if (value >= static_cast<double>(std::numeric_limits<long long>::max())) {
+            return std::numeric_limits<long long>::max();
+        }
+        if (value <= static_cast<double>(std::numeric_limits<long long>::min())) {
+            return std::numeric_limits<long long>::min();
+        }
+        return static_cast<long long>(value);
+    }
+
+    Status constructDocument(BSONObjBuilder* builder,
+                             const BSONObj& reference,
+                             const std::vector<long long>& metrics,
+                             size_t* pos) {
+        BSONObjIterator it(reference);
+        while (it.more()) {
+            const BSONElement element = it.next();
+
+            size_t needed = 0;
+            switch (element.type()) {
+            case NumberDouble:
+            case NumberInt:
+            case NumberLong:
+            case Bool:
+            case Date:
+                needed = 1;
+                break;
+            case bsonTimestamp:
+                needed = 2;
+                break;
+            default:
+                break;
+            }
+
+            if (*pos + needed > metrics.size()) {
+                return Status(ErrorCodes::InvalidLength,
+                              "Not enough metrics to rebuild the reference document");
+            }
+
+            switch (element.type()) {
+            case NumberDouble:
+                builder->append(element.fieldName(), static_cast<double>(metrics[*pos]));
+                break;
+            case NumberInt:
+                builder->append(element.fieldName(), static_cast<int>(metrics[*pos]));
+                break;
+            case NumberLong:
+                builder->append(element.fieldName(), metrics[*pos]);
+                break;
+            case Bool:
+                builder->appendBool(element.fieldName(), metrics[*pos] != 0);
+                break;
+            case Date:
+                builder->appendDate(element.fieldName(),
+                                    Date_t::fromMillisSinceEpoch(metrics[*pos]));
+                break;
+            case bsonTimestamp:
+                builder->append(element.fieldName(),
+                                Timestamp(static_cast<unsigned>(metrics[*pos]),
+                                          static_cast<unsigned>(metrics[*pos + 1])));
+                break;
+            case Object: {
+                BSONObjBuilder sub(builder->subobjStart(element.fieldName()));
+                Status status = constructDocument(&sub, element.Obj(), metrics, pos);
+                if (!status.isOK()) {
+                    return status;
+                }
+                break;
+            }
+            case Array: {
+                BSONObjBuilder sub(builder->subarrayStart(element.fieldName()));
+                Status status = constructDocument(&sub, element.Obj(), metrics, pos);
+                if (!status.isOK()) {
+                    return status;
+                }
+                break;
+            }
+            default:
+                builder->append(element);
+                break;
+            }
+
+            *pos += needed;
+        }
+        return Status::OK();
+    }
+
+}  // namespace
+
+    bool extractMetricsFromDocument(const BSONObj* reference,
+                                    const BSONObj& doc,
+                                    std::vector<long long>* metrics) {
+        BSONObjIterator docIt(doc);
+        BSONObjIterator refIt(reference ? *reference : BSONObj());
+
+        while (docIt.more()) {
+            const BSONElement element = docIt.next();
+
+            BSONElement refElement;
+            if (reference) {
+                if (!refIt.more()) {
+                    return false;
+                }
+                refElement = refIt.next();
+                if (refElement.type() != element.type() ||
+                        strcmp(refElement.fieldName(), element.fieldName()) != 0) {
+                    return false;
+                }
+            }
+
+            switch (element.type()) {
+            case NumberDouble:
+                metrics->push_back(doubleToMetric(element.numberDouble()));
+                break;
+            case NumberInt:
+            case NumberLong:
+                metrics->push_back(element.numberLong());
+                break;
+            case Bool:
+                metrics->push_back(element.boolean() ? 1 : 0);
+                break;
+            case Date:
+                metrics->push_back(element.date().toMillisSinceEpoch());
+                break;
+            case bsonTimestamp:
+                metrics->push_back(element.timestamp().getSecs());
+                metrics->push_back(element.timestamp().getInc());
+                break;
+            case Object:
+            case Array: {
+                const BSONObj refSub = reference ? refElement.Obj() : BSONObj();
+                if (!extractMetricsFromDocument(reference ? &refSub : NULL,
+                                                element.Obj(),
+                                                metrics)) {
+                    return false;
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        return !(reference && refIt.more());
+    }
+
+    StatusWith<BSONObj> constructDocumentFromMetrics(const BSONObj& reference,
+                                                     const std::vector<long long>& metrics) {
+        BSONObjBuilder builder;
+        size_t pos = 0;
+        Status status = constructDocument(&builder, reference, metrics, &pos);
+        if (!status.isOK()) {
+            return StatusWith<BSONObj>(status);
+        }
+        if (pos != metrics.size()) {
+            return StatusWith<BSONObj>(ErrorCodes::InvalidLength,
+                                       "Too many metrics for the reference document");
+        }
+        return StatusWith<BSONObj>(builder.obj());
+    }
+
+    BSONObj createBSONMetadataDocument(const BSONObj& metadata, Date_t date) {
+        BSONObjBuilder builder;
+        builder.appendDate(kFTDCIdField, date);
+        builder.append(kFTDCTypeField, static_cast<int>(kMetadata));
+        builder.append(kFTDCDocField, metadata);
+        return builder.obj();
+    }
+
+    BSONObj createBSONMetricChunkDocument(const char* data, size_t length, Date_t date) {
+        BSONObjBuilder builder;
+        builder.appendDate(kFTDCIdField, date);
+        builder.append(kFTDCTypeField, static_cast<int>(kMetricChunk));
+        builder.appendBinData(kFTDCDataField, static_cast<int>(length), BinDataGeneral, data);
+        return builder.obj();
+    }
+
+    StatusWith<FTDCType> getBSONDocumentType(const BSONObj& doc) {
+        const BSONElement type = doc[kFTDCTypeField];
+        if (!type.isNumber() ||
+                (type.numberInt() != kMetadata && type.numberInt() != kMetricChunk)) {
+            return StatusWith<FTDCType>(ErrorCodes::BadValue,
+                                        str::stream() << "Invalid FTDC document type: "
+                                                      << type);
+        }
+        return StatusWith<FTDCType>(static_cast<FTDCType>(type.numberInt()));
+    }
+
+}  // namespace FTDCBSONUtil
+}  // namespace mongo
@@ -0,0 +1,91 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/base/status_with.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    /**
+     * Helpers shared by the full-time diagnostic data capture (FTDC) writer and readers.
+     *
+     * FTDC files are a sequence of BSON documents, each of the form
+     *
+     *     { _id: <Date>, type: <FTDCType>, ... }
+     *
+     * A metadata document ("type: 0") stores a document in its "doc" field.  A metric chunk
+     * document ("type: 1") stores a compressed run of samples in its "data" field; see
+     * FTDCCompressor for its layout.
+     */
+    namespace FTDCBSONUtil {
+
+        enum FTDCType {
+            kMetadata = 0,
+            kMetricChunk = 1,
+        };
+
+        extern const char kFTDCIdField[];
+        extern const char kFTDCTypeField[];
+        extern const char kFTDCDocField[];
+        extern const char kFTDCDataField[];
+
+        /**
+         * Appends the metrics found in "doc" to "metrics", visiting nested documents and arrays
+         * depth first.  Numbers, booleans and dates are one metric each, and timestamps are two.
+         * Other types carry no metrics.
+         *
+         * If "reference" is not NULL, also checks that "doc" has the same schema as
+         * "*reference", that is the same field names holding the same types in the same order,
+         * and returns false as soon as it does not.  Returns true otherwise.
+         */
+        bool extractMetricsFromDocument(const BSONObj* reference,
+                                        const BSONObj& doc,
+                                        std::vector<long long>* metrics);
+
+        /**
+         * Rebuilds a document with the schema of "reference" whose metrics take the values in
+         * "metrics", the inverse of extractMetricsFromDocument().  Fields that carry no metrics
+         * are copied from "reference".
+         */
+        StatusWith<BSONObj> constructDocumentFromMetrics(const BSONObj& reference,
+                                                         const std::vector<long long>& metrics);
+
+        BSONObj createBSONMetadataDocument(const BSONObj& metadata, Date_t date);
+
+        BSONObj createBSONMetricChunkDocument(const char* data, size_t length, Date_t date);
+
+        StatusWith<FTDCType> getBSONDocumentType(const BSONObj& doc);
+
+    }  // namespace FTDCBSONUtil
+}  // namespace mongo
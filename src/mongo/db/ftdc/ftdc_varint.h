@@ -0,0 +1,86 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "mongo/bson/util/builder.h"
+
+namespace mongo {
+
+    /**
+     * Unsigned LEB128 variable length integers, as used by the FTDC metric chunks.
+     */
+    namespace FTDCVarInt {
+
+        // The longest encoding of a 64-bit value.
+        const size_t kMaxSizeBytes64 = 10;
+
+        inline uint64_t zigzagEncode(long long value) {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        inline long long zigzagDecode(uint64_t value) {
+            return static_cast<long long>((value >> 1) ^ (~(value & 1) + 1));
+        }
+
+        inline void append(BufBuilder* builder, uint64_t value) {
+            char buf[kMaxSizeBytes64];
+            size_t len = 0;
+            do {
+                uint8_t byte = value & 0x7f;
+                value >>= 7;
+                if (value) {
+                    byte |= 0x80;
+                }
+                buf[len++] = static_cast<char>(byte);
+            } while (value);
+            builder->appendBuf(buf, len);
+        }
+
+        /**
+         * Decodes the varint at "*pos", which must be before "end", and advances "*pos" past it.
+         * Returns false if the encoding is truncated or too long.
+         */
+        inline bool read(const char** pos, const char* end, uint64_t* value) {
+            uint64_t result = 0;
+            for (size_t i = 0; i < kMaxSizeBytes64 && *pos < end; ++i) {
+                const uint8_t byte = static_cast<uint8_t>(**pos);
+                ++*pos;
+                result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+                if (!(byte & 0x80)) {
+                    *value = result;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    }  // namespace FTDCVarInt
+}  // namespace mongo
@@ -59,6 +59,7 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/exec/delete.h"
 #include "mongo/db/exec/update.h"
+#include "mongo/db/ftdc/ftdc_controller.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/global_timestamp.h"
 #include "mongo/db/instance.h"
@@ -406,6 +407,10 @@ namespace {
             audit::logQueryAuthzCheck(client, nss, q.query, status.code());
             uassertStatusOK(status);
 
+            if (nss.coll() == "system.profile") {
+                waitForProfileWrites(txn);
+            }
+
             dbResponse.exhaustNS = runQuery(txn, q, nss, op, *resp);
             verify( !resp->empty() );
         }
@@ -1290,6 +1295,9 @@ namespace {
             return;
         }
 
+        // Write out the diagnostic data gathered so far while its collectors can still run.
+        stopFTDC();
+
         getGlobalServiceContext()->setKillAllOperations();
 
         repl::getGlobalReplicationCoordinator()->shutdown();
@@ -1343,6 +1351,7 @@ namespace {
         audit::logShutdown(&cc());
 
         log(LogComponent::kControl) << "dbexit: " << why << " rc: " << rc;
+        flushLogs();
 
 #ifdef _WIN32
         // Windows Service Controller wants to be told when we are down,
@@ -32,25 +32,62 @@
 
 #include "mongo/db/introspect.h"
 
-#include "mongo/bson/util/builder.h"
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "mongo/base/counter.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_set.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
-    using boost::scoped_ptr;
     using std::endl;
     using std::string;
+    using std::vector;
+
+    // Upper bound on the total size of the profile entries waiting to be written.  Entries of
+    // operations that finish while the buffer is full are dropped.
+    MONGO_EXPORT_SERVER_PARAMETER(profileWriteBufferSizeBytes, int, 16 * 1024 * 1024);
 
 namespace {
 
+    Counter64 profileEntriesWritten;
+    Counter64 profileEntriesDropped;
+    Counter64 profileBatchesWritten;
+
+    ServerStatusMetricField<Counter64> displayProfileEntriesWritten(
+            "profiler.written", &profileEntriesWritten);
+    ServerStatusMetricField<Counter64> displayProfileEntriesDropped(
+            "profiler.dropped", &profileEntriesDropped);
+    ServerStatusMetricField<Counter64> displayProfileBatchesWritten(
+            "profiler.batches", &profileBatchesWritten);
+
+    // Maximum number of entries inserted into one system.profile collection in a single
+    // WriteUnitOfWork.
+    const size_t kMaxEntriesPerWriteUnit = 100;
+
+    // How long waitForProfileWrites() waits for the writer before giving up.
+    const Milliseconds kWaitForProfileWritesTimeout(10 * 1000);
+
     void _appendUserInfo(const CurOp& c,
                          BSONObjBuilder& builder,
                          AuthorizationSession* authSession) {
@@ -79,88 +116,207 @@ namespace {
 
     }
 
-} // namespace
-
+    /**
+     * Writes profile entries to system.profile on a background thread, so that profiled
+     * operations do not pay for the database lock and the insert themselves.
+     *
+     * Entries wait in a queue bounded by profileWriteBufferSizeBytes.  The writer takes
+     * everything queued, and inserts the entries for each database in as few write units as
+     * possible.  Entries that do not fit in the queue are dropped and counted.
+     */
+    class ProfileWriter : public BackgroundJob {
+    public:
+        ProfileWriter() : _bufferedBytes(0), _numEnqueued(0), _numProcessed(0), _started(false) {}
+
+        virtual string name() const { return "ProfileWriter"; }
+
+        void enqueue(const string& dbName, const BSONObj& entry) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+            if (_bufferedBytes + entry.objsize() > profileWriteBufferSizeBytes) {
+                profileEntriesDropped.increment();
+                return;
+            }
 
-    void profile(OperationContext* txn, int op) {
-        // Initialize with 1kb at start in order to avoid realloc later
-        BufBuilder profileBufBuilder(1024);
+            if (!_started) {
+                go();
+                _started = true;
+            }
 
-        BSONObjBuilder b(profileBufBuilder);
+            _queue.push_back(Entry(dbName, entry));
+            _bufferedBytes += entry.objsize();
+            ++_numEnqueued;
+            _queueNotEmpty.notify_one();
+        }
 
-        {
-            Locker::LockerInfo lockerInfo;
-            txn->lockState()->getLockerInfo(&lockerInfo);
-            CurOp::get(txn)->debug().append(*CurOp::get(txn), lockerInfo.stats, b);
+        /**
+         * Waits until every entry enqueued before this call has been written or discarded.
+         * Returns false if that took longer than "timeout".
+         */
+        bool waitForPending(Milliseconds timeout) {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            const unsigned long long target = _numEnqueued;
+            return _entriesProcessed.wait_for(lk, timeout, [this, target] {
+                return _numProcessed >= target;
+            });
         }
 
-        b.appendDate("ts", jsTime());
-        b.append("client", txn->getClient()->clientAddress());
+        virtual void run() {
+            Client::initThread(name().c_str());
 
-        AuthorizationSession * authSession = AuthorizationSession::get(txn->getClient());
-        _appendUserInfo(*CurOp::get(txn), b, authSession);
+            while (!inShutdown()) {
+                std::deque<Entry> batch;
+                {
+                    stdx::unique_lock<stdx::mutex> lk(_mutex);
+                    if (_queue.empty()) {
+                        _queueNotEmpty.wait_for(lk, Milliseconds(1000));
+                        continue;
+                    }
+                    batch.swap(_queue);
+                    _bufferedBytes = 0;
+                }
 
-        const BSONObj p = b.done();
+                _writeBatch(batch);
 
-        const bool wasLocked = txn->lockState()->isLocked();
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _numProcessed += batch.size();
+                _entriesProcessed.notify_all();
+            }
+        }
 
-        const string dbName(nsToDatabase(CurOp::get(txn)->getNS()));
+    private:
+        struct Entry {
+            Entry(const string& dbName, const BSONObj& doc) : dbName(dbName), doc(doc) {}
 
-        try {
-            bool acquireDbXLock = false;
-            while (true) {
-                ScopedTransaction scopedXact(txn, MODE_IX);
+            string dbName;
+            BSONObj doc;
+        };
 
-                boost::scoped_ptr<AutoGetDb> autoGetDb;
-                if (acquireDbXLock) {
-                    autoGetDb.reset(new AutoGetDb(txn, dbName, MODE_X));
-                    if (autoGetDb->getDb()) {
-                        createProfileCollection(txn, autoGetDb->getDb());
-                    }
-                }
-                else {
-                    autoGetDb.reset(new AutoGetDb(txn, dbName, MODE_IX));
-                }
+        void _writeBatch(const std::deque<Entry>& batch) {
+            // Group by database, keeping the entries of each database in the order they finished.
+            typedef std::map<string, vector<BSONObj> > EntriesByDb;
+            EntriesByDb entriesByDb;
+            for (std::deque<Entry>::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+                entriesByDb[it->dbName].push_back(it->doc);
+            }
 
-                Database* const db = autoGetDb->getDb();
-                if (!db) {
-                    // Database disappeared
-                    log() << "note: not profiling because db went away for "
-                          << CurOp::get(txn)->getNS();
-                    break;
+            OperationContextImpl txn;
+            for (EntriesByDb::const_iterator it = entriesByDb.begin();
+                    it != entriesByDb.end(); ++it) {
+                const vector<BSONObj>& entries = it->second;
+                for (size_t i = 0; i < entries.size(); i += kMaxEntriesPerWriteUnit) {
+                    const size_t end = std::min(entries.size(), i + kMaxEntriesPerWriteUnit);
+                    _writeEntries(&txn, it->first, entries.begin() + i, entries.begin() + end);
                 }
+            }
+        }
 
-                Lock::CollectionLock collLock(txn->lockState(), db->getProfilingNS(), MODE_IX);
+        void _writeEntries(OperationContext* txn,
+                           const string& dbName,
+                           vector<BSONObj>::const_iterator begin,
+                           vector<BSONObj>::const_iterator end) {
+            try {
+                bool acquireDbXLock = false;
+                while (true) {
+                    bool written = false;
+                    MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                        ScopedTransaction scopedXact(txn, MODE_IX);
+                        AutoGetDb autoGetDb(txn, dbName, acquireDbXLock ? MODE_X : MODE_IX);
+
+                        Database* const db = autoGetDb.getDb();
+                        if (!db) {
+                            // Database disappeared
+                            log() << "note: not profiling because db went away for " << dbName;
+                            return;
+                        }
+
+                        if (acquireDbXLock) {
+                            createProfileCollection(txn, db);
+                        }
+
+                        Lock::CollectionLock collLock(txn->lockState(),
+                                                      db->getProfilingNS(),
+                                                      MODE_IX);
+
+                        Collection* const coll = db->getCollection(db->getProfilingNS());
+                        if (coll) {
+                            WriteUnitOfWork wuow(txn);
+                            for (vector<BSONObj>::const_iterator it = begin; it != end; ++it) {
+                                coll->insertDocument(txn, *it, false);
+                            }
+                            wuow.commit();
+                            written = true;
+                        }
+                    } MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn, "profile", dbName);
+
+                    if (written) {
+                        profileEntriesWritten.increment(end - begin);
+                        profileBatchesWritten.increment();
+                        return;
+                    }
 
-                Collection* const coll = db->getCollection(db->getProfilingNS());
-                if (coll) {
-                    WriteUnitOfWork wuow(txn);
-                    coll->insertDocument(txn, p, false);
-                    wuow.commit();
+                    if (acquireDbXLock) {
+                        // Cannot write the profile information
+                        return;
+                    }
 
-                    break;
-                }
-                else if (!acquireDbXLock &&
-                            (!wasLocked || txn->lockState()->isDbLockedForMode(dbName, MODE_X))) {
-                    // Try to create the collection only if we are not under lock, in order to
-                    // avoid deadlocks due to lock conversion. This would only be hit if someone
-                    // deletes the profiler collection after setting profile level.
+                    // This would only be hit if someone deletes the profiler collection after
+                    // setting profile level.  The writer holds no other locks, so it can safely
+                    // take the database lock exclusively to recreate it.
                     acquireDbXLock = true;
                 }
-                else {
-                    // Cannot write the profile information
-                    break;
-                }
+            }
+            catch (const DBException& ex) {
+                warning() << "Caught exception while writing " << (end - begin)
+                          << " profile entries to " << dbName << ": " << ex.toString();
             }
         }
-        catch (const AssertionException& assertionEx) {
-            warning() << "Caught Assertion while trying to profile "
-                      << opToString(op)
-                      << " against " << CurOp::get(txn)->getNS()
-                      << ": " << assertionEx.toString() << endl;
+
+        stdx::mutex _mutex;
+        stdx::condition_variable _queueNotEmpty;
+        stdx::condition_variable _entriesProcessed;
+
+        std::deque<Entry> _queue;
+        int _bufferedBytes;
+        unsigned long long _numEnqueued;
+        unsigned long long _numProcessed;
+        bool _started;
+    };
+
+    // Never deleted, since the writer thread may still be running at exit.
+    ProfileWriter* const profileWriter = new ProfileWriter();
+
+} // namespace
+
+
+    void profile(OperationContext* txn, int op) {
+        // Initialize with 1kb at start in order to avoid realloc later
+        BSONObjBuilder b(1024);
+
+        {
+            Locker::LockerInfo lockerInfo;
+            txn->lockState()->getLockerInfo(&lockerInfo);
+            CurOp::get(txn)->debug().append(*CurOp::get(txn), lockerInfo.stats, b);
         }
+
+        b.appendDate("ts", jsTime());
+        b.append("client", txn->getClient()->clientAddress());
+
+        AuthorizationSession * authSession = AuthorizationSession::get(txn->getClient());
+        _appendUserInfo(*CurOp::get(txn), b, authSession);
+
+        profileWriter->enqueue(nsToDatabase(CurOp::get(txn)->getNS()), b.obj());
     }
 
+    void waitForProfileWrites(OperationContext* txn) {
+        if (txn->lockState()->isLocked()) {
+            return;
+        }
+
+        if (!profileWriter->waitForPending(kWaitForProfileWritesTimeout)) {
+            warning() << "Timed out waiting for pending profile entries to be written";
+        }
+    }
 
     Status createProfileCollection(OperationContext* txn, Database *db) {
         invariant(txn->lockState()->isDbLockedForMode(db->name(), MODE_X));
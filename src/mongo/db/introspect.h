@@ -36,10 +36,18 @@ namespace mongo {
     class OperationContext;
 
     /**
-     * Invoked when database profile is enabled.
+     * Invoked when database profile is enabled.  Builds the profile entry for the current
+     * operation and queues it to be written to system.profile by a background thread.
      */
     void profile(OperationContext* txn, int op);
 
+    /**
+     * Waits until the profile entries of all operations that finished before this call have been
+     * written to system.profile, so that a client reading the profile sees its own operations.
+     * Returns immediately if "txn" holds any locks, since the writer may need them.
+     */
+    void waitForProfileWrites(OperationContext* txn);
+
     /**
      * Pre-creates the profile collection for the specified database.
      */
@@ -450,6 +450,8 @@ namespace mongo {
         _regexes.clear();
     }
 
+    const size_t ArrayFilterEntries::kMinEqualitiesToHash;
+
     Status ArrayFilterEntries::addEquality( const BSONElement& e ) {
         if ( e.type() == RegEx )
             return Status( ErrorCodes::BadValue, "ArrayFilterEntries equality cannot be a regex" );
@@ -467,6 +469,14 @@ namespace mongo {
             _hasEmptyArray = true;
 
         _equalities.insert( e );
+
+        if ( _hashedEqualities ) {
+            _hashedEqualities->insert( e );
+        }
+        else if ( _equalities.size() >= kMinEqualitiesToHash ) {
+            _hashedEqualities.reset( new HashedElementSet( _equalities.begin(),
+                                                           _equalities.end() ) );
+        }
         return Status::OK();
     }
 
@@ -492,6 +502,8 @@ namespace mongo {
         toFillIn._hasNull = _hasNull;
         toFillIn._hasEmptyArray = _hasEmptyArray;
         toFillIn._equalities = _equalities;
+        if ( _hashedEqualities )
+            toFillIn._hashedEqualities.reset( new HashedElementSet( *_hashedEqualities ) );
         for ( unsigned i = 0; i < _regexes.size(); i++ )
             toFillIn._regexes.push_back( static_cast<RegexMatchExpression*>(_regexes[i]->shallowClone()) );
     }
@@ -35,6 +35,7 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/platform/unordered_set.h"
 
 namespace pcrecpp {
     class RE;
@@ -295,7 +296,11 @@ namespace mongo {
         Status addRegex( RegexMatchExpression* expr );
 
         const BSONElementSet& equalities() const { return _equalities; }
-        bool contains( const BSONElement& elem ) const { return _equalities.count(elem) > 0; }
+        bool contains( const BSONElement& elem ) const {
+            if ( _hashedEqualities )
+                return _hashedEqualities->count(elem) > 0;
+            return _equalities.count(elem) > 0;
+        }
 
         size_t numRegexes() const { return _regexes.size(); }
         RegexMatchExpression* regex( int idx ) const { return _regexes[idx]; }
@@ -313,10 +318,21 @@ namespace mongo {
 
         void toBSON(BSONArrayBuilder* out) const;
 
+        /**
+         * Once there are this many equalities, contains() is answered from a hash table rather
+         * than by a walk of the _equalities tree.
+         */
+        static const size_t kMinEqualitiesToHash = 16;
+
     private:
+        typedef unordered_set<BSONElement,
+                              BSONElementHasherWithoutField,
+                              BSONElementEqWithoutField> HashedElementSet;
+
         bool _hasNull; // if _equalities has a jstNULL element in it
         bool _hasEmptyArray;
         BSONElementSet _equalities;
+        boost::scoped_ptr<HashedElementSet> _hashedEqualities; // same elements as _equalities
         std::vector<RegexMatchExpression*> _regexes;
     };
 
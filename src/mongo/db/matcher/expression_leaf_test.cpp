@@ -1479,6 +1479,45 @@ namespace mongo {
     }
 
 
+    TEST( InMatchExpression, MatchesElementManyHashed ) {
+        BSONArrayBuilder bab;
+        for ( int i = 0; i < 1000; i++ ) {
+            bab.append( i * 2 );
+        }
+        bab.append( "str" );
+        bab.append( BSON( "x" << 1 ) );
+        BSONObj operand = bab.arr();
+
+        InMatchExpression in;
+        in.init( "a" );
+        BSONObjIterator it( operand );
+        while ( it.more() ) {
+            ASSERT_OK( in.getArrayFilterEntries()->addEquality( it.next() ) );
+        }
+
+        // Numbers of all types compare, and so match, by value.
+        ASSERT( in.matchesBSON( BSON( "a" << 10 ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << 10.0 ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << 10LL ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << 1998 ), NULL ) );
+        ASSERT( !in.matchesBSON( BSON( "a" << 11 ), NULL ) );
+        ASSERT( !in.matchesBSON( BSON( "a" << 10.5 ), NULL ) );
+        ASSERT( !in.matchesBSON( BSON( "a" << 2000 ), NULL ) );
+
+        ASSERT( in.matchesBSON( BSON( "a" << "str" ), NULL ) );
+        ASSERT( !in.matchesBSON( BSON( "a" << "st" ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << BSON( "x" << 1.0 ) ), NULL ) );
+        ASSERT( !in.matchesBSON( BSON( "a" << BSON( "y" << 1 ) ), NULL ) );
+        ASSERT( in.matchesBSON( BSON( "a" << BSON_ARRAY( 3 << 4 ) ), NULL ) );
+
+        // A copy keeps answering from its own hash table.
+        InMatchExpression copy;
+        in.copyTo( &copy );
+        ASSERT( copy.matchesBSON( BSON( "a" << 4.0 ), NULL ) );
+        ASSERT( !copy.matchesBSON( BSON( "a" << 5 ), NULL ) );
+        ASSERT( copy.equivalent( &in ) );
+    }
+
     TEST( InMatchExpression, MatchesScalar ) {
         BSONObj operand = BSON_ARRAY( 5 );
         InMatchExpression in;
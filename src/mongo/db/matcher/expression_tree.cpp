@@ -33,9 +33,43 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/matcher/matchable.h"
 
 namespace mongo {
 
+    namespace {
+
+        // Number of top level leaves of a single $and whose fields are looked up together.  Any
+        // further leaves are matched through their own path lookups.
+        const size_t kMaxSinglePassLeaves = 16;
+
+        /**
+         * Returns true if 'expr' is a LeafMatchExpression over a single, undotted field name.
+         * For such an expression matches() is equivalent to matchesSingleElement() on
+         * BSONObj::getField() of that name, unless the field holds an array.
+         */
+        bool isTopLevelLeaf( const MatchExpression* expr ) {
+            switch ( expr->matchType() ) {
+            case MatchExpression::EQ:
+            case MatchExpression::LTE:
+            case MatchExpression::LT:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+            case MatchExpression::REGEX:
+            case MatchExpression::MOD:
+            case MatchExpression::EXISTS:
+            case MatchExpression::MATCH_IN:
+                break;
+            default:
+                return false;
+            }
+
+            const StringData path = expr->path();
+            return !path.empty() && path.find( '.' ) == std::string::npos;
+        }
+
+    } // namespace
+
     ListOfMatchExpression::~ListOfMatchExpression() {
         for ( unsigned i = 0; i < _expressions.size(); i++ )
             delete _expressions[i];
@@ -81,6 +115,13 @@ namespace mongo {
     // -----
 
     bool AndMatchExpression::matches( const MatchableDocument* doc, MatchDetails* details ) const {
+        if ( numChildren() > 1 ) {
+            const BSONObj* obj = doc->getBSONObj();
+            if ( obj ) {
+                return _matchesSinglePass( *obj, doc, details );
+            }
+        }
+
         for ( size_t i = 0; i < numChildren(); i++ ) {
             if ( !getChild(i)->matches( doc, details ) ) {
                 if ( details )
@@ -91,6 +132,70 @@ namespace mongo {
         return true;
     }
 
+    bool AndMatchExpression::_matchesSinglePass( const BSONObj& obj,
+                                                 const MatchableDocument* doc,
+                                                 MatchDetails* details ) const {
+        // The top level leaves, in child order, and the first element of 'obj' named by each
+        // (EOO until it has been seen).
+        size_t leafChild[kMaxSinglePassLeaves];
+        StringData leafPath[kMaxSinglePassLeaves];
+        BSONElement leafElt[kMaxSinglePassLeaves];
+        size_t numLeaves = 0;
+
+        for ( size_t i = 0; i < numChildren() && numLeaves < kMaxSinglePassLeaves; i++ ) {
+            const MatchExpression* child = getChild(i);
+            if ( isTopLevelLeaf( child ) ) {
+                leafChild[numLeaves] = i;
+                leafPath[numLeaves] = child->path();
+                numLeaves++;
+            }
+        }
+
+        // The fields of 'obj' are walked at most once, and only as far as the leaf currently
+        // being evaluated needs.  Every element passed over on the way is recorded for the
+        // leaves that come later, so a conjunction that fails early reads no more of the
+        // document than before.
+        BSONObjIterator it( obj );
+        size_t nextLeaf = 0;
+
+        for ( size_t i = 0; i < numChildren(); i++ ) {
+            const MatchExpression* child = getChild(i);
+            bool childMatches;
+
+            if ( nextLeaf < numLeaves && leafChild[nextLeaf] == i ) {
+                const size_t slot = nextLeaf++;
+                while ( leafElt[slot].eoo() && it.more() ) {
+                    const BSONElement e = it.next();
+                    const StringData fieldName = e.fieldNameStringData();
+                    for ( size_t j = slot; j < numLeaves; j++ ) {
+                        if ( leafElt[j].eoo() && leafPath[j] == fieldName ) {
+                            leafElt[j] = e;
+                        }
+                    }
+                }
+
+                // Arrays go through the full path iteration, which matches against their
+                // contents and reports the matching offset in 'details'.
+                if ( leafElt[slot].type() == Array ) {
+                    childMatches = child->matches( doc, details );
+                }
+                else {
+                    childMatches = child->matchesSingleElement( leafElt[slot] );
+                }
+            }
+            else {
+                childMatches = child->matches( doc, details );
+            }
+
+            if ( !childMatches ) {
+                if ( details )
+                    details->resetOutput();
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool AndMatchExpression::matchesSingleElement( const BSONElement& e ) const {
         for ( size_t i = 0; i < numChildren(); i++ ) {
             if ( !getChild(i)->matchesSingleElement( e ) ) {
@@ -95,6 +95,17 @@ namespace mongo {
         virtual void debugString( StringBuilder& debug, int level = 0 ) const;
 
         virtual void toBSON(BSONObjBuilder* out) const;
+
+    private:
+        /**
+         * matches() for a document backed by 'obj'.  Children that are leaves over a top level
+         * field find their elements through a single, incremental scan of 'obj' rather than a
+         * separate lookup each; all other children, and leaves whose field is an array, are
+         * matched against 'doc' as usual.
+         */
+        bool _matchesSinglePass( const BSONObj& obj,
+                                 const MatchableDocument* doc,
+                                 MatchDetails* details ) const;
     };
 
     class OrMatchExpression : public ListOfMatchExpression {
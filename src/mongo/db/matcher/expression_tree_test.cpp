@@ -208,6 +208,81 @@ namespace mongo {
         ASSERT_EQUALS( "1", details.elemMatchKey() );
     }
 
+    TEST( AndOp, TopLevelFieldsInAnyOrder ) {
+        BSONObj operand = BSON( "a" << 1 << "b" << 2 << "c" << 3 );
+
+        AndMatchExpression andOp;
+        for ( BSONObjIterator it( operand ); it.more(); ) {
+            BSONElement e = it.next();
+            auto_ptr<ComparisonMatchExpression> sub( new EqualityMatchExpression() );
+            ASSERT( sub->init( e.fieldName(), e ).isOK() );
+            andOp.add( sub.release() );
+        }
+
+        ASSERT( andOp.matchesBSON( BSON( "a" << 1 << "b" << 2 << "c" << 3 ), NULL ) );
+        ASSERT( andOp.matchesBSON( BSON( "c" << 3 << "b" << 2 << "a" << 1 ), NULL ) );
+        ASSERT( andOp.matchesBSON( BSON( "x" << 0 << "c" << 3 << "y" << 0 << "a" << 1 <<
+                                         "b" << 2 << "z" << 0 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "c" << 3 << "b" << 2 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "c" << 3 << "b" << 2 << "a" << 4 ), NULL ) );
+        // As with BSONObj::getField(), only the first of several same named fields is used.
+        ASSERT( andOp.matchesBSON( BSON( "a" << 1 << "b" << 2 << "c" << 3 << "a" << 4 ),
+                                   NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << 4 << "b" << 2 << "c" << 3 << "a" << 1 ),
+                                    NULL ) );
+    }
+
+    TEST( AndOp, SeveralClausesOnOneTopLevelField ) {
+        BSONObj baseOperand1 = BSON( "$gt" << 1 );
+        BSONObj baseOperand2 = BSON( "$lt" << 10 );
+
+        auto_ptr<ComparisonMatchExpression> sub1( new GTMatchExpression() );
+        ASSERT( sub1->init( "a", baseOperand1[ "$gt" ] ).isOK() );
+        auto_ptr<ComparisonMatchExpression> sub2( new LTMatchExpression() );
+        ASSERT( sub2->init( "a", baseOperand2[ "$lt" ] ).isOK() );
+        auto_ptr<ExistsMatchExpression> sub3( new ExistsMatchExpression() );
+        ASSERT( sub3->init( "b" ).isOK() );
+
+        AndMatchExpression andOp;
+        andOp.add( sub1.release() );
+        andOp.add( sub2.release() );
+        andOp.add( sub3.release() );
+
+        ASSERT( andOp.matchesBSON( BSON( "b" << BSONNULL << "a" << 5 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << 5 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << 10 << "b" << 1 ), NULL ) );
+        // Array values are still traversed.
+        ASSERT( andOp.matchesBSON( BSON( "a" << BSON_ARRAY( 0 << 5 ) << "b" << 1 ), NULL ) );
+        ASSERT( andOp.matchesBSON( BSON( "a" << BSON_ARRAY( 0 << 11 ) << "b" << 1 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << BSON_ARRAY( 0 << 1 ) << "b" << 1 ), NULL ) );
+    }
+
+    TEST( AndOp, TopLevelAndDottedClauses ) {
+        BSONObj baseOperand1 = BSON( "a.b" << 1 );
+        BSONObj baseOperand2 = BSON( "c" << BSONNULL );
+        BSONObj baseOperand3 = BSON( "d" << 2 );
+
+        auto_ptr<ComparisonMatchExpression> sub1( new EqualityMatchExpression() );
+        ASSERT( sub1->init( "a.b", baseOperand1[ "a.b" ] ).isOK() );
+        auto_ptr<ComparisonMatchExpression> sub2( new EqualityMatchExpression() );
+        ASSERT( sub2->init( "c", baseOperand2[ "c" ] ).isOK() );
+        auto_ptr<ComparisonMatchExpression> sub3( new EqualityMatchExpression() );
+        ASSERT( sub3->init( "d", baseOperand3[ "d" ] ).isOK() );
+
+        AndMatchExpression andOp;
+        andOp.add( sub1.release() );
+        andOp.add( sub2.release() );
+        andOp.add( sub3.release() );
+
+        ASSERT( andOp.matchesBSON( BSON( "d" << 2 << "a" << BSON( "b" << 1 ) ), NULL ) );
+        ASSERT( andOp.matchesBSON( BSON( "a" << BSON_ARRAY( BSON( "b" << 1 ) ) <<
+                                         "c" << BSONNULL << "d" << 2 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << BSON( "b" << 1 ) << "c" << 1 << "d" << 2 ),
+                                    NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << BSON( "b" << 2 ) << "d" << 2 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << BSON( "b" << 1 ) << "d" << 3 ), NULL ) );
+    }
+
     /**
     TEST( AndOp, MatchesIndexKeyWithoutUnknown ) {
         BSONObj baseOperand1 = BSON( "$gt" << 1 );
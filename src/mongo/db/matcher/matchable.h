@@ -53,6 +53,14 @@ namespace mongo {
 
         virtual void releaseIterator( ElementIterator* iterator ) const = 0;
 
+        /**
+         * If this document is backed by a single BSONObj whose elements are what
+         * allocateIterator() walks, returns a pointer to it; otherwise NULL.  The pointer is
+         * valid for the lifetime of this MatchableDocument.  Used by expressions that can look
+         * up several top level fields in one pass over the object.
+         */
+        virtual const BSONObj* getBSONObj() const { return NULL; }
+
         class IteratorHolder {
         public:
             IteratorHolder( const MatchableDocument* doc, const ElementPath* path ) {
@@ -97,6 +105,8 @@ namespace mongo {
             }
         }
 
+        virtual const BSONObj* getBSONObj() const { return &_obj; }
+
     private:
         BSONObj _obj;
         mutable BSONElementIterator _iterator;
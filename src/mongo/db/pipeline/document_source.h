@@ -59,6 +59,7 @@ namespace mongo {
     class ExpressionFieldPath;
     class ExpressionObject;
     class DocumentSourceLimit;
+    class Pipeline;
     class PlanExecutor;
 
     class DocumentSource : public IntrusiveCounterUnsigned {
@@ -434,6 +435,77 @@ namespace mongo {
     };
 
 
+    /**
+     * Reads the BSONObj objects produced by a supplied PlanExecutor, like DocumentSourceCursor,
+     * and hands them out in batches to several worker threads. Each worker runs its own copy of
+     * a partition pipeline, see Pipeline::splitForParallel(), over the batches it takes. The
+     * Documents the workers produce are returned in no particular order.
+     *
+     * Only the thread running the aggregation uses the PlanExecutor, so yielding and interrupt
+     * checks work as they do for DocumentSourceCursor. The workers see owned copies of the
+     * documents and never take locks.
+     */
+    class DocumentSourceParallelCursor :
+        public DocumentSource {
+    public:
+        // virtuals from DocumentSource
+        virtual ~DocumentSourceParallelCursor();
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual void setSource(DocumentSource *pSource);
+        virtual bool isValidInitialSource() const { return true; }
+        virtual void dispose();
+
+        /**
+         * Create a document source which runs 'partitionPipeline' on 'parallelism' threads over
+         * the results of 'exec'. The threads are started by the first call to getNext().
+         */
+        static boost::intrusive_ptr<DocumentSourceParallelCursor> create(
+            const std::string& ns,
+            const boost::shared_ptr<PlanExecutor>& exec,
+            const boost::intrusive_ptr<Pipeline>& partitionPipeline,
+            int parallelism,
+            const boost::intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        /// Records the query of the PlanExecutor, for explain.
+        void setQuery(const BSONObj& query) { _query = query; }
+
+        /**
+         * Same as DocumentSourceCursor::setProjection(). The workers use 'deps' to turn the
+         * objects into Documents.
+         */
+        void setProjection(const BSONObj& projection, const boost::optional<ParsedDeps>& deps);
+
+    private:
+        class Workers;
+
+        DocumentSourceParallelCursor(
+            const std::string& ns,
+            const boost::shared_ptr<PlanExecutor>& exec,
+            const boost::intrusive_ptr<Pipeline>& partitionPipeline,
+            int parallelism,
+            const boost::intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        /**
+         * Reads the next batch of objects from the PlanExecutor into 'batch'. Releases the
+         * PlanExecutor once it is exhausted.
+         */
+        void loadBatch(std::vector<BSONObj>* batch);
+
+        // BSONObj members must outlive _projection and cursor.
+        BSONObj _query;
+        BSONObj _projection;
+        boost::optional<ParsedDeps> _dependencies;
+
+        const std::string _ns;
+        boost::shared_ptr<PlanExecutor> _exec; // PipelineProxyStage holds a weak_ptr to this.
+        boost::intrusive_ptr<Pipeline> _partitionPipeline;
+        const int _parallelism;
+        boost::scoped_ptr<Workers> _workers;
+    };
+
+
     class DocumentSourceGroup : public DocumentSource
                               , public SplittableDocumentSource {
     public:
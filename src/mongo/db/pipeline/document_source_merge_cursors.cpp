@@ -150,6 +150,8 @@ namespace mongo {
     }
 
     boost::optional<Document> DocumentSourceMergeCursors::getNext() {
+        pExpCtx->checkForInterrupt();
+
         if (_unstarted)
             start();
 
@@ -0,0 +1,505 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include <boost/shared_ptr.hpp>
+#include <deque>
+#include <vector>
+
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/explain.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    using boost::intrusive_ptr;
+    using boost::shared_ptr;
+    using std::string;
+    using std::vector;
+
+namespace {
+    // A batch ends after this many objects or bytes, whichever comes first.
+    const size_t kMaxBatchObjects = 1000;
+    const int kMaxBatchBytes = 1024 * 1024;
+
+    // How many batches per worker may wait to be taken.
+    const size_t kQueuedBatchesPerWorker = 2;
+
+    // Workers wait to hand over their results while this many are waiting to be returned.
+    const size_t kMaxQueuedResults = 4096;
+
+    // How long getNext() waits for the workers before checking for interrupts.
+    const Milliseconds kWaitForWorkersPeriod(10);
+}
+
+    /**
+     * The worker threads, and the queues between them and the thread running the aggregation.
+     */
+    class DocumentSourceParallelCursor::Workers {
+    public:
+        enum Progress {
+            RESULT,      // Set '*out' to the next result.
+            EXHAUSTED,   // All the workers are done, and their results have been returned.
+            NEEDS_INPUT, // The workers could take another batch.
+            WAITING,     // Nothing happened yet. Check for interrupts and try again.
+        };
+
+        Workers(const BSONObj& partitionSpec,
+                const intrusive_ptr<ExpressionContext>& pExpCtx,
+                const boost::optional<ParsedDeps>& deps,
+                int parallelism)
+            : _partitionSpec(partitionSpec)
+            , _ns(pExpCtx->ns)
+            , _extSortAllowed(pExpCtx->extSortAllowed)
+            , _tempDir(pExpCtx->tempDir)
+            , _dependencies(deps)
+            , _maxQueuedBatches(kQueuedBatchesPerWorker * parallelism)
+            , _inputDone(false)
+            , _stopping(false)
+            , _numFinished(0)
+            , _status(Status::OK()) {
+            try {
+                for (int i = 0; i < parallelism; i++) {
+                    _threads.push_back(shared_ptr<stdx::thread>(
+                        new stdx::thread(stdx::bind(&Workers::run, this))));
+                }
+            }
+            catch (...) {
+                stop();
+                throw;
+            }
+        }
+
+        ~Workers() {
+            stop();
+        }
+
+        /**
+         * Returns the results of the workers, and tells the caller when they want more input.
+         * 'canAddInput' is false once endOfInput() has been called. Throws the first error of
+         * any worker.
+         */
+        Progress waitForProgress(bool canAddInput, Document* out) {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            uassertStatusOK(_status);
+
+            if (!_results.empty()) {
+                *out = _results.front();
+                _results.pop_front();
+                if (_results.empty()) {
+                    _resultSpace.notify_all();
+                }
+                return RESULT;
+            }
+
+            if (_numFinished == _threads.size()) {
+                return EXHAUSTED;
+            }
+
+            if (canAddInput && _batches.size() < _maxQueuedBatches) {
+                return NEEDS_INPUT;
+            }
+
+            _progress.wait_for(lk, kWaitForWorkersPeriod);
+            return WAITING;
+        }
+
+        /**
+         * Queues 'batch' for the next worker to take. Leaves 'batch' empty.
+         */
+        void addBatch(vector<BSONObj>* batch) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _batches.push_back(vector<BSONObj>());
+            _batches.back().swap(*batch);
+            _inputAvailable.notify_one();
+        }
+
+        /**
+         * Lets the workers finish once they have taken every batch.
+         */
+        void endOfInput() {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _inputDone = true;
+            _inputAvailable.notify_all();
+        }
+
+    private:
+        /**
+         * The initial source of the pipeline of each worker.
+         */
+        class Input : public DocumentSource {
+        public:
+            Input(Workers* workers,
+                  vector<Document>* results,
+                  const intrusive_ptr<ExpressionContext>& pExpCtx)
+                : DocumentSource(pExpCtx)
+                , _workers(workers)
+                , _results(results)
+                , _dependencies(workers->_dependencies)
+                , _position(0) {}
+
+            virtual boost::optional<Document> getNext() {
+                pExpCtx->checkForInterrupt();
+
+                if (_position == _batch.size()) {
+                    // Hand over what the pipeline made from the last batch before waiting for
+                    // the next one, so that results don't sit here while the worker is idle.
+                    _batch.clear();
+                    _position = 0;
+                    if (!_workers->pushResults(_results) || !_workers->takeBatch(&_batch)) {
+                        return boost::none;
+                    }
+                }
+
+                const BSONObj& obj = _batch[_position++];
+                if (_dependencies) {
+                    return _dependencies->extractFields(obj);
+                }
+                return Document::fromBsonWithMetaData(obj);
+            }
+
+            virtual const char* getSourceName() const {
+                return "$parallelCursorInput";
+            }
+
+            virtual Value serialize(bool explain = false) const {
+                // Only exists in the pipelines of the workers, which are never serialized.
+                return Value();
+            }
+
+            virtual void setSource(DocumentSource* pSource) {
+                // This is the initial source, so it doesn't take one.
+                verify(false);
+            }
+
+            virtual bool isValidInitialSource() const { return true; }
+
+        private:
+            Workers* const _workers;
+            vector<Document>* const _results;
+            const boost::optional<ParsedDeps> _dependencies;
+            vector<BSONObj> _batch;
+            size_t _position;
+        };
+
+        /**
+         * The body of each worker thread. Builds a partition pipeline and runs it over batches
+         * until the input ends or the workers are stopped.
+         */
+        void run() {
+            Status status = Status::OK();
+            try {
+                // The partition pipeline doesn't need an OperationContext since it never reads
+                // from a collection. Interrupts are checked by the thread running the
+                // aggregation.
+                intrusive_ptr<ExpressionContext> ctx(new ExpressionContext(NULL, _ns));
+                ctx->tempDir = _tempDir;
+
+                string errmsg;
+                intrusive_ptr<Pipeline> pipeline = Pipeline::parseCommand(errmsg,
+                                                                          _partitionSpec,
+                                                                          ctx);
+                massert(28666, str::stream() << "can't parse partition pipeline: " << errmsg,
+                        pipeline);
+
+                // Like on a shard, a $group outputs partial results for the merging $group.
+                ctx->inShard = true;
+                ctx->extSortAllowed = _extSortAllowed;
+
+                vector<Document> results;
+                pipeline->addInitialSource(new Input(this, &results, ctx));
+                pipeline->stitch();
+
+                DocumentSource* output = pipeline->output();
+                while (boost::optional<Document> next = output->getNext()) {
+                    results.push_back(*next);
+                }
+                pushResults(&results);
+            }
+            catch (const DBException& e) {
+                status = e.toStatus();
+            }
+            catch (const std::exception& e) {
+                status = Status(ErrorCodes::InternalError, e.what());
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (_status.isOK()) {
+                _status = status;
+            }
+            _numFinished++;
+            _progress.notify_one();
+        }
+
+        /**
+         * Waits for a batch, and swaps it into 'batch'. Returns false if there are no more.
+         */
+        bool takeBatch(vector<BSONObj>* batch) {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            while (_batches.empty() && !_inputDone && !_stopping) {
+                _inputAvailable.wait(lk);
+            }
+
+            if (_stopping || _batches.empty()) {
+                return false;
+            }
+
+            batch->swap(_batches.front());
+            _batches.pop_front();
+            _progress.notify_one();
+            return true;
+        }
+
+        /**
+         * Hands 'results' to getNext(), leaving it empty. Waits if too many results are already
+         * waiting. Returns false if the workers are being stopped.
+         */
+        bool pushResults(vector<Document>* results) {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            while (_results.size() >= kMaxQueuedResults && !_stopping) {
+                _resultSpace.wait(lk);
+            }
+
+            if (_stopping) {
+                return false;
+            }
+
+            if (!results->empty()) {
+                _results.insert(_results.end(), results->begin(), results->end());
+                results->clear();
+                _progress.notify_one();
+            }
+            return true;
+        }
+
+        /**
+         * Tells the workers to stop, and waits until they have.
+         */
+        void stop() {
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _stopping = true;
+                _inputAvailable.notify_all();
+                _resultSpace.notify_all();
+            }
+
+            for (size_t i = 0; i < _threads.size(); i++) {
+                _threads[i]->join();
+            }
+        }
+
+        const BSONObj _partitionSpec;
+        const NamespaceString _ns;
+        const bool _extSortAllowed;
+        const string _tempDir;
+        const boost::optional<ParsedDeps> _dependencies;
+        const size_t _maxQueuedBatches;
+
+        vector<shared_ptr<stdx::thread> > _threads;
+
+        // Everything below is protected by _mutex.
+        stdx::mutex _mutex;
+        stdx::condition_variable _inputAvailable; // A batch was added, or the input ended.
+        stdx::condition_variable _resultSpace; // _results became empty.
+        stdx::condition_variable _progress; // Signals waitForProgress().
+
+        std::deque<vector<BSONObj> > _batches;
+        bool _inputDone;
+        std::deque<Document> _results;
+        bool _stopping;
+        size_t _numFinished;
+        Status _status; // The first error of any worker.
+    };
+
+    DocumentSourceParallelCursor::~DocumentSourceParallelCursor() {
+        dispose();
+    }
+
+    const char *DocumentSourceParallelCursor::getSourceName() const {
+        return "$parallelCursor";
+    }
+
+    boost::optional<Document> DocumentSourceParallelCursor::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        if (!_workers) {
+            if (!_exec) {
+                // Disposed before we started.
+                return boost::none;
+            }
+
+            _workers.reset(new Workers(_partitionPipeline->serialize().toBson(),
+                                       pExpCtx,
+                                       _dependencies,
+                                       _parallelism));
+        }
+
+        while (true) {
+            Document out;
+            switch (_workers->waitForProgress(static_cast<bool>(_exec), &out)) {
+            case Workers::RESULT:
+                return out;
+            case Workers::EXHAUSTED:
+                return boost::none;
+            case Workers::NEEDS_INPUT: {
+                vector<BSONObj> batch;
+                loadBatch(&batch);
+                if (!batch.empty()) {
+                    _workers->addBatch(&batch);
+                }
+                if (!_exec) {
+                    _workers->endOfInput();
+                }
+                break;
+            }
+            case Workers::WAITING:
+                pExpCtx->opCtx->checkForInterrupt();
+                break;
+            }
+        }
+    }
+
+    void DocumentSourceParallelCursor::dispose() {
+        // Stopping the workers doesn't call in to PlanExecutor or ClientCursor registries, so this
+        // is safe when an agg cursor is killed, see DocumentSourceCursor::dispose().
+        _workers.reset();
+        _exec.reset();
+    }
+
+    void DocumentSourceParallelCursor::loadBatch(vector<BSONObj>* batch) {
+        const NamespaceString nss(_ns);
+        AutoGetCollectionForRead autoColl(pExpCtx->opCtx, nss);
+
+        _exec->restoreState(pExpCtx->opCtx);
+
+        int memUsageBytes = 0;
+        BSONObj obj;
+        PlanExecutor::ExecState state;
+        while ((state = _exec->getNext(&obj, NULL)) == PlanExecutor::ADVANCED) {
+            batch->push_back(obj.getOwned());
+            memUsageBytes += obj.objsize();
+
+            if (batch->size() >= kMaxBatchObjects || memUsageBytes > kMaxBatchBytes) {
+                // End this batch and prepare PlanExecutor for yielding.
+                _exec->saveState();
+                return;
+            }
+        }
+
+        // If we got here, there won't be any more objects, so destroy the executor.
+        _exec.reset();
+
+        uassert(28667, "collection or index disappeared when cursor yielded",
+                state != PlanExecutor::DEAD);
+
+        uassert(28668, "cursor encountered an error: " + WorkingSetCommon::toStatusString(obj),
+                state != PlanExecutor::FAILURE);
+
+        massert(28669, str::stream() << "Unexpected return from PlanExecutor::getNext: " << state,
+                state == PlanExecutor::IS_EOF);
+    }
+
+    void DocumentSourceParallelCursor::setSource(DocumentSource *pSource) {
+        /* this doesn't take a source */
+        verify(false);
+    }
+
+    Value DocumentSourceParallelCursor::serialize(bool explain) const {
+        // we never parse a DocumentSourceParallelCursor, so we only serialize for explain
+        if (!explain)
+            return Value();
+
+        // Get planner-level explain info from the underlying PlanExecutor.
+        BSONObjBuilder explainBuilder;
+        {
+            const NamespaceString nss(_ns);
+            AutoGetCollectionForRead autoColl(pExpCtx->opCtx, nss);
+
+            massert(28670, "No _exec. Were we disposed before explained?", _exec);
+
+            _exec->restoreState(pExpCtx->opCtx);
+            Explain::explainStages(_exec.get(), ExplainCommon::QUERY_PLANNER, &explainBuilder);
+            _exec->saveState();
+        }
+
+        MutableDocument out;
+        out["query"] = Value(_query);
+
+        if (!_projection.isEmpty())
+            out["fields"] = Value(_projection);
+
+        out["parallelism"] = Value(_parallelism);
+        out["partitionPipeline"] = Value(_partitionPipeline->writeExplainOps());
+
+        // Add explain results from the query system into the agg explain output.
+        BSONObj explainObj = explainBuilder.obj();
+        invariant(explainObj.hasField("queryPlanner"));
+        out["queryPlanner"] = Value(explainObj["queryPlanner"]);
+
+        return Value(DOC(getSourceName() << out.freezeToValue()));
+    }
+
+    DocumentSourceParallelCursor::DocumentSourceParallelCursor(
+            const string& ns,
+            const shared_ptr<PlanExecutor>& exec,
+            const intrusive_ptr<Pipeline>& partitionPipeline,
+            int parallelism,
+            const intrusive_ptr<ExpressionContext> &pCtx)
+        : DocumentSource(pCtx)
+        , _ns(ns)
+        , _exec(exec)
+        , _partitionPipeline(partitionPipeline)
+        , _parallelism(parallelism)
+    {}
+
+    intrusive_ptr<DocumentSourceParallelCursor> DocumentSourceParallelCursor::create(
+            const string& ns,
+            const shared_ptr<PlanExecutor>& exec,
+            const intrusive_ptr<Pipeline>& partitionPipeline,
+            int parallelism,
+            const intrusive_ptr<ExpressionContext> &pExpCtx) {
+        return new DocumentSourceParallelCursor(ns, exec, partitionPipeline, parallelism, pExpCtx);
+    }
+
+    void DocumentSourceParallelCursor::setProjection(
+            const BSONObj& projection,
+            const boost::optional<ParsedDeps>& deps) {
+        _projection = projection;
+        _dependencies = deps;
+    }
+}
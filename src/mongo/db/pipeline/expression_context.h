@@ -30,9 +30,12 @@
 
 #include <string>
 
+#include "mongo/base/error_codes.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/util/assert_util.h"
 #include "mongo/util/intrusive_counter.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -43,14 +46,20 @@ namespace mongo {
             , opCtx(opCtx)
         {}
 
-        /** Used by a pipeline to check for interrupts so that killOp() works.
-         *  @throws if the operation has been interrupted
+        /** Used by a pipeline to check for interrupts so that killOp() works. Without an
+         *  OperationContext, as on mongos, it checks routerMaxTimeMicros instead.
+         *  @throws if the operation has been interrupted or has exceeded its time limit
          */
         void checkForInterrupt() {
-            if (opCtx && --interruptCounter == 0) { // XXX SERVER-13931 for opCtx check
+            if (--interruptCounter == 0) {
                 // The checkForInterrupt could be expensive, at least in relative terms.
-                opCtx->checkForInterrupt();
                 interruptCounter = kInterruptCheckPeriod;
+                if (opCtx) { // XXX SERVER-13931 for opCtx check
+                    opCtx->checkForInterrupt();
+                }
+                else if (routerMaxTimeMicros > 0 && routerTimer.micros() >= routerMaxTimeMicros) {
+                    uasserted(ErrorCodes::ExceededTimeLimit, "operation exceeded time limit");
+                }
             }
         }
 
@@ -63,6 +72,13 @@ namespace mongo {
         std::string tempDir; // Defaults to empty to prevent external sorting in mongos.
 
         OperationContext* opCtx;
+
+        // The maxTimeMS of the operation in microseconds, counted from when this context was
+        // created, for pipelines run where there is no OperationContext to enforce it (mongos).
+        // 0 means no limit.
+        long long routerMaxTimeMicros = 0;
+        Timer routerTimer;
+
         static const int kInterruptCheckPeriod = 128;
         int interruptCounter = kInterruptCheckPeriod; // when 0, check interruptStatus
     };
@@ -32,6 +32,8 @@
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/pipeline_optimizations.h"
 
+#include <limits>
+
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/catalog/document_validation.h"
@@ -58,9 +60,11 @@ namespace mongo {
     const char Pipeline::fromRouterName[] = "fromRouter";
     const char Pipeline::serverPipelineName[] = "serverPipeline";
     const char Pipeline::mongosPipelineName[] = "mongosPipeline";
+    const char Pipeline::parallelismName[] = "parallelism";
 
     Pipeline::Pipeline(const intrusive_ptr<ExpressionContext> &pTheCtx):
         explain(false),
+        parallelism(1),
         pCtx(pTheCtx) {
     }
 
@@ -168,6 +172,17 @@ namespace mongo {
                 continue;
             }
 
+            if (str::equals(pFieldName, parallelismName)) {
+                uassert(28665,
+                        str::stream() << "parallelism must be a positive integer, not "
+                                      << cmdElement.toString(false),
+                        cmdElement.isNumber() && cmdElement.numberLong() >= 1
+                            && cmdElement.numberLong() <= std::numeric_limits<int>::max()
+                            && cmdElement.numberDouble() == cmdElement.numberLong());
+                pPipeline->parallelism = cmdElement.numberInt();
+                continue;
+            }
+
             /* we didn't recognize a field in the command */
             ostringstream sb;
             sb << "unrecognized field '" << cmdElement.fieldName() << "'";
@@ -384,6 +399,44 @@ namespace mongo {
         return shardPipeline;
     }
 
+    intrusive_ptr<Pipeline> Pipeline::splitForParallel() {
+        intrusive_ptr<Pipeline> partitionPipeline(new Pipeline(pCtx));
+        partitionPipeline->explain = explain;
+
+        Optimizations::Parallel::findSplitPoint(partitionPipeline.get(), this);
+        if (partitionPipeline->sources.empty())
+            return intrusive_ptr<Pipeline>();
+
+        return partitionPipeline;
+    }
+
+    void Pipeline::Optimizations::Parallel::findSplitPoint(Pipeline* partitionPipe,
+                                                           Pipeline* mergePipe) {
+        while (!mergePipe->sources.empty()) {
+            intrusive_ptr<DocumentSource> current = mergePipe->sources.front();
+            DocumentSource* source = current.get();
+
+            if (dynamic_cast<DocumentSourceMatch*>(source)
+                    || dynamic_cast<DocumentSourceProject*>(source)
+                    || dynamic_cast<DocumentSourceRedact*>(source)
+                    || dynamic_cast<DocumentSourceUnwind*>(source)) {
+                // Each of these looks at one document at a time.
+                mergePipe->sources.pop_front();
+                partitionPipe->sources.push_back(current);
+                continue;
+            }
+
+            if (DocumentSourceGroup* group = dynamic_cast<DocumentSourceGroup*>(source)) {
+                // Each partition groups its own documents, and the merger combines the groups.
+                mergePipe->sources.pop_front();
+                partitionPipe->sources.push_back(group->getShardSource());
+                mergePipe->sources.push_front(group->getMergeSource());
+            }
+
+            break;
+        }
+    }
+
     void Pipeline::Optimizations::Sharded::findSplitPoint(Pipeline* shardPipe,
                                                           Pipeline* mergePipe) {
         while (!mergePipe->sources.empty()) {
@@ -467,6 +520,23 @@ namespace mongo {
         return match->getQuery();
     }
 
+    bool Pipeline::canRunInMongos() const {
+        for (SourceContainer::const_iterator it = sources.begin(); it != sources.end(); ++it) {
+            DocumentSource* source = it->get();
+            if (dynamic_cast<DocumentSourceNeedsMongod*>(source))
+                return false;
+
+            // mongos has no temp directory, so stages that could use external sorting must stay
+            // on a mongod.
+            if (pCtx->extSortAllowed
+                    && (dynamic_cast<DocumentSourceSort*>(source)
+                        || dynamic_cast<DocumentSourceGroup*>(source))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     Document Pipeline::serialize() const {
         MutableDocument serialized;
         // create an array out of the pipeline operations
@@ -495,6 +565,10 @@ namespace mongo {
             serialized.setField(bypassDocumentValidationCommandOption(), Value(true));
         }
 
+        if (parallelism > 1) {
+            serialized.setField(parallelismName, Value(parallelism));
+        }
+
         return serialized.freeze();
     }
 
@@ -523,6 +597,8 @@ namespace mongo {
         BSONArrayBuilder resultArray;
         DocumentSource* finalSource = sources.back().get();
         while (boost::optional<Document> next = finalSource->getNext()) {
+            pCtx->checkForInterrupt();
+
             // add the document to the result set
             BSONObjBuilder documentBuilder (resultArray.subobjStart());
             next->toBson(&documentBuilder);
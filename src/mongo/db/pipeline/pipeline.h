@@ -82,11 +82,29 @@ namespace mongo {
         */
         boost::intrusive_ptr<Pipeline> splitForSharded();
 
+        /**
+         * Moves the stages at the front of this Pipeline which can run on separate partitions of
+         * the input into a new Pipeline, which is returned. Those are the streaming stages, such
+         * as $match and $project, and the shard half of the $group following them, if any. This
+         * Pipeline is left with the stages which combine the results of the partitions.
+         *
+         * Returns NULL, and leaves this Pipeline unchanged, if the first stage can't be run on
+         * partitions.
+         */
+        boost::intrusive_ptr<Pipeline> splitForParallel();
+
         /** If the pipeline starts with a $match, return its BSON predicate.
          *  Returns empty BSON if the first stage isn't $match.
          */
         BSONObj getInitialQuery() const;
 
+        /**
+         * Returns true if this pipeline can be run to completion inside mongos. This is false if
+         * any stage needs a mongod (such as $out), or if external sorting is allowed and a stage
+         * may need to spill to disk. Only meaningful for the merger part of a split pipeline.
+         */
+        bool canRunInMongos() const;
+
         /**
           Write the Pipeline as a BSONObj command.  This should be the
           inverse of parseCommand().
@@ -114,6 +132,9 @@ namespace mongo {
 
         bool isExplain() const { return explain; }
 
+        /// The number of threads the command asked to run the pipeline with. Defaults to 1.
+        int getParallelism() const { return parallelism; }
+
         /// The initial source is special since it varies between mongos and mongod.
         void addInitialSource(boost::intrusive_ptr<DocumentSource> source);
 
@@ -158,22 +179,26 @@ namespace mongo {
             // Classes are defined in pipeline_optimizations.h.
             class Local;
             class Sharded;
+            class Parallel;
         };
 
         friend class Optimizations::Local;
         friend class Optimizations::Sharded;
+        friend class Optimizations::Parallel;
 
         static const char pipelineName[];
         static const char explainName[];
         static const char fromRouterName[];
         static const char serverPipelineName[];
         static const char mongosPipelineName[];
+        static const char parallelismName[];
 
         Pipeline(const boost::intrusive_ptr<ExpressionContext> &pCtx);
 
         typedef std::deque<boost::intrusive_ptr<DocumentSource> > SourceContainer;
         SourceContainer sources;
         bool explain;
+        int parallelism;
 
         boost::intrusive_ptr<ExpressionContext> pCtx;
     };
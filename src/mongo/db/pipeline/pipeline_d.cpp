@@ -30,7 +30,9 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include <algorithm>
 #include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "mongo/client/dbclientinterface.h"
@@ -39,10 +41,13 @@
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/d_state.h"
 
 namespace mongo {
@@ -52,6 +57,10 @@ namespace mongo {
     using std::string;
 
 namespace {
+    // Upper bound on the number of threads an aggregation may ask for with 'parallelism'. Setting
+    // this to 1 runs every aggregation on a single thread.
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationMaxParallelism, int, 16);
+
     class MongodImplementation final : public DocumentSourceNeedsMongod::MongodInterface {
     public:
         MongodImplementation(const intrusive_ptr<ExpressionContext>& ctx)
@@ -90,6 +99,120 @@ namespace {
         intrusive_ptr<ExpressionContext> _ctx;
         DBDirectClient _client;
     };
+
+    /**
+     * Returns true if every document matching 'expr' has a top level field 'field'.
+     */
+    bool queryRequiresField(const MatchExpression* expr, StringData field) {
+        if (expr->matchType() == MatchExpression::AND) {
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (queryRequiresField(expr->getChild(i), field)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (expr->path() != field) {
+            return false;
+        }
+
+        switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            // Comparisons to null and the extreme keys can match a missing field.
+            const BSONType type =
+                static_cast<const ComparisonMatchExpression*>(expr)->getData().type();
+            return type != jstNULL && type != Undefined && type != MinKey && type != MaxKey;
+        }
+        case MatchExpression::MATCH_IN: {
+            const ArrayFilterEntries& entries =
+                static_cast<const InMatchExpression*>(expr)->getData();
+            return !entries.hasNull() && !entries.hasEmptyArray();
+        }
+        case MatchExpression::TYPE_OPERATOR: {
+            const int type = static_cast<const TypeMatchExpression*>(expr)->getData();
+            return type != jstNULL && type != Undefined;
+        }
+        case MatchExpression::EXISTS:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::SIZE:
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * Returns true if the fields in 'deps' are ones a covered plan could provide, which is
+     * only the case for top level fields.
+     *
+     * A covered plan also returns null for a field the document doesn't have, where the
+     * document itself would leave the field out. So every field other than _id has to be one
+     * that 'queryObj' doesn't let be missing.
+     */
+    bool canCoverDependencies(const DepsTracker& deps, const BSONObj& queryObj) {
+        if (deps.needWholeDocument || deps.needTextScore || deps.fields.empty()) {
+            return false;
+        }
+
+        for (std::set<string>::const_iterator it = deps.fields.begin();
+             it != deps.fields.end();
+             ++it) {
+            if (it->find('.') != string::npos) {
+                return false;
+            }
+        }
+
+        StatusWithMatchExpression swme = MatchExpressionParser::parse(queryObj);
+        if (!swme.isOK()) {
+            return false;
+        }
+        boost::scoped_ptr<MatchExpression> expr(swme.getValue());
+
+        for (std::set<string>::const_iterator it = deps.fields.begin();
+             it != deps.fields.end();
+             ++it) {
+            if (*it != "_id" && !queryRequiresField(expr.get(), *it)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Canonicalizes the query and gets a PlanExecutor for it. Fails if either step does, for
+     * instance because 'plannerOptions' rule out every plan.
+     */
+    Status attemptToGetExecutor(OperationContext* txn,
+                                Collection* collection,
+                                const intrusive_ptr<ExpressionContext>& pExpCtx,
+                                const BSONObj& queryObj,
+                                const BSONObj& projectionObj,
+                                const BSONObj& sortObj,
+                                size_t plannerOptions,
+                                PlanExecutor** out) {
+        CanonicalQuery* cq;
+        Status status =
+            CanonicalQuery::canonicalize(pExpCtx->ns,
+                                         queryObj,
+                                         sortObj,
+                                         projectionObj,
+                                         &cq,
+                                         WhereCallbackReal(pExpCtx->opCtx, pExpCtx->ns.db()));
+        if (!status.isOK()) {
+            return status;
+        }
+
+        return getExecutor(txn, collection, cq, PlanExecutor::YIELD_AUTO, out, plannerOptions);
+    }
 }
 
     shared_ptr<PlanExecutor> PipelineD::prepareCursorSource(
@@ -137,10 +260,15 @@ namespace {
         // Find the set of fields in the source documents depended on by this pipeline.
         const DepsTracker deps = pPipeline->getDependencies(queryObj);
 
-        // Passing query an empty projection since it is faster to use ParsedDeps::extractFields().
-        // This will need to change to support covering indexes (SERVER-12015). There is an
-        // exception for textScore since that can only be retrieved by a query projection.
-        const BSONObj projectionForQuery = deps.needTextScore ? deps.toProjection() : BSONObj();
+        // If the pipeline only needs top level fields which the query guarantees are present, we
+        // first ask for a plan which reads them from an index without fetching any documents
+        // (SERVER-12015). Otherwise we pass the
+        // query an empty projection since it is faster to use ParsedDeps::extractFields() on
+        // whole documents. There is an exception for textScore since that can only be retrieved
+        // by a query projection.
+        const BSONObj depsProjection = deps.toProjection();
+        const bool tryCovered = canCoverDependencies(deps, queryObj);
+        const BSONObj projectionForQuery = deps.needTextScore ? depsProjection : BSONObj();
 
         /*
           Look for an initial sort; we'll try to add this to the
@@ -174,6 +302,10 @@ namespace {
         // If we are able to incorporate the sort into the PlanExecutor, remove it
         // from the head of the pipeline.
         //
+        // Each attempt first asks for a covered plan, if one is possible. An index that provides
+        // the sort is preferred over one that covers the projection, since the $sort would
+        // otherwise have to hold every document in memory.
+        //
         // LATER - we should be able to find this out before we create the
         // cursor.  Either way, we can then apply other optimizations there
         // are tickets for, such as SERVER-4507.
@@ -183,28 +315,25 @@ namespace {
                                    ;
         boost::shared_ptr<PlanExecutor> exec;
         bool sortInRunner = false;
+        bool projectionInRunner = false;
 
-        const WhereCallbackReal whereCallback(pExpCtx->opCtx, pExpCtx->ns.db());
-
+        PlanExecutor* rawExec;
         if (sortStage) {
-            CanonicalQuery* cq;
-            Status status =
-                CanonicalQuery::canonicalize(pExpCtx->ns,
-                                             queryObj,
-                                             sortObj,
-                                             projectionForQuery,
-                                             &cq,
-                                             whereCallback);
-
-            PlanExecutor* rawExec;
-            if (status.isOK() && getExecutor(txn,
-                                             collection,
-                                             cq,
-                                             PlanExecutor::YIELD_AUTO,
-                                             &rawExec,
-                                             runnerOptions).isOK()) {
-                // success: The PlanExecutor will handle sorting for us using an index.
+            if (tryCovered &&
+                attemptToGetExecutor(txn, collection, pExpCtx, queryObj, depsProjection, sortObj,
+                                     runnerOptions | QueryPlannerParams::NO_UNCOVERED_PROJECTIONS,
+                                     &rawExec).isOK()) {
                 exec.reset(rawExec);
+                projectionInRunner = true;
+            }
+            else if (attemptToGetExecutor(txn, collection, pExpCtx, queryObj,
+                                          projectionForQuery, sortObj, runnerOptions,
+                                          &rawExec).isOK()) {
+                exec.reset(rawExec);
+            }
+
+            if (exec.get()) {
+                // success: The PlanExecutor will handle sorting for us using an index.
                 sortInRunner = true;
 
                 sources.pop_front();
@@ -217,22 +346,17 @@ namespace {
 
         if (!exec.get()) {
             const BSONObj noSort;
-            CanonicalQuery* cq;
-            uassertStatusOK(
-                CanonicalQuery::canonicalize(pExpCtx->ns,
-                                             queryObj,
-                                             noSort,
-                                             projectionForQuery,
-                                             &cq,
-                                             whereCallback));
-
-            PlanExecutor* rawExec;
-            uassertStatusOK(getExecutor(txn,
-                                        collection,
-                                        cq,
-                                        PlanExecutor::YIELD_AUTO,
-                                        &rawExec,
-                                        runnerOptions));
+            if (tryCovered &&
+                attemptToGetExecutor(txn, collection, pExpCtx, queryObj, depsProjection, noSort,
+                                     runnerOptions | QueryPlannerParams::NO_UNCOVERED_PROJECTIONS,
+                                     &rawExec).isOK()) {
+                projectionInRunner = true;
+            }
+            else {
+                uassertStatusOK(attemptToGetExecutor(txn, collection, pExpCtx, queryObj,
+                                                     projectionForQuery, noSort, runnerOptions,
+                                                     &rawExec));
+            }
             exec.reset(rawExec);
         }
 
@@ -242,6 +366,27 @@ namespace {
         exec->deregisterExec();
         exec->saveState();
 
+        // If the command asked for several threads, the stages which can run on partitions of the
+        // input get a copy per thread. This doesn't apply to shards, where the results are merged
+        // elsewhere, or when the order of the results matters because the sort was pushed down.
+        const int parallelism = std::min(pPipeline->getParallelism(),
+                                         static_cast<int>(aggregationMaxParallelism));
+        if (parallelism > 1 && !pExpCtx->inShard && !sortInRunner) {
+            if (intrusive_ptr<Pipeline> partitionPipeline = pPipeline->splitForParallel()) {
+                intrusive_ptr<DocumentSourceParallelCursor> pSource =
+                    DocumentSourceParallelCursor::create(fullName,
+                                                         exec,
+                                                         partitionPipeline,
+                                                         parallelism,
+                                                         pExpCtx);
+                pSource->setQuery(queryObj);
+                pSource->setProjection(depsProjection,
+                                       projectionInRunner ? boost::none : deps.toParsedDeps());
+                pPipeline->addInitialSource(pSource);
+                return exec;
+            }
+        }
+
         // Put the PlanExecutor into a DocumentSourceCursor and add it to the front of the pipeline.
         intrusive_ptr<DocumentSourceCursor> pSource =
             DocumentSourceCursor::create(fullName, exec, pExpCtx);
@@ -251,7 +396,10 @@ namespace {
         if (sortInRunner)
             pSource->setSort(sortObj);
 
-        pSource->setProjection(deps.toProjection(), deps.toParsedDeps());
+        // A covered plan returns just the fields we need, so its results become Documents as they
+        // are.
+        pSource->setProjection(depsProjection,
+                               projectionInRunner ? boost::none : deps.toParsedDeps());
 
         while (!sources.empty() && pSource->coalesce(sources.front())) {
             sources.pop_front();
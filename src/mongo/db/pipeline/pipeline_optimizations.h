@@ -121,4 +121,22 @@ namespace mongo {
          */
         static void limitFieldsSentFromShardsToMerger(Pipeline* shardPipe, Pipeline* mergePipe);
     };
+
+    /**
+     * This class holds optimizations applied to a Pipeline run on partitions of its input, and
+     * the Pipeline which combines the results of the partitions.
+     *
+     * Each function has the same signature and takes two Pipelines, both as an in/out parameters.
+     */
+    class Pipeline::Optimizations::Parallel {
+    public:
+        /**
+         * Moves the leading $match, $project, $redact and $unwind stages to the partitions, and
+         * splits a $group following them. Unlike the split for shards, stops at any other stage,
+         * since for instance the merging half of a $sort expects its input from cursors.
+         *
+         * It is not safe to call this optimization multiple times.
+         */
+        static void findSplitPoint(Pipeline* partitionPipe, Pipeline* mergePipe);
+    };
 } // namespace mongo
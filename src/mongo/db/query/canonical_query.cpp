@@ -92,6 +92,31 @@ namespace {
         return matchExpressionComparator(lhs, rhs) < 0;
     }
 
+    /**
+     * Returns true if 'elt' can be looked up in the _id index as an exact match: a literal
+     * object, BinData or a simple type.
+     */
+    bool isSimpleIdValue(const BSONElement& elt) {
+        if (elt.type() == Object) {
+            // If the value is an object, it can't have a query operator
+            // (must be a literal object match).
+            return elt.Obj().firstElementFieldName()[0] != '$';
+        }
+
+        // The _id fild cannot be something like { _id : { $gt : ...
+        // But it can be BinData.
+        return elt.isSimpleType() || BinData == elt.type();
+    }
+
+    /**
+     * Returns true if 'elt' is $isolated or $atomic, which the _id fast paths pass through.
+     */
+    bool isIsolationModifier(const BSONElement& elt) {
+        return elt.fieldName()[0] == '$' &&
+               (str::equals("$isolated", elt.fieldName()) ||
+                str::equals("$atomic", elt.fieldName()));
+    }
+
 }  // namespace
 
     //
@@ -345,22 +370,11 @@ namespace {
                 // Verify that the query on _id is a simple equality.
                 hasID = true;
 
-                if (elt.type() == Object) {
-                    // If the value is an object, it can't have a query operator
-                    // (must be a literal object match).
-                    if (elt.Obj().firstElementFieldName()[0] == '$') {
-                        return false;
-                    }
-                }
-                else if (!elt.isSimpleType() && BinData != elt.type()) {
-                    // The _id fild cannot be something like { _id : { $gt : ...
-                    // But it can be BinData.
+                if (!isSimpleIdValue(elt)) {
                     return false;
                 }
             }
-            else if (elt.fieldName()[0] == '$' &&
-                     (str::equals("$isolated", elt.fieldName())||
-                      str::equals("$atomic", elt.fieldName()))) {
+            else if (isIsolationModifier(elt)) {
                 // ok, passthrough
             }
             else {
@@ -372,6 +386,43 @@ namespace {
         return hasID;
     }
 
+    // static
+    bool CanonicalQuery::isSimpleIdInQuery(const BSONObj& query) {
+        bool hasID = false;
+
+        BSONObjIterator it(query);
+        while (it.more()) {
+            BSONElement elt = it.next();
+            if (str::equals("_id", elt.fieldName())) {
+                hasID = true;
+
+                // The predicate must be exactly {$in: [...]}.
+                if (elt.type() != Object) {
+                    return false;
+                }
+                BSONObj predicate = elt.Obj();
+                if (predicate.nFields() != 1 ||
+                    !str::equals("$in", predicate.firstElementFieldName()) ||
+                    predicate.firstElement().type() != Array) {
+                    return false;
+                }
+
+                // Each value must be an exact match we can look up in the _id index.
+                BSONObjIterator values(predicate.firstElement().Obj());
+                while (values.more()) {
+                    if (!isSimpleIdValue(values.next())) {
+                        return false;
+                    }
+                }
+            }
+            else if (!isIsolationModifier(elt)) {
+                return false;
+            }
+        }
+
+        return hasID;
+    }
+
     // static
     MatchExpression* CanonicalQuery::normalizeTree(MatchExpression* root) {
         // root->isLogical() is true now.  We care about AND, OR, and NOT. NOR currently scares us.
@@ -151,6 +151,13 @@ namespace mongo {
          */
         static bool isSimpleIdQuery(const BSONObj& query);
 
+        /**
+         * Returns true if "query" is {_id: {$in: [...]}} where every value of the $in is an
+         * exact match that isSimpleIdQuery() would accept, possibly with the $isolated/$atomic
+         * modifier.
+         */
+        static bool isSimpleIdInQuery(const BSONObj& query);
+
         // What namespace is this query over?
         const std::string& ns() const { return _pq->ns(); }
 
@@ -599,4 +599,24 @@ namespace {
                            "{$and: [{a: 1}, {b: 1}, {c: 1}]}");
     }
 
+    TEST(CanonicalQueryTest, IsSimpleIdInQuery) {
+        ASSERT_TRUE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: []}}")));
+        ASSERT_TRUE(CanonicalQuery::isSimpleIdInQuery(
+                        fromjson("{_id: {$in: [1, 'a', {b: 1}, 2.5]}}")));
+        ASSERT_TRUE(CanonicalQuery::isSimpleIdInQuery(
+                        fromjson("{_id: {$in: [1, 2]}, $isolated: 1}")));
+
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: 1}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: 1}}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1], $ne: 2}}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1], a: 2}}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1, /a/]}}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1, null]}}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [[1]]}}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(
+                        fromjson("{_id: {$in: [{$gt: 1}]}}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1]}, a: 1}")));
+        ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{a: {$in: [1]}}")));
+    }
+
 }
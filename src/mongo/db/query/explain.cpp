@@ -113,6 +113,10 @@ namespace {
             const IDHackStats* spec = static_cast<const IDHackStats*>(specific);
             return spec->keysExamined;
         }
+        else if (STAGE_ID_MULTI_GET == type) {
+            const IDMultiGetStats* spec = static_cast<const IDMultiGetStats*>(specific);
+            return spec->keysExamined;
+        }
         else if (STAGE_TEXT == type) {
             const TextStats* spec = static_cast<const TextStats*>(specific);
             return spec->keysExamined;
@@ -143,6 +147,10 @@ namespace {
             const IDHackStats* spec = static_cast<const IDHackStats*>(specific);
             return spec->docsExamined;
         }
+        else if (STAGE_ID_MULTI_GET == type) {
+            const IDMultiGetStats* spec = static_cast<const IDMultiGetStats*>(specific);
+            return spec->docsExamined;
+        }
         else if (STAGE_TEXT == type) {
             const TextStats* spec = static_cast<const TextStats*>(specific);
             return spec->fetches;
@@ -286,12 +294,22 @@ namespace mongo {
 
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("keysExamined", spec->keysExamined);
+                bob->appendNumber("keysFilteredOut", spec->keysFilteredOut);
             }
 
             bob->append("keyPattern", spec->keyPattern);
             bob->append("indexName", spec->indexName);
             bob->appendBool("isMultiKey", spec->isMultiKey);
             bob->append("indexVersion", spec->indexVersion);
+
+            if (!spec->indexBounds.isEmpty()) {
+                if ((topLevelBob->len() + spec->indexBounds.objsize()) > kMaxStatsBSONSize) {
+                    bob->append("warning", "index bounds omitted due to BSON size limit");
+                }
+                else {
+                    bob->append("indexBounds", spec->indexBounds);
+                }
+            }
         }
         else if (STAGE_DELETE == stats.stageType) {
             DeleteStats* spec = static_cast<DeleteStats*>(stats.specific.get());
@@ -323,8 +341,10 @@ namespace mongo {
                     intervalBob.append("minDistance", it->minDistanceAllowed);
                     intervalBob.append("maxDistance", it->maxDistanceAllowed);
                     intervalBob.append("maxInclusive", it->inclusiveMaxDistanceAllowed);
+                    intervalBob.appendNumber("numCoveringCells", it->numCoveringCells);
                 }
                 intervalsBob.doneFast();
+                bob->appendBool("cachedDensityEstimate", spec->cachedDensityEstimate);
             }
         }
         else if (STAGE_GROUP == stats.stageType) {
@@ -340,6 +360,16 @@ namespace mongo {
                 bob->appendNumber("docsExamined", spec->docsExamined);
             }
         }
+        else if (STAGE_ID_MULTI_GET == stats.stageType) {
+            IDMultiGetStats* spec = static_cast<IDMultiGetStats*>(stats.specific.get());
+            bob->append("outputOrder", spec->outputOrder);
+            if (verbosity >= ExplainCommon::EXEC_STATS) {
+                bob->appendNumber("keysRequested", spec->keysRequested);
+                bob->appendNumber("seeks", spec->seeks);
+                bob->appendNumber("keysExamined", spec->keysExamined);
+                bob->appendNumber("docsExamined", spec->docsExamined);
+            }
+        }
         else if (STAGE_IXSCAN == stats.stageType) {
             IndexScanStats* spec = static_cast<IndexScanStats*>(stats.specific.get());
 
@@ -390,6 +420,8 @@ namespace mongo {
 
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("chunkSkips", spec->chunkSkips);
+                bob->appendNumber("docsChecked", spec->docsChecked);
+                bob->appendNumber("docsNotChecked", spec->docsNotChecked);
             }
         }
         else if (STAGE_SKIP == stats.stageType) {
@@ -534,6 +566,19 @@ namespace mongo {
         }
         allPlansBob.doneFast();
 
+        // If multiple plans were ranked against each other, report the cost of the trial.
+        MultiPlanStage* mps = getMultiPlanStage(exec->getRootStage());
+        if (NULL != mps) {
+            const MultiPlanStats* spec =
+                static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+            BSONObjBuilder trialBob(plannerBob.subobjStart("planSelectionTrial"));
+            trialBob.appendNumber("works", spec->trialWorks);
+            trialBob.appendNumber("timeMicros", spec->trialMicros);
+            trialBob.appendNumber("candidatesEliminated", spec->candidatesEliminated);
+            trialBob.appendBool("timeLimitReached", spec->trialTimeLimitReached);
+            trialBob.doneFast();
+        }
+
         plannerBob.doneFast();
     }
 
@@ -44,4 +44,9 @@ namespace mongo {
      */
     extern int internalGeoNearQuery2DMaxCoveringCells;
 
+    /**
+     * The number of density estimates each collection keeps for $near searches
+     */
+    extern int internalGeoNearDensityCacheSize;
+
 }  // namespace mongo
@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/geo_near_density_cache.h"
+
+#include "mongo/db/query/expression_index_knobs.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+    GeoNearDensityCache::GeoNearDensityCache()
+        : _estimates(internalGeoNearDensityCacheSize) { }
+
+    // static
+    std::string GeoNearDensityCache::makeKey(StringData indexName, StringData region) {
+        std::string key = indexName.toString();
+        key.push_back('\0');
+        key.append(region.rawData(), region.size());
+        return key;
+    }
+
+    bool GeoNearDensityCache::get(StringData indexName,
+                                  StringData region,
+                                  double* estimatedDistance) const {
+        const std::string key = makeKey(indexName, region);
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        double* entry;
+        if (!_estimates.get(key, &entry).isOK()) {
+            return false;
+        }
+        *estimatedDistance = *entry;
+        return true;
+    }
+
+    bool GeoNearDensityCache::getFirst(StringData indexName,
+                                       const std::vector<std::string>& regions,
+                                       double* estimatedDistance) const {
+        std::vector<std::string> keys;
+        keys.reserve(regions.size());
+        for (size_t i = 0; i < regions.size(); ++i) {
+            keys.push_back(makeKey(indexName, regions[i]));
+        }
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            double* entry;
+            if (_estimates.get(keys[i], &entry).isOK()) {
+                *estimatedDistance = *entry;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void GeoNearDensityCache::add(StringData indexName,
+                                  StringData region,
+                                  double estimatedDistance) {
+        const std::string key = makeKey(indexName, region);
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _estimates.add(key, new double(estimatedDistance));
+    }
+
+    void GeoNearDensityCache::clear() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _estimates.clear();
+        _writeOperations.store(0);
+    }
+
+    void GeoNearDensityCache::notifyOfWriteOp() {
+        // Like the plan cache, it's fine for several threads to clear the cache at once.
+        if (_writeOperations.addAndFetch(1) < internalQueryCacheWriteOpsBetweenFlush) {
+            return;
+        }
+
+        LOG(1) << "clearing geo near density cache - " << internalQueryCacheWriteOpsBetweenFlush
+               << " write operations detected since last refresh.";
+        clear();
+    }
+
+    size_t GeoNearDensityCache::size() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _estimates.size();
+    }
+
+}  // namespace mongo
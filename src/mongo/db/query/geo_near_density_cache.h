@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/query/lru_key_value.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * Remembers the density estimates made by $near searches over the geo indexes of a
+     * collection.  Before a $near search buffers any results it scans ever larger cells around
+     * the query point to guess how far away the nearest documents are.  Queries around the same
+     * point make the same guess, so the cache lets them skip those scans.
+     *
+     * Estimates are keyed by the index and a region token, which identifies the cell the
+     * estimate was made at: the smallest cell around the query point whose neighborhood held
+     * documents.  A later query anywhere in that cell can use the estimate, so callers look up
+     * the tokens of every cell containing their query point, finest first.  An estimate only
+     * chooses the size of the first search annulus, so a stale one slows the search down but
+     * doesn't change its results.
+     *
+     * Thread safe.
+     */
+    class GeoNearDensityCache {
+        MONGO_DISALLOW_COPYING(GeoNearDensityCache);
+    public:
+        GeoNearDensityCache();
+
+        /**
+         * If there is an estimate for 'region' of the index named 'indexName', returns true and
+         * sets '*estimatedDistance' to it.
+         */
+        bool get(StringData indexName, StringData region, double* estimatedDistance) const;
+
+        /**
+         * Like get(), but tries each of 'regions' in order and uses the first one with an
+         * estimate.
+         */
+        bool getFirst(StringData indexName,
+                      const std::vector<std::string>& regions,
+                      double* estimatedDistance) const;
+
+        /**
+         * Remembers 'estimatedDistance' for 'region' of the index named 'indexName', evicting
+         * the least recently used estimate if the cache is full.
+         */
+        void add(StringData indexName, StringData region, double estimatedDistance);
+
+        /**
+         * Forgets all estimates.
+         */
+        void clear();
+
+        /**
+         * Clears the cache once enough writes have happened since it was last cleared for the
+         * estimates to be out of date.
+         */
+        void notifyOfWriteOp();
+
+        size_t size() const;
+
+    private:
+        static std::string makeKey(StringData indexName, StringData region);
+
+        mutable boost::mutex _mutex;
+
+        // Protected by '_mutex'.  get() changes the order of the entries.
+        mutable LRUKeyValue<std::string, double> _estimates;
+
+        AtomicInt32 _writeOperations;
+    };
+
+}  // namespace mongo
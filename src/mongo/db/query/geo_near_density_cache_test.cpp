@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/geo_near_density_cache.h"
+
+#include "mongo/db/query/expression_index_knobs.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST(GeoNearDensityCacheTest, AddGet) {
+        GeoNearDensityCache cache;
+        double estimate = -1;
+        ASSERT_FALSE(cache.get("loc_2dsphere", "1/0", &estimate));
+
+        cache.add("loc_2dsphere", "1/0", 25.0);
+        ASSERT_TRUE(cache.get("loc_2dsphere", "1/0", &estimate));
+        ASSERT_EQUALS(25.0, estimate);
+        ASSERT_EQUALS(1U, cache.size());
+
+        // Replaces the earlier estimate.
+        cache.add("loc_2dsphere", "1/0", 50.0);
+        ASSERT_TRUE(cache.get("loc_2dsphere", "1/0", &estimate));
+        ASSERT_EQUALS(50.0, estimate);
+        ASSERT_EQUALS(1U, cache.size());
+    }
+
+    TEST(GeoNearDensityCacheTest, KeyedByIndexAndRegion) {
+        GeoNearDensityCache cache;
+        cache.add("a_2d", "0101", 1.0);
+        cache.add("b_2d", "0101", 2.0);
+        cache.add("a_2d", "0110", 3.0);
+
+        // The index name and region can't run into each other.
+        double estimate = -1;
+        ASSERT_FALSE(cache.get("a_2d0", "101", &estimate));
+
+        ASSERT_TRUE(cache.get("a_2d", "0101", &estimate));
+        ASSERT_EQUALS(1.0, estimate);
+        ASSERT_TRUE(cache.get("b_2d", "0101", &estimate));
+        ASSERT_EQUALS(2.0, estimate);
+        ASSERT_TRUE(cache.get("a_2d", "0110", &estimate));
+        ASSERT_EQUALS(3.0, estimate);
+    }
+
+    TEST(GeoNearDensityCacheTest, GetFirstUsesFirstRegionWithEstimate) {
+        GeoNearDensityCache cache;
+        cache.add("loc_2d", "01", 4.0);
+        cache.add("loc_2d", "0110", 1.0);
+
+        std::vector<std::string> regions;
+        regions.push_back("011011");
+        regions.push_back("0110");
+        regions.push_back("01");
+
+        double estimate = -1;
+        ASSERT_TRUE(cache.getFirst("loc_2d", regions, &estimate));
+        ASSERT_EQUALS(1.0, estimate);
+
+        regions.erase(regions.begin() + 1);
+        ASSERT_TRUE(cache.getFirst("loc_2d", regions, &estimate));
+        ASSERT_EQUALS(4.0, estimate);
+
+        ASSERT_FALSE(cache.getFirst("other_2d", regions, &estimate));
+        ASSERT_FALSE(cache.getFirst("loc_2d", std::vector<std::string>(), &estimate));
+    }
+
+    TEST(GeoNearDensityCacheTest, EvictsLeastRecentlyUsed) {
+        GeoNearDensityCache cache;
+        for (int i = 0; i <= internalGeoNearDensityCacheSize; ++i) {
+            cache.add("loc_2dsphere", std::string(str::stream() << i), i);
+
+            // Keep the first estimate in use.
+            double estimate;
+            ASSERT_TRUE(cache.get("loc_2dsphere", "0", &estimate));
+        }
+        ASSERT_EQUALS(static_cast<size_t>(internalGeoNearDensityCacheSize), cache.size());
+
+        double estimate;
+        ASSERT_TRUE(cache.get("loc_2dsphere", "0", &estimate));
+        ASSERT_FALSE(cache.get("loc_2dsphere", "1", &estimate));
+    }
+
+    TEST(GeoNearDensityCacheTest, ClearedByWrites) {
+        GeoNearDensityCache cache;
+        cache.add("loc_2dsphere", "1/0", 25.0);
+
+        for (int i = 0; i < internalQueryCacheWriteOpsBetweenFlush - 1; ++i) {
+            cache.notifyOfWriteOp();
+        }
+        ASSERT_EQUALS(1U, cache.size());
+
+        cache.notifyOfWriteOp();
+        ASSERT_EQUALS(0U, cache.size());
+
+        cache.add("loc_2dsphere", "1/0", 25.0);
+        cache.clear();
+        ASSERT_EQUALS(0U, cache.size());
+    }
+
+}  // namespace
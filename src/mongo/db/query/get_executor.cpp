@@ -36,14 +36,18 @@
 #include <memory>
 
 #include "mongo/base/error_codes.h"
+#include "mongo/base/counter.h"
 #include "mongo/base/parse_number.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/count.h"
 #include "mongo/db/exec/delete.h"
 #include "mongo/db/exec/eof.h"
 #include "mongo/db/exec/group.h"
+#include "mongo/db/exec/id_multi_get.h"
 #include "mongo/db/exec/idhack.h"
+#include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/oplogstart.h"
 #include "mongo/db/exec/projection.h"
@@ -85,6 +89,15 @@ namespace mongo {
     using std::string;
     using std::vector;
 
+    // Plan cache hits, split by whether the cached plan was restored from a persisted plan cache
+    // ("warm", as after a warm start) or chosen by this process ("cold").
+    static Counter64 planCacheWarmHits;
+    static Counter64 planCacheColdHits;
+    static ServerStatusMetricField<Counter64> displayPlanCacheWarmHits("query.planCache.hits.warm",
+                                                                       &planCacheWarmHits);
+    static ServerStatusMetricField<Counter64> displayPlanCacheColdHits("query.planCache.hits.cold",
+                                                                       &planCacheColdHits);
+
     // static
     void filterAllowedIndexEntries(const AllowedIndices& allowedIndices,
                                    std::vector<IndexEntry>* indexEntries) {
@@ -221,6 +234,45 @@ namespace mongo {
 
     namespace {
 
+        /**
+         * Adds the stages needed above a stage which looks documents up by _id, such as
+         * IDHackStage: a shard filter and the query's projection. Returns the new root.
+         */
+        PlanStage* addIdLookupWrappers(OperationContext* opCtx,
+                                       Collection* collection,
+                                       CanonicalQuery* canonicalQuery,
+                                       const QueryPlannerParams& plannerParams,
+                                       WorkingSet* ws,
+                                       PlanStage* root) {
+            // Might have to filter out orphaned docs.
+            if (plannerParams.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
+                root = new ShardFilterStage(shardingState.getCollectionMetadata(collection->ns()),
+                                            ws, root);
+            }
+
+            // There might be a projection. The _id lookup stages always fetch the full
+            // document, so we don't support covered projections. However, we might use the
+            // simple inclusion fast path.
+            if (NULL != canonicalQuery->getProj()) {
+                ProjectionStageParams params(WhereCallbackReal(opCtx, collection->ns().db()));
+                params.projObj = canonicalQuery->getProj()->getProjObj();
+
+                // Stuff the right data into the params depending on what proj impl we use.
+                if (canonicalQuery->getProj()->requiresDocument()
+                    || canonicalQuery->getProj()->wantIndexKey()) {
+                    params.fullExpression = canonicalQuery->root();
+                    params.projImpl = ProjectionStageParams::NO_FAST_PATH;
+                }
+                else {
+                    params.projImpl = ProjectionStageParams::SIMPLE_DOC;
+                }
+
+                root = new ProjectionStage(params, ws, root);
+            }
+
+            return root;
+        }
+
         /**
          * Build an execution tree for the query described in 'canonicalQuery'.  Does not take
          * ownership of arguments.
@@ -263,33 +315,28 @@ namespace mongo {
 
                 LOG(2) << "Using idhack: " << canonicalQuery->toStringShort();
 
-                *rootOut = new IDHackStage(opCtx, collection, canonicalQuery, ws);
+                *rootOut = addIdLookupWrappers(opCtx, collection, canonicalQuery, plannerParams,
+                                               ws,
+                                               new IDHackStage(opCtx, collection,
+                                                               canonicalQuery, ws));
+                return Status::OK();
+            }
 
-                // Might have to filter out orphaned docs.
-                if (plannerParams.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
-                    *rootOut =
-                        new ShardFilterStage(shardingState.getCollectionMetadata(collection->ns()),
-                                             ws, *rootOut);
-                }
+            // Likewise an {_id: {$in: [...]}} query can look the documents up directly.
+            if (IDMultiGetStage::supportsQuery(*canonicalQuery) &&
+                collection->getIndexCatalog()->findIdIndex(opCtx)) {
 
-                // There might be a projection. The idhack stage will always fetch the full
-                // document, so we don't support covered projections. However, we might use the
-                // simple inclusion fast path.
-                if (NULL != canonicalQuery->getProj()) {
-                    ProjectionStageParams params(WhereCallbackReal(opCtx, collection->ns().db()));
-                    params.projObj = canonicalQuery->getProj()->getProjObj();
-
-                    // Stuff the right data into the params depending on what proj impl we use.
-                    if (canonicalQuery->getProj()->requiresDocument()
-                        || canonicalQuery->getProj()->wantIndexKey()) {
-                        params.fullExpression = canonicalQuery->root();
-                        params.projImpl = ProjectionStageParams::NO_FAST_PATH;
-                    }
-                    else {
-                        params.projImpl = ProjectionStageParams::SIMPLE_DOC;
-                    }
+                LOG(2) << "Using _id multi-get: " << canonicalQuery->toStringShort();
+
+                *rootOut = addIdLookupWrappers(opCtx, collection, canonicalQuery, plannerParams,
+                                               ws,
+                                               new IDMultiGetStage(opCtx, collection,
+                                                                   canonicalQuery, ws));
 
-                    *rootOut = new ProjectionStage(params, ws, *rootOut);
+                // A negative limit ('ntoreturn' without 'wantMore') is a hard limit.
+                const LiteParsedQuery& parsed = canonicalQuery->getParsed();
+                if (0 != parsed.getNumToReturn() && !parsed.wantMore()) {
+                    *rootOut = new LimitStage(parsed.getNumToReturn(), ws, *rootOut);
                 }
 
                 return Status::OK();
@@ -325,6 +372,13 @@ namespace mongo {
                                                             &qs);
 
                 if (status.isOK()) {
+                    if (cs->restored) {
+                        planCacheWarmHits.increment();
+                    }
+                    else {
+                        planCacheColdHits.increment();
+                    }
+
                     verify(StageBuilder::build(opCtx, collection, *qs, ws, rootOut));
                     if ((plannerParams.options & QueryPlannerParams::PRIVATE_IS_COUNT)
                         && turnIxscanIntoCount(qs)) {
@@ -1065,37 +1119,34 @@ namespace {
 
             IndexScanNode* isn = static_cast<IndexScanNode*>(root->children[0]);
 
-            // No filters allowed and side-stepping isSimpleRange for now.  TODO: do we ever see
-            // isSimpleRange here?  because we could well use it.  I just don't think we ever do see
-            // it.
-
-            if (NULL != isn->filter.get() || isn->bounds.isSimpleRange) {
-                return false;
-            }
-
-            // Make sure the bounds are OK.
-            BSONObj startKey;
-            bool startKeyInclusive;
-            BSONObj endKey;
-            bool endKeyInclusive;
-
-            if (!IndexBoundsBuilder::isSingleInterval( isn->bounds,
-                                                       &startKey,
-                                                       &startKeyInclusive,
-                                                       &endKey,
-                                                       &endKeyInclusive )) {
+            // Side-stepping isSimpleRange for now.  TODO: do we ever see isSimpleRange here?
+            // because we could well use it.  I just don't think we ever do see it.
+            //
+            // The count scan only goes forward, but nothing asks a count for an order.
+            if (isn->bounds.isSimpleRange || 1 != isn->direction) {
                 return false;
             }
 
             // Make the count node that we replace the fetch + ixscan with.
-            CountNode* cn = new CountNode();
+            auto_ptr<CountNode> cn(new CountNode());
             cn->indexKeyPattern = isn->indexKeyPattern;
-            cn->startKey = startKey;
-            cn->startKeyInclusive = startKeyInclusive;
-            cn->endKey = endKey;
-            cn->endKeyInclusive = endKeyInclusive;
+
+            // A single interval is scanned from its start key to its end key.  Otherwise the
+            // count scan walks the bounds the same way the index scan would have.
+            if (!IndexBoundsBuilder::isSingleInterval(isn->bounds,
+                                                      &cn->startKey,
+                                                      &cn->startKeyInclusive,
+                                                      &cn->endKey,
+                                                      &cn->endKeyInclusive)) {
+                cn->bounds = isn->bounds;
+            }
+
+            // The ixscan's filter only refers to fields in the index key, so the count scan can
+            // apply it without fetching.
+            cn->filter.swap(isn->filter);
+
             // Takes ownership of 'cn' and deletes the old root.
-            soln->root.reset(cn);
+            soln->root.reset(cn.release());
             return true;
         }
 
@@ -37,6 +37,7 @@
 #include <memory>
 #include "boost/thread/locks.hpp"
 #include "mongo/base/owned_pointer_vector.h"
+#include "mongo/bson/util/bson_extract.h"
 #include "mongo/client/dbclientinterface.h"   // For QueryOption_foobar
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
@@ -246,7 +247,8 @@ namespace {
           query(entry.query.getOwned()),
           sort(entry.sort.getOwned()),
           projection(entry.projection.getOwned()),
-          decisionWorks(entry.decision->stats[0]->common.works) {
+          decisionWorks(entry.decision->stats[0]->common.works),
+          restored(entry.restored) {
         // CachedSolution should not having any references into
         // cache entry. All relevant data should be cloned/copied.
         for (size_t i = 0; i < entry.plannerData.size(); ++i) {
@@ -270,7 +272,8 @@ namespace {
     PlanCacheEntry::PlanCacheEntry(const std::vector<QuerySolution*>& solutions,
                                    PlanRankingDecision* why)
         : plannerData(solutions.size()),
-          decision(why) {
+          decision(why),
+          restored(false) {
         invariant(why);
 
         // The caller of this constructor is responsible for ensuring
@@ -306,6 +309,7 @@ namespace {
         entry->query = query.getOwned();
         entry->sort = sort.getOwned();
         entry->projection = projection.getOwned();
+        entry->restored = restored;
 
         // Copy performance stats.
         for (size_t i = 0; i < feedback.size(); ++i) {
@@ -374,6 +378,94 @@ namespace {
         return result.str();
     }
 
+    BSONObj PlanCacheIndexTree::toBSON() const {
+        BSONObjBuilder bob;
+        if (NULL != entry.get()) {
+            bob.append("index", BSON("name" << entry->name << "key" << entry->keyPattern));
+            bob.appendNumber("pos", static_cast<long long>(index_pos));
+        }
+
+        BSONArrayBuilder childrenBob(bob.subarrayStart("children"));
+        for (std::vector<PlanCacheIndexTree*>::const_iterator it = children.begin();
+                it != children.end(); ++it) {
+            childrenBob.append((*it)->toBSON());
+        }
+        childrenBob.doneFast();
+
+        return bob.obj();
+    }
+
+    // static
+    StatusWith<PlanCacheIndexTree*> PlanCacheIndexTree::fromBSON(
+                                                const BSONObj& obj,
+                                                const std::vector<IndexEntry>& indices) {
+        std::auto_ptr<PlanCacheIndexTree> tree(new PlanCacheIndexTree());
+
+        BSONElement indexElt = obj["index"];
+        if (!indexElt.eoo()) {
+            if (Object != indexElt.type()) {
+                return StatusWith<PlanCacheIndexTree*>(ErrorCodes::TypeMismatch,
+                                                       "'index' must be an object");
+            }
+            BSONObj indexObj = indexElt.Obj();
+
+            std::string name;
+            Status status = bsonExtractStringField(indexObj, "name", &name);
+            if (!status.isOK()) {
+                return StatusWith<PlanCacheIndexTree*>(status);
+            }
+            BSONObj keyPattern = indexObj["key"].isABSONObj() ? indexObj["key"].Obj()
+                                                               : BSONObj();
+
+            long long pos;
+            status = bsonExtractIntegerField(obj, "pos", &pos);
+            if (!status.isOK()) {
+                return StatusWith<PlanCacheIndexTree*>(status);
+            }
+
+            // The index must still exist with the same key pattern.
+            const IndexEntry* found = NULL;
+            for (size_t i = 0; i < indices.size(); ++i) {
+                if (indices[i].name == name && indices[i].keyPattern == keyPattern) {
+                    found = &indices[i];
+                    break;
+                }
+            }
+            if (NULL == found) {
+                return StatusWith<PlanCacheIndexTree*>(ErrorCodes::IndexNotFound, str::stream()
+                    << "index " << name << " with key " << keyPattern << " no longer exists");
+            }
+            if (pos < 0 || pos >= found->keyPattern.nFields()) {
+                return StatusWith<PlanCacheIndexTree*>(ErrorCodes::BadValue, str::stream()
+                    << "position " << pos << " out of range for index " << name);
+            }
+
+            tree->setIndexEntry(*found);
+            tree->index_pos = static_cast<size_t>(pos);
+        }
+
+        BSONElement childrenElt = obj["children"];
+        if (!childrenElt.eoo()) {
+            if (Array != childrenElt.type()) {
+                return StatusWith<PlanCacheIndexTree*>(ErrorCodes::TypeMismatch,
+                                                       "'children' must be an array");
+            }
+            BSONForEach(childElt, childrenElt.Obj()) {
+                if (Object != childElt.type()) {
+                    return StatusWith<PlanCacheIndexTree*>(ErrorCodes::TypeMismatch,
+                                                           "'children' must contain objects");
+                }
+                StatusWith<PlanCacheIndexTree*> child = fromBSON(childElt.Obj(), indices);
+                if (!child.isOK()) {
+                    return child;
+                }
+                tree->children.push_back(child.getValue());
+            }
+        }
+
+        return StatusWith<PlanCacheIndexTree*>(tree.release());
+    }
+
     //
     // SolutionCacheData
     //
@@ -412,6 +504,86 @@ namespace {
         MONGO_UNREACHABLE;
     }
 
+    namespace {
+
+        const char* solutionTypeName(SolutionCacheData::SolutionType type) {
+            switch (type) {
+            case SolutionCacheData::WHOLE_IXSCAN_SOLN: return "wholeIndexScan";
+            case SolutionCacheData::COLLSCAN_SOLN: return "collectionScan";
+            case SolutionCacheData::USE_INDEX_TAGS_SOLN: return "indexTags";
+            }
+            MONGO_UNREACHABLE;
+        }
+
+    } // namespace
+
+    BSONObj SolutionCacheData::toBSON() const {
+        BSONObjBuilder bob;
+        bob.append("type", solutionTypeName(solnType));
+        bob.append("wholeIndexScanDir", wholeIXSolnDir);
+        bob.append("indexFilterApplied", indexFilterApplied);
+        if (NULL != tree.get()) {
+            bob.append("tree", tree->toBSON());
+        }
+        return bob.obj();
+    }
+
+    // static
+    StatusWith<SolutionCacheData*> SolutionCacheData::fromBSON(
+                                                const BSONObj& obj,
+                                                const std::vector<IndexEntry>& indices) {
+        std::auto_ptr<SolutionCacheData> data(new SolutionCacheData());
+
+        std::string type;
+        Status status = bsonExtractStringField(obj, "type", &type);
+        if (!status.isOK()) {
+            return StatusWith<SolutionCacheData*>(status);
+        }
+        if (type == solutionTypeName(WHOLE_IXSCAN_SOLN)) {
+            data->solnType = WHOLE_IXSCAN_SOLN;
+        }
+        else if (type == solutionTypeName(COLLSCAN_SOLN)) {
+            data->solnType = COLLSCAN_SOLN;
+        }
+        else if (type == solutionTypeName(USE_INDEX_TAGS_SOLN)) {
+            data->solnType = USE_INDEX_TAGS_SOLN;
+        }
+        else {
+            return StatusWith<SolutionCacheData*>(ErrorCodes::BadValue,
+                                                  "unknown cached solution type: " + type);
+        }
+
+        long long dir;
+        status = bsonExtractIntegerFieldWithDefault(obj, "wholeIndexScanDir", 1, &dir);
+        if (!status.isOK()) {
+            return StatusWith<SolutionCacheData*>(status);
+        }
+        data->wholeIXSolnDir = static_cast<int>(dir);
+
+        status = bsonExtractBooleanFieldWithDefault(obj, "indexFilterApplied", false,
+                                                    &data->indexFilterApplied);
+        if (!status.isOK()) {
+            return StatusWith<SolutionCacheData*>(status);
+        }
+
+        BSONElement treeElt = obj["tree"];
+        if (treeElt.isABSONObj()) {
+            StatusWith<PlanCacheIndexTree*> tree = PlanCacheIndexTree::fromBSON(treeElt.Obj(),
+                                                                                indices);
+            if (!tree.isOK()) {
+                return StatusWith<SolutionCacheData*>(tree.getStatus());
+            }
+            data->tree.reset(tree.getValue());
+        }
+
+        if (COLLSCAN_SOLN != data->solnType && NULL == data->tree.get()) {
+            return StatusWith<SolutionCacheData*>(ErrorCodes::BadValue,
+                                                  "cached index solution has no index tree");
+        }
+
+        return StatusWith<SolutionCacheData*>(data.release());
+    }
+
     //
     // PlanCache
     //
@@ -586,6 +758,59 @@ namespace {
         return Status::OK();
     }
 
+    Status PlanCache::addRestored(const CanonicalQuery& query,
+                                  const std::vector<SolutionCacheData*>& plannerData,
+                                  const std::vector<double>& scores,
+                                  size_t decisionWorks) {
+        if (plannerData.empty()) {
+            return Status(ErrorCodes::BadValue, "no solutions provided");
+        }
+
+        if (scores.size() != plannerData.size()) {
+            return Status(ErrorCodes::BadValue, "number of scores must match solutions");
+        }
+
+        // Rebuild just enough of a ranking decision for the CachedPlanStage to decide when the
+        // restored entry should be evicted and the query replanned.
+        OwnedPointerVector<QuerySolution> solutions;
+        std::auto_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        for (size_t i = 0; i < plannerData.size(); ++i) {
+            invariant(plannerData[i]);
+            QuerySolution* qs = new QuerySolution();
+            qs->cacheData.reset(plannerData[i]->clone());
+            solutions.mutableVector().push_back(qs);
+
+            CommonStats common("RESTORED_PLAN");
+            common.works = decisionWorks;
+            why->stats.mutableVector().push_back(new PlanStageStats(common, STAGE_MULTI_PLAN));
+            why->scores.push_back(scores[i]);
+            why->candidateOrder.push_back(i);
+        }
+
+        std::auto_ptr<PlanCacheEntry> entry(new PlanCacheEntry(solutions.vector(),
+                                                               why.release()));
+        const LiteParsedQuery& pq = query.getParsed();
+        entry->query = pq.getFilter().getOwned();
+        entry->sort = pq.getSort().getOwned();
+        entry->projection = pq.getProj().getOwned();
+        entry->restored = true;
+
+        const PlanCacheKey key = computeKey(query);
+        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        if (_cache.hasKey(key)) {
+            return Status(ErrorCodes::AlreadyInitialized, "query shape already has a cached plan");
+        }
+
+        std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, entry.release());
+        if (NULL != evictedEntry.get()) {
+            LOG(1) << _ns << ": plan cache maximum size exceeded - "
+                   << "removed least recently used entry "
+                   << evictedEntry->toString();
+        }
+
+        return Status::OK();
+    }
+
     Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const {
         PlanCacheKey key = computeKey(query);
         verify(crOut);
@@ -33,6 +33,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "mongo/base/status_with.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -111,6 +112,21 @@ namespace mongo {
          */
         std::string toString(int indents = 0) const;
 
+        /**
+         * Serializes this tree so that it can be persisted. Index entries are identified only
+         * by name and key pattern.
+         */
+        BSONObj toBSON() const;
+
+        /**
+         * Parses a tree serialized by toBSON(), resolving each index by name and key pattern
+         * against 'indices'. Returns an error if an index is no longer present.
+         *
+         * Caller owns the returned tree.
+         */
+        static StatusWith<PlanCacheIndexTree*> fromBSON(const BSONObj& obj,
+                                                         const std::vector<IndexEntry>& indices);
+
         // Children owned here.
         std::vector<PlanCacheIndexTree*> children;
 
@@ -140,6 +156,12 @@ namespace mongo {
         // For debugging.
         std::string toString() const;
 
+        // Serialization for persisting cached plan choices. See PlanCacheIndexTree::toBSON()
+        // and PlanCacheIndexTree::fromBSON(). Caller owns the result of fromBSON().
+        BSONObj toBSON() const;
+        static StatusWith<SolutionCacheData*> fromBSON(const BSONObj& obj,
+                                                        const std::vector<IndexEntry>& indices);
+
         // Owned here. If 'wholeIXSoln' is false, then 'tree'
         // can be used to tag an isomorphic match expression. If 'wholeIXSoln'
         // is true, then 'tree' is used to store the relevant IndexEntry.
@@ -200,6 +222,10 @@ namespace mongo {
         // The number of work cycles taken to decide on a winning plan when the plan was first
         // cached.
         size_t decisionWorks;
+
+        // True if the entry was restored from persisted plan choices rather than decided by a
+        // local trial.
+        bool restored;
     };
 
     /**
@@ -257,6 +283,10 @@ namespace mongo {
         // Annotations from cached runs.  The CachedPlanStage provides these stats about its
         // runs when they complete.
         std::vector<PlanCacheEntryFeedback*> feedback;
+
+        // True if this entry was restored from persisted plan choices (after a restart, or
+        // imported from another replica set member) rather than decided by a local trial.
+        bool restored;
     };
 
     /**
@@ -300,6 +330,20 @@ namespace mongo {
                    const std::vector<QuerySolution*>& solns,
                    PlanRankingDecision* why);
 
+        /**
+         * Record previously persisted plan choices for 'query'. 'plannerData' holds the
+         * solutions, best first, and 'scores' their scores at the time they were ranked.
+         * 'decisionWorks' is the number of works it originally took to pick the winner.
+         * Does not take ownership of the elements of 'plannerData'.
+         *
+         * An existing entry for the query is never replaced, as a local decision is more
+         * trustworthy than a persisted one; in that case an error Status is returned.
+         */
+        Status addRestored(const CanonicalQuery& query,
+                           const std::vector<SolutionCacheData*>& plannerData,
+                           const std::vector<double>& scores,
+                           size_t decisionWorks);
+
         /**
          * Look up the cached data access for the provided 'query'.  Used by the query planner
          * to shortcut planning.
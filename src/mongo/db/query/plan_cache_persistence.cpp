@@ -0,0 +1,465 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache_persistence.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/base/counter.h"
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/repl/is_master_response.h"
+#include "mongo/db/repl/oplogreader.h"
+#include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+    using std::auto_ptr;
+    using std::list;
+    using std::set;
+    using std::string;
+    using std::vector;
+
+    const char kPersistedPlanCacheNamespace[] = "local.system.plancache";
+
+    // How often, in seconds, cached plan choices are persisted. Zero disables persistence.
+    MONGO_EXPORT_SERVER_PARAMETER(planCachePersistIntervalSecs, int, 0);
+
+    // Whether a secondary also imports the plan choices persisted by its primary.
+    MONGO_EXPORT_SERVER_PARAMETER(planCacheImportFromPrimary, bool, false);
+
+namespace {
+
+    Counter64 planCacheEntriesPersisted;
+    Counter64 planCacheEntriesRestored;
+    Counter64 planCacheEntriesInvalid;
+
+    ServerStatusMetricField<Counter64> displayPlanCacheEntriesPersisted(
+                                            "query.planCache.persisted",
+                                            &planCacheEntriesPersisted);
+    ServerStatusMetricField<Counter64> displayPlanCacheEntriesRestored(
+                                            "query.planCache.restored",
+                                            &planCacheEntriesRestored);
+    ServerStatusMetricField<Counter64> displayPlanCacheEntriesInvalid(
+                                            "query.planCache.restoreInvalid",
+                                            &planCacheEntriesInvalid);
+
+    /**
+     * Serializes every entry in the plan cache of 'ns' and appends them to 'out'.
+     */
+    void serializeCollectionPlanCache(OperationContext* txn,
+                                      Database* db,
+                                      const string& ns,
+                                      vector<BSONObj>* out) {
+        Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IS);
+        Collection* collection = db->getCollection(ns);
+        if (!collection) {
+            return;
+        }
+
+        OwnedPointerVector<PlanCacheEntry> entries;
+        entries.mutableVector() = collection->infoCache()->getPlanCache()->getAllEntries();
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const PlanCacheEntry* entry = entries[i];
+            invariant(entry->decision.get());
+
+            BSONObjBuilder bob;
+            bob.genOID();
+            bob.append("ns", ns);
+            bob.append("query", entry->query);
+            bob.append("sort", entry->sort);
+            bob.append("projection", entry->projection);
+            bob.appendNumber("decisionWorks",
+                             static_cast<long long>(entry->decision->stats[0]->common.works));
+
+            BSONArrayBuilder plansBob(bob.subarrayStart("plans"));
+            for (size_t j = 0; j < entry->plannerData.size(); ++j) {
+                plansBob.append(entry->plannerData[j]->toBSON());
+            }
+            plansBob.doneFast();
+
+            BSONArrayBuilder scoresBob(bob.subarrayStart("scores"));
+            for (size_t j = 0; j < entry->decision->scores.size(); ++j) {
+                scoresBob.append(entry->decision->scores[j]);
+            }
+            scoresBob.doneFast();
+
+            if (bob.len() > BSONObjMaxUserSize) {
+                LOG(1) << "not persisting oversized plan cache entry for " << ns;
+                continue;
+            }
+            out->push_back(bob.obj());
+        }
+    }
+
+    /**
+     * Adds the persisted plan cache entry 'obj' to the plan cache of its collection if the
+     * entry is still valid for the collection's indexes.
+     */
+    Status restorePlanCacheEntry(OperationContext* txn, const BSONObj& obj) {
+        const string ns = obj["ns"].str();
+        const NamespaceString nss(ns);
+        if (!nss.isValid()) {
+            return Status(ErrorCodes::InvalidNamespace, "invalid namespace: " + ns);
+        }
+
+        if (!obj["query"].isABSONObj() || !obj["sort"].isABSONObj() ||
+            !obj["projection"].isABSONObj() || Array != obj["plans"].type() ||
+            Array != obj["scores"].type()) {
+            return Status(ErrorCodes::BadValue, "malformed plan cache entry");
+        }
+
+        AutoGetCollectionForRead ctx(txn, ns);
+        Collection* collection = ctx.getCollection();
+        if (!collection) {
+            return Status(ErrorCodes::NamespaceNotFound, "collection no longer exists: " + ns);
+        }
+
+        CanonicalQuery* rawCq;
+        const WhereCallbackReal whereCallback(txn, nss.db());
+        Status status = CanonicalQuery::canonicalize(ns,
+                                                     obj["query"].Obj(),
+                                                     obj["sort"].Obj(),
+                                                     obj["projection"].Obj(),
+                                                     &rawCq,
+                                                     whereCallback);
+        if (!status.isOK()) {
+            return status;
+        }
+        scoped_ptr<CanonicalQuery> cq(rawCq);
+
+        if (!PlanCache::shouldCacheQuery(*cq)) {
+            return Status(ErrorCodes::BadValue, "query shape is not cacheable");
+        }
+
+        // Resolve the persisted indexes against the ones the planner would use now.
+        QueryPlannerParams plannerParams;
+        fillOutPlannerParams(txn, collection, cq.get(), &plannerParams);
+
+        OwnedPointerVector<SolutionCacheData> plannerData;
+        BSONForEach(planElt, obj["plans"].Obj()) {
+            if (!planElt.isABSONObj()) {
+                return Status(ErrorCodes::BadValue, "malformed plan cache entry");
+            }
+            StatusWith<SolutionCacheData*> data =
+                SolutionCacheData::fromBSON(planElt.Obj(), plannerParams.indices);
+            if (!data.isOK()) {
+                return data.getStatus();
+            }
+            plannerData.mutableVector().push_back(data.getValue());
+        }
+
+        vector<double> scores;
+        BSONForEach(scoreElt, obj["scores"].Obj()) {
+            scores.push_back(scoreElt.numberDouble());
+        }
+
+        return collection->infoCache()->getPlanCache()->addRestored(
+                                        *cq,
+                                        plannerData.vector(),
+                                        scores,
+                                        static_cast<size_t>(obj["decisionWorks"].numberLong()));
+    }
+
+    /**
+     * Periodically persists cached plan choices and, on secondaries, imports the plan choices
+     * of the primary.
+     */
+    class PlanCachePersister : public BackgroundJob {
+    public:
+        virtual string name() const { return "PlanCachePersister"; }
+
+        virtual void run() {
+            Client::initThread(name().c_str());
+            AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+            Timer sinceLastPass;
+            while (!inShutdown()) {
+                sleepsecs(1);
+
+                const int intervalSecs = planCachePersistIntervalSecs;
+                if (intervalSecs <= 0 || sinceLastPass.seconds() < intervalSecs) {
+                    continue;
+                }
+                sinceLastPass.reset();
+
+                try {
+                    doPass();
+                }
+                catch (const DBException& ex) {
+                    warning() << "error persisting plan cache: " << ex.toString();
+                }
+            }
+        }
+
+    private:
+        void doPass() {
+            OperationContextImpl txn;
+
+            repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
+            const bool isReplSet =
+                replCoord->getReplicationMode() == repl::ReplicationCoordinator::modeReplSet;
+
+            // If part of replSet but not in a readable state (e.g. during initial sync), skip.
+            if (isReplSet && !replCoord->getMemberState().readable()) {
+                return;
+            }
+
+            if (isReplSet && planCacheImportFromPrimary &&
+                replCoord->getMemberState().secondary()) {
+                importFromPrimary(&txn, replCoord);
+            }
+
+            const size_t saved = savePlanCaches(&txn);
+            LOG(1) << "persisted " << saved << " plan cache entries";
+        }
+
+        void importFromPrimary(OperationContext* txn, repl::ReplicationCoordinator* replCoord) {
+            repl::IsMasterResponse isMaster;
+            replCoord->fillIsMasterForReplSet(&isMaster);
+            if (!isMaster.hasPrimary()) {
+                return;
+            }
+
+            DBClientConnection conn(false, 30 /* socket timeout */);
+            string errmsg;
+            if (!conn.connect(isMaster.getPrimary(), errmsg) || !repl::replAuthenticate(&conn)) {
+                warning() << "could not connect to primary " << isMaster.getPrimary()
+                          << " to import its plan cache: " << errmsg;
+                return;
+            }
+
+            const size_t restored = restorePlanCaches(txn, &conn);
+            LOG(1) << "imported " << restored << " plan cache entries from primary "
+                   << isMaster.getPrimary();
+        }
+    };
+
+    /**
+     * Creates local.system.plancache if it doesn't exist yet. Only this takes the local database
+     * in MODE_X, which blocks oplog writes, and it only does so the first time.
+     */
+    void createPersistedPlanCacheCollection(OperationContext* txn) {
+        const StringData ns(kPersistedPlanCacheNamespace);
+        {
+            ScopedTransaction transaction(txn, MODE_IS);
+            AutoGetDb autoDb(txn, nsToDatabaseSubstring(ns), MODE_IS);
+            if (autoDb.getDb() && autoDb.getDb()->getCollection(ns)) {
+                return;
+            }
+        }
+
+        MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+            ScopedTransaction transaction(txn, MODE_IX);
+            AutoGetOrCreateDb autoDb(txn, nsToDatabaseSubstring(ns), MODE_X);
+            Database* db = autoDb.getDb();
+            if (!db->getCollection(ns)) {
+                WriteUnitOfWork wunit(txn);
+                invariant(db->createCollection(txn, ns));
+                wunit.commit();
+            }
+        } MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn, "savePlanCaches", ns);
+    }
+
+    /**
+     * Replaces the previously persisted choices with 'docs'. Entries for dropped collections and
+     * evicted query shapes go away with them. The collection is written directly rather than
+     * through a client because user writes to local.system.* are rejected. Removing the old
+     * entries and inserting the new ones is a single unit of work, so a crash in between can't
+     * lose the persisted choices. The local database is only locked in MODE_IX, so oplog writes
+     * carry on while the entries are saved.
+     */
+    Status writePersistedPlanCaches(OperationContext* txn, const vector<BSONObj>& docs) {
+        const StringData ns(kPersistedPlanCacheNamespace);
+        try {
+            createPersistedPlanCacheCollection(txn);
+
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetDb autoDb(txn, nsToDatabaseSubstring(ns), MODE_IX);
+                Lock::CollectionLock collLock(txn->lockState(), ns, MODE_X);
+                Collection* collection = autoDb.getDb() ? autoDb.getDb()->getCollection(ns)
+                                                        : NULL;
+                if (!collection) {
+                    return Status(ErrorCodes::NamespaceNotFound,
+                                  str::stream() << ns << " was dropped while saving");
+                }
+
+                WriteUnitOfWork wunit(txn);
+                vector<RecordId> locs;
+                scoped_ptr<RecordIterator> it(collection->getIterator(txn));
+                while (!it->isEOF()) {
+                    locs.push_back(it->getNext());
+                }
+                it.reset();
+                for (size_t i = 0; i < locs.size(); ++i) {
+                    collection->deleteDocument(txn, locs[i]);
+                }
+
+                for (size_t i = 0; i < docs.size(); ++i) {
+                    StatusWith<RecordId> inserted = collection->insertDocument(txn,
+                                                                               docs[i],
+                                                                               false);
+                    if (!inserted.isOK()) {
+                        return inserted.getStatus();
+                    }
+                }
+                wunit.commit();
+            } MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn, "savePlanCaches", ns);
+        }
+        catch (const DBException& ex) {
+            return ex.toStatus();
+        }
+        return Status::OK();
+    }
+
+} // namespace
+
+    size_t savePlanCaches(OperationContext* txn) {
+        const NamespaceString persistedNss(kPersistedPlanCacheNamespace);
+
+        vector<BSONObj> docs;
+        set<string> dbNames;
+        dbHolder().getAllShortNames(dbNames);
+        for (set<string>::const_iterator it = dbNames.begin(); it != dbNames.end(); ++it) {
+            if (*it == persistedNss.db()) {
+                continue;
+            }
+
+            ScopedTransaction transaction(txn, MODE_IS);
+            Lock::DBLock dbLock(txn->lockState(), *it, MODE_IS);
+            Database* db = dbHolder().get(txn, *it);
+            if (!db) {
+                continue;
+            }
+
+            list<string> namespaces;
+            db->getDatabaseCatalogEntry()->getCollectionNamespaces(&namespaces);
+            for (list<string>::const_iterator ns = namespaces.begin();
+                 ns != namespaces.end(); ++ns) {
+                serializeCollectionPlanCache(txn, db, *ns, &docs);
+            }
+        }
+
+        Status status = writePersistedPlanCaches(txn, docs);
+        if (!status.isOK()) {
+            warning() << "could not persist plan cache to " << kPersistedPlanCacheNamespace
+                      << ": " << status;
+            return 0;
+        }
+
+        planCacheEntriesPersisted.increment(docs.size());
+        return docs.size();
+    }
+
+    size_t restorePlanCaches(OperationContext* txn, DBClientBase* source) {
+        // Read everything up front so that no cursor is held open on 'source' while taking
+        // collection locks.
+        vector<BSONObj> docs;
+        auto_ptr<DBClientCursor> cursor = source->query(kPersistedPlanCacheNamespace,
+                                                        Query(),
+                                                        0,
+                                                        0,
+                                                        NULL,
+                                                        QueryOption_SlaveOk);
+        if (!cursor.get()) {
+            return 0;
+        }
+        while (cursor->more()) {
+            docs.push_back(cursor->nextSafe().getOwned());
+        }
+        cursor.reset();
+
+        size_t restored = 0;
+        for (size_t i = 0; i < docs.size(); ++i) {
+            Status status = restorePlanCacheEntry(txn, docs[i]);
+            if (status.isOK()) {
+                ++restored;
+            }
+            else if (status.code() != ErrorCodes::AlreadyInitialized) {
+                // Shapes that were planned locally since startup keep their own decision and are
+                // not counted as invalid.
+                LOG(2) << "not restoring plan cache entry " << docs[i] << ": " << status;
+                planCacheEntriesInvalid.increment();
+            }
+        }
+
+        planCacheEntriesRestored.increment(restored);
+        return restored;
+    }
+
+    void startPlanCachePersistence(OperationContext* txn) {
+        if (planCachePersistIntervalSecs > 0) {
+            try {
+                DBDirectClient client(txn);
+                const size_t restored = restorePlanCaches(txn, &client);
+                log() << "restored " << restored << " persisted plan cache entries";
+            }
+            catch (const DBException& ex) {
+                warning() << "could not restore persisted plan cache: " << ex.toString();
+            }
+        }
+
+        PlanCachePersister* persister = new PlanCachePersister();
+        persister->go();
+    }
+
+} // namespace mongo
@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace mongo {
+
+    class DBClientBase;
+    class OperationContext;
+
+    /**
+     * Plan cache warm start.
+     *
+     * The plan cache lives in memory only, so after a restart or a failover every query shape
+     * must be planned again. When planCachePersistIntervalSecs is set, the cached plan choices
+     * of every collection are periodically written to kPersistedPlanCacheNamespace and are
+     * reloaded at startup. Secondaries can also import the plan choices of their primary with
+     * planCacheImportFromPrimary so that they are warm if they are elected.
+     *
+     * Restored entries are validated against the collection's current indexes and never
+     * replace plan choices that were made locally.
+     */
+
+    // The collection that cached plan choices are persisted to. It is not replicated.
+    extern const char kPersistedPlanCacheNamespace[];
+
+    /**
+     * Replaces the contents of kPersistedPlanCacheNamespace with the cached plan choices of
+     * every collection. Returns the number of entries written.
+     */
+    size_t savePlanCaches(OperationContext* txn);
+
+    /**
+     * Reads the persisted plan choices in kPersistedPlanCacheNamespace on 'source' and adds
+     * the ones which are still valid to the plan caches of the local collections. 'source' may
+     * be a DBDirectClient to reload this node's own choices. Returns the number of entries
+     * restored.
+     */
+    size_t restorePlanCaches(OperationContext* txn, DBClientBase* source);
+
+    /**
+     * Reloads the persisted plan choices, if persistence is enabled, and starts the background
+     * job that periodically persists them. Called once at startup.
+     */
+    void startPlanCachePersistence(OperationContext* txn);
+
+} // namespace mongo
@@ -424,6 +424,88 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    TEST(PlanCacheTest, AddRestoredSolution) {
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        SolutionCacheData data;
+        data.tree.reset(new PlanCacheIndexTree());
+        std::vector<SolutionCacheData*> plannerData;
+        plannerData.push_back(&data);
+        std::vector<double> scores;
+        scores.push_back(1.5);
+
+        ASSERT_OK(planCache.addRestored(*cq, plannerData, scores, 42U));
+        ASSERT_TRUE(planCache.contains(*cq));
+
+        CachedSolution* rawCS;
+        ASSERT_OK(planCache.get(*cq, &rawCS));
+        boost::scoped_ptr<CachedSolution> cs(rawCS);
+        ASSERT_TRUE(cs->restored);
+        ASSERT_EQUALS(cs->decisionWorks, 42U);
+
+        // A restored entry never replaces an existing one.
+        ASSERT_NOT_OK(planCache.addRestored(*cq, plannerData, scores, 1U));
+        ASSERT_EQUALS(planCache.size(), 1U);
+
+        // Mismatched scores are rejected.
+        auto_ptr<CanonicalQuery> otherCq(canonicalize("{b: 1}"));
+        ASSERT_NOT_OK(planCache.addRestored(*otherCq, plannerData, std::vector<double>(), 1U));
+    }
+
+    TEST(PlanCacheTest, LocallyDecidedSolutionIsNotRestored) {
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+
+        CachedSolution* rawCS;
+        ASSERT_OK(planCache.get(*cq, &rawCS));
+        boost::scoped_ptr<CachedSolution> cs(rawCS);
+        ASSERT_FALSE(cs->restored);
+    }
+
+    TEST(PlanCacheTest, SolutionCacheDataFromBSONRequiresMatchingIndex) {
+        std::vector<IndexEntry> indices;
+        indices.push_back(IndexEntry(BSON("a" << 1), false, false, false, "a_1", NULL,
+                                     BSONObj()));
+
+        SolutionCacheData data;
+        data.tree.reset(new PlanCacheIndexTree());
+        data.tree->setIndexEntry(indices[0]);
+        const BSONObj serialized = data.toBSON();
+
+        StatusWith<SolutionCacheData*> parsed = SolutionCacheData::fromBSON(serialized, indices);
+        ASSERT_OK(parsed.getStatus());
+        boost::scoped_ptr<SolutionCacheData> parsedData(parsed.getValue());
+        ASSERT_EQUALS(parsedData->solnType, SolutionCacheData::USE_INDEX_TAGS_SOLN);
+        ASSERT_EQUALS(parsedData->tree->entry->name, "a_1");
+        ASSERT_EQUALS(serialized, parsedData->toBSON());
+
+        // Same name, different key pattern.
+        std::vector<IndexEntry> changedIndices;
+        changedIndices.push_back(IndexEntry(BSON("a" << -1), false, false, false, "a_1", NULL,
+                                            BSONObj()));
+        ASSERT_NOT_OK(SolutionCacheData::fromBSON(serialized, changedIndices).getStatus());
+
+        // Index dropped.
+        ASSERT_NOT_OK(SolutionCacheData::fromBSON(serialized,
+                                                  std::vector<IndexEntry>()).getStatus());
+
+        // Unknown solution type.
+        ASSERT_NOT_OK(SolutionCacheData::fromBSON(BSON("type" << "bogus"), indices).getStatus());
+
+        // Collection scans have no index tree.
+        SolutionCacheData collscan;
+        collscan.solnType = SolutionCacheData::COLLSCAN_SOLN;
+        parsed = SolutionCacheData::fromBSON(collscan.toBSON(), std::vector<IndexEntry>());
+        ASSERT_OK(parsed.getStatus());
+        delete parsed.getValue();
+    }
+
     /**
      * Each test in the CachePlanSelectionTest suite goes through
      * the following flow:
@@ -656,6 +738,23 @@ namespace {
             return out;
         }
 
+        /**
+         * Like planQueryFromCache(), but first round-trips the cache data through the BSON
+         * form used to persist plan choices, resolving indexes against 'params.indices'.
+         */
+        QuerySolution* planQueryFromPersistedCache(const BSONObj& query,
+                                                   const BSONObj& sort,
+                                                   const BSONObj& proj,
+                                                   const QuerySolution& soln) const {
+            StatusWith<SolutionCacheData*> parsed =
+                SolutionCacheData::fromBSON(soln.cacheData->toBSON(), params.indices);
+            ASSERT_OK(parsed.getStatus());
+
+            QuerySolution restored;
+            restored.cacheData.reset(parsed.getValue());
+            return planQueryFromCache(query, sort, proj, restored);
+        }
+
         /**
          * @param solnJson -- a json representation of a query solution.
          *
@@ -726,6 +825,20 @@ namespace {
             delete planSoln;
         }
 
+        /**
+         * Same as assertPlanCacheRecoversSolution(), but the cache data goes through the
+         * persisted (BSON) form first.
+         */
+        void assertPersistedPlanCacheRecoversSolution(const BSONObj& query,
+                                                      const BSONObj& sort,
+                                                      const BSONObj& proj,
+                                                      const string& solnJson) {
+            QuerySolution* bestSoln = firstMatchingSolution(solnJson);
+            QuerySolution* planSoln = planQueryFromPersistedCache(query, sort, proj, *bestSoln);
+            assertSolutionMatches(planSoln, solnJson);
+            delete planSoln;
+        }
+
         /**
          * Check that the solution will not be cached. The planner will store
          * cache data inside non-cachable solutions, but will not do so for
@@ -898,6 +1011,41 @@ namespace {
                 "[{ixscan: {pattern: {a: 1, c: 1}}}, {ixscan: {pattern: {b: 1, c: 1}}}]}}}}");
     }
 
+    //
+    // Persisted cache data
+    //
+
+    TEST_F(CachePlanSelectionTest, PersistedEqualityIndexScan) {
+        addIndex(BSON("x" << 1));
+        runQuery(BSON("x" << 5));
+
+        assertPersistedPlanCacheRecoversSolution(BSON("x" << 5), BSONObj(), BSONObj(),
+            "{fetch: {filter: null, node: {ixscan: {pattern: {x: 1}}}}}");
+    }
+
+    TEST_F(CachePlanSelectionTest, PersistedAndWithOrWithOneIndex) {
+        addIndex(BSON("b" << 1));
+        addIndex(BSON("a" << 1));
+        BSONObj query = fromjson("{$or: [{b:1}, {c:7}], a:20}");
+        runQuery(query);
+        assertPersistedPlanCacheRecoversSolution(query, BSONObj(), BSONObj(),
+            "{fetch: {filter: {$or: [{b: 1}, {c: 7}]}, "
+                "node: {ixscan: {filter: null, pattern: {a: 1}}}}}");
+    }
+
+    TEST_F(CachePlanSelectionTest, PersistedMergeSort) {
+        addIndex(BSON("a" << 1 << "c" << 1));
+        addIndex(BSON("b" << 1 << "c" << 1));
+
+        BSONObj query = fromjson("{$or: [{a:1}, {b:1}]}");
+        BSONObj sort = BSON("c" << 1);
+        runQuerySortProj(query, sort, BSONObj());
+
+        assertPersistedPlanCacheRecoversSolution(query, sort, BSONObj(),
+            "{fetch: {node: {mergeSort: {nodes: "
+                "[{ixscan: {pattern: {a: 1, c: 1}}}, {ixscan: {pattern: {b: 1, c: 1}}}]}}}}");
+    }
+
     // SERVER-1205 as well.
     TEST_F(CachePlanSelectionTest, NoMergeSortIfNoSortWanted) {
         addIndex(BSON("a" << 1 << "c" << 1));
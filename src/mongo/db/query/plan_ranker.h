@@ -69,7 +69,7 @@ namespace mongo {
      */
     struct CandidatePlan {
         CandidatePlan(QuerySolution* s, PlanStage* r, WorkingSet* w)
-            : solution(s), root(r), ws(w), failed(false) { }
+            : solution(s), root(r), ws(w), failed(false), eliminated(false) { }
 
         QuerySolution* solution;
         PlanStage* root;
@@ -79,6 +79,10 @@ namespace mongo {
         std::list<WorkingSetID> results;
 
         bool failed;
+
+        // True if this plan stopped being worked during the trial period because another
+        // candidate was clearly more productive. An eliminated plan is still ranked.
+        bool eliminated;
     };
 
     /**
@@ -706,6 +706,14 @@ namespace mongo {
                 }
             }
 
+            // The caller may only want covered plans.
+            if ((params.options & QueryPlannerParams::NO_UNCOVERED_PROJECTIONS)
+                && solnRoot->fetched()) {
+                LOG(5) << "PROJECTION: not covered, dropping solution";
+                delete solnRoot;
+                return NULL;
+            }
+
             // We now know we have whatever data is required for the projection.
             ProjectionNode* projNode = new ProjectionNode();
             projNode->children.push_back(solnRoot);
@@ -38,6 +38,14 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxResults, int, 101);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxTimeMS, int, 0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEarlyEliminationEnabled, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEarlyEliminationMinWorks, int, 100);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEarlyEliminationErrorRate, double, 0.01);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
@@ -45,6 +45,20 @@ namespace mongo {
     // Stop working plans once a plan returns this many results.
     extern int internalQueryPlanEvaluationMaxResults;
 
+    // Stop working plans once this many milliseconds have elapsed. Zero means no time limit.
+    extern int internalQueryPlanEvaluationMaxTimeMS;
+
+    // Do we stop working candidate plans whose productivity is statistically dominated by
+    // another candidate before the trial period ends?
+    extern bool internalQueryPlanEarlyEliminationEnabled;
+
+    // The number of times each candidate must be worked before it can be eliminated early.
+    extern int internalQueryPlanEarlyEliminationMinWorks;
+
+    // The probability we tolerate of eliminating a candidate whose true productivity is as good
+    // as the best candidate's.
+    extern double internalQueryPlanEarlyEliminationErrorRate;
+
     // Do we give a big ranking bonus to intersection plans?
     extern bool internalQueryForceIntersectionPlans;
 
@@ -808,7 +808,11 @@ namespace mongo {
             if (0 == out->size()) {
                 QuerySolution* soln = buildWholeIXSoln(params.indices[hintIndexNumber],
                                                        query, params);
-                verify(NULL != soln);
+                if (NULL == soln) {
+                    // The planner options rule out the only solution with the hinted index, for
+                    // instance because it doesn't cover the projection.
+                    return Status::OK();
+                }
                 LOG(5) << "Planner: outputting soln that uses hinted index as scan." << endl;
                 out->push_back(soln);
             }
@@ -86,6 +86,10 @@ namespace mongo {
             // Set this to prevent the planner from generating plans which answer a predicate
             // implicitly via exact index bounds for index intersection solutions.
             CANNOT_TRIM_IXISECT = 1 << 8,
+
+            // Set this if you only want plans which answer the query's projection from index keys,
+            // without fetching documents. Has no effect if the query has no projection.
+            NO_UNCOVERED_PROJECTIONS = 1 << 9,
         };
 
         // See Options enum above.
@@ -1060,6 +1060,46 @@ namespace {
                                 "{ixscan: {filter: null, pattern: {x: 1}}}}}}}");
     }
 
+    TEST_F(QueryPlannerTest, NoUncoveredProjections) {
+        params.options |= QueryPlannerParams::NO_UNCOVERED_PROJECTIONS;
+        addIndex(BSON("x" << 1));
+        runQuerySortProj(fromjson("{ x : {$gt: 1}}"), BSONObj(), fromjson("{_id: 0, x: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {_id: 0, x: 1}, node: {ixscan: "
+                                "{filter: null, pattern: {x: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, NoUncoveredProjectionsWithSort) {
+        params.options |= QueryPlannerParams::NO_UNCOVERED_PROJECTIONS |
+                          QueryPlannerParams::NO_BLOCKING_SORT;
+        addIndex(BSON("x" << 1 << "y" << 1));
+        runQuerySortProj(fromjson("{ x : {$gt: 1}}"), BSON("x" << -1),
+                         fromjson("{_id: 0, x: 1, y: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {_id: 0, x: 1, y: 1}, node: {ixscan: "
+                                "{filter: null, dir: -1, pattern: {x: 1, y: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, NoUncoveredProjectionsNotCovered) {
+        params.options |= QueryPlannerParams::NO_UNCOVERED_PROJECTIONS;
+        addIndex(BSON("x" << 1));
+
+        // _id isn't in the index.
+        runQuerySortProj(fromjson("{ x : {$gt: 1}}"), BSONObj(), fromjson("{x: 1}"));
+        assertNumSolutions(0U);
+
+        // The filter on y needs the document.
+        runQuerySortProj(fromjson("{ x : {$gt: 1}, y: 2}"), BSONObj(),
+                         fromjson("{_id: 0, x: 1}"));
+        assertNumSolutions(0U);
+
+        // As does an exclusion.
+        runQuerySortProj(fromjson("{ x : {$gt: 1}}"), BSONObj(), fromjson("{y: 0}"));
+        assertNumSolutions(0U);
+    }
+
     //
     // Basic sort
     //
@@ -855,10 +855,20 @@ namespace mongo {
         *ss << "COUNT\n";
         addIndent(ss, indent + 1);
         *ss << "keyPattern = " << indexKeyPattern << '\n';
-        addIndent(ss, indent + 1);
-        *ss << "startKey = " << startKey << '\n';
-        addIndent(ss, indent + 1);
-        *ss << "endKey = " << endKey << '\n';
+        if (NULL != filter) {
+            addIndent(ss, indent + 1);
+            *ss << "filter = " << filter->toString();
+        }
+        if (bounds.size() > 0) {
+            addIndent(ss, indent + 1);
+            *ss << "bounds = " << bounds.toString() << '\n';
+        }
+        else {
+            addIndent(ss, indent + 1);
+            *ss << "startKey = " << startKey << '\n';
+            addIndent(ss, indent + 1);
+            *ss << "endKey = " << endKey << '\n';
+        }
     }
 
     QuerySolutionNode* CountNode::clone() const {
@@ -871,6 +881,7 @@ namespace mongo {
         copy->startKeyInclusive = this->startKeyInclusive;
         copy->endKey = this->endKey;
         copy->endKeyInclusive = this->endKeyInclusive;
+        copy->bounds = this->bounds;
 
         return copy;
     }
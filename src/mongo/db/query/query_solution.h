@@ -727,6 +727,9 @@ namespace mongo {
 
         BSONObj endKey;
         bool endKeyInclusive;
+
+        // Set instead of the start and end keys when the scan covers several intervals.
+        IndexBounds bounds;
     };
 
 }  // namespace mongo
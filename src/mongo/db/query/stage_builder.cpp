@@ -57,6 +57,94 @@ namespace mongo {
 
     using std::auto_ptr;
 
+    namespace {
+
+        /**
+         * Computes a closed range [*minKey, *maxKey] of keys of the shard key pattern
+         * 'shardKeyPattern' that holds the shard key of every document produced by the solution
+         * rooted at 'node'.  Returns false if the solution doesn't bound the shard key through
+         * index scans over ascending indexes that have the shard key as their prefix, or if the
+         * range could include documents missing a shard key field.
+         */
+        bool getShardKeyRange(const QuerySolutionNode* node,
+                              const BSONObj& shardKeyPattern,
+                              BSONObj* minKey,
+                              BSONObj* maxKey) {
+            if (STAGE_FETCH == node->getType()) {
+                return getShardKeyRange(node->children[0], shardKeyPattern, minKey, maxKey);
+            }
+
+            if (STAGE_OR == node->getType() || STAGE_SORT_MERGE == node->getType()) {
+                if (node->children.empty()) { return false; }
+
+                // The union of the ranges of all the children.
+                for (size_t i = 0; i < node->children.size(); ++i) {
+                    BSONObj childMin;
+                    BSONObj childMax;
+                    if (!getShardKeyRange(node->children[i], shardKeyPattern,
+                                          &childMin, &childMax)) {
+                        return false;
+                    }
+                    if (0 == i || childMin.woCompare(*minKey) < 0) { *minKey = childMin; }
+                    if (0 == i || childMax.woCompare(*maxKey) > 0) { *maxKey = childMax; }
+                }
+                return true;
+            }
+
+            if (STAGE_IXSCAN != node->getType()) { return false; }
+
+            const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+            if (isn->bounds.isSimpleRange) { return false; }
+
+            BSONObjBuilder minBuilder;
+            BSONObjBuilder maxBuilder;
+            BSONObjIterator keyPatternIt(isn->indexKeyPattern);
+            size_t fieldNo = 0;
+
+            for (BSONObjIterator it(shardKeyPattern); it.more(); ++fieldNo) {
+                const BSONElement shardKeyElt = it.next();
+                if (!keyPatternIt.more() || fieldNo >= isn->bounds.fields.size()) {
+                    return false;
+                }
+
+                // Only ascending fields, so that index key values are shard key values.
+                const BSONElement keyPatternElt = keyPatternIt.next();
+                if (shardKeyElt.fieldNameStringData() != keyPatternElt.fieldNameStringData()
+                    || !shardKeyElt.isNumber() || shardKeyElt.numberInt() != 1
+                    || !keyPatternElt.isNumber() || keyPatternElt.numberInt() != 1) {
+                    return false;
+                }
+
+                // The intervals are ordered in the direction of the scan, so look at both of
+                // their ends.
+                const std::vector<Interval>& intervals = isn->bounds.fields[fieldNo].intervals;
+                if (intervals.empty()) { return false; }
+
+                BSONElement low = intervals[0].start;
+                BSONElement high = intervals[0].start;
+                for (size_t i = 0; i < intervals.size(); ++i) {
+                    const BSONElement ends[] = { intervals[i].start, intervals[i].end };
+                    for (size_t j = 0; j < 2; ++j) {
+                        if (ends[j].woCompare(low, false) < 0) { low = ends[j]; }
+                        if (ends[j].woCompare(high, false) > 0) { high = ends[j]; }
+                    }
+                }
+
+                // A document missing a shard key field has a null index key, but no shard key
+                // at all, so only ranges above null say anything about the documents' keys.
+                if (low.canonicalType() <= canonicalizeBSONType(jstNULL)) { return false; }
+
+                minBuilder.appendAs(low, shardKeyElt.fieldName());
+                maxBuilder.appendAs(high, shardKeyElt.fieldName());
+            }
+
+            *minKey = minBuilder.obj();
+            *maxKey = maxBuilder.obj();
+            return true;
+        }
+
+    }  // namespace
+
     PlanStage* buildStages(OperationContext* txn,
                            Collection* collection,
                            const QuerySolution& qsol,
@@ -279,8 +367,17 @@ namespace mongo {
             const ShardingFilterNode* fn = static_cast<const ShardingFilterNode*>(root);
             PlanStage* childStage = buildStages(txn, collection, qsol, fn->children[0], ws);
             if (NULL == childStage) { return NULL; }
-            return new ShardFilterStage(shardingState.getCollectionMetadata(collection->ns()),
-                                        ws, childStage);
+            CollectionMetadataPtr metadata = shardingState.getCollectionMetadata(collection->ns());
+            ShardFilterStage* filterStage = new ShardFilterStage(metadata, ws, childStage);
+
+            // Documents from a scan of owned shard key ranges need no checking.
+            BSONObj minKey;
+            BSONObj maxKey;
+            if (metadata && getShardKeyRange(fn->children[0], metadata->getKeyPattern(),
+                                             &minKey, &maxKey)) {
+                filterStage->setChildShardKeyRange(minKey, maxKey);
+            }
+            return filterStage;
         }
         else if (STAGE_KEEP_MUTATIONS == root->getType()) {
             const KeepMutationsNode* km = static_cast<const KeepMutationsNode*>(root);
@@ -321,8 +418,9 @@ namespace mongo {
             params.startKeyInclusive = cn->startKeyInclusive;
             params.endKey = cn->endKey;
             params.endKeyInclusive = cn->endKeyInclusive;
+            params.bounds = cn->bounds;
 
-            return new CountScan(txn, params, ws);
+            return new CountScan(txn, params, ws, cn->filter.get());
         }
         else {
             mongoutils::str::stream ss;
@@ -72,6 +72,10 @@ namespace mongo {
         STAGE_GROUP,
 
         STAGE_IDHACK,
+
+        // Looks up the documents for a list of _id values.
+        STAGE_ID_MULTI_GET,
+
         STAGE_IXSCAN,
         STAGE_LIMIT,
 
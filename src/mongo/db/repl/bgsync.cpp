@@ -45,6 +45,8 @@
 #include "mongo/db/repl/replication_coordinator_impl.h"
 #include "mongo/db/repl/rs_rollback.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/histogram_stats.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
@@ -64,6 +66,10 @@ namespace {
 
     MONGO_FP_DECLARE(rsBgSyncProduce);
 
+    // Whether to tail the sync source's oplog with an exhaust cursor, so that batches are
+    // pushed by the sync source instead of being requested with a getMore each.
+    MONGO_EXPORT_SERVER_PARAMETER(replExhaustOplogFetching, bool, true);
+
     BackgroundSync* BackgroundSync::s_instance = 0;
     boost::mutex BackgroundSync::s_mutex;
 
@@ -72,6 +78,19 @@ namespace {
     static ServerStatusMetricField<TimerStats> displayBatchesRecieved(
                                                     "repl.network.getmores",
                                                     &getmoreReplStats );
+    //The time spent waiting for each batch, the number of oplog entries and bytes per batch
+    static HistogramStats fetchLatencyStats;
+    static ServerStatusMetricField<HistogramStats> displayFetchLatency(
+                                                    "repl.network.fetchLatencyMillis",
+                                                    &fetchLatencyStats );
+    static HistogramStats batchOpsStats;
+    static ServerStatusMetricField<HistogramStats> displayBatchOps(
+                                                    "repl.network.batchSizeOps",
+                                                    &batchOpsStats );
+    static HistogramStats batchBytesStats;
+    static ServerStatusMetricField<HistogramStats> displayBatchBytes(
+                                                    "repl.network.batchSizeBytes",
+                                                    &batchBytesStats );
     //The oplog entries read via the oplog reader
     static Counter64 opsReadStats;
     static ServerStatusMetricField<Counter64> displayOpsRead( "repl.network.ops",
@@ -250,7 +269,8 @@ namespace {
             _replCoord->signalUpstreamUpdater();
         }
 
-        _syncSourceReader.tailingQueryGTE(rsOplogName.c_str(), lastOpTimeFetched);
+        const bool exhaust = replExhaustOplogFetching;
+        _syncSourceReader.tailingQueryGTE(rsOplogName.c_str(), lastOpTimeFetched, exhaust);
 
         // if target cut connections between connecting and querying (for
         // example, because it stepped down) we might not have a cursor
@@ -270,7 +290,7 @@ namespace {
                 // current cursor batch)
 
                 int bs = _syncSourceReader.currentBatchMessageSize();
-                if( bs > 0 && bs < BatchIsSmallish ) {
+                if( !exhaust && bs > 0 && bs < BatchIsSmallish ) {
                     // on a very low latency network, if we don't wait a little, we'll be 
                     // getting ops to write almost one at a time.  this will both be expensive
                     // for the upstream server as well as potentially defeating our parallel 
@@ -279,6 +299,9 @@ namespace {
                     // the inference here is basically if the batch is really small, we are 
                     // "caught up".
                     //
+                    // with an exhaust cursor the upstream server never waits for a getmore,
+                    // so there is nothing to save by waiting.
+                    //
                     sleepmillis(SleepToAllowBatchingMillis);
                 }
 
@@ -300,7 +323,9 @@ namespace {
                     
                     // This calls receiveMore() on the oplogreader cursor.
                     // It can wait up to five seconds for more data.
+                    // With an exhaust cursor it only waits for the next pushed batch.
                     _syncSourceReader.more();
+                    fetchLatencyStats.record(batchTimer.recordMillis());
                 }
                 networkByteStats.increment(_syncSourceReader.currentBatchMessageSize());
 
@@ -333,9 +358,14 @@ namespace {
             }
 
             // At this point, we are guaranteed to have at least one thing to read out
-            // of the oplogreader cursor.
-            BSONObj o = _syncSourceReader.nextSafe().getOwned();
-            opsReadStats.increment();
+            // of the oplogreader cursor. Buffer the rest of the batch as a whole; its ops share
+            // one copy of the received message.
+            const int batchBytes = _syncSourceReader.currentBatchMessageSize();
+            std::vector<BSONObj> ops;
+            _syncSourceReader.nextBatch(&ops);
+            opsReadStats.increment(ops.size());
+            batchOpsStats.record(ops.size());
+            batchBytesStats.record(batchBytes);
 
             {
                 boost::unique_lock<boost::mutex> lock(_mutex);
@@ -346,14 +376,19 @@ namespace {
                 LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes";
             }
 
-            bufferCountGauge.increment();
-            bufferSizeGauge.increment(getSize(o));
-            _buffer.push(o);
+            size_t opsSize = 0;
+            for (std::vector<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+                opsSize += getSize(*it);
+            }
+            bufferCountGauge.increment(ops.size());
+            bufferSizeGauge.increment(opsSize);
+            _buffer.pushAll(ops);
 
             {
                 boost::unique_lock<boost::mutex> lock(_mutex);
-                _lastFetchedHash = o["h"].numberLong();
-                _lastOpTimeFetched = o["ts"].timestamp();
+                const BSONObj& lastOp = ops.back();
+                _lastFetchedHash = lastOp["h"].numberLong();
+                _lastOpTimeFetched = lastOp["ts"].timestamp();
                 LOG(3) << "lastOpTimeFetched: " << _lastOpTimeFetched.toStringPretty();
             }
         }
@@ -394,6 +429,14 @@ namespace {
         string hn = r.conn()->getServerAddress();
 
         if (!r.more()) {
+            // An exhaust cursor keeps the connection busy, so drop it before querying.
+            r.resetCursor();
+            if (!r.conn()) {
+                error() << "lost connection to " << hn;
+                sleepsecs(2);
+                return true;
+            }
+
             try {
                 BSONObj theirLastOp = r.getLastOp(rsOplogName.c_str());
                 if (theirLastOp.isEmpty()) {
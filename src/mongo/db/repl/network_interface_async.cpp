@@ -0,0 +1,972 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kReplication
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/network_interface_async.h"
+
+#include <algorithm>
+#include <boost/make_shared.hpp>
+#include <limits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/auth/authorization_manager_global.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/auth/internal_user_auth.h"
+#include "mongo/db/client.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/rpc/legacy_reply.h"
+#include "mongo/rpc/legacy_request_builder.h"
+#include "mongo/rpc/metadata.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/message_compressor.h"
+#include "mongo/util/net/sock.h"
+#include "mongo/util/net/socket_poll.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace repl {
+
+namespace {
+
+    const size_t kNumHelperThreads = 4;
+
+    // Connections are retired after this long, as in ConnectionPool.
+    const Seconds kMaxConnectionAge(30);
+
+    // Limit on establishing and authenticating a connection, independent of the timeout of the
+    // command waiting for it, so that a host that does not answer holds a helper thread for no
+    // longer than this.
+    const Seconds kConnectTimeout(5);
+
+#ifdef _WIN32
+    // There is no pipe to interrupt the poll on Windows, so new work is picked up by polling at
+    // least this often.
+    const int kMaxPollIntervalMillis = 10;
+#endif
+
+    const size_t kHeaderSize = sizeof(MSGHEADER::Value);
+
+    int getLastSocketError() {
+#ifdef _WIN32
+        return WSAGetLastError();
+#else
+        return errno;
+#endif
+    }
+
+    bool isWouldBlock(int error) {
+#ifdef _WIN32
+        return error == WSAEWOULDBLOCK;
+#else
+        return error == EAGAIN || error == EWOULDBLOCK;
+#endif
+    }
+
+    bool isInterrupted(int error) {
+#ifdef _WIN32
+        return error == WSAEINTR;
+#else
+        return error == EINTR;
+#endif
+    }
+
+    Status setNonBlocking(int sock) {
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        if (ioctlsocket(sock, FIONBIO, &nonBlocking) != 0) {
+#else
+        const int flags = fcntl(sock, F_GETFL);
+        if (flags == -1 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) == -1) {
+#endif
+            return Status(ErrorCodes::InternalError,
+                          str::stream() << "could not make socket non-blocking: "
+                                        << errnoWithDescription(getLastSocketError()));
+        }
+        return Status::OK();
+    }
+
+    bool isExpired(const RemoteCommandRequest& request, Date_t now) {
+        return request.expirationDate != RemoteCommandRequest::kNoExpirationDate &&
+            request.expirationDate <= now;
+    }
+
+    Status makeNetworkError(const RemoteCommandRequest& request, const std::string& reason) {
+        return Status(ErrorCodes::HostUnreachable,
+                      str::stream() << "network error while attempting to run command '"
+                                    << request.cmdObj.firstElementFieldName() << "' on host '"
+                                    << request.target.toString() << "': " << reason);
+    }
+
+    Status makeTimeoutError(const RemoteCommandRequest& request) {
+        return Status(ErrorCodes::ExceededTimeLimit,
+                      str::stream() << "Operation timed out, request was "
+                                    << request.toString());
+    }
+
+    const Status kCanceledStatus(ErrorCodes::CallbackCanceled, "Callback canceled");
+
+    /**
+     * Makes connections the way ConnectionPool does, with a DBClientConnection that has been
+     * authenticated as the internal user if authentication is enabled.
+     */
+    class DBClientConnectionFactory : public NetworkInterfaceAsync::ConnectionFactory {
+    public:
+        class ClientConnection : public NetworkInterfaceAsync::Connection {
+        public:
+            explicit ClientConnection(DBClientConnection* conn) : _conn(conn) {}
+
+            int getSocket() const override {
+                return _conn->port().psock->rawFD();
+            }
+
+        private:
+            const std::unique_ptr<DBClientConnection> _conn;
+        };
+
+        StatusWith<NetworkInterfaceAsync::Connection*> connect(const HostAndPort& target,
+                                                               Milliseconds timeout) override {
+            try {
+                std::unique_ptr<DBClientConnection> conn(new DBClientConnection);
+
+                // setSoTimeout takes a double representing the number of seconds for send and
+                // receive timeouts.
+                conn->setSoTimeout(timeout.count() / 1000.0);
+                std::string errmsg;
+                if (!conn->connect(target, errmsg)) {
+                    return {ErrorCodes::HostUnreachable,
+                            str::stream() << "Failed attempt to connect to "
+                                          << target.toString() << "; " << errmsg};
+                }
+
+                conn->port().tag |=
+                    ReplicationExecutor::NetworkInterface::kMessagingPortKeepOpen;
+
+                if (getGlobalAuthorizationManager()->isAuthEnabled()) {
+                    if (!isInternalAuthSet()) {
+                        return {ErrorCodes::AuthenticationFailed,
+                                "Missing credentials for authenticating as internal user"};
+                    }
+                    conn->auth(getInternalUserAuthParamsWithFallback());
+                }
+                return StatusWith<NetworkInterfaceAsync::Connection*>(
+                        new ClientConnection(conn.release()));
+            }
+            catch (const DBException& ex) {
+                return ex.toStatus();
+            }
+        }
+    };
+
+}  // namespace
+
+    NetworkInterfaceAsync::NetworkInterfaceAsync()
+        : NetworkInterfaceAsync(new DBClientConnectionFactory) {
+
+    }
+
+    NetworkInterfaceAsync::NetworkInterfaceAsync(ConnectionFactory* connectionFactory)
+        : _connectionFactory(connectionFactory),
+          _wakeupPending(false),
+          _isExecutorRunnable(false),
+          _inShutdown(false),
+          _fallbackExec(kMessagingPortKeepOpen) {
+
+        _wakeupPipe[0] = -1;
+        _wakeupPipe[1] = -1;
+    }
+
+    NetworkInterfaceAsync::~NetworkInterfaceAsync() { }
+
+    std::string NetworkInterfaceAsync::getDiagnosticString() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        str::stream output;
+        output << "NetworkAsync";
+        output << " inShutdown:" << _inShutdown;
+        output << " waiting:" << _waiting.size();
+        output << " running:" << _running.size();
+        output << " fallback:" << _fallback.size();
+        output << " idleConnections:" << _idleConnections.size();
+        size_t connecting = 0;
+        for (HostConnectsMap::const_iterator it = _hostConnects.begin();
+             it != _hostConnects.end();
+             ++it) {
+            connecting += it->second.queued + it->second.inProgress;
+        }
+        output << " connecting:" << connecting;
+        output << " execRunable:" << _isExecutorRunnable;
+        return output;
+    }
+
+    void NetworkInterfaceAsync::startup() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        invariant(!_inShutdown);
+        if (_networkThread) {
+            return;
+        }
+
+#ifndef _WIN32
+        if (pipe(_wakeupPipe) != 0 ||
+                !setNonBlocking(_wakeupPipe[0]).isOK() ||
+                !setNonBlocking(_wakeupPipe[1]).isOK()) {
+            severe() << "Could not create the replication network wakeup pipe: " <<
+                errnoWithDescription();
+            fassertFailedNoTrace(28664);
+        }
+#endif
+
+        _networkThread = boost::make_shared<boost::thread>(
+                stdx::bind(&NetworkInterfaceAsync::_runNetworkThread, this));
+        for (size_t i = 0; i < kNumHelperThreads; ++i) {
+            const std::string threadName(str::stream() << "ReplExecNetHelper-" << i);
+            _helperThreads.push_back(
+                    boost::make_shared<boost::thread>(
+                            stdx::bind(&NetworkInterfaceAsync::_runHelperThread,
+                                       this,
+                                       threadName)));
+        }
+    }
+
+    void NetworkInterfaceAsync::shutdown() {
+        using std::swap;
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        _inShutdown = true;
+        _wakeNetworkThread_inlock();
+        _helperWorkCondition.notify_all();
+        boost::shared_ptr<boost::thread> networkThread;
+        swap(networkThread, _networkThread);
+        std::vector<boost::shared_ptr<boost::thread> > helperThreads;
+        swap(helperThreads, _helperThreads);
+        lk.unlock();
+
+        _fallbackExec.shutdown();
+        if (networkThread) {
+            networkThread->join();
+        }
+        std::for_each(helperThreads.begin(),
+                      helperThreads.end(),
+                      stdx::bind(&boost::thread::join, stdx::placeholders::_1));
+
+        // Only this thread is left, finish whatever is still outstanding.
+        const ResponseStatus shutdownStatus(ErrorCodes::ShutdownInProgress,
+                                            "Shutting down the replication network interface");
+        CompletionList completions;
+        lk.lock();
+        CommandList* const lists[] = {&_waiting, &_running, &_fallback};
+        for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); ++i) {
+            for (CommandList::iterator cmd = lists[i]->begin(); cmd != lists[i]->end(); ++cmd) {
+                completions.push_back(Completion(cmd->onFinish, shutdownStatus));
+            }
+            lists[i]->clear();
+        }
+        _fallbackQueue.clear();
+        _idleConnections.clear();
+        _hostConnects.clear();
+        for (stdx::list<ConnectResult>::iterator result = _connectResults.begin();
+             result != _connectResults.end();
+             ++result) {
+            if (result->conn.isOK()) {
+                delete result->conn.getValue();
+            }
+        }
+        _connectResults.clear();
+#ifndef _WIN32
+        for (size_t i = 0; i < 2; ++i) {
+            if (_wakeupPipe[i] != -1) {
+                close(_wakeupPipe[i]);
+                _wakeupPipe[i] = -1;
+            }
+        }
+#endif
+        lk.unlock();
+        _runCompletions(&completions);
+    }
+
+    void NetworkInterfaceAsync::signalWorkAvailable() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _signalWorkAvailable_inlock();
+    }
+
+    void NetworkInterfaceAsync::_signalWorkAvailable_inlock() {
+        if (!_isExecutorRunnable) {
+            _isExecutorRunnable = true;
+            _isExecutorRunnableCondition.notify_one();
+        }
+    }
+
+    void NetworkInterfaceAsync::waitForWork() {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (!_isExecutorRunnable) {
+            _isExecutorRunnableCondition.wait(lk);
+        }
+        _isExecutorRunnable = false;
+    }
+
+    void NetworkInterfaceAsync::waitForWorkUntil(Date_t when) {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (!_isExecutorRunnable) {
+            const Milliseconds waitTime(when - now());
+            if (waitTime <= Milliseconds(0)) {
+                break;
+            }
+            _isExecutorRunnableCondition.wait_for(lk, waitTime);
+        }
+        _isExecutorRunnable = false;
+    }
+
+    void NetworkInterfaceAsync::startCommand(
+            const ReplicationExecutor::CallbackHandle& cbHandle,
+            const RemoteCommandRequest& request,
+            const RemoteCommandCompletionFn& onFinish) {
+        LOG(2) << "Scheduling " << request.cmdObj.firstElementFieldName() << " to " <<
+            request.target;
+        const Date_t startDate = now();
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _waiting.emplace_back();
+        CommandState& cmd = _waiting.back();
+        cmd.cbHandle = cbHandle;
+        cmd.request = request;
+        cmd.onFinish = onFinish;
+        cmd.startDate = startDate;
+        _wakeNetworkThread_inlock();
+    }
+
+    void NetworkInterfaceAsync::cancelCommand(
+            const ReplicationExecutor::CallbackHandle& cbHandle) {
+        // The command is finished by the network thread, or by the helper thread running it.
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        CommandList* const lists[] = {&_waiting, &_running, &_fallback};
+        for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); ++i) {
+            for (CommandList::iterator cmd = lists[i]->begin(); cmd != lists[i]->end(); ++cmd) {
+                if (cmd->cbHandle == cbHandle) {
+                    LOG(2) << "Canceled sending " << cmd->request.cmdObj.firstElementFieldName() <<
+                        " to " << cmd->request.target;
+                    cmd->canceled = true;
+                    _wakeNetworkThread_inlock();
+                    return;
+                }
+            }
+        }
+    }
+
+    Date_t NetworkInterfaceAsync::now() {
+        return Date_t::now();
+    }
+
+    OperationContext* NetworkInterfaceAsync::createOperationContext() {
+        if (!ClientBasic::getCurrent()) {
+            Client::initThreadIfNotAlready();
+            AuthorizationSession::get(*ClientBasic::getCurrent())->grantInternalAuthorization();
+        }
+        return new OperationContextImpl();
+    }
+
+    void NetworkInterfaceAsync::_wakeNetworkThread_inlock() {
+#ifndef _WIN32
+        if (_wakeupPending || _wakeupPipe[1] == -1) {
+            return;
+        }
+        const char byte = 0;
+        if (write(_wakeupPipe[1], &byte, 1) == 1) {
+            _wakeupPending = true;
+        }
+#endif
+    }
+
+    void NetworkInterfaceAsync::_runCompletions(CompletionList* completions) {
+        for (CompletionList::iterator it = completions->begin(); it != completions->end(); ++it) {
+            it->onFinish(it->response);
+        }
+        completions->clear();
+        signalWorkAvailable();
+    }
+
+    void NetworkInterfaceAsync::_runNetworkThread() {
+        setThreadName("ReplExecNetThread");
+        LOG(1) << "thread starting";
+
+        std::vector<pollfd> pollFds;
+        std::vector<CommandList::iterator> polledCommands;
+        std::vector<ConnectionList::iterator> polledConnections;
+        CompletionList completions;
+
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (!_inShutdown) {
+            Date_t nowDate = now();
+            _processConnectResults_inlock(nowDate, &completions);
+            _processWaitingCommands_inlock(nowDate, &completions);
+            _processRunningCommands_inlock(nowDate, &completions);
+            _retireIdleConnections_inlock(nowDate);
+            if (!completions.empty()) {
+                lk.unlock();
+                _runCompletions(&completions);
+                lk.lock();
+                continue;
+            }
+
+            pollFds.clear();
+            polledCommands.clear();
+            polledConnections.clear();
+#ifndef _WIN32
+            pollfd wakeup = {_wakeupPipe[0], POLLIN, 0};
+            pollFds.push_back(wakeup);
+#endif
+            for (CommandList::iterator cmd = _running.begin(); cmd != _running.end(); ++cmd) {
+                const bool sending = cmd->bytesSent < static_cast<size_t>(cmd->toSend->size());
+                pollfd pfd = {cmd->conn->conn->getSocket(),
+                              static_cast<short>(sending ? POLLOUT : POLLIN),
+                              0};
+                pollFds.push_back(pfd);
+                polledCommands.push_back(cmd);
+            }
+            for (ConnectionList::iterator conn = _idleConnections.begin();
+                 conn != _idleConnections.end();
+                 ++conn) {
+                // An idle connection only becomes readable when the remote node closes it.
+                pollfd pfd = {(*conn)->conn->getSocket(), POLLIN, 0};
+                pollFds.push_back(pfd);
+                polledConnections.push_back(conn);
+            }
+
+            int timeoutMillis = -1;
+            const Date_t wakeupDate = _nextWakeupDate_inlock();
+            if (wakeupDate != Date_t::max()) {
+                const long long millis = std::max<long long>(0, (wakeupDate - nowDate).count());
+                timeoutMillis = static_cast<int>(
+                        std::min<long long>(millis, std::numeric_limits<int>::max()));
+            }
+#ifdef _WIN32
+            if (timeoutMillis < 0 || timeoutMillis > kMaxPollIntervalMillis) {
+                timeoutMillis = kMaxPollIntervalMillis;
+            }
+#endif
+
+            lk.unlock();
+            int numReady = 0;
+            if (pollFds.empty()) {
+                sleepmillis(timeoutMillis);
+            }
+            else {
+                numReady = socketPoll(&pollFds[0], pollFds.size(), timeoutMillis);
+                if (numReady < 0) {
+                    const int error = getLastSocketError();
+                    if (!isInterrupted(error)) {
+                        // Should not happen, avoid spinning if it does.
+                        warning() << "poll() failed in the replication network thread: " <<
+                            errnoWithDescription(error);
+                        sleepmillis(10);
+                    }
+                }
+            }
+            lk.lock();
+            if (numReady <= 0) {
+                continue;
+            }
+
+            nowDate = now();
+            size_t next = 0;
+#ifndef _WIN32
+            if (pollFds[next++].revents) {
+                char buf[64];
+                while (read(_wakeupPipe[0], buf, sizeof(buf)) > 0) {
+                }
+                _wakeupPending = false;
+            }
+#endif
+            for (size_t i = 0; i < polledCommands.size(); ++i, ++next) {
+                if (!pollFds[next].revents) {
+                    continue;
+                }
+                const CommandList::iterator cmd = polledCommands[i];
+                if (cmd->bytesSent < static_cast<size_t>(cmd->toSend->size())) {
+                    _doSend_inlock(cmd, nowDate, &completions);
+                }
+                else {
+                    _doReceive_inlock(cmd, nowDate, &completions);
+                }
+            }
+            for (size_t i = 0; i < polledConnections.size(); ++i, ++next) {
+                if (pollFds[next].revents) {
+                    LOG(2) << "Closing idle connection to " << (*polledConnections[i])->target;
+                    _idleConnections.erase(polledConnections[i]);
+                }
+            }
+        }
+        LOG(1) << "thread shutting down";
+    }
+
+    void NetworkInterfaceAsync::_runHelperThread(const std::string& threadName) {
+        setThreadName(threadName);
+        LOG(1) << "thread starting";
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (!_inShutdown) {
+            if (!_fallbackQueue.empty()) {
+                const CommandList::iterator cmd = _fallbackQueue.front();
+                _fallbackQueue.pop_front();
+                const RemoteCommandRequest request = cmd->request;
+                lk.unlock();
+                const ResponseStatus result = _fallbackExec.runCommand(request);
+                LOG(2) << "Network status of sending " << request.cmdObj.firstElementFieldName() <<
+                    " to " << request.target << " was " << result.getStatus();
+                lk.lock();
+                CompletionList completions;
+                completions.push_back(
+                        Completion(cmd->onFinish,
+                                   cmd->canceled ? ResponseStatus(kCanceledStatus) : result));
+                _fallback.erase(cmd);
+                lk.unlock();
+                _runCompletions(&completions);
+                lk.lock();
+                continue;
+            }
+            const HostConnectsMap::iterator host = _nextHostToConnect_inlock();
+            if (host != _hostConnects.end()) {
+                const HostAndPort target = host->first;
+                --host->second.queued;
+                ++host->second.inProgress;
+                lk.unlock();
+                LOG(2) << "Connecting to " << target;
+                const StatusWith<Connection*> conn =
+                    _connectionFactory->connect(target, kConnectTimeout);
+                lk.lock();
+                _connectResults.push_back(ConnectResult(target, conn));
+                _wakeNetworkThread_inlock();
+                continue;
+            }
+            _helperWorkCondition.wait(lk);
+        }
+        LOG(1) << "thread shutting down";
+    }
+
+    void NetworkInterfaceAsync::_processConnectResults_inlock(Date_t now,
+                                                             CompletionList* completions) {
+        while (!_connectResults.empty()) {
+            const HostAndPort target = _connectResults.front().target;
+            StatusWith<Connection*> result = _connectResults.front().conn;
+            _connectResults.pop_front();
+
+            AsyncConnectionPtr conn;
+            Status status = result.getStatus();
+            if (status.isOK()) {
+                conn.reset(new AsyncConnection(target, result.getValue(), now));
+                status = setNonBlocking(conn->conn->getSocket());
+            }
+
+            const HostConnectsMap::iterator host = _hostConnects.find(target);
+            invariant(host != _hostConnects.end());
+            --host->second.inProgress;
+            host->second.reachable = status.isOK();
+
+            if (!status.isOK()) {
+                // Fail the commands waiting for this host, and the attempts queued for them,
+                // rather than have them wait for attempts that will likely fail in the same way.
+                LOG(1) << "Failed to connect to " << target << ": " << status;
+                host->second.queued = 0;
+                if (host->second.inProgress == 0) {
+                    _hostConnects.erase(host);
+                }
+                for (CommandList::iterator cmd = _waiting.begin(); cmd != _waiting.end();) {
+                    if (cmd->request.target != target) {
+                        ++cmd;
+                        continue;
+                    }
+                    completions->push_back(
+                            Completion(cmd->onFinish,
+                                       cmd->canceled ? kCanceledStatus : status));
+                    cmd = _waiting.erase(cmd);
+                }
+                continue;
+            }
+
+            CommandList::iterator cmd = _waiting.begin();
+            while (cmd != _waiting.end() &&
+                   (cmd->request.target != target || cmd->canceled ||
+                    isExpired(cmd->request, now))) {
+                ++cmd;
+            }
+            if (cmd == _waiting.end()) {
+                _idleConnections.push_back(std::move(conn));
+            }
+            else {
+                _startOnConnection_inlock(cmd, std::move(conn), now, completions);
+            }
+        }
+    }
+
+    void NetworkInterfaceAsync::_processWaitingCommands_inlock(Date_t now,
+                                                              CompletionList* completions) {
+        std::map<HostAndPort, size_t> connectsNeeded;
+        for (CommandList::iterator cmd = _waiting.begin(); cmd != _waiting.end();) {
+            const CommandList::iterator current = cmd++;
+            if (current->canceled) {
+                completions->push_back(Completion(current->onFinish, kCanceledStatus));
+                _waiting.erase(current);
+                continue;
+            }
+            if (isExpired(current->request, now)) {
+                completions->push_back(
+                        Completion(current->onFinish, makeTimeoutError(current->request)));
+                _waiting.erase(current);
+                continue;
+            }
+
+            ConnectionList::iterator idle = _idleConnections.begin();
+            while (idle != _idleConnections.end() &&
+                   (*idle)->target != current->request.target) {
+                ++idle;
+            }
+            if (idle != _idleConnections.end()) {
+                AsyncConnectionPtr conn = std::move(*idle);
+                _idleConnections.erase(idle);
+                _startOnConnection_inlock(current, std::move(conn), now, completions);
+                continue;
+            }
+
+            ++connectsNeeded[current->request.target];
+        }
+
+        // Ask for as many connections as there are commands waiting, but never tie up all of the
+        // helper threads on one host, nor more than one on a host that is not known to be
+        // reachable.
+        for (std::map<HostAndPort, size_t>::const_iterator it = connectsNeeded.begin();
+             it != connectsNeeded.end();
+             ++it) {
+            HostConnects& connects = _hostConnects[it->first];
+            const size_t wanted =
+                std::min(it->second, connects.reachable ? kNumHelperThreads - 1 : 1);
+            if (connects.queued == 0) {
+                connects.queuedDate = now;
+            }
+            for (; connects.queued + connects.inProgress < wanted; ++connects.queued) {
+                _helperWorkCondition.notify_one();
+            }
+        }
+    }
+
+    NetworkInterfaceAsync::HostConnectsMap::iterator
+    NetworkInterfaceAsync::_nextHostToConnect_inlock() {
+        HostConnectsMap::iterator next = _hostConnects.end();
+        for (HostConnectsMap::iterator it = _hostConnects.begin();
+             it != _hostConnects.end();
+             ++it) {
+            if (it->second.queued == 0) {
+                continue;
+            }
+            if (next == _hostConnects.end() ||
+                    it->second.inProgress < next->second.inProgress ||
+                    (it->second.inProgress == next->second.inProgress &&
+                     it->second.queuedDate < next->second.queuedDate)) {
+                next = it;
+            }
+        }
+        return next;
+    }
+
+    void NetworkInterfaceAsync::_processRunningCommands_inlock(Date_t now,
+                                                              CompletionList* completions) {
+        for (CommandList::iterator cmd = _running.begin(); cmd != _running.end();) {
+            const CommandList::iterator current = cmd++;
+            if (current->canceled) {
+                _finishRunning_inlock(current, kCanceledStatus, false, now, completions);
+            }
+            else if (isExpired(current->request, now)) {
+                _finishRunning_inlock(current,
+                                      makeTimeoutError(current->request),
+                                      false,
+                                      now,
+                                      completions);
+            }
+        }
+    }
+
+    void NetworkInterfaceAsync::_retireIdleConnections_inlock(Date_t now) {
+        for (ConnectionList::iterator conn = _idleConnections.begin();
+             conn != _idleConnections.end();) {
+            if (now >= (*conn)->creationDate + kMaxConnectionAge) {
+                conn = _idleConnections.erase(conn);
+            }
+            else {
+                ++conn;
+            }
+        }
+    }
+
+    Date_t NetworkInterfaceAsync::_nextWakeupDate_inlock() const {
+        Date_t wakeupDate = Date_t::max();
+        const CommandList* const lists[] = {&_waiting, &_running};
+        for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); ++i) {
+            for (CommandList::const_iterator cmd = lists[i]->begin();
+                 cmd != lists[i]->end();
+                 ++cmd) {
+                if (cmd->request.expirationDate != RemoteCommandRequest::kNoExpirationDate) {
+                    wakeupDate = std::min(wakeupDate, cmd->request.expirationDate);
+                }
+            }
+        }
+        for (ConnectionList::const_iterator conn = _idleConnections.begin();
+             conn != _idleConnections.end();
+             ++conn) {
+            wakeupDate = std::min(wakeupDate, (*conn)->creationDate + kMaxConnectionAge);
+        }
+        return wakeupDate;
+    }
+
+    void NetworkInterfaceAsync::_startOnConnection_inlock(CommandList::iterator cmd,
+                                                         AsyncConnectionPtr conn,
+                                                         Date_t now,
+                                                         CompletionList* completions) {
+        _running.splice(_running.end(), _waiting, cmd);
+        cmd->conn = std::move(conn);
+        try {
+            BSONObj upconvertedCmd;
+            BSONObj upconvertedMetadata;
+            std::tie(upconvertedCmd, upconvertedMetadata) = uassertStatusOK(
+                rpc::metadata::upconvertRequest(cmd->request.cmdObj, 0));
+
+            rpc::LegacyRequestBuilder requestBuilder;
+            cmd->toSend = requestBuilder.setDatabase(cmd->request.dbname)
+                                        .setCommandName(upconvertedCmd.firstElementFieldName())
+                                        .setMetadata(upconvertedMetadata)
+                                        .setCommandArgs(upconvertedCmd)
+                                        .done();
+        }
+        catch (const DBException& ex) {
+            _finishRunning_inlock(cmd, ex.toStatus(), true, now, completions);
+            return;
+        }
+        cmd->toSend->header().setId(nextMessageId());
+        cmd->toSend->header().setResponseTo(0);
+
+        // Most requests fit in the socket buffer, so there is no need to wait for the poll.
+        _doSend_inlock(cmd, now, completions);
+    }
+
+    void NetworkInterfaceAsync::_doSend_inlock(CommandList::iterator cmd,
+                                               Date_t now,
+                                               CompletionList* completions) {
+        const int sock = cmd->conn->conn->getSocket();
+        const char* const data = cmd->toSend->singleData().view2ptr();
+        const size_t len = cmd->toSend->size();
+        while (cmd->bytesSent < len) {
+            const int ret = ::send(sock,
+                                   data + cmd->bytesSent,
+                                   static_cast<int>(len - cmd->bytesSent),
+                                   portSendFlags);
+            if (ret < 0) {
+                const int error = getLastSocketError();
+                if (isInterrupted(error)) {
+                    continue;
+                }
+                if (!isWouldBlock(error)) {
+                    _finishRunning_inlock(cmd,
+                                          makeNetworkError(cmd->request,
+                                                           errnoWithDescription(error)),
+                                          false,
+                                          now,
+                                          completions);
+                }
+                return;
+            }
+            cmd->bytesSent += ret;
+        }
+    }
+
+    void NetworkInterfaceAsync::_doReceive_inlock(CommandList::iterator cmd,
+                                                  Date_t now,
+                                                  CompletionList* completions) {
+        const int sock = cmd->conn->conn->getSocket();
+        while (true) {
+            char* buf;
+            size_t wanted;
+            if (cmd->reply.empty()) {
+                buf = cmd->replyHeader + cmd->bytesReceived;
+                wanted = kHeaderSize - cmd->bytesReceived;
+            }
+            else {
+                buf = cmd->reply.singleData().view2ptr() + cmd->bytesReceived;
+                wanted = cmd->reply.size() - cmd->bytesReceived;
+            }
+
+            if (wanted > 0) {
+                const int ret = ::recv(sock, buf, static_cast<int>(wanted), portRecvFlags);
+                if (ret == 0) {
+                    _finishRunning_inlock(cmd,
+                                          makeNetworkError(cmd->request, "connection closed"),
+                                          false,
+                                          now,
+                                          completions);
+                    return;
+                }
+                if (ret < 0) {
+                    const int error = getLastSocketError();
+                    if (isInterrupted(error)) {
+                        continue;
+                    }
+                    if (!isWouldBlock(error)) {
+                        _finishRunning_inlock(cmd,
+                                              makeNetworkError(cmd->request,
+                                                               errnoWithDescription(error)),
+                                              false,
+                                              now,
+                                              completions);
+                    }
+                    return;
+                }
+                cmd->bytesReceived += ret;
+            }
+
+            if (cmd->reply.empty()) {
+                if (cmd->bytesReceived < kHeaderSize) {
+                    continue;
+                }
+                const int len = MsgData::ConstView(cmd->replyHeader).getLen();
+                if (len < static_cast<int>(kHeaderSize) ||
+                        static_cast<size_t>(len) > MaxMessageSizeBytes) {
+                    _finishRunning_inlock(cmd,
+                                          Status(ErrorCodes::ProtocolError,
+                                                 str::stream() << "invalid reply length " << len
+                                                               << " from "
+                                                               << cmd->request.target.toString()),
+                                          false,
+                                          now,
+                                          completions);
+                    return;
+                }
+                char* const data = reinterpret_cast<char*>(mongoMalloc(len));
+                memcpy(data, cmd->replyHeader, kHeaderSize);
+                cmd->reply.setData(data, true);
+            }
+
+            if (cmd->bytesReceived == static_cast<size_t>(cmd->reply.size())) {
+                _processReply_inlock(cmd, now, completions);
+                return;
+            }
+        }
+    }
+
+    void NetworkInterfaceAsync::_processReply_inlock(CommandList::iterator cmd,
+                                                     Date_t now,
+                                                     CompletionList* completions) {
+        if (cmd->reply.header().getResponseTo() != cmd->toSend->header().getId()) {
+            _finishRunning_inlock(cmd,
+                                  Status(ErrorCodes::ProtocolError,
+                                         str::stream() << "reply from "
+                                                       << cmd->request.target.toString()
+                                                       << " is not for the request sent"),
+                                  false,
+                                  now,
+                                  completions);
+            return;
+        }
+
+        const Message* reply = &cmd->reply;
+        Message decompressed;
+        if (reply->operation() == dbCompressed) {
+            const Status status = decompressMessage(*reply, &decompressed);
+            if (!status.isOK()) {
+                _finishRunning_inlock(cmd, status, false, now, completions);
+                return;
+            }
+            reply = &decompressed;
+        }
+
+        BSONObj output;
+        try {
+            uassert(ErrorCodes::ProtocolError,
+                    str::stream() << "unexpected reply of type " << reply->operation()
+                                  << " from " << cmd->request.target.toString(),
+                    reply->operation() == opReply);
+            const char* const end = reply->singleData().view2ptr() + reply->size();
+            QueryResult::ConstView qr = reply->singleData().view2ptr();
+            uassertStatusOK(validateBSON(qr.data(), end - qr.data()));
+            rpc::LegacyReply legacyReply(reply);
+            output = legacyReply.getCommandReply().getOwned();
+        }
+        catch (const DBException& ex) {
+            _finishRunning_inlock(cmd, ex.toStatus(), false, now, completions);
+            return;
+        }
+
+        // If the remote node does not support the find or getMore commands, the down conversion
+        // needs a synchronous client, so hand the command to the helper threads.
+        if (getStatusFromCommandResult(output).code() == ErrorCodes::CommandNotFound &&
+                !cmd->canceled) {
+            const StringData commandName = cmd->request.cmdObj.firstElement().fieldNameStringData();
+            if (commandName == "find" || commandName == "getMore") {
+                _releaseConnection_inlock(std::move(cmd->conn), now);
+                _fallback.splice(_fallback.end(), _running, cmd);
+                _fallbackQueue.push_back(cmd);
+                _helperWorkCondition.notify_one();
+                return;
+            }
+        }
+
+        _finishRunning_inlock(cmd,
+                              ResponseStatus(RemoteCommandResponse(
+                                      output, Milliseconds(now - cmd->startDate))),
+                              true,
+                              now,
+                              completions);
+    }
+
+    void NetworkInterfaceAsync::_finishRunning_inlock(CommandList::iterator cmd,
+                                                      const ResponseStatus& response,
+                                                      bool reuseConnection,
+                                                      Date_t now,
+                                                      CompletionList* completions) {
+        LOG(2) << "Network status of sending " << cmd->request.cmdObj.firstElementFieldName() <<
+            " to " << cmd->request.target << " was " << response.getStatus();
+        if (reuseConnection) {
+            _releaseConnection_inlock(std::move(cmd->conn), now);
+        }
+        completions->push_back(
+                Completion(cmd->onFinish,
+                           cmd->canceled ? ResponseStatus(kCanceledStatus) : response));
+        _running.erase(cmd);
+    }
+
+    void NetworkInterfaceAsync::_releaseConnection_inlock(AsyncConnectionPtr conn, Date_t now) {
+        if (now < conn->creationDate + kMaxConnectionAge) {
+            _idleConnections.push_back(std::move(conn));
+        }
+    }
+
+}  // namespace repl
+} // namespace mongo
@@ -0,0 +1,355 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "mongo/client/remote_command_executor_impl.h"
+#include "mongo/db/repl/replication_executor.h"
+#include "mongo/stdx/list.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+namespace repl {
+
+    /**
+     * Event driven implementation of the network interface used by the ReplicationExecutor.
+     *
+     * All outstanding commands are multiplexed over non-blocking sockets by a single network
+     * thread, which sends each request and collects its reply as the sockets become ready, so the
+     * number of in-flight commands does not determine the number of threads.  Connections are
+     * reused for later commands to the same host and retired after they have been connected for a
+     * certain maximum period, as in the ConnectionPool used by NetworkInterfaceImpl.
+     *
+     * Establishing and authenticating a connection is still done with blocking calls, on a small
+     * fixed set of helper threads, so that a slow or unreachable host does not stall the commands
+     * to other hosts.  Each attempt is bounded by a short connect timeout rather than by the
+     * timeout of the command that needs it, and a host that is not known to be reachable only
+     * gets one helper thread at a time, so unreachable hosts cannot hold up connections to the
+     * others.  The helper threads also run the rare commands that need a synchronous client,
+     * which are find and getMore commands against servers that do not support them.
+     *
+     * Commands are sent as OP_QUERY commands, and replies must not need the connection for
+     * anything but plain reads, so this implementation cannot be used with SSL.
+     */
+    class NetworkInterfaceAsync : public ReplicationExecutor::NetworkInterface {
+    public:
+        /**
+         * A connected socket to a remote node, ready for commands to be sent over it.  The socket
+         * is closed when the Connection is destroyed.
+         */
+        class Connection {
+        public:
+            virtual ~Connection() {}
+            virtual int getSocket() const = 0;
+        };
+
+        /**
+         * Source of Connections.  Called on the helper threads, so it may block, for at most
+         * "timeout".
+         */
+        class ConnectionFactory {
+        public:
+            virtual ~ConnectionFactory() {}
+            virtual StatusWith<Connection*> connect(const HostAndPort& target,
+                                                    Milliseconds timeout) = 0;
+        };
+
+        /**
+         * Creates a network interface using DBClientConnections, authenticated as the internal
+         * user when authentication is enabled.
+         */
+        NetworkInterfaceAsync();
+
+        /**
+         * Creates a network interface that takes its connections from "connectionFactory", of
+         * which it takes ownership.
+         */
+        explicit NetworkInterfaceAsync(ConnectionFactory* connectionFactory);
+
+        virtual ~NetworkInterfaceAsync();
+        virtual std::string getDiagnosticString();
+        virtual void startup();
+        virtual void shutdown();
+        virtual void waitForWork();
+        virtual void waitForWorkUntil(Date_t when);
+        virtual void signalWorkAvailable();
+        virtual Date_t now();
+        virtual void startCommand(
+                const ReplicationExecutor::CallbackHandle& cbHandle,
+                const RemoteCommandRequest& request,
+                const RemoteCommandCompletionFn& onFinish);
+        virtual void cancelCommand(const ReplicationExecutor::CallbackHandle& cbHandle);
+        OperationContext* createOperationContext() override;
+
+    private:
+        /**
+         * A connection owned by this network interface.
+         */
+        struct AsyncConnection {
+            AsyncConnection(const HostAndPort& theTarget, Connection* theConn, Date_t date)
+                : target(theTarget),
+                  conn(theConn),
+                  creationDate(date) {}
+
+            HostAndPort target;
+            std::unique_ptr<Connection> conn;
+            Date_t creationDate;
+        };
+        typedef std::unique_ptr<AsyncConnection> AsyncConnectionPtr;
+        typedef stdx::list<AsyncConnectionPtr> ConnectionList;
+
+        /**
+         * State of a command from startCommand() until its onFinish function is called.
+         */
+        struct CommandState {
+            CommandState() : canceled(false), bytesSent(0), bytesReceived(0) {}
+
+            ReplicationExecutor::CallbackHandle cbHandle;
+            RemoteCommandRequest request;
+            RemoteCommandCompletionFn onFinish;
+            Date_t startDate;
+            bool canceled;
+
+            // The connection the command is running on, once it has one.
+            AsyncConnectionPtr conn;
+
+            // The request message and how much of it has been written to the connection.
+            std::unique_ptr<Message> toSend;
+            size_t bytesSent;
+
+            // The reply read so far.  Its header is read into "replyHeader" and the whole message
+            // into "reply" once its length is known.
+            char replyHeader[sizeof(MSGHEADER::Value)];
+            Message reply;
+            size_t bytesReceived;
+        };
+        typedef stdx::list<CommandState> CommandList;
+
+        /**
+         * Connection attempts to one host.
+         */
+        struct HostConnects {
+            HostConnects() : queued(0), inProgress(0), reachable(false) {}
+
+            // Attempts waiting for a helper thread, the oldest of them queued at "queuedDate".
+            size_t queued;
+            Date_t queuedDate;
+
+            // Attempts a helper thread is making.
+            size_t inProgress;
+
+            // Whether the last attempt succeeded.
+            bool reachable;
+        };
+        typedef std::map<HostAndPort, HostConnects> HostConnectsMap;
+
+        /**
+         * The outcome of an attempt to connect to a host, made by a helper thread.
+         */
+        struct ConnectResult {
+            ConnectResult(const HostAndPort& theTarget, StatusWith<Connection*> theConn)
+                : target(theTarget),
+                  conn(theConn) {}
+
+            HostAndPort target;
+            StatusWith<Connection*> conn;
+        };
+
+        /**
+         * A command whose onFinish function is ready to be called with "response".
+         */
+        struct Completion {
+            Completion(const RemoteCommandCompletionFn& theOnFinish,
+                       const ResponseStatus& theResponse)
+                : onFinish(theOnFinish),
+                  response(theResponse) {}
+
+            RemoteCommandCompletionFn onFinish;
+            ResponseStatus response;
+        };
+        typedef std::vector<Completion> CompletionList;
+
+        /**
+         * Body of the network thread, which does all of the socket I/O.
+         */
+        void _runNetworkThread();
+
+        /**
+         * Body of the helper threads, which connect to hosts and run fallback commands.
+         */
+        void _runHelperThread(const std::string& threadName);
+
+        /**
+         * Hands connections made by the helper threads to the commands waiting for them, or fails
+         * those commands if the connection could not be made.
+         */
+        void _processConnectResults_inlock(Date_t now, CompletionList* completions);
+
+        /**
+         * Finishes the waiting commands that have been canceled or have expired, and starts the
+         * others on idle connections or asks the helper threads for new connections.
+         */
+        void _processWaitingCommands_inlock(Date_t now, CompletionList* completions);
+
+        /**
+         * Returns the host a helper thread should connect to next, which is the one with queued
+         * attempts that has the fewest attempts in progress, or the oldest queued attempt among
+         * those.  Returns _hostConnects.end() if no attempt is queued.
+         */
+        HostConnectsMap::iterator _nextHostToConnect_inlock();
+
+        /**
+         * Finishes the running commands that have been canceled or have expired.
+         */
+        void _processRunningCommands_inlock(Date_t now, CompletionList* completions);
+
+        /**
+         * Starts "cmd" on "conn", which must be connected to the command's target.
+         */
+        void _startOnConnection_inlock(CommandList::iterator cmd,
+                                       AsyncConnectionPtr conn,
+                                       Date_t now,
+                                       CompletionList* completions);
+
+        /**
+         * Keeps "conn" for later commands to the same host if it is young enough, or closes it.
+         */
+        void _releaseConnection_inlock(AsyncConnectionPtr conn, Date_t now);
+
+        /**
+         * Writes or reads as much of the command as the socket accepts without blocking.  When the
+         * command has finished or failed, adds it to "completions" or hands it to the helper
+         * threads.
+         */
+        void _doSend_inlock(CommandList::iterator cmd, Date_t now, CompletionList* completions);
+        void _doReceive_inlock(CommandList::iterator cmd, Date_t now, CompletionList* completions);
+
+        /**
+         * Finishes the running command "cmd" with "response".  If "reuseConnection" is true, the
+         * connection is released for later commands, otherwise it is closed.
+         */
+        void _finishRunning_inlock(CommandList::iterator cmd,
+                                   const ResponseStatus& response,
+                                   bool reuseConnection,
+                                   Date_t now,
+                                   CompletionList* completions);
+
+        /**
+         * Parses the complete reply of "cmd", and either finishes the command or, for find and
+         * getMore commands the remote node does not support, hands it to the helper threads.
+         */
+        void _processReply_inlock(CommandList::iterator cmd,
+                                  Date_t now,
+                                  CompletionList* completions);
+
+        /**
+         * Closes idle connections that are too old or that the remote node has closed.
+         */
+        void _retireIdleConnections_inlock(Date_t now);
+
+        /**
+         * Returns the earliest date at which the network thread has work to do without any
+         * socket becoming ready.
+         */
+        Date_t _nextWakeupDate_inlock() const;
+
+        /**
+         * Calls the onFinish functions of "completions", which must be done without holding
+         * _mutex, and lets the executor know.
+         */
+        void _runCompletions(CompletionList* completions);
+
+        /**
+         * Interrupts the network thread's poll so it looks at the queues again.
+         */
+        void _wakeNetworkThread_inlock();
+
+        void _signalWorkAvailable_inlock();
+
+        // Source of new connections.
+        const std::unique_ptr<ConnectionFactory> _connectionFactory;
+
+        // Mutex guarding the state of this network interface.
+        boost::mutex _mutex;
+
+        // The network thread and the helper threads.
+        boost::shared_ptr<boost::thread> _networkThread;
+        std::vector<boost::shared_ptr<boost::thread> > _helperThreads;
+
+        // Pipe written to by _wakeNetworkThread_inlock(), and whether a wakeup is already pending.
+        int _wakeupPipe[2];
+        bool _wakeupPending;
+
+        // Commands that do not have a connection yet.
+        CommandList _waiting;
+
+        // Commands running on a connection.
+        CommandList _running;
+
+        // Commands run synchronously by the helper threads, and the ones not yet picked up.
+        CommandList _fallback;
+        std::deque<CommandList::iterator> _fallbackQueue;
+
+        // Connected sockets that no command is using.
+        ConnectionList _idleConnections;
+
+        // Connection attempts per host.  Hosts are only removed once they have no attempts left
+        // and are not known to be reachable.
+        HostConnectsMap _hostConnects;
+
+        // Attempts the helper threads have finished, for the network thread to process.
+        stdx::list<ConnectResult> _connectResults;
+
+        // Condition signaled when there is work for the helper threads.
+        boost::condition_variable _helperWorkCondition;
+
+        // Condition signaled to indicate that the executor, blocked in waitForWorkUntil or
+        // waitForWork, should wake up.
+        boost::condition_variable _isExecutorRunnableCondition;
+
+        // Flag indicating whether or not the executor associated with this interface is runnable.
+        bool _isExecutorRunnable;
+
+        // Flag indicating when this interface is being shut down (because shutdown() has executed).
+        bool _inShutdown;
+
+        // Runs the fallback commands.
+        RemoteCommandExecutorImpl _fallbackExec;
+    };
+
+}  // namespace repl
+} // namespace mongo
@@ -0,0 +1,389 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/make_shared.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstring>
+#include <set>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/network_interface_async.h"
+#include "mongo/db/repl/replication_executor.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+    const size_t kHeaderSize = sizeof(MSGHEADER::Value);
+
+    bool readFully(int sock, char* buf, size_t len) {
+        while (len > 0) {
+            const ssize_t ret = read(sock, buf, len);
+            if (ret <= 0) {
+                return false;
+            }
+            buf += ret;
+            len -= ret;
+        }
+        return true;
+    }
+
+    /**
+     * Serves OP_QUERY commands on one end of a socket pair until the other end is closed.
+     *
+     * {ping: 1} replies with the number of the connection, {hang: 1} never replies and
+     * {fail: 1} closes the connection.
+     */
+    void serveConnection(int sock, int connectionNumber) {
+        while (true) {
+            char header[kHeaderSize];
+            if (!readFully(sock, header, kHeaderSize)) {
+                break;
+            }
+            const MsgData::ConstView headerView(header);
+            std::vector<char> body(headerView.getLen() - kHeaderSize);
+            if (!readFully(sock, body.data(), body.size())) {
+                break;
+            }
+            invariant(dbQuery == headerView.getOperation());
+
+            // flags, namespace, nToSkip, nToReturn, then the command object.
+            const char* ns = body.data() + 4;
+            invariant(std::string("admin.$cmd") == ns);
+            const BSONObj cmdObj(ns + strlen(ns) + 1 + 8);
+
+            const StringData commandName = cmdObj.firstElement().fieldNameStringData();
+            if (commandName == "hang") {
+                continue;
+            }
+            if (commandName == "fail") {
+                break;
+            }
+            invariant(commandName == "ping");
+
+            BufBuilder b;
+            b.appendNum(0);  // resultFlags
+            b.appendNum(0LL);  // cursorId
+            b.appendNum(0);  // startingFrom
+            b.appendNum(1);  // nReturned
+            BSON("ok" << 1 << "connection" << connectionNumber).appendSelfToBufBuilder(b);
+            Message reply;
+            reply.setData(opReply, b.buf(), b.len());
+            reply.header().setId(nextMessageId());
+            reply.header().setResponseTo(headerView.getId());
+            invariant(reply.size() == write(sock, reply.singleData().view2ptr(), reply.size()));
+        }
+        close(sock);
+    }
+
+    class SocketPairConnection : public NetworkInterfaceAsync::Connection {
+    public:
+        explicit SocketPairConnection(int sock) : _sock(sock) {}
+        ~SocketPairConnection() { close(_sock); }
+        int getSocket() const override { return _sock; }
+
+    private:
+        const int _sock;
+    };
+
+    /**
+     * Connects to a thread running serveConnection() for each new connection.  Connections to
+     * hosts in "unreachable" fail, and connections to hosts in "unresponsive" block until they
+     * time out or the host is no longer unresponsive, and then fail.
+     */
+    class SocketPairConnectionFactory : public NetworkInterfaceAsync::ConnectionFactory {
+    public:
+        SocketPairConnectionFactory() : _numConnections(0), _numBlocked(0) {}
+
+        StatusWith<NetworkInterfaceAsync::Connection*> connect(const HostAndPort& target,
+                                                               Milliseconds timeout) override {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _timeouts.push_back(timeout);
+            if (_unreachable.count(target)) {
+                return {ErrorCodes::HostUnreachable, "unreachable"};
+            }
+            if (_unresponsive.count(target)) {
+                ++_numBlocked;
+                _blockedChanged.notify_all();
+                const Date_t deadline = Date_t::now() + timeout;
+                while (_unresponsive.count(target)) {
+                    const Milliseconds remaining(deadline - Date_t::now());
+                    if (remaining <= Milliseconds(0)) {
+                        break;
+                    }
+                    _blockedChanged.wait_for(lk, remaining);
+                }
+                --_numBlocked;
+                return {ErrorCodes::HostUnreachable, "timed out"};
+            }
+            int socks[2];
+            invariant(socketpair(AF_UNIX, SOCK_STREAM, 0, socks) == 0);
+            _servers.push_back(boost::make_shared<boost::thread>(
+                    stdx::bind(serveConnection, socks[1], _numConnections++)));
+            return StatusWith<NetworkInterfaceAsync::Connection*>(
+                    new SocketPairConnection(socks[0]));
+        }
+
+        void setUnreachable(const HostAndPort& target, bool unreachable) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            if (unreachable) {
+                _unreachable.insert(target);
+            }
+            else {
+                _unreachable.erase(target);
+            }
+        }
+
+        void setUnresponsive(const HostAndPort& target, bool unresponsive) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            if (unresponsive) {
+                _unresponsive.insert(target);
+            }
+            else {
+                _unresponsive.erase(target);
+                _blockedChanged.notify_all();
+            }
+        }
+
+        /**
+         * Waits until at least "numBlocked" attempts are blocked on unresponsive hosts, and
+         * returns how many are.
+         */
+        int waitForBlockedConnects(int numBlocked) {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            while (_numBlocked < numBlocked) {
+                _blockedChanged.wait(lk);
+            }
+            return _numBlocked;
+        }
+
+        /**
+         * Returns the timeouts of all attempts made so far.
+         */
+        std::vector<Milliseconds> getConnectTimeouts() {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            return _timeouts;
+        }
+
+        int getNumConnections() {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            return _numConnections;
+        }
+
+        /**
+         * Waits for the server threads, which exit once their connections are closed.
+         */
+        void joinServers() {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            for (size_t i = 0; i < _servers.size(); ++i) {
+                _servers[i]->join();
+            }
+        }
+
+    private:
+        boost::mutex _mutex;
+        boost::condition_variable _blockedChanged;
+        std::set<HostAndPort> _unreachable;
+        std::set<HostAndPort> _unresponsive;
+        std::vector<boost::shared_ptr<boost::thread> > _servers;
+        std::vector<Milliseconds> _timeouts;
+        int _numConnections;
+        int _numBlocked;
+    };
+
+    class NetworkInterfaceAsyncTest : public unittest::Test {
+    protected:
+        void setUp() override {
+            _factory = new SocketPairConnectionFactory;
+            _executor.reset(new ReplicationExecutor(new NetworkInterfaceAsync(_factory), 1));
+            _executorThread.reset(
+                    new boost::thread(stdx::bind(&ReplicationExecutor::run, _executor.get())));
+        }
+
+        void tearDown() override {
+            _executor->shutdown();
+            _executorThread->join();
+            _factory->joinServers();
+            _executor.reset();
+        }
+
+        /**
+         * Schedules "cmdObj" against "target" and returns its handle.  The response is stored in
+         * "response" when the command finishes.
+         */
+        ReplicationExecutor::CallbackHandle schedule(const HostAndPort& target,
+                                                     const BSONObj& cmdObj,
+                                                     Milliseconds timeout,
+                                                     ResponseStatus* response) {
+            const RemoteCommandRequest request(target, "admin", cmdObj, timeout);
+            return unittest::assertGet(_executor->scheduleRemoteCommand(
+                    request,
+                    [response](const ReplicationExecutor::RemoteCommandCallbackData& cbData) {
+                        *response = cbData.response;
+                    }));
+        }
+
+        ResponseStatus runCommand(const HostAndPort& target,
+                           const BSONObj& cmdObj,
+                           Milliseconds timeout = RemoteCommandRequest::kNoTimeout) {
+            ResponseStatus response(ErrorCodes::InternalError, "not run");
+            _executor->wait(schedule(target, cmdObj, timeout, &response));
+            return response;
+        }
+
+        ReplicationExecutor& getExecutor() { return *_executor; }
+        SocketPairConnectionFactory& getFactory() { return *_factory; }
+        int getNumConnections() { return _factory->getNumConnections(); }
+
+    private:
+        SocketPairConnectionFactory* _factory;
+        std::unique_ptr<ReplicationExecutor> _executor;
+        std::unique_ptr<boost::thread> _executorThread;
+    };
+
+    TEST_F(NetworkInterfaceAsyncTest, RunsCommandsAndReusesConnections) {
+        const HostAndPort target("node1", 27017);
+        for (int i = 0; i < 3; ++i) {
+            const ResponseStatus response = runCommand(target, BSON("ping" << 1));
+            ASSERT_OK(response.getStatus());
+            ASSERT_EQUALS(BSON("ok" << 1 << "connection" << 0), response.getValue().data);
+        }
+        ASSERT_EQUALS(1, getNumConnections());
+    }
+
+    TEST_F(NetworkInterfaceAsyncTest, RunsManyCommandsAtOnce) {
+        const size_t numCommands = 100;
+        std::vector<ResponseStatus> responses(numCommands,
+                                              ResponseStatus(ErrorCodes::InternalError, "not run"));
+        std::vector<ReplicationExecutor::CallbackHandle> handles;
+        for (size_t i = 0; i < numCommands; ++i) {
+            const HostAndPort target("node", 27017 + i % 10);
+            handles.push_back(schedule(target,
+                                       BSON("ping" << 1),
+                                       RemoteCommandRequest::kNoTimeout,
+                                       &responses[i]));
+        }
+        for (size_t i = 0; i < numCommands; ++i) {
+            getExecutor().wait(handles[i]);
+            ASSERT_OK(responses[i].getStatus());
+        }
+        ASSERT_GREATER_THAN_OR_EQUALS(getNumConnections(), 10);
+        ASSERT_LESS_THAN_OR_EQUALS(getNumConnections(), static_cast<int>(numCommands));
+    }
+
+    TEST_F(NetworkInterfaceAsyncTest, TimesOutCommandsAndClosesTheirConnections) {
+        const HostAndPort target("node1", 27017);
+        const ResponseStatus response = runCommand(target, BSON("hang" << 1), Milliseconds(100));
+        ASSERT_EQUALS(ErrorCodes::ExceededTimeLimit, response.getStatus());
+
+        // The late reply must not be read as the reply to the next command.
+        ASSERT_OK(runCommand(target, BSON("ping" << 1)).getStatus());
+        ASSERT_EQUALS(2, getNumConnections());
+    }
+
+    TEST_F(NetworkInterfaceAsyncTest, CancelsRunningCommands) {
+        const HostAndPort target("node1", 27017);
+        ResponseStatus response(ErrorCodes::InternalError, "not run");
+        const ReplicationExecutor::CallbackHandle handle =
+            schedule(target, BSON("hang" << 1), RemoteCommandRequest::kNoTimeout, &response);
+
+        // Let the command reach the connection before canceling it.
+        ASSERT_OK(runCommand(target, BSON("ping" << 1)).getStatus());
+        getExecutor().cancel(handle);
+        getExecutor().wait(handle);
+        ASSERT_EQUALS(ErrorCodes::CallbackCanceled, response.getStatus());
+    }
+
+    TEST_F(NetworkInterfaceAsyncTest, ReportsNetworkErrors) {
+        const HostAndPort target("node1", 27017);
+        getFactory().setUnreachable(target, true);
+        ASSERT_EQUALS(ErrorCodes::HostUnreachable,
+                      runCommand(target, BSON("ping" << 1)).getStatus());
+
+        getFactory().setUnreachable(target, false);
+        ASSERT_EQUALS(ErrorCodes::HostUnreachable,
+                      runCommand(target, BSON("fail" << 1)).getStatus());
+        ASSERT_OK(runCommand(target, BSON("ping" << 1)).getStatus());
+    }
+
+    TEST_F(NetworkInterfaceAsyncTest, UnresponsiveHostsDoNotDelayConnectsToOtherHosts) {
+        const Milliseconds commandTimeout(60 * 60 * 1000);
+        const size_t numUnresponsive = 3;
+        const size_t commandsPerHost = 5;
+        std::vector<HostAndPort> unresponsive;
+        for (size_t i = 0; i < numUnresponsive; ++i) {
+            unresponsive.push_back(HostAndPort("unresponsive", 27017 + i));
+            getFactory().setUnresponsive(unresponsive.back(), true);
+        }
+
+        std::vector<ResponseStatus> responses(numUnresponsive * commandsPerHost,
+                                              ResponseStatus(ErrorCodes::InternalError, "not run"));
+        std::vector<ReplicationExecutor::CallbackHandle> handles;
+        for (size_t i = 0; i < responses.size(); ++i) {
+            handles.push_back(schedule(unresponsive[i % numUnresponsive],
+                                       BSON("ping" << 1),
+                                       commandTimeout,
+                                       &responses[i]));
+        }
+
+        // Each unresponsive host takes up a single helper thread, which leaves one to connect to
+        // a healthy host well before the unresponsive attempts time out.
+        getFactory().waitForBlockedConnects(numUnresponsive);
+        ASSERT_OK(runCommand(HostAndPort("node1", 27017),
+                             BSON("ping" << 1),
+                             Milliseconds(2000)).getStatus());
+        ASSERT_EQUALS(static_cast<int>(numUnresponsive), getFactory().waitForBlockedConnects(0));
+
+        // Attempts are bounded by the connect timeout, not by the timeout of the commands.
+        const std::vector<Milliseconds> timeouts = getFactory().getConnectTimeouts();
+        for (size_t i = 0; i < timeouts.size(); ++i) {
+            ASSERT_GREATER_THAN(timeouts[i], Milliseconds(0));
+            ASSERT_LESS_THAN(timeouts[i], commandTimeout);
+        }
+
+        for (size_t i = 0; i < numUnresponsive; ++i) {
+            getFactory().setUnresponsive(unresponsive[i], false);
+        }
+        for (size_t i = 0; i < handles.size(); ++i) {
+            getExecutor().wait(handles[i]);
+            ASSERT_EQUALS(ErrorCodes::HostUnreachable, responses[i].getStatus());
+        }
+    }
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
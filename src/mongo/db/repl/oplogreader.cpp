@@ -77,7 +77,7 @@ namespace repl {
         return authenticateInternalUser(conn);
     }
 
-    OplogReader::OplogReader() {
+    OplogReader::OplogReader() : _exhausting(false) {
         _tailingQueryOptions = QueryOption_SlaveOk;
         _tailingQueryOptions |= QueryOption_CursorTailable | QueryOption_OplogReplay;
         
@@ -106,6 +106,17 @@ namespace repl {
         return true;
     }
 
+    void OplogReader::resetCursor() {
+        if (_exhausting && cursor.get() && cursor->getCursorId() != 0) {
+            const HostAndPort host = _host;
+            resetConnection();
+            connect(host);
+            return;
+        }
+        cursor.reset();
+        _exhausting = false;
+    }
+
     void OplogReader::tailCheck() {
         if( cursor.get() && cursor->isDead() ) {
             log() << "old cursor isDead, will initiate a new one" << std::endl;
@@ -123,18 +134,47 @@ namespace repl {
         );
     }
 
-    void OplogReader::tailingQuery(const char *ns, const BSONObj& query) {
+    void OplogReader::tailingQuery(const char *ns, const BSONObj& query, bool exhaust) {
         verify( !haveCursor() );
-        LOG(2) << ns << ".find(" << query.toString() << ')' << endl;
-        cursor.reset( _conn->query( ns, query, 0, 0, nullptr, _tailingQueryOptions ).release() );
+        LOG(2) << ns << ".find(" << query.toString() << ')'
+               << (exhaust ? " exhaust" : "") << endl;
+        int options = _tailingQueryOptions;
+        if (exhaust) {
+            options |= QueryOption_Exhaust;
+        }
+        cursor.reset( _conn->query( ns, query, 0, 0, nullptr, options ).release() );
+        _exhausting = exhaust && cursor.get();
     }
 
-    void OplogReader::tailingQueryGTE(const char *ns, Timestamp optime) {
+    void OplogReader::tailingQueryGTE(const char *ns, Timestamp optime, bool exhaust) {
         BSONObjBuilder gte;
         gte.append("$gte", optime);
         BSONObjBuilder query;
         query.append("ts", gte.done());
-        tailingQuery(ns, query.done());
+        tailingQuery(ns, query.done(), exhaust);
+    }
+
+    void OplogReader::nextBatch(std::vector<BSONObj>* ops) {
+        uassert( 28661, "Doesn't have cursor for reading oplog", cursor.get() );
+
+        // Objects returned by the cursor point into the received message, which is freed when
+        // the next batch arrives. Copy the message once and let every op share the copy.
+        const Message* batch = cursor->getMessage();
+        const char* const batchData = batch->singleData().view2ptr();
+        const int batchSize = batch->size();
+        SharedBuffer batchCopy = SharedBuffer::allocate(batchSize);
+        memcpy(batchCopy.get(), batchData, batchSize);
+
+        while (cursor->moreInCurrentBatch()) {
+            BSONObj op = cursor->nextSafe();
+            const ptrdiff_t offset = op.objdata() - batchData;
+            if (offset < 0 || offset + op.objsize() > batchSize) {
+                // Not part of the received batch, e.g. an op which was put back.
+                ops->push_back(op.getOwned());
+                continue;
+            }
+            ops->push_back(BSONObj(batchCopy.get() + offset).shareOwnershipWith(batchCopy));
+        }
     }
 
     HostAndPort OplogReader::getHost() const {
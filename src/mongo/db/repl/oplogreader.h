@@ -61,15 +61,25 @@ namespace repl {
         boost::shared_ptr<DBClientCursor> cursor;
         int _tailingQueryOptions;
 
+        // True while 'cursor' is an exhaust cursor, for which the sync source streams batches
+        // on '_conn' without waiting for getMores.
+        bool _exhausting;
+
         // If _conn was actively connected, _host represents the current HostAndPort of the
         // connection.
         HostAndPort _host;
     public:
         OplogReader();
         ~OplogReader() { }
-        void resetCursor() { cursor.reset(); }
+        /**
+         * Drops the current cursor. If it is an exhaust cursor which is still open, the
+         * connection is reopened as well, since the sync source keeps streaming batches on it.
+         * If reconnecting fails, this OplogReader is left unconnected.
+         */
+        void resetCursor();
         void resetConnection() {
             cursor.reset();
+            _exhausting = false;
             _conn.reset();
             _host = HostAndPort();
         }
@@ -97,9 +107,15 @@ namespace repl {
                    int nToSkip,
                    const BSONObj* fields=0);
 
-        void tailingQuery(const char *ns, const BSONObj& query);
+        /**
+         * Opens a tailable, awaitData cursor. With 'exhaust', the cursor is opened in exhaust
+         * mode: the sync source pushes each batch as soon as it is available rather than
+         * waiting for a getMore round trip, and the connection cannot be used for anything
+         * else until resetCursor() or resetConnection().
+         */
+        void tailingQuery(const char *ns, const BSONObj& query, bool exhaust = false);
 
-        void tailingQueryGTE(const char *ns, Timestamp t);
+        void tailingQueryGTE(const char *ns, Timestamp t, bool exhaust = false);
 
         bool more() {
             uassert( 15910, "Doesn't have cursor for reading oplog", cursor.get() );
@@ -120,6 +136,12 @@ namespace repl {
         BSONObj nextSafe() { return cursor->nextSafe(); }
         BSONObj next() { return cursor->next(); }
 
+        /**
+         * Appends the rest of the current batch to 'ops'. The returned objects are owned, but
+         * share a single copy of the received batch instead of each holding its own copy.
+         */
+        void nextBatch(std::vector<BSONObj>* ops);
+
 
         // master/slave only
         void peek(std::vector<BSONObj>& v, int n) {
@@ -43,5 +43,9 @@ namespace repl {
         return Status::OK();
     }
 
+    // Runs the replication executor's remote commands on NetworkInterfaceAsync rather than on a
+    // pool of threads.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replAsyncNetworkInterface, bool, false);
+
 }
 }
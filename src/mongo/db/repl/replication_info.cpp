@@ -48,6 +48,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/s/write_ops/batched_command_request.h"
+#include "mongo/util/net/message_port.h"
 
 namespace mongo {
 
@@ -229,6 +230,14 @@ namespace repl {
             result.appendDate("localTime", jsTime());
             result.append("maxWireVersion", maxWireVersion);
             result.append("minWireVersion", minWireVersion);
+
+            // The reply is already sent with the negotiated compressor; the client understands
+            // it since it asked for compression.
+            AbstractMessagingPort* port = txn->getClient()->port();
+            if (port) {
+                port->setCompressor(
+                    negotiateCompressor(cmdObj, port->getCompressor(), &result));
+            }
             return true;
         }
     } cmdismaster;
@@ -863,6 +863,7 @@ namespace {
 
             log() << "rollback 2 FindCommonPoint";
             try {
+                uassert(28662, "lost connection to sync source", oplogreader->conn());
                 StatusWith<FixUpInfo> res = syncRollbackFindCommonPoint(txn, oplogreader->conn());
                 if (!res.isOK()) {
                     switch (res.getStatus().code()) {
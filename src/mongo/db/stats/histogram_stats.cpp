@@ -0,0 +1,69 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/histogram_stats.h"
+
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    void HistogramStats::record( long long value ) {
+        if ( value < 0 )
+            value = 0;
+
+        int bucket = 0;
+        for ( unsigned long long v = value; v > 0; v >>= 1 ) {
+            bucket++;
+        }
+
+        _buckets[bucket].fetchAndAdd(1);
+        _num.fetchAndAdd(1);
+        _total.fetchAndAdd(value);
+    }
+
+    BSONObj HistogramStats::getReport() const {
+        BSONObjBuilder b;
+        b.appendNumber( "num", static_cast<long long>(_num.loadRelaxed()) );
+        b.appendNumber( "total", static_cast<long long>(_total.loadRelaxed()) );
+
+        BSONObjBuilder buckets( b.subobjStart( "buckets" ) );
+        for ( int i = 0; i < kNumBuckets; i++ ) {
+            const unsigned long long count = _buckets[i].loadRelaxed();
+            if ( count == 0 )
+                continue;
+            const unsigned long long lowerBound = i == 0 ? 0 : 1ULL << (i - 1);
+            buckets.appendNumber( std::string( str::stream() << lowerBound ),
+                                 static_cast<long long>(count) );
+        }
+        buckets.doneFast();
+
+        return b.obj();
+    }
+}
@@ -38,6 +38,8 @@ namespace mongo {
      * Sample format:
      *
      * rangeDeleter: {
+     *   queuedRanges: 2,
+     *   deletesInProgress: 1,
      *   lastDeleteStats: [
      *     {
      *       deleteDocs: NumberLong(5);
@@ -45,6 +47,7 @@ namespace mongo {
      *       queueEnd: ISODate("2014-06-11T22:45:30.221Z"),
      *       deleteStart: ISODate("2014-06-11T22:45:30.221Z"),
      *       deleteEnd: ISODate("2014-06-11T22:45:30.221Z"),
+     *       docsPerSecond: 5000,
      *       waitForReplStart: ISODate("2014-06-11T22:45:30.221Z"),
      *       waitForReplEnd: ISODate("2014-06-11T22:45:30.221Z")
      *     }
@@ -65,6 +68,10 @@ namespace mongo {
             }
 
             BSONObjBuilder result;
+            result.appendNumber("queuedRanges",
+                                static_cast<long long>(deleter->getPendingDeletes()));
+            result.appendNumber("deletesInProgress",
+                                static_cast<long long>(deleter->getDeletesInProgress()));
 
             OwnedPointerVector<DeleteJobStats> statsList;
             deleter->getStatsHistory(&statsList.mutableVector());
@@ -83,6 +90,12 @@ namespace mongo {
                     entryBuilder.append("deleteStart", (*it)->deleteStartTS);
                     entryBuilder.append("deleteEnd", (*it)->deleteEndTS);
 
+                    const long long deleteMillis =
+                        durationCount<Milliseconds>((*it)->deleteEndTS - (*it)->deleteStartTS);
+                    entryBuilder.appendNumber("docsPerSecond",
+                                              (*it)->deletedDocCount * 1000 /
+                                                  std::max(deleteMillis, 1LL));
+
                     if ((*it)->waitForReplEndTS > Date_t()) {
                         entryBuilder.append("waitForReplStart", (*it)->waitForReplStartTS);
                         entryBuilder.append("waitForReplEnd", (*it)->waitForReplEndTS);
@@ -46,6 +46,8 @@ namespace mongo {
                 KVStorageEngineOptions options;
                 options.directoryPerDB = params.directoryperdb;
                 options.forRepair = params.repair;
+                options.openThreads = params.startupLoadThreads;
+                options.lazyRecordStores = params.lazyOpenRecordStores;
                 return new KVStorageEngine( new DevNullKVEngine(), options );
             }
 
@@ -237,8 +237,6 @@ namespace mongo {
                                                  bool forRepair ) {
         invariant(!_collections.count(ns));
 
-        const std::string ident = _engine->getCatalog()->getCollectionIdent( ns );
-
         RecordStore* rs;
         if (forRepair) {
             // Using a NULL rs since we don't want to open this record store before it has been
@@ -246,11 +244,20 @@ namespace mongo {
             rs = NULL;
         }
         else {
+            const std::string ident = _engine->getCatalog()->getCollectionIdent( ns );
             BSONCollectionCatalogEntry::MetaData md = _engine->getCatalog()->getMetaData(opCtx, ns);
             rs = _engine->getEngine()->getRecordStore( opCtx, ns, ident, md.options );
             invariant( rs );
         }
 
+        initCollection( ns, rs );
+    }
+
+    void KVDatabaseCatalogEntry::initCollection( const std::string& ns, RecordStore* rs ) {
+        invariant(!_collections.count(ns));
+
+        const std::string ident = _engine->getCatalog()->getCollectionIdent( ns );
+
         // No change registration since this is only for committed collections
         _collections[ns] = new KVCollectionCatalogEntry( _engine->getEngine(),
                                                          _engine->getCatalog(),
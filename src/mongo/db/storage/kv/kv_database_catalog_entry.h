@@ -89,6 +89,13 @@ namespace mongo {
                              const std::string& ns,
                              bool forRepair );
 
+        /**
+         * Like initCollection() above, but with a record store which the caller already opened.
+         * Takes ownership of 'rs', which may only be NULL if the collection is about to be
+         * repaired.
+         */
+        void initCollection( const std::string& ns, RecordStore* rs );
+
         void initCollectionBeforeRepair(OperationContext* opCtx, const std::string& ns);
         void reinitCollectionAfterRepair(OperationContext* opCtx, const std::string& ns);
 
@@ -0,0 +1,234 @@
+// kv_lazy_record_store.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/kv/kv_lazy_record_store.h"
+
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/kv/kv_engine.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    KVLazyRecordStore::KVLazyRecordStore( KVEngine* engine,
+                                          StringData ns,
+                                          StringData ident,
+                                          const CollectionOptions& options )
+        : RecordStore( ns ),
+          _engine( engine ),
+          _ident( ident.toString() ),
+          _options( options ),
+          _recordStore( NULL ) {
+    }
+
+    KVLazyRecordStore::~KVLazyRecordStore() {
+        delete _recordStore.load();
+    }
+
+    RecordStore* KVLazyRecordStore::_get() const {
+        RecordStore* rs = _recordStore.load();
+        if ( rs ) {
+            return rs;
+        }
+
+        boost::lock_guard<boost::mutex> lk( _openMutex );
+        rs = _recordStore.load();
+        if ( !rs ) {
+            // Opened with its own recovery unit so that the caller's snapshot isn't affected.
+            OperationContextNoop opCtx( _engine->newRecoveryUnit() );
+            rs = _engine->getRecordStore( &opCtx, _ns, _ident, _options );
+            invariant( rs );
+            _recordStore.store( rs );
+        }
+        return rs;
+    }
+
+    const char* KVLazyRecordStore::name() const {
+        return _get()->name();
+    }
+
+    long long KVLazyRecordStore::dataSize( OperationContext* txn ) const {
+        return _get()->dataSize( txn );
+    }
+
+    long long KVLazyRecordStore::numRecords( OperationContext* txn ) const {
+        return _get()->numRecords( txn );
+    }
+
+    void KVLazyRecordStore::setCappedDeleteCallback( CappedDocumentDeleteCallback* cb ) {
+        _get()->setCappedDeleteCallback( cb );
+    }
+
+    int64_t KVLazyRecordStore::storageSize( OperationContext* txn,
+                                            BSONObjBuilder* extraInfo,
+                                            int infoLevel ) const {
+        return _get()->storageSize( txn, extraInfo, infoLevel );
+    }
+
+    RecordData KVLazyRecordStore::dataFor( OperationContext* txn, const RecordId& loc ) const {
+        return _get()->dataFor( txn, loc );
+    }
+
+    bool KVLazyRecordStore::findRecord( OperationContext* txn,
+                                        const RecordId& loc,
+                                        RecordData* out ) const {
+        return _get()->findRecord( txn, loc, out );
+    }
+
+    void KVLazyRecordStore::deleteRecord( OperationContext* txn, const RecordId& dl ) {
+        _get()->deleteRecord( txn, dl );
+    }
+
+    StatusWith<RecordId> KVLazyRecordStore::insertRecord( OperationContext* txn,
+                                                          const char* data,
+                                                          int len,
+                                                          bool enforceQuota ) {
+        return _get()->insertRecord( txn, data, len, enforceQuota );
+    }
+
+    StatusWith<RecordId> KVLazyRecordStore::insertRecord( OperationContext* txn,
+                                                          const DocWriter* doc,
+                                                          bool enforceQuota ) {
+        return _get()->insertRecord( txn, doc, enforceQuota );
+    }
+
+    StatusWith<RecordId> KVLazyRecordStore::updateRecord( OperationContext* txn,
+                                                          const RecordId& oldLocation,
+                                                          const char* data,
+                                                          int len,
+                                                          bool enforceQuota,
+                                                          UpdateNotifier* notifier ) {
+        return _get()->updateRecord( txn, oldLocation, data, len, enforceQuota, notifier );
+    }
+
+    bool KVLazyRecordStore::updateWithDamagesSupported() const {
+        return _get()->updateWithDamagesSupported();
+    }
+
+    Status KVLazyRecordStore::updateWithDamages( OperationContext* txn,
+                                                 const RecordId& loc,
+                                                 const RecordData& oldRec,
+                                                 const char* damageSource,
+                                                 const mutablebson::DamageVector& damages ) {
+        return _get()->updateWithDamages( txn, loc, oldRec, damageSource, damages );
+    }
+
+    RecordFetcher* KVLazyRecordStore::recordNeedsFetch( OperationContext* txn,
+                                                        const RecordId& loc ) const {
+        return _get()->recordNeedsFetch( txn, loc );
+    }
+
+    RecordIterator* KVLazyRecordStore::getIterator( OperationContext* txn,
+                                                    const RecordId& start,
+                                                    const CollectionScanParams::Direction& dir
+                                                    ) const {
+        return _get()->getIterator( txn, start, dir );
+    }
+
+    RecordIterator* KVLazyRecordStore::getIteratorForRepair( OperationContext* txn ) const {
+        return _get()->getIteratorForRepair( txn );
+    }
+
+    std::vector<RecordIterator*> KVLazyRecordStore::getManyIterators(
+                                                            OperationContext* txn ) const {
+        return _get()->getManyIterators( txn );
+    }
+
+    Status KVLazyRecordStore::truncate( OperationContext* txn ) {
+        return _get()->truncate( txn );
+    }
+
+    void KVLazyRecordStore::temp_cappedTruncateAfter( OperationContext* txn,
+                                                      RecordId end,
+                                                      bool inclusive ) {
+        _get()->temp_cappedTruncateAfter( txn, end, inclusive );
+    }
+
+    bool KVLazyRecordStore::compactSupported() const {
+        return _get()->compactSupported();
+    }
+
+    bool KVLazyRecordStore::compactsInPlace() const {
+        return _get()->compactsInPlace();
+    }
+
+    Status KVLazyRecordStore::compact( OperationContext* txn,
+                                       RecordStoreCompactAdaptor* adaptor,
+                                       const CompactOptions* options,
+                                       CompactStats* stats ) {
+        return _get()->compact( txn, adaptor, options, stats );
+    }
+
+    StatusWith<RecordId> KVLazyRecordStore::relocateRecord( OperationContext* txn,
+                                                            const RecordId& loc,
+                                                            UpdateNotifier* notifier ) {
+        return _get()->relocateRecord( txn, loc, notifier );
+    }
+
+    size_t KVLazyRecordStore::releaseRelocatedSpace( OperationContext* txn, size_t maxRecords ) {
+        return _get()->releaseRelocatedSpace( txn, maxRecords );
+    }
+
+    Status KVLazyRecordStore::validate( OperationContext* txn,
+                                        bool full, bool scanData,
+                                        ValidateAdaptor* adaptor,
+                                        ValidateResults* results, BSONObjBuilder* output ) {
+        return _get()->validate( txn, full, scanData, adaptor, results, output );
+    }
+
+    void KVLazyRecordStore::appendCustomStats( OperationContext* txn,
+                                               BSONObjBuilder* result,
+                                               double scale ) const {
+        _get()->appendCustomStats( txn, result, scale );
+    }
+
+    Status KVLazyRecordStore::touch( OperationContext* txn, BSONObjBuilder* output ) const {
+        return _get()->touch( txn, output );
+    }
+
+    boost::optional<RecordId> KVLazyRecordStore::oplogStartHack(
+                                                    OperationContext* txn,
+                                                    const RecordId& startingPosition ) const {
+        return _get()->oplogStartHack( txn, startingPosition );
+    }
+
+    Status KVLazyRecordStore::oplogDiskLocRegister( OperationContext* txn,
+                                                    const Timestamp& opTime ) {
+        return _get()->oplogDiskLocRegister( txn, opTime );
+    }
+
+    void KVLazyRecordStore::updateStatsAfterRepair( OperationContext* txn,
+                                                    long long numRecords,
+                                                    long long dataSize ) {
+        _get()->updateStatsAfterRepair( txn, numRecords, dataSize );
+    }
+
+}
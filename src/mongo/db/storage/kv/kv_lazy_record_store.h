@@ -0,0 +1,178 @@
+// kv_lazy_record_store.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class KVEngine;
+
+    /**
+     * A RecordStore which asks the KVEngine for the real record store of a collection the first
+     * time it is used, and forwards every call to it from then on. Lets startup skip opening the
+     * tables of collections which are never read.
+     *
+     * The ns, and whether the collection is capped, are known without opening the record store.
+     * Only collections which aren't capped should be opened lazily, because Collection registers
+     * its capped delete callback as soon as it is constructed.
+     */
+    class KVLazyRecordStore final : public RecordStore {
+    public:
+        KVLazyRecordStore( KVEngine* engine,
+                           StringData ns,
+                           StringData ident,
+                           const CollectionOptions& options );
+
+        ~KVLazyRecordStore() final;
+
+        /**
+         * Returns true once the underlying record store has been opened.
+         */
+        bool isOpen() const { return _recordStore.load() != NULL; }
+
+        const char* name() const final;
+
+        long long dataSize( OperationContext* txn ) const final;
+
+        long long numRecords( OperationContext* txn ) const final;
+
+        bool isCapped() const final { return _options.capped; }
+
+        void setCappedDeleteCallback( CappedDocumentDeleteCallback* cb ) final;
+
+        int64_t storageSize( OperationContext* txn,
+                             BSONObjBuilder* extraInfo = NULL,
+                             int infoLevel = 0 ) const final;
+
+        RecordData dataFor( OperationContext* txn, const RecordId& loc ) const final;
+
+        bool findRecord( OperationContext* txn, const RecordId& loc, RecordData* out ) const final;
+
+        void deleteRecord( OperationContext* txn, const RecordId& dl ) final;
+
+        StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                           const char* data,
+                                           int len,
+                                           bool enforceQuota ) final;
+
+        StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                           const DocWriter* doc,
+                                           bool enforceQuota ) final;
+
+        StatusWith<RecordId> updateRecord( OperationContext* txn,
+                                           const RecordId& oldLocation,
+                                           const char* data,
+                                           int len,
+                                           bool enforceQuota,
+                                           UpdateNotifier* notifier ) final;
+
+        bool updateWithDamagesSupported() const final;
+
+        Status updateWithDamages( OperationContext* txn,
+                                  const RecordId& loc,
+                                  const RecordData& oldRec,
+                                  const char* damageSource,
+                                  const mutablebson::DamageVector& damages ) final;
+
+        RecordFetcher* recordNeedsFetch( OperationContext* txn,
+                                         const RecordId& loc ) const final;
+
+        RecordIterator* getIterator( OperationContext* txn,
+                                     const RecordId& start = RecordId(),
+                                     const CollectionScanParams::Direction& dir =
+                                             CollectionScanParams::FORWARD ) const final;
+
+        RecordIterator* getIteratorForRepair( OperationContext* txn ) const final;
+
+        std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const final;
+
+        Status truncate( OperationContext* txn ) final;
+
+        void temp_cappedTruncateAfter( OperationContext* txn,
+                                       RecordId end,
+                                       bool inclusive ) final;
+
+        bool compactSupported() const final;
+
+        bool compactsInPlace() const final;
+
+        Status compact( OperationContext* txn,
+                        RecordStoreCompactAdaptor* adaptor,
+                        const CompactOptions* options,
+                        CompactStats* stats ) final;
+
+        StatusWith<RecordId> relocateRecord( OperationContext* txn,
+                                             const RecordId& loc,
+                                             UpdateNotifier* notifier ) final;
+
+        size_t releaseRelocatedSpace( OperationContext* txn, size_t maxRecords ) final;
+
+        Status validate( OperationContext* txn,
+                         bool full, bool scanData,
+                         ValidateAdaptor* adaptor,
+                         ValidateResults* results, BSONObjBuilder* output ) final;
+
+        void appendCustomStats( OperationContext* txn,
+                                BSONObjBuilder* result,
+                                double scale ) const final;
+
+        Status touch( OperationContext* txn, BSONObjBuilder* output ) const final;
+
+        boost::optional<RecordId> oplogStartHack( OperationContext* txn,
+                                                  const RecordId& startingPosition ) const final;
+
+        Status oplogDiskLocRegister( OperationContext* txn, const Timestamp& opTime ) final;
+
+        void updateStatsAfterRepair( OperationContext* txn,
+                                     long long numRecords,
+                                     long long dataSize ) final;
+
+    private:
+        /**
+         * Returns the underlying record store, opening it first if this is the first call.
+         */
+        RecordStore* _get() const;
+
+        KVEngine* const _engine; // not owned
+        const std::string _ident;
+        const CollectionOptions _options;
+
+        // Owned. Set once, under _openMutex, and never changed afterwards.
+        mutable AtomicWord<RecordStore*> _recordStore;
+        mutable boost::mutex _openMutex;
+    };
+
+}
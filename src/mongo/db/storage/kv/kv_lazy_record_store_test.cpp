@@ -0,0 +1,107 @@
+// kv_lazy_record_store_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/kv/kv_lazy_record_store.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/in_memory/in_memory_engine.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+
+    /**
+     * Counts how many record stores have been handed out.
+     */
+    class CountingKVEngine : public InMemoryEngine {
+    public:
+        CountingKVEngine() : numOpened(0) {}
+
+        virtual RecordStore* getRecordStore( OperationContext* opCtx,
+                                             StringData ns,
+                                             StringData ident,
+                                             const CollectionOptions& options ) {
+            numOpened++;
+            return InMemoryEngine::getRecordStore(opCtx, ns, ident, options);
+        }
+
+        int numOpened;
+    };
+
+    TEST(KVLazyRecordStoreTest, OpensOnFirstUse) {
+        CountingKVEngine engine;
+        OperationContextNoop txn(engine.newRecoveryUnit());
+        ASSERT_OK(engine.createRecordStore(&txn, "db.coll", "ident", CollectionOptions()));
+
+        KVLazyRecordStore rs(&engine, "db.coll", "ident", CollectionOptions());
+        ASSERT_EQUALS("db.coll", rs.ns());
+        ASSERT_FALSE(rs.isCapped());
+        ASSERT_FALSE(rs.isOpen());
+        ASSERT_EQUALS(0, engine.numOpened);
+
+        ASSERT_EQUALS(0, rs.numRecords(&txn));
+        ASSERT_TRUE(rs.isOpen());
+        ASSERT_EQUALS(1, engine.numOpened);
+
+        StatusWith<RecordId> loc = rs.insertRecord(&txn, "abc", 4, false);
+        ASSERT_OK(loc.getStatus());
+        ASSERT_EQUALS(1, rs.numRecords(&txn));
+        ASSERT_EQUALS(std::string("abc"), rs.dataFor(&txn, loc.getValue()).data());
+        ASSERT_EQUALS(1, engine.numOpened);
+    }
+
+    TEST(KVLazyRecordStoreTest, SeesDataWrittenBeforeOpening) {
+        CountingKVEngine engine;
+        OperationContextNoop txn(engine.newRecoveryUnit());
+        ASSERT_OK(engine.createRecordStore(&txn, "db.coll", "ident", CollectionOptions()));
+
+        RecordId loc;
+        {
+            boost::scoped_ptr<RecordStore> eager(
+                engine.getRecordStore(&txn, "db.coll", "ident", CollectionOptions()));
+            StatusWith<RecordId> res = eager->insertRecord(&txn, "abc", 4, false);
+            ASSERT_OK(res.getStatus());
+            loc = res.getValue();
+        }
+
+        KVLazyRecordStore rs(&engine, "db.coll", "ident", CollectionOptions());
+        RecordData data;
+        ASSERT_TRUE(rs.findRecord(&txn, loc, &data));
+        ASSERT_EQUALS(std::string("abc"), data.data());
+        ASSERT_EQUALS(2, engine.numOpened);
+    }
+
+}
@@ -32,12 +32,19 @@
 
 #include "mongo/db/storage/kv/kv_storage_engine.h"
 
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/kv/kv_database_catalog_entry.h"
 #include "mongo/db/storage/kv/kv_engine.h"
+#include "mongo/db/storage/kv/kv_lazy_record_store.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -46,6 +53,38 @@ namespace mongo {
 
     namespace {
         const std::string catalogInfo = "_mdb_catalog";
+
+        /**
+         * A record store to open on startup, and where to put it once it is open.
+         */
+        struct RecordStoreToOpen {
+            std::string ns;
+            std::string ident;
+            CollectionOptions options;
+            RecordStore** out;
+        };
+
+        /**
+         * Opens every 'step'th record store of 'toOpen', starting with 'first'. May run on its own
+         * thread, so it uses its own recovery unit. Errors are returned through 'status'.
+         */
+        void openRecordStores( KVEngine* engine,
+                               const std::vector<RecordStoreToOpen>* toOpen,
+                               size_t first,
+                               size_t step,
+                               Status* status ) {
+            try {
+                OperationContextNoop opCtx( engine->newRecoveryUnit() );
+                for ( size_t i = first; i < toOpen->size(); i += step ) {
+                    const RecordStoreToOpen& next = (*toOpen)[i];
+                    *next.out = engine->getRecordStore( &opCtx, next.ns, next.ident, next.options );
+                    invariant( *next.out );
+                }
+            }
+            catch (const DBException& e) {
+                *status = e.toStatus();
+            }
+        }
     }
 
     class KVStorageEngine::RemoveDBChange : public RecoveryUnit::Change {
@@ -114,6 +153,12 @@ namespace mongo {
             std::vector<std::string> collections;
             _catalog->getAllCollections( &collections );
 
+            // Collections being repaired are opened once the repair is done.
+            std::vector<RecordStore*> recordStores( collections.size(), NULL );
+            if ( !options.forRepair ) {
+                _openRecordStores( &opCtx, collections, &recordStores );
+            }
+
             for ( size_t i = 0; i < collections.size(); i++ ) {
                 std::string coll = collections[i];
                 NamespaceString nss( coll );
@@ -125,7 +170,7 @@ namespace mongo {
                     db = new KVDatabaseCatalogEntry( dbName, this );
                 }
 
-                db->initCollection( &opCtx, coll, options.forRepair );
+                db->initCollection( coll, recordStores[i] );
             }
 
             uow.commit();
@@ -184,6 +229,76 @@ namespace mongo {
     KVStorageEngine::~KVStorageEngine() {
     }
 
+    void KVStorageEngine::_openRecordStores( OperationContext* opCtx,
+                                             const std::vector<std::string>& collections,
+                                             std::vector<RecordStore*>* out ) {
+        Timer timer;
+
+        // The catalog is read on this thread. Only opening the record stores is spread out.
+        std::vector<RecordStoreToOpen> toOpen;
+        size_t numLazy = 0;
+        for ( size_t i = 0; i < collections.size(); i++ ) {
+            RecordStoreToOpen next;
+            next.ns = collections[i];
+            next.ident = _catalog->getCollectionIdent( next.ns );
+            next.options = _catalog->getMetaData( opCtx, next.ns ).options;
+            next.out = &(*out)[i];
+
+            if ( _options.lazyRecordStores
+                 && !next.options.capped
+                 && !NamespaceString::oplog( next.ns ) ) {
+                *next.out = new KVLazyRecordStore( _engine.get(),
+                                                   next.ns,
+                                                   next.ident,
+                                                   next.options );
+                numLazy++;
+                continue;
+            }
+
+            toOpen.push_back( next );
+        }
+
+        const size_t maxThreads = std::max( 1, _options.openThreads );
+        const size_t numThreads = std::max( size_t(1), std::min( toOpen.size(), maxThreads ) );
+        std::vector<Status> statuses( numThreads, Status::OK() );
+        if ( numThreads == 1 ) {
+            openRecordStores( _engine.get(), &toOpen, 0, 1, &statuses[0] );
+        }
+        else {
+            std::vector<boost::shared_ptr<stdx::thread> > threads;
+            for ( size_t i = 0; i < numThreads; i++ ) {
+                threads.push_back( boost::shared_ptr<stdx::thread>(
+                    new stdx::thread( stdx::bind( &openRecordStores,
+                                                  _engine.get(),
+                                                  &toOpen,
+                                                  i,
+                                                  numThreads,
+                                                  &statuses[i] ) ) ) );
+            }
+            for ( size_t i = 0; i < threads.size(); i++ ) {
+                threads[i]->join();
+            }
+        }
+
+        for ( size_t i = 0; i < statuses.size(); i++ ) {
+            if ( statuses[i].isOK() ) {
+                continue;
+            }
+
+            for ( size_t j = 0; j < out->size(); j++ ) {
+                delete (*out)[j];
+                (*out)[j] = NULL;
+            }
+            uassertStatusOK( statuses[i] );
+        }
+
+        log() << "opened " << toOpen.size() << " record stores using " << numThreads
+              << " thread(s) in " << timer.millis() << "ms";
+        if ( numLazy ) {
+            log() << numLazy << " record stores will be opened on first use";
+        }
+    }
+
     void KVStorageEngine::finishInit() {
     }
 
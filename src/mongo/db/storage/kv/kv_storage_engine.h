@@ -50,11 +50,20 @@ namespace mongo {
         KVStorageEngineOptions() :
             directoryPerDB(false),
             directoryForIndexes(false),
-            forRepair(false) {}
+            forRepair(false),
+            openThreads(1),
+            lazyRecordStores(false) {}
 
         bool directoryPerDB;
         bool directoryForIndexes;
         bool forRepair;
+
+        // Number of threads opening the record stores of existing collections on startup.
+        int openThreads;
+
+        // Open the record stores of existing collections on first use. Capped collections, the
+        // oplog, and collections opened for repair are always opened up front.
+        bool lazyRecordStores;
     };
 
     class KVStorageEngine : public StorageEngine {
@@ -100,6 +109,15 @@ namespace mongo {
     private:
         class RemoveDBChange;
 
+        /**
+         * Opens the record stores of 'collections' on up to _options.openThreads threads, or wraps
+         * them to be opened on first use if _options.lazyRecordStores is set. out[i] is set to
+         * the record store of collections[i], and is owned by the caller.
+         */
+        void _openRecordStores( OperationContext* opCtx,
+                                const std::vector<std::string>& collections,
+                                std::vector<RecordStore*>* out );
+
         KVStorageEngineOptions _options;
 
         // This must be the first member so it is destroyed last.
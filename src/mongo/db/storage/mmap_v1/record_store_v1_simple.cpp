@@ -128,6 +128,53 @@ namespace mongo {
             *txn->recoveryUnit()->writing(&dr->nextDeleted()) = DiskLoc().setInvalid(); // defensive
         }
 
+        _splitDeletedRecord( txn, loc, lenToAlloc );
+        return loc;
+    }
+
+    DiskLoc SimpleRecordStoreV1::_allocFromDeletedRecordsBefore( OperationContext* txn,
+                                                                 int lenToAllocRaw,
+                                                                 const DiskLoc& limit ) {
+        // The deleted lists aren't ordered by location, so bound the search in each of them.
+        const int maxCandidatesPerBucket = 30;
+
+        // align size up to a multiple of 4
+        const int lenToAlloc = (lenToAllocRaw + (4-1)) & ~(4-1);
+
+        freelistAllocs.increment();
+        for (int myBucket = bucket(lenToAlloc); myBucket < Buckets; myBucket++) {
+            DiskLoc prev;
+            DiskLoc loc = _details->deletedListEntry(myBucket);
+            for (int n = 0; !loc.isNull() && n < maxCandidatesPerBucket; n++) {
+                freelistIterations.increment();
+                DeletedRecord* const candidate = drec(loc);
+                if (loc < limit && candidate->lengthWithHeaders() >= lenToAlloc) {
+                    // Unlink ourself from the deleted list
+                    if (prev.isNull()) {
+                        _details->setDeletedListEntry(txn, myBucket, candidate->nextDeleted());
+                    }
+                    else {
+                        *txn->recoveryUnit()->writing(&drec(prev)->nextDeleted()) =
+                            candidate->nextDeleted();
+                    }
+                    *txn->recoveryUnit()->writing(&candidate->nextDeleted()) =
+                        DiskLoc().setInvalid(); // defensive
+
+                    _splitDeletedRecord( txn, loc, lenToAlloc );
+                    return loc;
+                }
+                prev = loc;
+                loc = candidate->nextDeleted();
+            }
+        }
+
+        return DiskLoc(); // no space
+    }
+
+    void SimpleRecordStoreV1::_splitDeletedRecord( OperationContext* txn,
+                                                   const DiskLoc& loc,
+                                                   int lenToAlloc ) {
+        DeletedRecord* const dr = drec(loc);
         invariant( dr->extentOfs() < loc.getOfs() );
 
         // Split the deleted record if it has at least as much left over space as our smallest
@@ -143,8 +190,6 @@ namespace mongo {
 
             addDeletedRec(txn, newDelLoc);
         }
-
-        return loc;
     }
 
     StatusWith<DiskLoc> SimpleRecordStoreV1::allocRecord( OperationContext* txn,
@@ -490,4 +535,75 @@ namespace mongo {
         return Status::OK();
     }
 
+    StatusWith<RecordId> SimpleRecordStoreV1::relocateRecord( OperationContext* txn,
+                                                              const RecordId& loc,
+                                                              UpdateNotifier* notifier ) {
+        // system.indexes records are never reused, see deleteRecord().
+        if ( _isSystemIndexes )
+            return StatusWith<RecordId>( loc );
+
+        const DiskLoc oldLoc = DiskLoc::fromRecordId(loc);
+        Record* oldRecord = recordFor( oldLoc );
+
+        // Keep the record's allocation size, and with it any padding it has.
+        const DiskLoc newLoc = _allocFromDeletedRecordsBefore( txn,
+                                                               oldRecord->lengthWithHeaders(),
+                                                               oldLoc );
+        if ( newLoc.isNull() )
+            return StatusWith<RecordId>( loc );
+
+        const int dataSize = oldRecord->netLength();
+        Record* r = recordFor( newLoc );
+        invariant( r->netLength() >= dataSize );
+
+        // copy the data
+        r = reinterpret_cast<Record*>( txn->recoveryUnit()->writingPtr( r,
+                                                                        Record::HeaderSize +
+                                                                        dataSize ) );
+        memcpy( r->data(), oldRecord->data(), dataSize );
+
+        _addRecordToRecListInExtent(txn, r, newLoc);
+
+        _details->incrementStats( txn, r->netLength(), 1 );
+
+        if ( notifier ) {
+            Status moveStatus = notifier->recordStoreGoingToMove( txn,
+                                                                  loc,
+                                                                  oldRecord->data(),
+                                                                  dataSize );
+            if ( !moveStatus.isOK() )
+                return StatusWith<RecordId>( moveStatus );
+        }
+
+        deleteRecord( txn, loc );
+
+        // deleteRecord() put the old space at the head of its deleted list, where every later
+        // relocation would have to step over it. Park it in the legacy grab bag instead, until
+        // releaseRelocatedSpace() returns it to the deleted lists at the end of the pass.
+        DeletedRecord* const oldSpace = drec( oldLoc );
+        const int b = bucket( oldSpace->lengthWithHeaders() );
+        invariant( _details->deletedListEntry(b) == oldLoc );
+        _details->setDeletedListEntry( txn, b, oldSpace->nextDeleted() );
+        *txn->recoveryUnit()->writing(&oldSpace->nextDeleted()) =
+            _details->deletedListLegacyGrabBag();
+        _details->setDeletedListLegacyGrabBag( txn, oldLoc );
+
+        return StatusWith<RecordId>( newLoc.toRecordId() );
+    }
+
+    size_t SimpleRecordStoreV1::releaseRelocatedSpace( OperationContext* txn,
+                                                       size_t maxRecords ) {
+        // Ordinary allocations only drain one record from the grab bag each, which would leave
+        // most of the space a compaction freed unused for as many inserts.
+        size_t released = 0;
+        for ( ; released < maxRecords; ++released ) {
+            const DiskLoc head = _details->deletedListLegacyGrabBag();
+            if ( head.isNull() )
+                break;
+            _details->setDeletedListLegacyGrabBag( txn, drec( head )->nextDeleted() );
+            addDeletedRec( txn, head );
+        }
+        return released;
+    }
+
 }
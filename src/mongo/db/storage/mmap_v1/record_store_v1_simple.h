@@ -69,6 +69,12 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats );
 
+        virtual StatusWith<RecordId> relocateRecord( OperationContext* txn,
+                                                     const RecordId& loc,
+                                                     UpdateNotifier* notifier );
+
+        virtual size_t releaseRelocatedSpace( OperationContext* txn, size_t maxRecords );
+
     protected:
         virtual bool isCapped() const { return false; }
         virtual bool shouldPadInserts() const {
@@ -85,6 +91,21 @@ namespace mongo {
         DiskLoc _allocFromExistingExtents( OperationContext* txn,
                                            int lengthWithHeaders );
 
+        /**
+         * Like _allocFromExistingExtents, but only uses a DeletedRecord which comes before
+         * 'limit', and doesn't drain the legacy grab bag. Returns a null DiskLoc if the first
+         * few entries of each deleted list don't have one that fits.
+         */
+        DiskLoc _allocFromDeletedRecordsBefore( OperationContext* txn,
+                                                int lengthWithHeaders,
+                                                const DiskLoc& limit );
+
+        /**
+         * Gives the tail of the unlinked DeletedRecord at 'loc' back to the deleted lists, if
+         * enough is left over after taking 'lenToAlloc' bytes.
+         */
+        void _splitDeletedRecord( OperationContext* txn, const DiskLoc& loc, int lenToAlloc );
+
         void _compactExtent(OperationContext* txn,
                             const DiskLoc diskloc,
                             int extentNumber,
@@ -474,6 +474,230 @@ namespace {
         }
     }
 
+    /**
+     * relocateRecord() moves a record into an earlier DeletedRecord and parks the space it left
+     * in the legacy grab bag.
+     */
+    TEST(SimpleRecordStoreV1, RelocateIntoEarlierDeletedRecord) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 2000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 512},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+
+        StatusWith<RecordId> newLocation =
+            rs.relocateRecord(&txn, DiskLoc(0, 2000).toRecordId(), NULL);
+        ASSERT_OK( newLocation.getStatus() );
+        ASSERT_EQUALS( DiskLoc(0, 1000).toRecordId(), newLocation.getValue() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {}
+            };
+            LocAndSize grabBag[] = {
+                {DiskLoc(0, 2000), 512},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, grabBag, &em, md);
+        }
+    }
+
+    /**
+     * relocateRecord() skips over DeletedRecords which come after the record.
+     */
+    TEST(SimpleRecordStoreV1, RelocateSkipsLaterDeletedRecords) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 2000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 3000), 512},
+                {DiskLoc(0, 1000), 512},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+
+        StatusWith<RecordId> newLocation =
+            rs.relocateRecord(&txn, DiskLoc(0, 2000).toRecordId(), NULL);
+        ASSERT_OK( newLocation.getStatus() );
+        ASSERT_EQUALS( DiskLoc(0, 1000).toRecordId(), newLocation.getValue() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 3000), 512},
+                {}
+            };
+            LocAndSize grabBag[] = {
+                {DiskLoc(0, 2000), 512},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, grabBag, &em, md);
+        }
+    }
+
+    /**
+     * relocateRecord() splits a larger DeletedRecord, keeping the record's allocation size.
+     */
+    TEST(SimpleRecordStoreV1, RelocateSplitsDeletedRecord) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 3000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 1024},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+
+        StatusWith<RecordId> newLocation =
+            rs.relocateRecord(&txn, DiskLoc(0, 3000).toRecordId(), NULL);
+        ASSERT_OK( newLocation.getStatus() );
+        ASSERT_EQUALS( DiskLoc(0, 1000).toRecordId(), newLocation.getValue() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1512), 512},
+                {}
+            };
+            LocAndSize grabBag[] = {
+                {DiskLoc(0, 3000), 512},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, grabBag, &em, md);
+        }
+    }
+
+    /**
+     * relocateRecord() leaves the record alone if there is no earlier space that fits it.
+     */
+    TEST(SimpleRecordStoreV1, RelocateStaysPut) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        LocAndSize recs[] = {
+            {DiskLoc(0, 2000), 512},
+            {}
+        };
+        LocAndSize drecs[] = {
+            {DiskLoc(0, 1000), 256},
+            {DiskLoc(0, 3000), 512},
+            {}
+        };
+        initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+
+        StatusWith<RecordId> newLocation =
+            rs.relocateRecord(&txn, DiskLoc(0, 2000).toRecordId(), NULL);
+        ASSERT_OK( newLocation.getStatus() );
+        ASSERT_EQUALS( DiskLoc(0, 2000).toRecordId(), newLocation.getValue() );
+
+        assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+    }
+
+    /**
+     * releaseRelocatedSpace() returns all the space relocateRecord() parked in the grab bag to
+     * the deleted lists, where the next insert finds it.
+     */
+    TEST(SimpleRecordStoreV1, InsertReusesRelocatedSpace) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 3000), 512},
+                {DiskLoc(0, 4000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 512},
+                {DiskLoc(0, 2000), 512},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+
+        // Compactions move the last records first.
+        ASSERT_OK( rs.relocateRecord(&txn, DiskLoc(0, 4000).toRecordId(), NULL).getStatus() );
+        ASSERT_OK( rs.relocateRecord(&txn, DiskLoc(0, 3000).toRecordId(), NULL).getStatus() );
+
+        ASSERT_EQUALS( 1U, rs.releaseRelocatedSpace(&txn, 1) );
+        ASSERT_EQUALS( 1U, rs.releaseRelocatedSpace(&txn, 10) );
+        ASSERT_EQUALS( 0U, rs.releaseRelocatedSpace(&txn, 10) );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 512},
+                {DiskLoc(0, 2000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 4000), 512},
+                {DiskLoc(0, 3000), 512},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+
+        BsonDocWriter docWriter(docForRecordSize( 512 ), false);
+        StatusWith<RecordId> actualLocation = rs.insertRecord(&txn, &docWriter, false);
+        ASSERT_OK( actualLocation.getStatus() );
+        ASSERT_EQUALS( DiskLoc(0, 4000).toRecordId(), actualLocation.getValue() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 512},
+                {DiskLoc(0, 2000), 512},
+                {DiskLoc(0, 4000), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 3000), 512},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+    }
+
     // -----------------
 
     TEST( SimpleRecordStoreV1, FullSimple1 ) {
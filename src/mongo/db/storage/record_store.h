@@ -310,6 +310,29 @@ namespace mongo {
             invariant(false);
         }
 
+        /**
+         * Move the record at 'loc' into free space nearer the start of this RecordStore, if
+         * there is any that fits it, without growing the RecordStore. Returns the new location,
+         * or 'loc' if the record stays where it is. If the record moves, 'notifier' is told
+         * before the old copy is deleted.
+         *
+         * Only called if compactSupported() returns true and compactsInPlace() returns false.
+         */
+        virtual StatusWith<RecordId> relocateRecord( OperationContext* txn,
+                                                     const RecordId& loc,
+                                                     UpdateNotifier* notifier ) {
+            invariant(false);
+        }
+
+        /**
+         * Makes up to 'maxRecords' of the spaces that relocateRecord() left behind available to
+         * inserts again, and returns how many it made available. Called repeatedly once a pass
+         * of relocations is done, until it returns 0.
+         */
+        virtual size_t releaseRelocatedSpace( OperationContext* txn, size_t maxRecords ) {
+            return 0;
+        }
+
         /**
          * @param full - does more checks
          * @param scanData - scans each document
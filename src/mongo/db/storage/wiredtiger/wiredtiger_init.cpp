@@ -74,6 +74,8 @@ namespace mongo {
                 options.directoryPerDB = params.directoryperdb;
                 options.directoryForIndexes = wiredTigerGlobalOptions.directoryForIndexes;
                 options.forRepair = params.repair;
+                options.openThreads = params.startupLoadThreads;
+                options.lazyRecordStores = params.lazyOpenRecordStores;
                 return new KVStorageEngine( kv, options );
             }
 
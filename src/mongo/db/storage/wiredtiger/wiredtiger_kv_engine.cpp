@@ -440,7 +440,7 @@ namespace mongo {
                 continue;
 
             StringData ident = key.substr(idx+1);
-            if ( ident == "sizeStorer" )
+            if ( ident == "sizeStorer" || ident == WiredTigerSessionCache::kJournalFlushIdent )
                 continue;
 
             all.push_back( ident.toString() );
@@ -31,6 +31,8 @@
 #include "mongo/platform/basic.h"
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/barrier.hpp>
 #include <sstream>
 #include <string>
 
@@ -46,6 +48,9 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 
@@ -887,4 +892,83 @@ namespace {
         ASSERT_TRUE(it->isEOF());
     }
 
+    TEST(WiredTigerRecordStoreTest, WaitUntilDurableOnlyFlushesNewCommits) {
+        WiredTigerHarnessHelper harnessHelper("log=(enabled)");
+        scoped_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore("a.b"));
+
+        scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+        WiredTigerSessionCache* sessionCache =
+            WiredTigerRecoveryUnit::get(opCtx.get())->getSessionCache();
+
+        // Flush the creation of the record store, after which there is nothing left to flush.
+        sessionCache->waitUntilDurable();
+        ASSERT_FALSE(sessionCache->waitUntilDurable());
+
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            ASSERT_OK(rs->insertRecord(opCtx.get(), "a", 2, false).getStatus());
+            uow.commit();
+        }
+        ASSERT_TRUE(sessionCache->waitUntilDurable());
+        ASSERT_FALSE(sessionCache->waitUntilDurable());
+        ASSERT_TRUE(opCtx->recoveryUnit()->waitUntilDurable());
+    }
+
+    namespace {
+        const int kNumDurableRounds = 20;
+
+        void insertAndWaitUntilDurable(WiredTigerHarnessHelper* harnessHelper,
+                                       RecordStore* rs,
+                                       boost::barrier* barrier,
+                                       AtomicUInt32* numFlushes) {
+            scoped_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+            for (int i = 0; i < kNumDurableRounds; i++) {
+                {
+                    WriteUnitOfWork uow(opCtx.get());
+                    ASSERT_OK(rs->insertRecord(opCtx.get(), "a", 2, false).getStatus());
+                    uow.commit();
+                }
+                // Every thread has committed before any of them waits, so the first flush of
+                // the round covers all of the round's commits.
+                barrier->wait();
+                WiredTigerSessionCache* sessionCache =
+                    WiredTigerRecoveryUnit::get(opCtx.get())->getSessionCache();
+                if (sessionCache->waitUntilDurable()) {
+                    numFlushes->fetchAndAdd(1);
+                }
+                barrier->wait();
+            }
+        }
+    }
+
+    TEST(WiredTigerRecordStoreTest, WaitUntilDurableConcurrently) {
+        WiredTigerHarnessHelper harnessHelper("log=(enabled)");
+        scoped_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore("a.b"));
+
+        const int numThreads = 8;
+        boost::barrier barrier(numThreads);
+        AtomicUInt32 numFlushes;
+        std::vector<boost::shared_ptr<stdx::thread> > threads;
+        for (int i = 0; i < numThreads; i++) {
+            threads.push_back(boost::shared_ptr<stdx::thread>(
+                new stdx::thread(stdx::bind(&insertAndWaitUntilDurable,
+                                            &harnessHelper,
+                                            rs.get(),
+                                            &barrier,
+                                            &numFlushes))));
+        }
+        for (int i = 0; i < numThreads; i++) {
+            threads[i]->join();
+        }
+
+        scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+        ASSERT_EQUALS(numThreads * kNumDurableRounds, rs->numRecords(opCtx.get()));
+
+        // The callers of each round shared a single flush.
+        ASSERT_EQUALS(static_cast<unsigned>(kNumDurableRounds), numFlushes.load());
+        WiredTigerSessionCache* sessionCache =
+            WiredTigerRecoveryUnit::get(opCtx.get())->getSessionCache();
+        ASSERT_FALSE(sessionCache->waitUntilDurable());
+    }
+
 }  // namespace mongo
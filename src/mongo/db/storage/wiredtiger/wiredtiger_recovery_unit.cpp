@@ -30,9 +30,6 @@
 
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
 
-#include <boost/thread/condition.hpp>
-#include <boost/thread/mutex.hpp>
-
 #include "mongo/base/checked_cast.h"
 #include "mongo/base/init.h"
 #include "mongo/bson/bsonobjbuilder.h"
@@ -49,34 +46,9 @@
 namespace mongo {
 
     namespace {
-        struct WaitUntilDurableData {
-            WaitUntilDurableData() :
-                numWaitingForSync(0),
-                lastSyncTime(0) {
-            }
-
-            void syncHappend() {
-                boost::lock_guard<boost::mutex> lk( mutex );
-                lastSyncTime++;
-                condvar.notify_all();
-            }
-
-            // return true if happened
-            bool waitUntilDurable() {
-                boost::unique_lock<boost::mutex> lk( mutex );
-                long long start = lastSyncTime;
-                numWaitingForSync.fetchAndAdd(1);
-                condvar.timed_wait(lk,boost::posix_time::milliseconds(50));
-                numWaitingForSync.fetchAndAdd(-1);
-                return lastSyncTime > start;
-            }
-
-            AtomicUInt32 numWaitingForSync;
-
-            boost::mutex mutex; // this just protects lastSyncTime
-            boost::condition condvar;
-            long long lastSyncTime;
-        } waitUntilDurableData;
+        // Calls to waitUntilDurable(), and how many of them flushed the journal themselves.
+        AtomicUInt64 numDurableWaits;
+        AtomicUInt64 numJournalFlushes;
     }
 
     WiredTigerRecoveryUnit::WiredTigerRecoveryUnit(WiredTigerSessionCache* sc) :
@@ -87,7 +59,6 @@ namespace mongo {
         _myTransactionCount( 1 ),
         _everStartedWrite( false ),
         _currentlySquirreled( false ),
-        _syncing( false ),
         _noTicketNeeded( false ) {
     }
 
@@ -171,20 +142,15 @@ namespace mongo {
     }
 
     void WiredTigerRecoveryUnit::goingToWaitUntilDurable() {
-        if ( _active ) {
-            // too late, can't change config
-            return;
-        }
-        // yay, we've configured ourselves for sync
-        _syncing = true;
+        // Transactions aren't synced when they commit. waitUntilDurable() flushes the journal
+        // once for all of the callers waiting at the same time instead.
     }
 
     bool WiredTigerRecoveryUnit::waitUntilDurable() {
-        if ( _syncing && _everStartedWrite ) {
-            // we did a sync, so we're good
-            return true;
+        numDurableWaits.fetchAndAdd(1);
+        if ( _sessionCache->waitUntilDurable() ) {
+            numJournalFlushes.fetchAndAdd(1);
         }
-        waitUntilDurableData.waitUntilDurable();
         return true;
     }
 
@@ -298,6 +264,11 @@ namespace mongo {
             bbb.done();
         }
         bb.done();
+
+        BSONObjBuilder groupCommit(b.subobjStart("groupCommit"));
+        groupCommit.appendNumber("waits", static_cast<long long>(numDurableWaits.load()));
+        groupCommit.appendNumber("flushes", static_cast<long long>(numJournalFlushes.load()));
+        groupCommit.done();
     }
 
     void WiredTigerRecoveryUnit::_txnClose( bool commit ) {
@@ -306,8 +277,8 @@ namespace mongo {
         if ( commit ) {
             invariantWTOK( s->commit_transaction(s, NULL) );
             LOG(2) << "WT commit_transaction";
-            if ( _syncing )
-                waitUntilDurableData.syncHappend();
+            if ( _everStartedWrite )
+                _sessionCache->noteCommit();
         }
         else {
             invariantWTOK( s->rollback_transaction(s, NULL) );
@@ -360,8 +331,7 @@ namespace mongo {
         _getTicket(opCtx);
 
         WT_SESSION *s = _session->getSession();
-        _syncing = _syncing || waitUntilDurableData.numWaitingForSync.load() > 0;
-        invariantWTOK( s->begin_transaction(s, _syncing ? "sync=true" : NULL) );
+        invariantWTOK( s->begin_transaction(s, NULL) );
         LOG(2) << "WT begin_transaction";
         _timer.reset();
         _active = true;
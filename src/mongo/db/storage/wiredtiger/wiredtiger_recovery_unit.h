@@ -112,7 +112,6 @@ namespace mongo {
         bool _everStartedWrite;
         Timer _timer;
         bool _currentlySquirreled;
-        bool _syncing;
         RecordId _oplogReadTill;
 
         typedef OwnedPointerVector<Change> Changes;
@@ -38,6 +38,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -123,14 +124,32 @@ namespace mongo {
 
     // -----------------------
 
-    WiredTigerSessionCache::WiredTigerSessionCache( WiredTigerKVEngine* engine )
-        : _engine( engine ), _conn( engine->getConnection() ), _shuttingDown(0) {
+    const char WiredTigerSessionCache::kJournalFlushIdent[] = "journalFlush";
 
+    WiredTigerSessionCache::WiredTigerSessionCache( WiredTigerKVEngine* engine )
+        : _engine( engine ),
+          _conn( engine->getConnection() ),
+          _shuttingDown(0),
+          _flushGeneration(0),
+          _flushing(false),
+          _flushTarget(0),
+          _durableCommitCount(0),
+          _flushTableCreated(false),
+          _flushCursorId(WiredTigerSession::genCursorId()) {
+        _numWaiting[0] = _numWaiting[1] = 0;
     }
 
     WiredTigerSessionCache::WiredTigerSessionCache( WT_CONNECTION* conn )
-        : _engine( NULL ), _conn( conn ), _shuttingDown(0) {
-
+        : _engine( NULL ),
+          _conn( conn ),
+          _shuttingDown(0),
+          _flushGeneration(0),
+          _flushing(false),
+          _flushTarget(0),
+          _durableCommitCount(0),
+          _flushTableCreated(false),
+          _flushCursorId(WiredTigerSession::genCursorId()) {
+        _numWaiting[0] = _numWaiting[1] = 0;
     }
 
     WiredTigerSessionCache::~WiredTigerSessionCache() {
@@ -177,6 +196,10 @@ namespace mongo {
         // operations should be allowed to start.
         invariant(!_shuttingDown.loadRelaxed());
 
+        return _getSession();
+    }
+
+    WiredTigerSession* WiredTigerSessionCache::_getSession() {
         // Spread sessions uniformly across the cache partitions
         const int cachePartition = cachePartitionGen.addAndFetch(1) % NumSessionCachePartitions;
 
@@ -243,4 +266,93 @@ namespace mongo {
             _engine->dropAllQueued();
         }
     }
+
+    bool WiredTigerSessionCache::waitUntilDurable() {
+        // Without a journal there is nothing to wait for.
+        if ( _engine && !_engine->isDurable() ) {
+            return false;
+        }
+
+        const uint64_t target = _commitCount.load();
+
+        boost::unique_lock<boost::mutex> lk( _flushMutex );
+        if ( _durableCommitCount >= target ) {
+            return false;
+        }
+
+        // The flush which covers our commits: the running one if it started after them,
+        // otherwise the next one.
+        const uint64_t myFlush = ( _flushing && _flushTarget >= target ) ? _flushGeneration
+                                                                         : _flushGeneration + 1;
+        bool flushed = false;
+        while ( _completedFlush() < myFlush ) {
+            if ( !_flushing ) {
+                invariant( myFlush == _flushGeneration + 1 );
+                _flushGeneration = myFlush;
+                _flushing = true;
+                _flushTarget = _commitCount.load();
+                const uint64_t flushTarget = _flushTarget;
+
+                lk.unlock();
+                const bool wrote = _flushJournal( myFlush );
+                lk.lock();
+
+                if ( wrote ) {
+                    _durableCommitCount = std::max( _durableCommitCount, flushTarget );
+                }
+                _flushing = false;
+                flushed = wrote;
+
+                _flushDone[myFlush % 2].notify_all();
+                if ( _numWaiting[(myFlush + 1) % 2] > 0 ) {
+                    // Some callers need the next flush. Wake one of them to start it.
+                    _flushDone[(myFlush + 1) % 2].notify_one();
+                }
+                continue;
+            }
+
+            _numWaiting[myFlush % 2]++;
+            _flushDone[myFlush % 2].wait( lk );
+            _numWaiting[myFlush % 2]--;
+        }
+
+        return flushed;
+    }
+
+    bool WiredTigerSessionCache::_flushJournal( uint64_t generation ) {
+        WiredTigerSession* session;
+        {
+            // getSession() would hit its invariant if shutdown has already started, so check
+            // the flag and take the session under the same hold of the lock.
+            boost::shared_lock<boost::shared_mutex> shutdownLock(_shutdownLock);
+            if (_shuttingDown.loadRelaxed()) {
+                return false;
+            }
+            session = _getSession();
+        }
+        ON_BLOCK_EXIT( &WiredTigerSessionCache::releaseSession, this, session );
+        WT_SESSION* s = session->getSession();
+
+        const std::string uri = std::string( "table:" ) + kJournalFlushIdent;
+
+        // Only one flush runs at a time, so this doesn't need _flushMutex.
+        if ( !_flushTableCreated ) {
+            invariantWTOK( s->create( s, uri.c_str(), "key_format=q,value_format=q" ) );
+            _flushTableCreated = true;
+        }
+
+        WT_CURSOR* c = session->getCursor( uri, _flushCursorId, true );
+        invariant( c );
+        invariantWTOK( s->begin_transaction( s, "sync=true" ) );
+        c->set_key( c, static_cast<int64_t>( 1 ) );
+        c->set_value( c, static_cast<int64_t>( generation ) );
+        int ret = c->insert( c );
+        session->releaseCursor( _flushCursorId, c );
+        if ( ret != 0 ) {
+            invariantWTOK( s->rollback_transaction( s, NULL ) );
+            invariantWTOK( ret );
+        }
+        invariantWTOK( s->commit_transaction( s, NULL ) );
+        return true;
+    }
 }
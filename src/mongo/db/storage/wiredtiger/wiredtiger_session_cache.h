@@ -35,6 +35,7 @@
 #include <string>
 #include <vector>
 
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
@@ -122,6 +123,30 @@ namespace mongo {
 
         WT_CONNECTION* conn() const { return _conn; }
 
+        /**
+         * Records that a transaction which may have written to the journal has committed.
+         */
+        void noteCommit() { _commitCount.fetchAndAdd(1); }
+
+        /**
+         * Waits until the journal on disk holds every transaction committed before this call.
+         *
+         * Callers share flushes of the journal. If no flush is running, the caller starts one
+         * right away. Callers whose commits are covered by the running flush wait for it, and
+         * the others wait for the next one, which one of them starts as soon as the running one
+         * is done. Each finished flush only wakes the callers it covers.
+         *
+         * Returns true if the caller flushed the journal itself. Once shutdown has started no
+         * flush is written, and callers return without the journal having been synced.
+         */
+        bool waitUntilDurable();
+
+        /**
+         * The ident of the table written by waitUntilDurable(). It doesn't belong to any
+         * collection or index.
+         */
+        static const char kJournalFlushIdent[];
+
     private:
         typedef std::vector<WiredTigerSession*> SessionPool;
 
@@ -152,6 +177,44 @@ namespace mongo {
         // sessions to the cache would leak them.
         boost::shared_mutex _shutdownLock;
         AtomicUInt32 _shuttingDown; // Used as boolean - 0 = false, 1 = true
+
+        /**
+         * Does the work of getSession(). The caller must hold _shutdownLock and have checked
+         * that the cache isn't shutting down.
+         */
+        WiredTigerSession* _getSession();
+
+        /**
+         * Commits a synchronous write to a small internal table, which makes WiredTiger sync the
+         * journal up to and including that write. 'generation' is the value written.
+         *
+         * Returns false without writing anything if the cache is shutting down. WiredTiger syncs
+         * the journal itself when the connection is closed.
+         */
+        bool _flushJournal( uint64_t generation );
+
+        // Generation of the last flush which has finished.
+        uint64_t _completedFlush() const { return _flushing ? _flushGeneration - 1
+                                                            : _flushGeneration; }
+
+        // Number of noteCommit() calls so far.
+        AtomicUInt64 _commitCount;
+
+        // Protects the group commit state below.
+        boost::mutex _flushMutex;
+
+        // Callers waiting for flush generation g wait on _flushDone[g % 2]. Only the running and
+        // the next flush can have waiters.
+        boost::condition_variable _flushDone[2];
+        int _numWaiting[2];
+
+        uint64_t _flushGeneration; // The last flush started.
+        bool _flushing; // Whether flush _flushGeneration is still running.
+        uint64_t _flushTarget; // The _commitCount covered by the running flush.
+        uint64_t _durableCommitCount; // The _commitCount covered by finished flushes.
+
+        bool _flushTableCreated;
+        const uint64_t _flushCursorId;
     };
 
 }
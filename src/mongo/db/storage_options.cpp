@@ -69,4 +69,25 @@ namespace mongo {
                                                      true,
                                                      true);
 
+    /**
+     * The number of threads used at startup to open the record stores of all collections and then
+     * all databases. Can only be set at startup.
+     */
+    ExportedServerParameter<int> StartupLoadThreadsSetting(ServerParameterSet::getGlobal(),
+                                                           "startupLoadThreads",
+                                                           &storageGlobalParams.startupLoadThreads,
+                                                           true,
+                                                           false);
+
+    /**
+     * If true, KV storage engines open the record store of a collection on its first use rather
+     * than at startup. Can only be set at startup.
+     */
+    ExportedServerParameter<bool> LazyOpenRecordStoresSetting(
+                                                    ServerParameterSet::getGlobal(),
+                                                    "lazyOpenRecordStores",
+                                                    &storageGlobalParams.lazyOpenRecordStores,
+                                                    true,
+                                                    false);
+
 } // namespace mongo
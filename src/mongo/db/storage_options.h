@@ -55,7 +55,9 @@ namespace mongo {
             repair(false),
             noTableScan(false),
             directoryperdb(false),
-            syncdelay(60.0) {
+            syncdelay(60.0),
+            startupLoadThreads(4),
+            lazyOpenRecordStores(false) {
             dur = false;
             if (sizeof(void*) == 8)
                 dur = true;
@@ -102,6 +104,17 @@ namespace mongo {
         // Do not set this value on production systems.
         // In almost every situation, you should use the default setting.
         double syncdelay;      // seconds between fsyncs
+
+        // --setParameter startupLoadThreads
+        // The number of threads which open databases and collections at startup. Values below 1
+        // are treated as 1, which opens them one at a time.
+        int startupLoadThreads;
+
+        // --setParameter lazyOpenRecordStores
+        // Defers opening the record store of each collection until it is first used, instead of
+        // opening all of them at startup. Only applies to KV storage engines, and never to capped
+        // collections or the oplog.
+        bool lazyOpenRecordStores;
     };
 
     extern StorageGlobalParams storageGlobalParams;
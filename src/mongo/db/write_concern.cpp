@@ -38,6 +38,7 @@
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/stats/histogram_stats.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/write_concern_options.h"
@@ -55,6 +56,12 @@ namespace mongo {
     static ServerStatusMetricField<Counter64> gleWtimeoutsDisplay("getLastError.wtimeouts",
                                                                   &gleWtimeouts );
 
+    // Time writes with j: true spent waiting for the journal, in microseconds.
+    static HistogramStats gleJournalStats;
+    static ServerStatusMetricField<HistogramStats> displayGleJournalLatency(
+                                                        "getLastError.journalMicros",
+                                                        &gleJournalStats );
+
     void setupSynchronousCommit(OperationContext* txn) {
         const WriteConcernOptions& writeConcern = txn->getWriteConcern();
 
@@ -236,10 +243,13 @@ namespace mongo {
             }
             break;
         }
-        case WriteConcernOptions::JOURNAL:
+        case WriteConcernOptions::JOURNAL: {
+            Timer journalTimer;
             txn->recoveryUnit()->waitUntilDurable();
+            gleJournalStats.record(journalTimer.micros());
             break;
         }
+        }
 
         result->syncMillis = syncTimer.millis();
 
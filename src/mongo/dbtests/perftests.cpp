@@ -43,18 +43,26 @@
 #include <boost/thread/thread.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/version.hpp>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
 #include <mutex>
 
+#include "mongo/bson/bson_validate.h"
 #include "mongo/config.h"
+#include "mongo/db/auth/authorization_manager.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/auth/authz_manager_external_state_mock.h"
+#include "mongo/db/auth/authz_session_external_state_mock.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/json.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/mmap_v1/btree/key.h"
 #include "mongo/db/storage/mmap_v1/compress.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
@@ -63,6 +71,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/dbtests/framework_options.h"
+#include "mongo/platform/random.h"
 #include "mongo/util/allocator.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/fail_point.h"
@@ -479,6 +488,188 @@ namespace PerfTests {
         }
     };
 
+    /** validating a corpus of documents shaped like typical application data, about 5KB each */
+    class BSONValidate : public NonDurTest {
+    public:
+        int n;
+        string name() { return "BSONValidate"; }
+        BSONValidate() : n(0), _i(0) {
+            PseudoRandom r(5);
+            for ( int d = 0; d < 16; d++ ) {
+                BSONObjBuilder b;
+                b.append( "_id", OID::gen() );
+                b.append( "userName", str::stream() << "user" << r.nextInt32() );
+                b.append( "email", str::stream() << "someone" << d << "@example.com" );
+                b.appendDate( "created", Date_t::fromMillisSinceEpoch( r.nextInt64() >> 20 ) );
+                b.append( "active", d % 3 != 0 );
+                {
+                    BSONObjBuilder address( b.subobjStart( "address" ) );
+                    address.append( "street", "1633 Broadway" );
+                    address.append( "city", "New York" );
+                    address.append( "zip", 10019 );
+                    address.append( "geo", BSON_ARRAY( -73.98 << 40.76 ) );
+                }
+                {
+                    BSONArrayBuilder events( b.subarrayStart( "events" ) );
+                    for ( int e = 0; e < 40; e++ ) {
+                        BSONObjBuilder event( events.subobjStart() );
+                        event.append( "type", e % 2 ? "click" : "view" );
+                        event.appendDate( "at", Date_t::fromMillisSinceEpoch( e * 1000LL ) );
+                        event.append( "durationMillis", r.nextInt32( 10000 ) );
+                        event.append( "score", r.nextInt32( 1000 ) / 7.0 );
+                        event.append( "page", str::stream() << "/products/item-" << r.nextInt32() );
+                        event.append( "tags", BSON_ARRAY( "a" << "bb" << "ccc" ) );
+                    }
+                }
+                b.appendBinData( "thumbnail", 256, BinDataGeneral, string( 256, 'x' ).c_str() );
+                b.append( "notes", string( 300 + r.nextInt32( 200 ), 'n' ) );
+                _docs.push_back( b.obj() );
+            }
+        }
+        void timed() {
+            const BSONObj& doc = _docs[_i++ % _docs.size()];
+            if ( validateBSON( doc.objdata(), doc.objsize() ).isOK() )
+                n++;
+        }
+    private:
+        vector<BSONObj> _docs;
+        unsigned _i;
+    };
+
+    /** matching documents against an $in with a large list of values */
+    template <int N>
+    class InMatch : public NonDurTest {
+    public:
+        int n;
+        string name() { return str::stream() << "InMatch" << N; }
+        InMatch() : n(0), _i(0) {
+            BSONArrayBuilder in;
+            for ( int i = 0; i < N; i++ ) {
+                in.append( i * 2 );
+            }
+            _query = BSON( "x" << BSON( "$in" << in.arr() ) );
+
+            StatusWithMatchExpression status = MatchExpressionParser::parse( _query );
+            verify( status.isOK() );
+            _expr.reset( status.getValue() );
+
+            for ( int i = 0; i < 16; i++ ) {
+                // alternate between hits and misses, and int and double values
+                _docs.push_back( i % 2 ? BSON( "x" << ( i * N / 8 ) ) :
+                                         BSON( "x" << ( i * N / 8 + 1.0 ) ) );
+            }
+        }
+        void timed() {
+            if ( _expr->matchesBSON( _docs[_i++ % _docs.size()] ) )
+                n++;
+        }
+    private:
+        BSONObj _query;
+        boost::scoped_ptr<MatchExpression> _expr;
+        vector<BSONObj> _docs;
+        unsigned _i;
+    };
+
+    /** a conjunction over several top level fields of documents with 200 fields each */
+    class AndMatchWide : public NonDurTest {
+    public:
+        int n;
+        string name() { return "AndMatchWide"; }
+        AndMatchWide() : n(0), _i(0) {
+            _query = BSON( "f10" << 10 <<
+                           "f190" << BSON( "$gte" << 0 ) <<
+                           "f50" << BSON( "$in" << BSON_ARRAY( 50 << 51 ) ) <<
+                           "f150" << BSON( "$exists" << true ) <<
+                           "f100" << BSON( "$lt" << 1000 ) );
+
+            StatusWithMatchExpression status = MatchExpressionParser::parse( _query );
+            verify( status.isOK() );
+            _expr.reset( status.getValue() );
+
+            for ( int d = 0; d < 16; d++ ) {
+                BSONObjBuilder b;
+                for ( int f = 0; f < 200; f++ ) {
+                    // every fourth document misses on its last clause
+                    const int value = ( d % 4 == 0 && f == 100 ) ? 2000 : f;
+                    b.append( string( str::stream() << "f" << f ), value );
+                }
+                _docs.push_back( b.obj() );
+            }
+        }
+        void timed() {
+            if ( _expr->matchesBSON( _docs[_i++ % _docs.size()] ) )
+                n++;
+        }
+    private:
+        BSONObj _query;
+        boost::scoped_ptr<MatchExpression> _expr;
+        vector<BSONObj> _docs;
+        unsigned _i;
+    };
+
+    /**
+     * Authorization checks of one operation: two checks on a namespace, made by a session with 4
+     * users who hold 75 roles each.
+     */
+    class AuthzManyUsersManyRoles : public NonDurTest {
+    public:
+        string name() { return "AuthzManyUsersManyRoles"; }
+        AuthzManyUsersManyRoles() : _i(0) {
+            std::unique_ptr<AuthzManagerExternalStateMock> managerState(
+                    new AuthzManagerExternalStateMock());
+            AuthzManagerExternalStateMock* rawManagerState = managerState.get();
+            rawManagerState->setAuthzVersion(AuthorizationManager::schemaVersion26Final);
+            _authzManager.reset(new AuthorizationManager(std::move(managerState)));
+            _authzSession.reset(new AuthorizationSession(
+                    std::unique_ptr<AuthzSessionExternalState>(
+                            new AuthzSessionExternalStateMock(_authzManager.get()))));
+            _authzManager->setAuthEnabled(true);
+
+            // Each user holds read, readWrite and dbAdmin on 25 databases.
+            BSONArrayBuilder roles;
+            for ( int db = 0; db < 25; db++ ) {
+                const string dbName = str::stream() << "db" << db;
+                roles.append( BSON( "role" << "read" << "db" << dbName ) );
+                roles.append( BSON( "role" << "readWrite" << "db" << dbName ) );
+                roles.append( BSON( "role" << "dbAdmin" << "db" << dbName ) );
+            }
+            const BSONArray rolesArray = roles.arr();
+
+            for ( int u = 0; u < 4; u++ ) {
+                const string dbName = str::stream() << "userdb" << u;
+                verify( rawManagerState->insertPrivilegeDocument(
+                                &_txn,
+                                BSON( "user" << "user" <<
+                                      "db" << dbName <<
+                                      "credentials" << BSON( "MONGODB-CR" << "a" ) <<
+                                      "roles" << rolesArray ),
+                                BSONObj() ).isOK() );
+                verify( _authzSession->addAndAuthorizeUser( &_txn,
+                                                            UserName( "user", dbName ) ).isOK() );
+            }
+
+            _namespaces.push_back( NamespaceString( "db0.foo" ) );
+            _namespaces.push_back( NamespaceString( "db12.bar" ) );
+            _namespaces.push_back( NamespaceString( "db24.baz" ) );
+            _namespaces.push_back( NamespaceString( "unknown.foo" ) );
+        }
+        void timed() {
+            _authzSession->startRequest( &_txn );
+            const NamespaceString& ns = _namespaces[_i++ % _namespaces.size()];
+            const bool expected = ns.db() != "unknown";
+            verify( _authzSession->isAuthorizedForActionsOnNamespace( ns, ActionType::find )
+                    == expected );
+            verify( _authzSession->isAuthorizedForActionsOnNamespace( ns, ActionType::insert )
+                    == expected );
+        }
+    private:
+        OperationContextNoop _txn;
+        std::unique_ptr<AuthorizationManager> _authzManager;
+        std::unique_ptr<AuthorizationSession> _authzSession;
+        vector<NamespaceString> _namespaces;
+        unsigned _i;
+    };
+
     class KeyTest : public B {
     public:
         KeyV1Owned a,b,c;
@@ -1161,6 +1352,45 @@ namespace PerfTests {
         }
     };
 
+    /** finds N random documents by _id with a single {_id: {$in: [...]}} query */
+    template <int N>
+    class IdMultiGet : public B {
+    public:
+        enum { NumDocs = 20000 };
+        virtual unsigned batchSize() { return 1; }
+        string name() { return str::stream() << "find-by-_id-$in-" << N; }
+        void prep() {
+            // Insert in a random order so that _id order differs from storage order.
+            vector<int> ids;
+            for (int i = 0; i < NumDocs; i++) {
+                ids.push_back(i);
+            }
+            std::random_shuffle(ids.begin(), ids.end());
+            for (int i = 0; i < NumDocs; i++) {
+                client()->insert(ns(), BSON("_id" << ids[i] << "x" << i << "y" << "some text"));
+            }
+
+            for (int q = 0; q < 8; q++) {
+                BSONArrayBuilder in;
+                for (int i = 0; i < N; i++) {
+                    in.append(std::rand() % NumDocs);
+                }
+                _queries.push_back(BSON("_id" << BSON("$in" << in.arr())));
+            }
+            _i = 0;
+        }
+        void timed() {
+            std::auto_ptr<DBClientCursor> c =
+                client()->query(ns(), Query(_queries[_i++ % _queries.size()]));
+            while (c->more()) {
+                c->nextSafe();
+            }
+        }
+    private:
+        vector<BSONObj> _queries;
+        unsigned _i;
+    };
+
     /** upserts about 32k records and then keeps updating them
         2 indexes
     */
@@ -1463,6 +1693,11 @@ namespace PerfTests {
                 add< BSONIter >();
                 add< BSONGetFields1 >();
                 add< BSONGetFields2 >();
+                add< BSONValidate >();
+                add< InMatch<10000> >();
+                add< InMatch<100000> >();
+                add< AndMatchWide >();
+                add< AuthzManyUsersManyRoles >();
                 //add< TaskQueueTest >();
                 add< InsertDup >();
                 add< Insert1 >();
@@ -1470,6 +1705,8 @@ namespace PerfTests {
                 add< MoreIndexes<InsertRandom> >();
                 add< Update1 >();
                 add< MoreIndexes<Update1> >();
+                add< IdMultiGet<1000> >();
+                add< IdMultiGet<10000> >();
                 add< InsertBig >();
                 add< FailPointTest<false, false> >();
                 add< FailPointTest<true, false> >();
@@ -290,6 +290,104 @@ namespace PipelineTests {
 
             } // namespace limitFieldsSentFromShardsToMerger
         } // namespace Sharded
+
+        namespace Parallel {
+            class Base {
+            public:
+                // These all return json arrays of pipeline operators
+                virtual string inputPipeJson() = 0;
+                virtual string partitionPipeJson() = 0; // "" if the pipeline can't be split
+                virtual string mergePipeJson() = 0;
+
+                BSONObj pipelineFromJsonArray(const string& array) {
+                    return fromjson("{pipeline: " + array + "}");
+                }
+                virtual void run() {
+                    const BSONObj inputBson = pipelineFromJsonArray(inputPipeJson());
+                    const BSONObj mergePipeExpected = pipelineFromJsonArray(mergePipeJson());
+
+                    intrusive_ptr<ExpressionContext> ctx =
+                        new ExpressionContext(&_opCtx, NamespaceString("a.collection"));
+                    string errmsg;
+                    intrusive_ptr<Pipeline> mergePipe =
+                        Pipeline::parseCommand(errmsg, inputBson, ctx);
+                    ASSERT_EQUALS(errmsg, "");
+                    ASSERT(mergePipe != NULL);
+
+                    intrusive_ptr<Pipeline> partitionPipe = mergePipe->splitForParallel();
+                    if (partitionPipeJson().empty()) {
+                        ASSERT(partitionPipe == NULL);
+                    }
+                    else {
+                        const BSONObj partitionPipeExpected =
+                            pipelineFromJsonArray(partitionPipeJson());
+                        ASSERT(partitionPipe != NULL);
+                        ASSERT_EQUALS(partitionPipe->serialize()["pipeline"],
+                                      Value(partitionPipeExpected["pipeline"]));
+                    }
+                    ASSERT_EQUALS(mergePipe->serialize()["pipeline"],
+                                  Value(mergePipeExpected["pipeline"]));
+                }
+
+                virtual ~Base() {}
+
+            private:
+                OperationContextImpl _opCtx;
+            };
+
+            class Empty : public Base {
+                string inputPipeJson() { return "[]"; }
+                string partitionPipeJson() { return ""; }
+                string mergePipeJson() { return "[]"; }
+            };
+
+            class StreamingStages : public Base {
+                string inputPipeJson() { return "[{$match: {a: 1}}, {$unwind: '$b'}]"; }
+                string partitionPipeJson() { return "[{$match: {a: 1}}, {$unwind: '$b'}]"; }
+                string mergePipeJson() { return "[]"; }
+            };
+
+            class SplitGroup : public Base {
+                string inputPipeJson() {
+                    return "[{$unwind: '$b'}"
+                           ",{$group: {_id: '$b', n: {$sum: '$c'}}}"
+                           ",{$sort: {_id: 1}}"
+                           "]";
+                }
+                string partitionPipeJson() {
+                    return "[{$unwind: '$b'}"
+                           ",{$group: {_id: '$b', n: {$sum: '$c'}}}"
+                           "]";
+                }
+                string mergePipeJson() {
+                    return "[{$group: {_id: '$$ROOT._id', n: {$sum: '$$ROOT.n'}"
+                                      ",$doingMerge: true}}"
+                           ",{$sort: {_id: 1}}"
+                           "]";
+                }
+            };
+
+            class StopAtSort : public Base {
+                string inputPipeJson() {
+                    return "[{$unwind: '$a'}"
+                           ",{$sort: {a: 1}}"
+                           ",{$group: {_id: '$a', n: {$sum: '$b'}}}"
+                           "]";
+                }
+                string partitionPipeJson() { return "[{$unwind: '$a'}]"; }
+                string mergePipeJson() {
+                    return "[{$sort: {a: 1}}"
+                           ",{$group: {_id: '$a', n: {$sum: '$b'}}}"
+                           "]";
+                }
+            };
+
+            class FirstStageNotStreaming : public Base {
+                string inputPipeJson() { return "[{$limit: 5}, {$match: {a: 1}}]"; }
+                string partitionPipeJson() { return ""; }
+                string mergePipeJson() { return "[{$limit: 5}, {$match: {a: 1}}]"; }
+            };
+        } // namespace Parallel
     } // namespace Optimizations
 
     class All : public Suite {
@@ -313,6 +411,11 @@ namespace PipelineTests {
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::NothingNeeded>();
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::JustNeedsMetadata>();
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::ShardAlreadyExhaustive>();
+            add<Optimizations::Parallel::Empty>();
+            add<Optimizations::Parallel::StreamingStages>();
+            add<Optimizations::Parallel::SplitGroup>();
+            add<Optimizations::Parallel::StopAtSort>();
+            add<Optimizations::Parallel::FirstStageNotStreaming>();
         }
     };
 
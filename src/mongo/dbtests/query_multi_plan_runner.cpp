@@ -47,6 +47,7 @@
 #include "mongo/db/query/query_planner_test_lib.h"
 #include "mongo/db/query/stage_builder.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -72,6 +73,11 @@ namespace QueryMultiPlanRunner {
         return soln.release();
     }
 
+    void restoreEarlyEliminationKnobs(bool enabled, int minWorks) {
+        internalQueryPlanEarlyEliminationEnabled = enabled;
+        internalQueryPlanEarlyEliminationMinWorks = minWorks;
+    }
+
     class MultiPlanRunnerBase {
     public:
         MultiPlanRunnerBase() : _client(&_txn) {
@@ -184,6 +190,81 @@ namespace QueryMultiPlanRunner {
         }
     };
 
+    // A candidate which is clearly less productive than another should stop being worked
+    // before the end of the trial period, but should still be ranked.
+    class MPREarlyElimination : public MultiPlanRunnerBase {
+    public:
+        void run() {
+            const int N = 5000;
+            for (int i = 0; i < N; ++i) {
+                insert(BSON("foo" << (i % 10)));
+            }
+
+            addIndex(BSON("foo" << 1));
+
+            AutoGetCollectionForRead ctx(&_txn, ns());
+            const Collection* coll = ctx.getCollection();
+
+            // Plan 0: IXScan over foo == 7. Produces a result on every call to work().
+            IndexScanParams ixparams;
+            ixparams.descriptor = coll->getIndexCatalog()->findIndexByKeyPattern(&_txn, BSON("foo" << 1));
+            ixparams.bounds.isSimpleRange = true;
+            ixparams.bounds.startKey = BSON("" << 7);
+            ixparams.bounds.endKey = BSON("" << 7);
+            ixparams.bounds.endKeyInclusive = true;
+            ixparams.direction = 1;
+
+            auto_ptr<WorkingSet> sharedWs(new WorkingSet());
+            IndexScan* ix = new IndexScan(&_txn, ixparams, sharedWs.get(), NULL);
+            auto_ptr<PlanStage> firstRoot(new FetchStage(&_txn, sharedWs.get(), ix, NULL, coll));
+
+            // Plan 1: CollScan with matcher. Produces a result on one call to work() in ten.
+            CollectionScanParams csparams;
+            csparams.collection = coll;
+            csparams.direction = CollectionScanParams::FORWARD;
+
+            BSONObj filterObj = BSON("foo" << 7);
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filter(swme.getValue());
+            auto_ptr<PlanStage> secondRoot(new CollectionScan(&_txn, csparams, sharedWs.get(),
+                                                              filter.get()));
+
+            CanonicalQuery* cq = NULL;
+            verify(CanonicalQuery::canonicalize(ns(), BSON("foo" << 7), &cq).isOK());
+            verify(NULL != cq);
+            boost::scoped_ptr<CanonicalQuery> killCq(cq);
+
+            scoped_ptr<MultiPlanStage> mps(new MultiPlanStage(&_txn, ctx.getCollection(), cq));
+            mps->addPlan(createQuerySolution(), firstRoot.release(), sharedWs.get());
+            mps->addPlan(createQuerySolution(), secondRoot.release(), sharedWs.get());
+
+            // Allow elimination well before the index scan returns enough results to end the
+            // trial period.
+            ON_BLOCK_EXIT(restoreEarlyEliminationKnobs,
+                          internalQueryPlanEarlyEliminationEnabled,
+                          internalQueryPlanEarlyEliminationMinWorks);
+            internalQueryPlanEarlyEliminationEnabled = true;
+            internalQueryPlanEarlyEliminationMinWorks = 50;
+
+            PlanYieldPolicy yieldPolicy(NULL, PlanExecutor::YIELD_MANUAL);
+            ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+
+            ASSERT(mps->bestPlanChosen());
+            ASSERT_EQUALS(0, mps->bestPlanIdx());
+
+            const MultiPlanStats* stats =
+                static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+            ASSERT_EQUALS(1U, stats->candidatesEliminated);
+            ASSERT_FALSE(stats->trialTimeLimitReached);
+
+            // The collection scan stopped being worked, so the trial took fewer works than
+            // running both plans until the index scan produced enough results.
+            const size_t numResults = MultiPlanStage::getTrialPeriodNumToReturn(*cq);
+            ASSERT_LESS_THAN(stats->trialWorks, 2 * numResults);
+        }
+    };
+
     // Case in which we select a blocking plan as the winner, and a non-blocking plan
     // is available as a backup.
     class MPRBackupPlan : public MultiPlanRunnerBase {
@@ -289,6 +370,7 @@ namespace QueryMultiPlanRunner {
 
         void setupTests() {
             add<MPRCollectionScanVsHighlySelectiveIXScan>();
+            add<MPREarlyElimination>();
             add<MPRBackupPlan>();
         }
     };
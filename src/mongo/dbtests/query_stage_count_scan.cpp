@@ -625,6 +625,119 @@ namespace QueryStageCountScan {
         }
     };
 
+    //
+    // Keys in each of several intervals are counted, and documents with keys in more than one of
+    // them are only counted once
+    //
+    class QueryStageCountScanMultipleIntervals : public CountBase {
+    public:
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+
+            for (int i = 0; i < 10; ++i) {
+                insert(BSON("a" << i));
+            }
+            insert(BSON("a" << BSON_ARRAY(2 << 8)));
+            addIndex(BSON("a" << 1));
+
+            // Count a in [1, 2], (5, 6] and [8, 8].
+            CountScanParams params;
+            params.descriptor = getIndex(ctx.db(), BSON("a" << 1));
+            OrderedIntervalList oil("a");
+            oil.intervals.push_back(Interval(BSON("" << 1 << "" << 2), true, true));
+            oil.intervals.push_back(Interval(BSON("" << 5 << "" << 6), false, true));
+            oil.intervals.push_back(Interval(BSON("" << 8 << "" << 8), true, true));
+            params.bounds.fields.push_back(oil);
+
+            WorkingSet ws;
+            CountScan count(&_txn, params, &ws);
+
+            int numCounted = runCount(&count);
+            ASSERT_EQUALS(5, numCounted);
+        }
+    };
+
+    //
+    // Yielding while the scan is between intervals
+    //
+    class QueryStageCountScanMultipleIntervalsYield : public CountBase {
+    public:
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+
+            for (int i = 0; i < 10; ++i) {
+                insert(BSON("a" << i));
+            }
+            addIndex(BSON("a" << 1));
+
+            CountScanParams params;
+            params.descriptor = getIndex(ctx.db(), BSON("a" << 1));
+            OrderedIntervalList oil("a");
+            oil.intervals.push_back(Interval(BSON("" << 0 << "" << 1), true, true));
+            oil.intervals.push_back(Interval(BSON("" << 4 << "" << 5), true, true));
+            params.bounds.fields.push_back(oil);
+
+            WorkingSet ws;
+            CountScan count(&_txn, params, &ws);
+            WorkingSetID wsid;
+
+            // Yield after every call to work().
+            int numCounted = 0;
+            PlanStage::StageState countState = PlanStage::NEED_TIME;
+            while (PlanStage::IS_EOF != countState) {
+                countState = count.work(&wsid);
+                if (PlanStage::ADVANCED == countState) numCounted++;
+
+                count.saveState();
+                if (1 == numCounted) {
+                    // Removed before the scan gets to it.
+                    remove(BSON("a" << 4));
+                }
+                count.restoreState(&_txn);
+            }
+            ASSERT_EQUALS(3, numCounted);
+        }
+    };
+
+    //
+    // Only keys which pass the filter are counted
+    //
+    class QueryStageCountScanFilter : public CountBase {
+    public:
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+
+            for (int i = 0; i < 10; ++i) {
+                insert(BSON("a" << i % 2 << "b" << i));
+            }
+            addIndex(BSON("a" << 1 << "b" << 1));
+
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse(BSON("b" << BSON("$mod" << BSON_ARRAY(3 << 0))));
+            verify(swme.isOK());
+            boost::scoped_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            // Count a == 1 with b a multiple of 3, which is b in {3, 9}.
+            CountScanParams params;
+            params.descriptor = getIndex(ctx.db(), BSON("a" << 1 << "b" << 1));
+            params.startKey = BSON("" << 1 << "" << MINKEY);
+            params.startKeyInclusive = true;
+            params.endKey = BSON("" << 1 << "" << MAXKEY);
+            params.endKeyInclusive = true;
+
+            WorkingSet ws;
+            CountScan count(&_txn, params, &ws, filterExpr.get());
+
+            int numCounted = runCount(&count);
+            ASSERT_EQUALS(2, numCounted);
+
+            boost::scoped_ptr<PlanStageStats> stats(count.getStats());
+            const CountScanStats* countStats =
+                static_cast<const CountScanStats*>(stats->specific.get());
+            ASSERT_EQUALS(3U, countStats->keysFilteredOut);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite("query_stage_count_scan") { }
@@ -641,6 +754,9 @@ namespace QueryStageCountScan {
             add<QueryStageCountScanInsertNewDocsDuringYield>();
             add<QueryStageCountScanBecomesMultiKeyDuringYield>();
             add<QueryStageCountScanUnusedKeys>();
+            add<QueryStageCountScanMultipleIntervals>();
+            add<QueryStageCountScanMultipleIntervalsYield>();
+            add<QueryStageCountScanFilter>();
         }
     };
 
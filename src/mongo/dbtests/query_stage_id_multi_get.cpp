@@ -0,0 +1,281 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file tests db/exec/id_multi_get.cpp, which reads the _id index and the collection.
+ */
+
+#include <memory>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/id_multi_get.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace QueryStageIDMultiGet {
+
+    using std::auto_ptr;
+    using std::vector;
+
+    class IDMultiGetBase {
+    public:
+        IDMultiGetBase() : _client(&_txn) { }
+
+        virtual ~IDMultiGetBase() {
+            OldClientWriteContext ctx(&_txn, ns());
+            _client.dropCollection(ns());
+        }
+
+        void insert(const BSONObj& obj) {
+            _client.insert(ns(), obj);
+        }
+
+        void remove(const BSONObj& obj) {
+            _client.remove(ns(), obj);
+        }
+
+        Collection* collection(Database* db) {
+            return db->getCollection(ns());
+        }
+
+        RecordId locOf(Collection* coll, int id) {
+            const IndexCatalog* catalog = coll->getIndexCatalog();
+            return catalog->getIndex(catalog->findIdIndex(&_txn))->findSingle(&_txn,
+                                                                              BSON("" << id));
+        }
+
+        /**
+         * Works 'stage' until it returns a document, returning its _id, or -1 at EOF.
+         */
+        int next(IDMultiGetStage* stage, WorkingSet* ws, RecordId* locOut = NULL) {
+            while (true) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = stage->work(&id);
+                if (PlanStage::IS_EOF == state) {
+                    return -1;
+                }
+                if (PlanStage::ADVANCED == state) {
+                    WorkingSetMember* member = ws->get(id);
+                    ASSERT_TRUE(member->hasObj());
+                    if (locOut) {
+                        *locOut = member->loc;
+                    }
+                    int result = member->obj.value()["_id"].numberInt();
+                    ws->free(id);
+                    return result;
+                }
+            }
+        }
+
+        /**
+         * Returns the _id of every document 'stage' returns, in order.
+         */
+        vector<int> runStage(IDMultiGetStage* stage, WorkingSet* ws) {
+            vector<int> ids;
+            for (int id = next(stage, ws); id != -1; id = next(stage, ws)) {
+                ids.push_back(id);
+            }
+            return ids;
+        }
+
+        static const char* ns() { return "unittests.QueryStageIDMultiGet"; }
+
+    protected:
+        OperationContextImpl _txn;
+
+    private:
+        DBDirectClient _client;
+    };
+
+    // The _id values requested by most of the tests. 77 and "a" are missing, 3 is a duplicate.
+    BSONObj requestedIds() {
+        return BSON_ARRAY(10 << 3 << 77 << 3 << 42 << "a");
+    }
+
+    //
+    // Results come back in the order asked for, without missing or duplicate values.
+    //
+    class IDMultiGetOrders : public IDMultiGetBase {
+    public:
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+            for (int i = 49; i >= 0; --i) {
+                insert(BSON("_id" << i << "x" << i));
+            }
+            Collection* coll = collection(ctx.db());
+
+            {
+                WorkingSet ws;
+                IDMultiGetStage stage(&_txn, coll, requestedIds(),
+                                      IDMultiGetStage::kRequestOrder, &ws);
+                vector<int> ids = runStage(&stage, &ws);
+                ASSERT_EQUALS(3U, ids.size());
+                ASSERT_EQUALS(10, ids[0]);
+                ASSERT_EQUALS(3, ids[1]);
+                ASSERT_EQUALS(42, ids[2]);
+
+                const IDMultiGetStats* stats =
+                    static_cast<const IDMultiGetStats*>(stage.getSpecificStats());
+                ASSERT_EQUALS(5U, stats->keysRequested);
+                ASSERT_EQUALS(3U, stats->docsExamined);
+            }
+
+            {
+                WorkingSet ws;
+                IDMultiGetStage stage(&_txn, coll, requestedIds(),
+                                      IDMultiGetStage::kAscendingKeyOrder, &ws);
+                vector<int> ids = runStage(&stage, &ws);
+                ASSERT_EQUALS(3U, ids.size());
+                ASSERT_EQUALS(3, ids[0]);
+                ASSERT_EQUALS(10, ids[1]);
+                ASSERT_EQUALS(42, ids[2]);
+            }
+
+            {
+                WorkingSet ws;
+                IDMultiGetStage stage(&_txn, coll, requestedIds(),
+                                      IDMultiGetStage::kDescendingKeyOrder, &ws);
+                vector<int> ids = runStage(&stage, &ws);
+                ASSERT_EQUALS(3U, ids.size());
+                ASSERT_EQUALS(42, ids[0]);
+                ASSERT_EQUALS(10, ids[1]);
+                ASSERT_EQUALS(3, ids[2]);
+            }
+
+            {
+                WorkingSet ws;
+                IDMultiGetStage stage(&_txn, coll, requestedIds(),
+                                      IDMultiGetStage::kStorageOrder, &ws);
+                RecordId loc;
+                RecordId lastLoc;
+                int count = 0;
+                while (next(&stage, &ws, &loc) != -1) {
+                    ASSERT_LESS_THAN(lastLoc, loc);
+                    lastLoc = loc;
+                    ++count;
+                }
+                ASSERT_EQUALS(3, count);
+            }
+        }
+    };
+
+    //
+    // Neighbouring _id values are found by stepping the index cursor rather than seeking.
+    //
+    class IDMultiGetSeeks : public IDMultiGetBase {
+    public:
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("_id" << i));
+            }
+            Collection* coll = collection(ctx.db());
+
+            {
+                BSONArrayBuilder in;
+                for (int i = 49; i >= 0; --i) {
+                    in.append(i);
+                }
+                WorkingSet ws;
+                IDMultiGetStage stage(&_txn, coll, in.arr(), IDMultiGetStage::kStorageOrder, &ws);
+                ASSERT_EQUALS(50U, runStage(&stage, &ws).size());
+
+                const IDMultiGetStats* stats =
+                    static_cast<const IDMultiGetStats*>(stage.getSpecificStats());
+                ASSERT_EQUALS(1U, stats->seeks);
+                ASSERT_EQUALS(50U, stats->keysExamined);
+            }
+
+            {
+                // 20 is too far from 5 to step to, and nothing is past 1000.
+                WorkingSet ws;
+                IDMultiGetStage stage(&_txn, coll, BSON_ARRAY(1000 << 20 << 5 << 2000),
+                                      IDMultiGetStage::kStorageOrder, &ws);
+                ASSERT_EQUALS(2U, runStage(&stage, &ws).size());
+
+                const IDMultiGetStats* stats =
+                    static_cast<const IDMultiGetStats*>(stage.getSpecificStats());
+                ASSERT_EQUALS(3U, stats->seeks);
+                ASSERT_EQUALS(4U, stats->keysExamined);
+            }
+        }
+    };
+
+    //
+    // A record deleted or moved while we yield is looked up again by _id.
+    //
+    class IDMultiGetInvalidate : public IDMultiGetBase {
+    public:
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+            for (int i = 0; i < 10; ++i) {
+                insert(BSON("_id" << i));
+            }
+            Collection* coll = collection(ctx.db());
+
+            WorkingSet ws;
+            IDMultiGetStage stage(&_txn, coll, BSON_ARRAY(1 << 2 << 3),
+                                  IDMultiGetStage::kRequestOrder, &ws);
+            ASSERT_EQUALS(1, next(&stage, &ws));
+
+            // Move 2 and delete 3.
+            stage.saveState();
+            const RecordId loc2 = locOf(coll, 2);
+            remove(BSON("_id" << 2));
+            stage.invalidate(&_txn, loc2, INVALIDATION_DELETION);
+            insert(BSON("_id" << 2 << "moved" << true));
+            const RecordId loc3 = locOf(coll, 3);
+            remove(BSON("_id" << 3));
+            stage.invalidate(&_txn, loc3, INVALIDATION_DELETION);
+            stage.restoreState(&_txn);
+
+            ASSERT_EQUALS(2, next(&stage, &ws));
+            ASSERT_EQUALS(-1, next(&stage, &ws));
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite("query_stage_id_multi_get") { }
+
+        void setupTests() {
+            add<IDMultiGetOrders>();
+            add<IDMultiGetSeeks>();
+            add<IDMultiGetInvalidate>();
+        }
+    };
+
+    SuiteInstance<All> queryStageIDMultiGetAll;
+
+}  // namespace QueryStageIDMultiGet
@@ -0,0 +1,104 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_log_buffer.h"
+
+namespace mongo {
+namespace logger {
+
+namespace {
+
+    size_t roundUpToPowerOfTwo(size_t n) {
+        size_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+}  // namespace
+
+    AsyncLogBuffer::AsyncLogBuffer(size_t capacity) :
+        _mask(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity) - 1),
+        _slots(new Slot[_mask + 1]) {
+
+        for (size_t i = 0; i <= _mask; ++i) {
+            _slots[i].sequence.store(i);
+        }
+    }
+
+    bool AsyncLogBuffer::tryPush(std::string* line) {
+        unsigned long long pos = _enqueuePos.load();
+        while (true) {
+            Slot& slot = _slots[pos & _mask];
+            const long long diff = static_cast<long long>(slot.sequence.load() - pos);
+
+            if (diff == 0) {
+                // The slot is free; try to claim it.
+                const unsigned long long observed = _enqueuePos.compareAndSwap(pos, pos + 1);
+                if (observed == pos) {
+                    slot.line.swap(*line);
+                    slot.sequence.store(pos + 1);
+                    return true;
+                }
+                pos = observed;
+            }
+            else if (diff < 0) {
+                // The slot still holds the line from one lap ago, so the buffer is full.
+                return false;
+            }
+            else {
+                // Another producer claimed this position first.
+                pos = _enqueuePos.load();
+            }
+        }
+    }
+
+    bool AsyncLogBuffer::tryPop(std::string* line) {
+        const unsigned long long pos = _dequeuePos.load();
+        Slot& slot = _slots[pos & _mask];
+        if (slot.sequence.load() != pos + 1) {
+            return false;
+        }
+
+        line->clear();
+        line->swap(slot.line);
+        slot.sequence.store(pos + _mask + 1);
+        _dequeuePos.store(pos + 1);
+        return true;
+    }
+
+    bool AsyncLogBuffer::empty() const {
+        const unsigned long long pos = _dequeuePos.load();
+        return _slots[pos & _mask].sequence.load() != pos + 1;
+    }
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,92 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_array.hpp>
+#include <cstddef>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Bounded, lock-free queue of formatted log lines, with any number of producers and a single
+     * consumer.
+     *
+     * Producers claim a slot by advancing the enqueue position with a compare-and-swap, and
+     * publish the line by advancing the slot's sequence number; the consumer only reads slots
+     * whose sequence number shows they were published.  A producer that finds the queue full
+     * fails immediately instead of waiting for the consumer.
+     *
+     * tryPop() and empty() may only be called by one thread at a time.
+     */
+    class AsyncLogBuffer {
+        MONGO_DISALLOW_COPYING(AsyncLogBuffer);
+    public:
+        /**
+         * Constructs a buffer holding at least "capacity" lines.  The capacity is rounded up to
+         * a power of two.
+         */
+        explicit AsyncLogBuffer(size_t capacity);
+
+        /**
+         * Moves "line" into the buffer, leaving "line" empty, and returns true.  Returns false,
+         * leaving "line" untouched, if the buffer is full.
+         */
+        bool tryPush(std::string* line);
+
+        /**
+         * Moves the oldest line in the buffer into "line" and returns true, or returns false if
+         * the buffer is empty.
+         */
+        bool tryPop(std::string* line);
+
+        bool empty() const;
+
+        size_t capacity() const { return _mask + 1; }
+
+    private:
+        struct Slot {
+            // Equal to the slot's position when the slot is free for the producer writing that
+            // position, and to the position plus one once the line has been published.
+            AtomicUInt64 sequence;
+            std::string line;
+        };
+
+        const size_t _mask;
+        boost::scoped_array<Slot> _slots;
+        AtomicUInt64 _enqueuePos;
+        AtomicUInt64 _dequeuePos;
+    };
+
+}  // namespace logger
+}  // namespace mongo
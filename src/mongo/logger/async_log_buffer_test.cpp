@@ -0,0 +1,124 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mongo/logger/async_log_buffer.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+    using namespace mongo;
+    using namespace mongo::logger;
+
+    TEST(AsyncLogBufferTest, CapacityIsRoundedUpToPowerOfTwo) {
+        ASSERT_EQUALS(2U, AsyncLogBuffer(0).capacity());
+        ASSERT_EQUALS(8U, AsyncLogBuffer(5).capacity());
+        ASSERT_EQUALS(1024U, AsyncLogBuffer(1024).capacity());
+    }
+
+    TEST(AsyncLogBufferTest, PushAndPopInOrder) {
+        AsyncLogBuffer buffer(4);
+        ASSERT_TRUE(buffer.empty());
+
+        std::string line;
+        ASSERT_FALSE(buffer.tryPop(&line));
+
+        // Wrap around the ring several times.
+        for (int round = 0; round < 5; ++round) {
+            for (int i = 0; i < 4; ++i) {
+                line = str::stream() << "line " << round << " " << i;
+                ASSERT_TRUE(buffer.tryPush(&line));
+                ASSERT_TRUE(line.empty());
+            }
+
+            line = "overflow";
+            ASSERT_FALSE(buffer.tryPush(&line));
+            ASSERT_EQUALS("overflow", line);
+            ASSERT_FALSE(buffer.empty());
+
+            for (int i = 0; i < 4; ++i) {
+                ASSERT_TRUE(buffer.tryPop(&line));
+                ASSERT_EQUALS(std::string(str::stream() << "line " << round << " " << i), line);
+            }
+            ASSERT_TRUE(buffer.empty());
+            ASSERT_FALSE(buffer.tryPop(&line));
+        }
+    }
+
+    void pushLines(AsyncLogBuffer* buffer, int producer, int numLines) {
+        for (int i = 0; i < numLines; ++i) {
+            std::string line = str::stream() << producer << " " << i;
+            while (!buffer->tryPush(&line)) {
+                boost::this_thread::yield();
+            }
+        }
+    }
+
+    TEST(AsyncLogBufferTest, ManyProducersOneConsumer) {
+        const int numProducers = 4;
+        const int numLinesPerProducer = 20000;
+
+        AsyncLogBuffer buffer(64);
+        std::vector<boost::thread*> producers;
+        for (int p = 0; p < numProducers; ++p) {
+            producers.push_back(new boost::thread(pushLines, &buffer, p, numLinesPerProducer));
+        }
+
+        // Every line arrives exactly once, and each producer's lines arrive in order.
+        std::vector<int> nextLine(numProducers, 0);
+        int numReceived = 0;
+        std::string line;
+        while (numReceived < numProducers * numLinesPerProducer) {
+            if (!buffer.tryPop(&line)) {
+                boost::this_thread::yield();
+                continue;
+            }
+
+            std::istringstream is(line);
+            int producer;
+            int lineNumber;
+            is >> producer >> lineNumber;
+            ASSERT_EQUALS(nextLine[producer], lineNumber);
+            ++nextLine[producer];
+            ++numReceived;
+        }
+
+        for (int p = 0; p < numProducers; ++p) {
+            producers[p]->join();
+            delete producers[p];
+        }
+        ASSERT_TRUE(buffer.empty());
+    }
+
+}  // namespace
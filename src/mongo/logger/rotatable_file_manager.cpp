@@ -79,5 +79,12 @@ namespace logger {
         return badStatuses;
     }
 
+    void RotatableFileManager::flushAll() {
+        for (WriterByNameMap::const_iterator iter = _writers.begin();
+             iter != _writers.end(); ++iter) {
+            RotatableFileWriter::Use(iter->second).flushAsync();
+        }
+    }
+
 }  // namespace logger
 }  // namespace mongo
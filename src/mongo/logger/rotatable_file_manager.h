@@ -81,6 +81,11 @@ namespace logger {
          */
         FileNameStatusPairVector rotateAll(bool renameFiles, const std::string& renameTargetSuffix);
 
+        /**
+         * Writes out the lines queued on every asynchronous writer.
+         */
+        void flushAll();
+
     private:
         typedef unordered_map<std::string, RotatableFileWriter*> WriterByNameMap;
 
@@ -29,12 +29,15 @@
 
 #include "mongo/logger/rotatable_file_writer.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/scoped_array.hpp>
 #include <cstdio>
 #include <fstream>
 
 #include "mongo/base/string_data.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -239,19 +242,112 @@ namespace {
 }  // namespace
 #endif
 
-    RotatableFileWriter::RotatableFileWriter() : _stream(NULL) {}
+    RotatableFileWriter::RotatableFileWriter() :
+        _stream(NULL),
+        _numDroppedLinesReported(0),
+        _asyncShutdown(false) {
+    }
+
+    RotatableFileWriter::~RotatableFileWriter() {
+        if (!_asyncThread) {
+            return;
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lk(_asyncWakeupMutex);
+            _asyncShutdown = true;
+            _asyncWakeup.notify_one();
+        }
+        _asyncThread->join();
+
+        Use(this).flushAsync();
+    }
+
+    void RotatableFileWriter::startAsyncWriter(size_t capacity) {
+        invariant(!_asyncBuffer);
+        _asyncBuffer.reset(new AsyncLogBuffer(capacity));
+        _asyncThread.reset(new boost::thread(
+                boost::bind(&RotatableFileWriter::_asyncWriterThread, this)));
+    }
+
+    bool RotatableFileWriter::appendAsync(std::string* line) {
+        if (!_asyncBuffer->tryPush(line)) {
+            _numDroppedLines.fetchAndAdd(1);
+            return false;
+        }
+
+        if (_asyncWriterIdle.load()) {
+            boost::lock_guard<boost::mutex> lk(_asyncWakeupMutex);
+            _asyncWakeup.notify_one();
+        }
+        return true;
+    }
+
+    void RotatableFileWriter::_asyncWriterThread() {
+        setThreadName("logWriter");
+
+        while (true) {
+            Use(this).flushAsync();
+
+            boost::unique_lock<boost::mutex> lk(_asyncWakeupMutex);
+            if (_asyncShutdown) {
+                return;
+            }
+
+            // Publish that we are going to sleep before the final emptiness check, so that a
+            // producer either sees the flag and wakes us, or pushed before the check.  The timeout
+            // bounds the delay in the unlikely case a wakeup is missed anyway.
+            _asyncWriterIdle.store(1);
+            if (_asyncBuffer->empty()) {
+                _asyncWakeup.timed_wait(lk, boost::posix_time::milliseconds(100));
+            }
+            _asyncWriterIdle.store(0);
+        }
+    }
 
     RotatableFileWriter::Use::Use(RotatableFileWriter* writer) :
         _writer(writer),
         _lock(writer->_mutex) {
     }
 
+    void RotatableFileWriter::Use::flushAsync() {
+        if (!_writer->_asyncBuffer) {
+            return;
+        }
+
+        std::string line;
+        bool wroteAny = false;
+        while (_writer->_asyncBuffer->tryPop(&line)) {
+            if (_writer->_stream) {
+                *_writer->_stream << line;
+            }
+            wroteAny = true;
+        }
+
+        const unsigned long long numDropped = _writer->_numDroppedLines.load();
+        if (numDropped != _writer->_numDroppedLinesReported) {
+            if (_writer->_stream) {
+                *_writer->_stream << "*** " << (numDropped - _writer->_numDroppedLinesReported)
+                                  << " log lines were dropped because the asynchronous log "
+                                     "buffer was full ***" << std::endl;
+            }
+            _writer->_numDroppedLinesReported = numDropped;
+            wroteAny = true;
+        }
+
+        if (wroteAny && _writer->_stream) {
+            _writer->_stream->flush();
+        }
+    }
+
     Status RotatableFileWriter::Use::setFileName(const std::string& name, bool append) {
         _writer->_fileName = name;
         return _openFileStream(append);
     }
 
     Status RotatableFileWriter::Use::rotate(bool renameOnRotate, const std::string& renameTarget) {
+        flushAsync();
+
         if (_writer->_stream) {
             _writer->_stream->flush();
 
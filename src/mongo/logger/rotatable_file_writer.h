@@ -28,11 +28,15 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <string>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status.h"
+#include "mongo/logger/async_log_buffer.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 namespace logger {
@@ -48,6 +52,12 @@ namespace logger {
      *
      * Behavior is undefined if two instances of RotatableFileWriter should simultaneously have the
      * same value for their fileName.
+     *
+     * Optionally, a writer may also accept lines through appendAsync(), which queues them in a
+     * lock-free AsyncLogBuffer without taking the writer's lock.  A background thread started by
+     * startAsyncWriter() writes queued lines to the file in batches.  Any holder of a Use may
+     * write the queued lines out with flushAsync(); rotate() does so before rotating, so that
+     * lines queued before a rotation land in the rotated file.
      */
     class RotatableFileWriter {
         MONGO_DISALLOW_COPYING(RotatableFileWriter);
@@ -89,6 +99,13 @@ namespace logger {
              */
             Status rotate(bool renameFile, const std::string& renameTarget);
 
+            /**
+             * Writes all lines queued through appendAsync() to the stream, followed by a notice
+             * if any lines were dropped since the last flush, and flushes the stream.  Does
+             * nothing if the writer is not asynchronous.
+             */
+            void flushAsync();
+
             /**
              * Returns the status of the stream.
              *
@@ -118,11 +135,59 @@ namespace logger {
          */
         RotatableFileWriter();
 
+        /**
+         * Stops the asynchronous writer thread, if any, after writing out the lines it queued.
+         */
+        ~RotatableFileWriter();
+
+        /**
+         * Makes this writer asynchronous: lines passed to appendAsync() are buffered, up to
+         * "capacity" of them, and written by a background thread.
+         *
+         * May be called at most once, before any call to appendAsync().
+         */
+        void startAsyncWriter(size_t capacity);
+
+        /**
+         * Returns true if startAsyncWriter() has been called.
+         */
+        bool isAsync() const { return _asyncBuffer.get() != NULL; }
+
+        /**
+         * Queues "line", which should be newline terminated, to be written by the background
+         * writer, leaving "line" empty.  Never blocks.  Returns false, and counts the line as
+         * dropped, if the buffer is full.
+         *
+         * May only be called on an asynchronous writer.
+         */
+        bool appendAsync(std::string* line);
+
+        /**
+         * Returns the number of lines appendAsync() dropped because the buffer was full.
+         */
+        unsigned long long getNumDroppedLines() const { return _numDroppedLines.load(); }
+
     private:
         friend class RotatableFileWriter::Use;
+
+        void _asyncWriterThread();
+
         boost::mutex _mutex;
         std::string _fileName;
         boost::scoped_ptr<std::ostream> _stream;
+
+        // State for asynchronous writing.  _asyncBuffer's consumer side is protected by _mutex.
+        boost::scoped_ptr<AsyncLogBuffer> _asyncBuffer;
+        boost::scoped_ptr<boost::thread> _asyncThread;
+        AtomicUInt64 _numDroppedLines;
+        unsigned long long _numDroppedLinesReported;  // Protected by _mutex.
+
+        // Used to wake the writer thread, which sets _asyncWriterIdle while it waits, so that
+        // producers only take _asyncWakeupMutex when the writer is asleep.
+        boost::mutex _asyncWakeupMutex;
+        boost::condition_variable _asyncWakeup;
+        AtomicUInt32 _asyncWriterIdle;
+        bool _asyncShutdown;  // Protected by _asyncWakeupMutex.
     };
 
 }  // namespace logger
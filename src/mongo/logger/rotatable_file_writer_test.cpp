@@ -141,4 +141,77 @@ namespace {
         }
     }
 
+    void appendAsyncLine(RotatableFileWriter* writer, const std::string& text) {
+        std::string line = text + "\n";
+        ASSERT_TRUE(writer->appendAsync(&line));
+    }
+
+    TEST_F(RotatableFileWriterTest, AsyncRotationTest) {
+        {
+            RotatableFileWriter writer;
+            ASSERT_OK(RotatableFileWriter::Use(&writer).setFileName(logFileName, false));
+            writer.startAsyncWriter(16);
+            appendAsyncLine(&writer, "Level 1 message.");
+            appendAsyncLine(&writer, "Level 2 message.");
+
+            // Lines queued before the rotation are written to the rotated file.
+            ASSERT_OK(RotatableFileWriter::Use(&writer).rotate(true, logFileNameRotated));
+            appendAsyncLine(&writer, "Level 3 message.");
+            appendAsyncLine(&writer, "Level 4 message.");
+        }
+
+        {
+            std::ifstream ifs(logFileNameRotated.c_str());
+            ASSERT_TRUE(ifs.is_open());
+            std::string input;
+            ASSERT_TRUE(std::getline(ifs, input));
+            ASSERT_EQUALS(input, "Level 1 message.");
+            ASSERT_TRUE(std::getline(ifs, input));
+            ASSERT_EQUALS(input, "Level 2 message.");
+            ASSERT_TRUE(std::getline(ifs, input).fail());
+        }
+
+        {
+            std::ifstream ifs(logFileName.c_str());
+            ASSERT_TRUE(ifs.is_open());
+            std::string input;
+            ASSERT_TRUE(std::getline(ifs, input));
+            ASSERT_EQUALS(input, "Level 3 message.");
+            ASSERT_TRUE(std::getline(ifs, input));
+            ASSERT_EQUALS(input, "Level 4 message.");
+            ASSERT_TRUE(std::getline(ifs, input).fail());
+        }
+    }
+
+    TEST_F(RotatableFileWriterTest, AsyncDropsLinesWhenFull) {
+        {
+            RotatableFileWriter writer;
+            ASSERT_OK(RotatableFileWriter::Use(&writer).setFileName(logFileName, false));
+            writer.startAsyncWriter(4);
+
+            {
+                // Holding the writer keeps the background thread from draining the buffer.
+                RotatableFileWriter::Use writerUse(&writer);
+                for (int i = 0; i < 4; ++i) {
+                    appendAsyncLine(&writer, "Kept message.");
+                }
+                std::string line = "Dropped message.\n";
+                ASSERT_FALSE(writer.appendAsync(&line));
+                ASSERT_FALSE(writer.appendAsync(&line));
+                ASSERT_EQUALS(2U, writer.getNumDroppedLines());
+            }
+        }
+
+        std::ifstream ifs(logFileName.c_str());
+        ASSERT_TRUE(ifs.is_open());
+        std::string input;
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(std::getline(ifs, input));
+            ASSERT_EQUALS(input, "Kept message.");
+        }
+        ASSERT_TRUE(std::getline(ifs, input));
+        ASSERT_NOT_EQUALS(std::string::npos, input.find("2 log lines were dropped"));
+        ASSERT_TRUE(std::getline(ifs, input).fail());
+    }
+
 }  // namespace mongo
@@ -497,6 +497,63 @@ namespace mongo {
         return isPending;
     }
 
+    bool CollectionMetadata::keyBelongsToMe( const BSONObj& key,
+                                             BSONObj* rangeMin,
+                                             BSONObj* rangeMax ) const {
+        if ( _keyPattern.isEmpty() ) {
+            *rangeMin = BSONObj();
+            *rangeMax = BSONObj();
+            return true;
+        }
+
+        if ( _rangesMap.size() <= 0 ) {
+            return false;
+        }
+
+        RangeMap::const_iterator it = _rangesMap.upper_bound( key );
+        if ( it != _rangesMap.begin() ) it--;
+
+        if ( !rangeContains( it->first, it->second, key ) ) {
+            return false;
+        }
+
+        *rangeMin = it->first;
+        *rangeMax = it->second;
+        return true;
+    }
+
+    CollectionMetadata::RangeOwnership
+    CollectionMetadata::getRangeOwnership( const BSONObj& minKey, const BSONObj& maxKey ) const {
+        if ( _keyPattern.isEmpty() ) {
+            return RANGE_OWNED;
+        }
+
+        if ( _rangesMap.size() <= 0 ) {
+            return RANGE_NOT_OWNED;
+        }
+
+        // The first range starting after minKey.
+        RangeMap::const_iterator it = _rangesMap.upper_bound( minKey );
+
+        if ( it != _rangesMap.begin() ) {
+            RangeMap::const_iterator containing = it;
+            --containing;
+            if ( rangeContains( containing->first, containing->second, minKey ) ) {
+                // Ranges of contiguous chunks are merged in _rangesMap, so if maxKey is not in
+                // the same range there is an unowned gap between the two.
+                return maxKey.woCompare( containing->second ) < 0 ? RANGE_OWNED
+                                                                   : RANGE_PARTIALLY_OWNED;
+            }
+        }
+
+        // minKey itself isn't owned; something is only if a range starts at or before maxKey.
+        if ( it != _rangesMap.end() && it->first.woCompare( maxKey ) <= 0 ) {
+            return RANGE_PARTIALLY_OWNED;
+        }
+
+        return RANGE_NOT_OWNED;
+    }
+
     bool CollectionMetadata::getNextChunk( const BSONObj& lookupKey, ChunkType* chunk ) const {
 
         RangeMap::const_iterator upperChunkIt = _chunksMap.upper_bound( lookupKey );
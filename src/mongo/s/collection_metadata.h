@@ -153,6 +153,30 @@ namespace mongo {
          */
         bool keyIsPending( const BSONObj& key ) const;
 
+        /**
+         * Same as keyBelongsToMe(), but if 'key' belongs to this chunkset also returns the
+         * bounds [*rangeMin, *rangeMax) of the run of contiguous chunks that contains it.  Any
+         * other key inside those bounds belongs to this chunkset as well, which lets callers
+         * that check many nearby keys skip the lookup.  On an unsharded collection returns true
+         * and leaves the bounds empty.
+         */
+        bool keyBelongsToMe( const BSONObj& key, BSONObj* rangeMin, BSONObj* rangeMax ) const;
+
+        enum RangeOwnership {
+            // Every key in the range belongs to this chunkset.
+            RANGE_OWNED,
+            // No key in the range belongs to this chunkset.
+            RANGE_NOT_OWNED,
+            // Some keys in the range may belong to this chunkset and some may not.
+            RANGE_PARTIALLY_OWNED
+        };
+
+        /**
+         * Returns how much of the closed range [minKey, maxKey] of shard keys belongs to this
+         * chunkset.  Both keys must be full shard keys, with minKey <= maxKey.
+         */
+        RangeOwnership getRangeOwnership( const BSONObj& minKey, const BSONObj& maxKey ) const;
+
         /**
          * Given a key 'lookupKey' in the shard key range, get the next chunk which overlaps or is
          * greater than this key.  Returns true if a chunk exists, false otherwise.
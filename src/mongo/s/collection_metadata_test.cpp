@@ -1253,6 +1253,44 @@ namespace {
         ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << MAXKEY)) );
     }
 
+    TEST_F(ThreeChunkWithRangeGapFixture, ShardOwnsDocInRange) {
+        BSONObj rangeMin;
+        BSONObj rangeMax;
+        // The first two chunks are contiguous.
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 15), &rangeMin, &rangeMax) );
+        ASSERT_EQUALS( 0, rangeMin.woCompare(BSON("a" << MINKEY)) );
+        ASSERT_EQUALS( 0, rangeMax.woCompare(BSON("a" << 20)) );
+
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 30), &rangeMin, &rangeMax) );
+        ASSERT_EQUALS( 0, rangeMin.woCompare(BSON("a" << 30)) );
+        ASSERT_EQUALS( 0, rangeMax.woCompare(BSON("a" << MAXKEY)) );
+
+        ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << 20), &rangeMin, &rangeMax) );
+    }
+
+    TEST_F(ThreeChunkWithRangeGapFixture, RangeOwnership) {
+        const CollectionMetadata& metadata = getCollMetadata();
+        ASSERT_EQUALS( CollectionMetadata::RANGE_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << 5), BSON("a" << 5)) );
+        ASSERT_EQUALS( CollectionMetadata::RANGE_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << MINKEY), BSON("a" << 19)) );
+        ASSERT_EQUALS( CollectionMetadata::RANGE_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << 30), BSON("a" << 1000)) );
+
+        ASSERT_EQUALS( CollectionMetadata::RANGE_NOT_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << 20), BSON("a" << 29)) );
+        ASSERT_EQUALS( CollectionMetadata::RANGE_NOT_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << MAXKEY), BSON("a" << MAXKEY)) );
+
+        // The max key of a range of chunks is not owned.
+        ASSERT_EQUALS( CollectionMetadata::RANGE_PARTIALLY_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << 5), BSON("a" << 20)) );
+        ASSERT_EQUALS( CollectionMetadata::RANGE_PARTIALLY_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << 25), BSON("a" << 30)) );
+        ASSERT_EQUALS( CollectionMetadata::RANGE_PARTIALLY_OWNED,
+                       metadata.getRangeOwnership(BSON("a" << 40), BSON("a" << MAXKEY)) );
+    }
+
     TEST_F(ThreeChunkWithRangeGapFixture, GetNextFromEmpty) {
         ChunkType nextChunk;
         ASSERT( getCollMetadata().getNextChunk( getCollMetadata().getMinKey(), &nextChunk ) );
@@ -28,9 +28,11 @@
 
 #include "mongo/platform/basic.h"
 
+#include "mongo/db/client_basic.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/s/write_ops/batched_command_request.h"
+#include "mongo/util/net/message_port.h"
 
 namespace mongo {
 namespace {
@@ -77,6 +79,12 @@ namespace {
             result.append("maxWireVersion", maxWireVersion);
             result.append("minWireVersion", minWireVersion);
 
+            AbstractMessagingPort* port = ClientBasic::getCurrent()->port();
+            if (port) {
+                port->setCompressor(
+                    negotiateCompressor(cmdObj, port->getCompressor(), &result));
+            }
+
             return true;
         }
 
@@ -41,12 +41,15 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/lite_parsed_query.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/catalog/catalog_cache.h"
 #include "mongo/s/client/shard_connection.h"
 #include "mongo/s/commands/cluster_commands_common.h"
 #include "mongo/s/config.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/stale_exception.h"
+#include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -59,6 +62,18 @@ namespace mongo {
 
 namespace {
 
+    /**
+     * If true, the merging half of a sharded aggregation is run directly on mongos, streaming the
+     * results of the shard cursors, instead of being sent to the primary shard of the database.
+     * Pipelines which need a mongod ($out) or which may spill to disk (allowDiskUse) are still
+     * merged on the primary shard.
+     */
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationMergeOnMongos, bool, false);
+
+    // Enabling this fail point makes a merge on mongos with a maxTimeMS fail the first time it
+    // checks its time limit, like maxTimeAlwaysTimeOut does on mongod.
+    MONGO_FP_DECLARE(mongosMergeMaxTimeAlwaysTimeOut);
+
     /**
      * Implements the aggregation (pipeline command for sharding).
      */
@@ -104,6 +119,14 @@ namespace {
             mergeCtx->inRouter = true;
             // explicitly *not* setting mergeCtx->tempDir
 
+            // There is no OperationContext to enforce maxTimeMS on mongos (SERVER-13931), so a
+            // merge run here checks it against the time since mergeCtx was created.
+            StatusWith<int> maxTimeMS = LiteParsedQuery::parseMaxTimeMSCommand(cmdObj);
+            if (!maxTimeMS.isOK()) {
+                return appendCommandStatus(result, maxTimeMS.getStatus());
+            }
+            mergeCtx->routerMaxTimeMicros = static_cast<long long>(maxTimeMS.getValue()) * 1000;
+
             // Parse the pipeline specification
             intrusive_ptr<Pipeline> pipeline(Pipeline::parseCommand(errmsg, cmdObj, mergeCtx));
             if (!pipeline.get()) {
@@ -142,6 +165,10 @@ namespace {
                                         Value(cmdObj[LiteParsedQuery::cmdOptionMaxTimeMS]));
             }
 
+            // The merger part is decided before running anything on the shards so that explain can
+            // report it. 'pipeline' now only contains the merger part.
+            const bool mergeOnMongos = aggregationMergeOnMongos && pipeline->canRunInMongos();
+
             BSONObj shardedCommand = commandBuilder.freeze().toBson();
             BSONObj shardQuery = shardPipeline->getInitialQuery();
 
@@ -161,6 +188,7 @@ namespace {
 
                 result << "splitPipeline" << DOC("shardsPart" << shardPipeline->writeExplainOps()
                        << "mergerPart" << pipeline->writeExplainOps());
+                result << "mergeType" << (mergeOnMongos ? "mongos" : "primaryShard");
 
                 BSONObjBuilder shardExplains(result.subobjStart("shards"));
                 for (size_t i = 0; i < shardResults.size(); i++) {
@@ -175,6 +203,10 @@ namespace {
             DocumentSourceMergeCursors::CursorIds cursorIds = parseCursors(shardResults, fullns);
             pipeline->addInitialSource(DocumentSourceMergeCursors::create(cursorIds, mergeCtx));
 
+            if (mergeOnMongos) {
+                return runMergerOnMongos(pipeline, fullns, cmdObj, result);
+            }
+
             MutableDocument mergeCmd(pipeline->serialize());
             mergeCmd["cursor"] = Value(cmdObj["cursor"]);
 
@@ -214,6 +246,21 @@ namespace {
                                 const vector<Strategy::CommandResult>& shardResults,
                                 const string& fullns);
 
+        /**
+         * Runs the merger part of 'pipeline', which must already start with the
+         * $mergeCursors source, inside this mongos and appends the results to 'result'.
+         *
+         * mongos has no way to keep a locally merged result set alive across getMore requests,
+         * so the whole result set is returned in the first batch with a cursor id of 0 and must
+         * fit in a single response.
+         *
+         * A maxTimeMS on the command is checked while the results are merged.
+         */
+        bool runMergerOnMongos(const intrusive_ptr<Pipeline>& pipeline,
+                               const string& fullns,
+                               const BSONObj& cmdObj,
+                               BSONObjBuilder& result);
+
         void killAllCursors(const vector<Strategy::CommandResult>& shardResults);
         void uassertAllShardsSupportExplain(const vector<Strategy::CommandResult>& shardResults);
 
@@ -287,6 +334,52 @@ namespace {
         }
     }
 
+    bool PipelineCommand::runMergerOnMongos(const intrusive_ptr<Pipeline>& pipeline,
+                                            const string& fullns,
+                                            const BSONObj& cmdObj,
+                                            BSONObjBuilder& result) {
+        const intrusive_ptr<ExpressionContext>& mergeCtx = pipeline->getContext();
+        if (MONGO_FAIL_POINT(mongosMergeMaxTimeAlwaysTimeOut) &&
+                mergeCtx->routerMaxTimeMicros > 0) {
+            mergeCtx->routerMaxTimeMicros = 1;
+        }
+
+        pipeline->stitch();
+
+        if (cmdObj["cursor"].eoo()) {
+            // Old-style inline results.
+            pipeline->run(result);
+            return true;
+        }
+
+        // can't use result BSONObjBuilder directly since it won't handle exceptions correctly.
+        BSONArrayBuilder resultsArray;
+        DocumentSource* finalSource = pipeline->output();
+        while (boost::optional<Document> next = finalSource->getNext()) {
+            mergeCtx->checkForInterrupt();
+
+            BSONObjBuilder documentBuilder(resultsArray.subobjStart());
+            next->toBson(&documentBuilder);
+            documentBuilder.doneFast();
+
+            // The extra 1KB is for the cursor response headers.
+            uassert(28660,
+                    str::stream() << "aggregation result merged on mongos exceeds maximum "
+                                  << "response size (" << BSONObjMaxUserSize / (1024 * 1024)
+                                  << "MB); set aggregationMergeOnMongos to false to merge on "
+                                  << "the primary shard instead",
+                    resultsArray.len() < BSONObjMaxUserSize - 1024);
+        }
+
+        BSONObjBuilder cursorResponse(result.subobjStart("cursor"));
+        cursorResponse.append("id", 0LL);
+        cursorResponse.append("ns", fullns);
+        cursorResponse.append("firstBatch", resultsArray.arr());
+        cursorResponse.done();
+
+        return true;
+    }
+
     void PipelineCommand::uassertAllShardsSupportExplain(
                                 const vector<Strategy::CommandResult>& shardResults) {
 
@@ -32,6 +32,7 @@
 
 #include "mongo/s/server.h"
 
+#include <boost/filesystem/path.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
 #include <iostream>
@@ -49,6 +50,7 @@
 #include "mongo/db/auth/user_cache_invalidator_job.h"
 #include "mongo/db/client_basic.h"
 #include "mongo/db/dbwebserver.h"
+#include "mongo/db/ftdc/ftdc_controller.h"
 #include "mongo/db/initialize_server_global_state.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/lasterror.h"
@@ -206,6 +208,36 @@ namespace mongo {
 
 using namespace mongo;
 
+/**
+ * Starts full-time diagnostic data capture into a directory next to the log file.  Without a
+ * log file there is no obvious place for the data, so nothing is captured.
+ */
+static void startMongoSFTDC() {
+    if (serverGlobalParams.logpath.empty()) {
+        return;
+    }
+
+    const boost::filesystem::path logFile(serverGlobalParams.logpath);
+    const boost::filesystem::path directory =
+        logFile.parent_path() / (logFile.filename().string() + ".diagnostic.data");
+
+    // Commands run without an operation context on mongos.
+    std::unique_ptr<FTDCController> controller = stdx::make_unique<FTDCController>(
+        directory, [] { return std::unique_ptr<OperationContext>(); });
+
+    controller->addPeriodicCollector(stdx::make_unique<FTDCCommandCollector>(
+        "serverStatus", BSON("serverStatus" << 1 << "tcmalloc" << true)));
+
+    controller->addMetadataCollector(stdx::make_unique<FTDCCommandCollector>(
+        "buildInfo", BSON("buildInfo" << 1)));
+    controller->addMetadataCollector(stdx::make_unique<FTDCCommandCollector>(
+        "getCmdLineOpts", BSON("getCmdLineOpts" << 1)));
+    controller->addMetadataCollector(stdx::make_unique<FTDCCommandCollector>(
+        "hostInfo", BSON("hostInfo" << 1)));
+
+    startFTDC(std::move(controller));
+}
+
 static ExitCode runMongosServer( bool doUpgrade ) {
     setThreadName( "mongosMain" );
     printShardingVersionInfo( false );
@@ -302,6 +334,8 @@ static ExitCode runMongosServer( bool doUpgrade ) {
         return EXIT_SHARDING_ERROR;
     }
 
+    startMongoSFTDC();
+
     MessageServer::Options opts;
     opts.port = serverGlobalParams.port;
     opts.ipList = serverGlobalParams.bind_ip;
@@ -485,6 +519,7 @@ void mongo::signalShutdown() {
 
 void mongo::exitCleanly(ExitCode code) {
     // TODO: do we need to add anything?
+    stopFTDC();
     grid.catalogManager()->shutDown();
     mongo::dbexit( code );
 }
@@ -499,11 +534,13 @@ void mongo::dbexit( ExitCode rc, const char *why ) {
     //
     if ( rc == EXIT_WINDOWS_SERVICE_STOP ) {
         log() << "dbexit: exiting because Windows service was stopped" << endl;
+        flushLogs();
         return;
     }
 #endif
     log() << "dbexit: " << why
           << " rc:" << rc
           << endl;
+    flushLogs();
     quickExit(rc);
 }
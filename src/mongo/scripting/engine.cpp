@@ -35,18 +35,22 @@
 
 #include <cctype>
 #include <boost/filesystem/operations.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/scoped_array.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
 #include "mongo/util/text.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -59,6 +63,8 @@ namespace mongo {
 
     AtomicInt64 Scope::_lastVersion(1);
 
+    ScriptingStats scriptingStats;
+
 namespace {
     // 2 GB is the largest support Javascript file size.
     const fileofs kMaxJsFileLength = fileofs(2) * 1024 * 1024 * 1024;
@@ -272,14 +278,21 @@ namespace {
         }
 
         FunctionCacheMap::iterator i = _cachedFunctions.find(code);
-        if (i != _cachedFunctions.end())
+        if (i != _cachedFunctions.end()) {
+            scriptingStats.functionCacheHits.increment();
             return i->second;
+        }
+        scriptingStats.functionCacheMisses.increment();
+
         // NB: we calculate the function number for v8 so the cache can be utilized to
         //     lookup the source on an exception, but SpiderMonkey uses the value
         //     returned by JS_CompileFunction.
         ScriptingFunction defaultFunctionNumber = getFunctionCache().size() + 1;
-        ScriptingFunction& actualFunctionNumber = _cachedFunctions[code];
-        actualFunctionNumber = _createFunction(code, defaultFunctionNumber);
+        Timer t;
+        // only cache the function once it compiled, a failed compile must not leave an entry
+        ScriptingFunction actualFunctionNumber = _createFunction(code, defaultFunctionNumber);
+        scriptingStats.compileMicros.increment(t.micros());
+        _cachedFunctions[code] = actualFunctionNumber;
         return actualFunctionNumber;
     }
 
@@ -314,49 +327,77 @@ namespace {
     }
 
 namespace {
+    // Maximum number of idle scopes kept for reuse, across all pools.
+    MONGO_EXPORT_SERVER_PARAMETER(scriptingScopePoolSize, int, 64);
+
+    // Number of times a scope is handed out before it is thrown away.
+    MONGO_EXPORT_SERVER_PARAMETER(scriptingMaxScopeReuse, int, 100);
+
+    // Scopes which compiled more functions than this are not reused, which bounds the memory
+    // held by their function caches.
+    MONGO_EXPORT_SERVER_PARAMETER(scriptingMaxCachedFunctionsPerScope, int, 1000);
+
+    /**
+     * Idle scopes, kept in independently locked partitions so that concurrent operations don't
+     * contend on one mutex. A thread releases scopes to, and first tries to acquire them from,
+     * its own partition, and only looks at the others when that one has no matching scope.
+     */
     class ScopeCache {
     public:
         void release(const string& poolName, const boost::shared_ptr<Scope>& scope) {
-            boost::lock_guard<boost::mutex> lk(_mutex);
-
             if (scope->hasOutOfMemoryException()) {
                 // make some room
                 log() << "Clearing all idle JS contexts due to out of memory" << endl;
-                _pools.clear();
+                clear();
                 return;
             }
 
-            if (scope->getTimesUsed() > kMaxScopeReuse)
+            if (scope->getTimesUsed() > scriptingMaxScopeReuse)
                 return; // used too many times to save
 
             if (!scope->getError().empty())
                 return; // not saving errored scopes
 
-            if (_pools.size() >= kMaxPoolSize) {
-                // prefer to keep recently-used scopes
-                _pools.pop_back();
-            }
+            if (scope->getNumCachedFunctions() >
+                    static_cast<size_t>(scriptingMaxCachedFunctionsPerScope))
+                return; // too much compiled code to keep around
 
             scope->reset();
+
+            const size_t maxPartitionSize =
+                std::max(1, scriptingScopePoolSize / static_cast<int>(kNumPartitions));
+            Partition& partition = _partitions[_homePartition()];
             ScopeAndPool toStore = {scope, poolName};
-            _pools.push_front(toStore);
+
+            boost::lock_guard<boost::mutex> lk(partition.mutex);
+            while (partition.pools.size() >= maxPartitionSize) {
+                // prefer to keep recently-used scopes
+                partition.pools.pop_back();
+            }
+            partition.pools.push_front(toStore);
         }
 
         boost::shared_ptr<Scope> tryAcquire(OperationContext* txn, const string& poolName) {
-            boost::lock_guard<boost::mutex> lk(_mutex);
+            const size_t home = _homePartition();
 
-            for (Pools::iterator it = _pools.begin(); it != _pools.end(); ++it) {
-                if (it->poolName == poolName) {
-                    boost::shared_ptr<Scope> scope = it->scope;
-                    _pools.erase(it);
-                    scope->incTimesUsed();
-                    scope->reset();
-                    scope->registerOperation(txn);
-                    return scope;
-                }
+            boost::shared_ptr<Scope> scope;
+            for (size_t i = 0; i < kNumPartitions && !scope; i++) {
+                scope = _tryAcquireFrom(&_partitions[(home + i) % kNumPartitions], poolName);
             }
 
-            return boost::shared_ptr<Scope>();
+            if (scope) {
+                scope->incTimesUsed();
+                scope->reset();
+                scope->registerOperation(txn);
+            }
+            return scope;
+        }
+
+        void clear() {
+            for (size_t i = 0; i < kNumPartitions; i++) {
+                boost::lock_guard<boost::mutex> lk(_partitions[i].mutex);
+                _partitions[i].pools.clear();
+            }
         }
 
     private:
@@ -365,13 +406,36 @@ namespace {
             string poolName;
         };
 
-        // Note: if these numbers change, reconsider choice of datastructure for _pools
-        static const unsigned kMaxPoolSize = 10;
-        static const int kMaxScopeReuse = 10;
-
+        // Note: if the partition size grows much, reconsider choice of datastructure for pools
         typedef std::deque<ScopeAndPool> Pools; // More-recently used Scopes are kept at the front.
-        Pools _pools;    // protected by _mutex
-        mongo::mutex _mutex;
+
+        struct Partition {
+            Pools pools;    // protected by mutex
+            boost::mutex mutex;
+        };
+
+        static const size_t kNumPartitions = 16;
+
+        static size_t _homePartition() {
+            return boost::hash<boost::thread::id>()(boost::this_thread::get_id()) % kNumPartitions;
+        }
+
+        static boost::shared_ptr<Scope> _tryAcquireFrom(Partition* partition,
+                                                        const string& poolName) {
+            boost::lock_guard<boost::mutex> lk(partition->mutex);
+            for (Pools::iterator it = partition->pools.begin();
+                 it != partition->pools.end();
+                 ++it) {
+                if (it->poolName == poolName) {
+                    boost::shared_ptr<Scope> scope = it->scope;
+                    partition->pools.erase(it);
+                    return scope;
+                }
+            }
+            return boost::shared_ptr<Scope>();
+        }
+
+        Partition _partitions[kNumPartitions];
     };
 
     ScopeCache scopeCache;
@@ -463,9 +527,13 @@ namespace {
                                                  const string& scopeType) {
         const string fullPoolName = db + scopeType;
         boost::shared_ptr<Scope> s = scopeCache.tryAcquire(txn, fullPoolName);
-        if (!s) {
+        if (s) {
+            scriptingStats.scopesReused.increment();
+        }
+        else {
             s.reset(newScope());
             s->registerOperation(txn);
+            scriptingStats.scopesCreated.increment();
         }
 
         auto_ptr<Scope> p;
@@ -29,14 +29,16 @@
 
 #pragma once
 
+#include "mongo/base/counter.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
     typedef unsigned long long ScriptingFunction;
     typedef BSONObj (*NativeFunction)(const BSONObj& args, void* data);
-    typedef std::map<std::string, ScriptingFunction> FunctionCacheMap;
+    typedef unordered_map<std::string, ScriptingFunction> FunctionCacheMap;
 
     class DBClientWithCommands;
     class DBClientBase;
@@ -159,6 +161,9 @@ namespace mongo {
         /** gets the number of times a scope was used */
         int getTimesUsed() const { return _numTimesUsed; }
 
+        /** number of compiled functions cached by createFunction() */
+        size_t getNumCachedFunctions() { return getFunctionCache().size(); }
+
         /** return true if last invoke() return'd native code */
         virtual bool isLastRetNativeCode() { return _lastRetIsNativeCode; }
 
@@ -248,6 +253,19 @@ namespace mongo {
         static void (*_connectCallback)(DBClientWithCommands&);
     };
 
+    /**
+     * Counters for the scope pool and the compiled function caches of all scopes.
+     */
+    struct ScriptingStats {
+        Counter64 scopesCreated;
+        Counter64 scopesReused;
+        Counter64 functionCacheHits;
+        Counter64 functionCacheMisses;
+        Counter64 compileMicros;
+    };
+
+    extern ScriptingStats scriptingStats;
+
     void installGlobalUtils(Scope& scope);
     bool hasJSReturn(const std::string& s);
     const char* jsSkipWhiteSpace(const char* raw);
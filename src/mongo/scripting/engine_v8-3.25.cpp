@@ -953,7 +953,7 @@ namespace mongo {
             // find the source script based on the resource name supplied to v8::Script::Compile().
             // this is accomplished by converting the integer after the '_funcs' prefix.
             unsigned int funcNum = str::toUnsigned(resourceNameString.substr(6));
-            for (map<string, ScriptingFunction>::iterator it = getFunctionCache().begin();
+            for (FunctionCacheMap::iterator it = getFunctionCache().begin();
                  it != getFunctionCache().end();
                  ++it) {
                 if (it->second == funcNum) {
@@ -1069,8 +1069,8 @@ namespace mongo {
 
     void V8Scope::setFunction(const char* field, const char* code) {
         V8_SIMPLE_HEADER
-        getGlobal()->ForceSet(v8StringData(field),
-                          __createFunction(code, getFunctionCache().size() + 1));
+        // reuse the compiled function if this scope has seen the code before
+        getGlobal()->ForceSet(v8StringData(field), _funcs[createFunction(code) - 1].Get(_isolate));
     }
 
     void V8Scope::rename(const char * from, const char * to) {
@@ -80,6 +80,10 @@ namespace mongo {
         return result.empty();
     }
 
+    void flushLogs() {
+        logger::globalRotatableFileManager()->flushAll();
+    }
+
     string errnoWithDescription(int x) {
 #if defined(_WIN32)
         if( x < 0 ) 
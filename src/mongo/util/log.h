@@ -191,6 +191,12 @@ namespace {
      */
     bool rotateLogs(bool renameFiles);
 
+    /**
+     * Writes out any log lines still queued for an asynchronous log file writer.  Called before
+     * the process exits.
+     */
+    void flushLogs();
+
     /** output the error # and error message with prefix.
         handy for use as parm in uassert/massert.
         */
@@ -0,0 +1,377 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compressor.h"
+
+#include <snappy.h>
+#include <zlib.h>
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/allocator.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+    using std::string;
+    using std::vector;
+
+namespace {
+
+    const char kHandshakeFieldName[] = "compression";
+
+    // original opCode, uncompressed size, compressor id
+    const int kCompressedHeaderSize = sizeof(int32_t) + sizeof(int32_t) + sizeof(uint8_t);
+
+    vector<string> networkMessageCompressors;
+
+    /**
+     * Compressors this process offers and accepts in the isMaster handshake, most preferred
+     * first. Empty, the default, disables message compression.
+     */
+    class NetworkMessageCompressorsParameter : public ExportedServerParameter<vector<string> > {
+    public:
+        NetworkMessageCompressorsParameter()
+            : ExportedServerParameter<vector<string> >(ServerParameterSet::getGlobal(),
+                                                      "networkMessageCompressors",
+                                                      &networkMessageCompressors,
+                                                      true,
+                                                      false) {}
+
+        virtual Status validate(const vector<string>& potentialNewValue) {
+            for (size_t i = 0; i < potentialNewValue.size(); ++i) {
+                const string& name = potentialNewValue[i];
+                if (name != messageCompressorName(kMessageCompressorSnappy) &&
+                    name != messageCompressorName(kMessageCompressorZlib)) {
+                    return Status(ErrorCodes::BadValue,
+                                  str::stream() << "unknown network message compressor: "
+                                                << name);
+                }
+            }
+            return Status::OK();
+        }
+    } networkMessageCompressorsParameter;
+
+    MONGO_EXPORT_SERVER_PARAMETER(networkMessageCompressionMinSize, int, 1024);
+
+    struct CompressorStats {
+        AtomicUInt64 compressorBytesIn;
+        AtomicUInt64 compressorBytesOut;
+        AtomicUInt64 decompressorBytesIn;
+        AtomicUInt64 decompressorBytesOut;
+
+        void append(BSONObjBuilder* b) const {
+            BSONObjBuilder compressorBob(b->subobjStart("compressor"));
+            compressorBob.appendNumber("bytesIn",
+                                       static_cast<long long>(compressorBytesIn.loadRelaxed()));
+            compressorBob.appendNumber("bytesOut",
+                                       static_cast<long long>(compressorBytesOut.loadRelaxed()));
+            compressorBob.doneFast();
+
+            BSONObjBuilder decompressorBob(b->subobjStart("decompressor"));
+            decompressorBob.appendNumber(
+                    "bytesIn", static_cast<long long>(decompressorBytesIn.loadRelaxed()));
+            decompressorBob.appendNumber(
+                    "bytesOut", static_cast<long long>(decompressorBytesOut.loadRelaxed()));
+            decompressorBob.doneFast();
+        }
+    };
+
+    CompressorStats snappyStats;
+    CompressorStats zlibStats;
+
+    CompressorStats* statsFor(MessageCompressorId id) {
+        switch (id) {
+        case kMessageCompressorSnappy: return &snappyStats;
+        case kMessageCompressorZlib: return &zlibStats;
+        default: return NULL;
+        }
+    }
+
+    MessageCompressorId compressorFromName(StringData name) {
+        if (name == messageCompressorName(kMessageCompressorSnappy)) {
+            return kMessageCompressorSnappy;
+        }
+        if (name == messageCompressorName(kMessageCompressorZlib)) {
+            return kMessageCompressorZlib;
+        }
+        return kMessageCompressorNoop;
+    }
+
+    bool isEnabled(MessageCompressorId id) {
+        for (size_t i = 0; i < networkMessageCompressors.size(); ++i) {
+            if (compressorFromName(networkMessageCompressors[i]) == id) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace
+
+    const char* messageCompressorName(MessageCompressorId id) {
+        switch (id) {
+        case kMessageCompressorNoop: return "noop";
+        case kMessageCompressorSnappy: return "snappy";
+        case kMessageCompressorZlib: return "zlib";
+        }
+        return "unknown";
+    }
+
+    Status compressMessage(MessageCompressorId id, Message& in, Message* out) {
+        invariant(out->empty());
+
+        CompressorStats* stats = statsFor(id);
+        if (!stats) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "cannot compress with " << messageCompressorName(id));
+        }
+
+        in.concat();
+        const MsgData::View inData = in.singleData();
+        const char* const input = inData.data();
+        const size_t inputLength = inData.dataLen();
+
+        size_t maxOutputLength;
+        if (id == kMessageCompressorSnappy) {
+            maxOutputLength = snappy::MaxCompressedLength(inputLength);
+        }
+        else {
+            // Without a stream, deflateBound assumes the most conservative settings.
+            maxOutputLength = deflateBound(NULL, inputLength);
+        }
+
+        const size_t maxLength = MsgData::MsgDataHeaderSize + kCompressedHeaderSize +
+                                 maxOutputLength;
+        MsgData::View outData = reinterpret_cast<char*>(mongoMalloc(maxLength));
+        ScopeGuard guard = MakeGuard(free, outData.view2ptr());
+
+        DataView(outData.data())
+            .write(tagLittleEndian<int32_t>(inData.getOperation()))
+            .write(tagLittleEndian<int32_t>(inputLength), sizeof(int32_t))
+            .write(static_cast<uint8_t>(id), 2 * sizeof(int32_t));
+
+        char* const output = outData.data() + kCompressedHeaderSize;
+        size_t outputLength = maxOutputLength;
+        if (id == kMessageCompressorSnappy) {
+            snappy::RawCompress(input, inputLength, output, &outputLength);
+        }
+        else {
+            // The vendored zlib only has the streaming interface, so deflate in a single call.
+            z_stream zlibStream;
+            memset(&zlibStream, 0, sizeof(zlibStream));
+            int ret = deflateInit(&zlibStream, Z_DEFAULT_COMPRESSION);
+            if (ret == Z_OK) {
+                zlibStream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+                zlibStream.avail_in = inputLength;
+                zlibStream.next_out = reinterpret_cast<Bytef*>(output);
+                zlibStream.avail_out = maxOutputLength;
+                ret = deflate(&zlibStream, Z_FINISH);
+                outputLength = zlibStream.total_out;
+                deflateEnd(&zlibStream);
+            }
+            if (ret != Z_STREAM_END) {
+                return Status(ErrorCodes::InternalError,
+                              str::stream() << "zlib compression failed with error " << ret);
+            }
+        }
+
+        outData.setLen(MsgData::MsgDataHeaderSize + kCompressedHeaderSize + outputLength);
+        outData.setId(inData.getId());
+        outData.setResponseTo(inData.getResponseTo());
+        outData.setOperation(dbCompressed);
+
+        stats->compressorBytesIn.fetchAndAdd(inData.getLen());
+        stats->compressorBytesOut.fetchAndAdd(outData.getLen());
+
+        guard.Dismiss();
+        out->setData(outData.view2ptr(), true);
+        return Status::OK();
+    }
+
+    Status decompressMessage(const Message& in, Message* out) {
+        invariant(out->empty());
+
+        const MsgData::View inData = in.singleData();
+        invariant(inData.getOperation() == dbCompressed);
+
+        if (inData.dataLen() < kCompressedHeaderSize) {
+            return Status(ErrorCodes::BadValue, "compressed message is too short");
+        }
+
+        const ConstDataView compressedHeader(inData.data());
+        const int32_t originalOperation =
+            compressedHeader.read<LittleEndian<int32_t>>();
+        const int32_t originalLength =
+            compressedHeader.read<LittleEndian<int32_t>>(sizeof(int32_t));
+        const MessageCompressorId id =
+            static_cast<MessageCompressorId>(
+                compressedHeader.read<uint8_t>(2 * sizeof(int32_t)));
+
+        CompressorStats* stats = statsFor(id);
+        if (!stats) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "unknown message compressor " << static_cast<int>(id));
+        }
+
+        if (originalLength < 0 ||
+            static_cast<size_t>(originalLength) + MsgData::MsgDataHeaderSize >
+                MaxMessageSizeBytes) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "invalid uncompressed message size "
+                                        << originalLength);
+        }
+
+        const char* const input = inData.data() + kCompressedHeaderSize;
+        const size_t inputLength = inData.dataLen() - kCompressedHeaderSize;
+
+        const size_t length = MsgData::MsgDataHeaderSize + originalLength;
+        MsgData::View outData = reinterpret_cast<char*>(mongoMalloc(length));
+        ScopeGuard guard = MakeGuard(free, outData.view2ptr());
+
+        bool ok;
+        if (id == kMessageCompressorSnappy) {
+            size_t uncompressedLength;
+            ok = snappy::GetUncompressedLength(input, inputLength, &uncompressedLength) &&
+                 uncompressedLength == static_cast<size_t>(originalLength) &&
+                 snappy::RawUncompress(input, inputLength, outData.data());
+        }
+        else {
+            z_stream zlibStream;
+            memset(&zlibStream, 0, sizeof(zlibStream));
+            ok = inflateInit(&zlibStream) == Z_OK;
+            if (ok) {
+                zlibStream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+                zlibStream.avail_in = inputLength;
+                zlibStream.next_out = reinterpret_cast<Bytef*>(outData.data());
+                zlibStream.avail_out = originalLength;
+                ok = inflate(&zlibStream, Z_FINISH) == Z_STREAM_END &&
+                     zlibStream.total_out == static_cast<uLong>(originalLength);
+                inflateEnd(&zlibStream);
+            }
+        }
+
+        if (!ok) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "could not decompress message compressed with "
+                                        << messageCompressorName(id));
+        }
+
+        outData.setLen(length);
+        outData.setId(inData.getId());
+        outData.setResponseTo(inData.getResponseTo());
+        outData.setOperation(originalOperation);
+
+        stats->decompressorBytesIn.fetchAndAdd(inData.getLen());
+        stats->decompressorBytesOut.fetchAndAdd(length);
+
+        guard.Dismiss();
+        out->setData(outData.view2ptr(), true);
+        return Status::OK();
+    }
+
+    int messageCompressionMinSize() {
+        return networkMessageCompressionMinSize;
+    }
+
+    bool appendCompressorsForHandshake(BSONObjBuilder* isMasterCmd) {
+        if (networkMessageCompressors.empty()) {
+            return false;
+        }
+        isMasterCmd->append(kHandshakeFieldName, networkMessageCompressors);
+        return true;
+    }
+
+    MessageCompressorId negotiateCompressor(const BSONObj& isMasterCmd,
+                                            MessageCompressorId current,
+                                            BSONObjBuilder* result) {
+        const BSONElement requested = isMasterCmd[kHandshakeFieldName];
+        if (requested.eoo()) {
+            return current;
+        }
+        if (requested.type() != Array) {
+            return kMessageCompressorNoop;
+        }
+
+        BSONForEach(elem, requested.Obj()) {
+            if (elem.type() != String) {
+                continue;
+            }
+            const MessageCompressorId id = compressorFromName(elem.valueStringData());
+            if (id != kMessageCompressorNoop && isEnabled(id)) {
+                result->append(kHandshakeFieldName, BSON_ARRAY(messageCompressorName(id)));
+                return id;
+            }
+        }
+        return kMessageCompressorNoop;
+    }
+
+    MessageCompressorId compressorFromHandshakeReply(const BSONObj& reply) {
+        const BSONElement chosen = reply[kHandshakeFieldName];
+        if (chosen.type() != Array) {
+            return kMessageCompressorNoop;
+        }
+
+        BSONForEach(elem, chosen.Obj()) {
+            if (elem.type() == String) {
+                const MessageCompressorId id = compressorFromName(elem.valueStringData());
+                if (isEnabled(id)) {
+                    return id;
+                }
+            }
+            break;
+        }
+        return kMessageCompressorNoop;
+    }
+
+    void appendMessageCompressionStats(BSONObjBuilder* b) {
+        BSONObjBuilder compressionBob(b->subobjStart(kHandshakeFieldName));
+
+        BSONObjBuilder snappyBob(compressionBob.subobjStart(
+                                     messageCompressorName(kMessageCompressorSnappy)));
+        snappyStats.append(&snappyBob);
+        snappyBob.doneFast();
+
+        BSONObjBuilder zlibBob(compressionBob.subobjStart(
+                                   messageCompressorName(kMessageCompressorZlib)));
+        zlibStats.append(&zlibBob);
+        zlibBob.doneFast();
+
+        compressionBob.doneFast();
+    }
+
+} // namespace mongo
@@ -0,0 +1,112 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/status.h"
+
+namespace mongo {
+
+    class BSONObj;
+    class BSONObjBuilder;
+    class Message;
+
+    /**
+     * Identifies the algorithm used for the body of a dbCompressed message. The values are
+     * part of the wire format and must not change.
+     */
+    enum MessageCompressorId {
+        kMessageCompressorNoop = 0,
+        kMessageCompressorSnappy = 1,
+        kMessageCompressorZlib = 2,
+    };
+
+    /**
+     * Name of the compressor with the given id, as used in the isMaster handshake.
+     */
+    const char* messageCompressorName(MessageCompressorId id);
+
+    /**
+     * Compresses 'in' into a dbCompressed message in 'out' which keeps the request id and
+     * responseTo of 'in'. Returns an error Status if 'in' cannot be compressed, in which case
+     * 'out' is left empty.
+     *
+     * The body of a dbCompressed message is laid out as follows:
+     *
+     *     int32  original opCode
+     *     int32  uncompressed size of the original body (excluding the header)
+     *     uint8  MessageCompressorId
+     *     ...    compressed original body
+     */
+    Status compressMessage(MessageCompressorId id, Message& in, Message* out);
+
+    /**
+     * Restores the original message carried by the dbCompressed message 'in' into 'out'.
+     */
+    Status decompressMessage(const Message& in, Message* out);
+
+    /**
+     * Messages shorter than this many bytes are never compressed.
+     */
+    int messageCompressionMinSize();
+
+    /**
+     * Client side of the isMaster handshake. Appends the compressors this process is
+     * configured to use, in order of preference, to the isMaster command being built.
+     * Returns false, appending nothing, if message compression is disabled.
+     */
+    bool appendCompressorsForHandshake(BSONObjBuilder* isMasterCmd);
+
+    /**
+     * Server side of the isMaster handshake. Picks the first compressor requested in
+     * 'isMasterCmd' which is also enabled locally, reports it in 'result' and returns it.
+     * Returns kMessageCompressorNoop if no requested compressor is enabled here.
+     *
+     * An isMaster without a compression field, such as the periodic ones sent by monitors,
+     * doesn't renegotiate: 'current', the connection's compressor, is returned unchanged.
+     */
+    MessageCompressorId negotiateCompressor(const BSONObj& isMasterCmd,
+                                            MessageCompressorId current,
+                                            BSONObjBuilder* result);
+
+    /**
+     * Client side of the isMaster handshake. Returns the compressor the server picked in its
+     * isMaster 'reply', or kMessageCompressorNoop.
+     */
+    MessageCompressorId compressorFromHandshakeReply(const BSONObj& reply);
+
+    /**
+     * Appends the number of bytes passed through each compressor, before and after
+     * compression, for the "network" serverStatus section.
+     */
+    void appendMessageCompressionStats(BSONObjBuilder* b);
+
+} // namespace mongo
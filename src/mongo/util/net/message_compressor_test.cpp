@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
+
+namespace mongo {
+namespace {
+
+    void setCompressors(const std::string& value) {
+        ServerParameter* param =
+            ServerParameterSet::getGlobal()->getMap().find("networkMessageCompressors")->second;
+        ASSERT_OK(param->setFromString(value));
+    }
+
+    void buildMessage(const std::string& body, Message* out) {
+        out->setData(dbQuery, body.c_str(), body.size());
+        out->header().setId(42);
+        out->header().setResponseTo(7);
+    }
+
+    void assertRoundTrips(MessageCompressorId id, const std::string& body) {
+        Message original;
+        buildMessage(body, &original);
+
+        Message compressed;
+        ASSERT_OK(compressMessage(id, original, &compressed));
+        ASSERT_EQUALS(dbCompressed, compressed.operation());
+        ASSERT_EQUALS(42, compressed.header().getId());
+        ASSERT_EQUALS(7, compressed.header().getResponseTo());
+
+        Message restored;
+        ASSERT_OK(decompressMessage(compressed, &restored));
+        ASSERT_EQUALS(dbQuery, restored.operation());
+        ASSERT_EQUALS(42, restored.header().getId());
+        ASSERT_EQUALS(7, restored.header().getResponseTo());
+        ASSERT_EQUALS(original.size(), restored.size());
+        ASSERT_EQUALS(body, std::string(restored.singleData().data(),
+                                        restored.singleData().dataLen()));
+    }
+
+    TEST(MessageCompressor, SnappyRoundTrip) {
+        assertRoundTrips(kMessageCompressorSnappy, std::string(10000, 'x'));
+        assertRoundTrips(kMessageCompressorSnappy, "a");
+    }
+
+    TEST(MessageCompressor, ZlibRoundTrip) {
+        assertRoundTrips(kMessageCompressorZlib, std::string(10000, 'x'));
+        assertRoundTrips(kMessageCompressorZlib, "a");
+    }
+
+    TEST(MessageCompressor, CompressionShrinksRepetitiveMessages) {
+        Message original;
+        buildMessage(std::string(10000, 'x'), &original);
+
+        Message compressed;
+        ASSERT_OK(compressMessage(kMessageCompressorSnappy, original, &compressed));
+        ASSERT_LESS_THAN(compressed.size(), original.size());
+    }
+
+    TEST(MessageCompressor, NoopCannotCompress) {
+        Message original;
+        buildMessage("abc", &original);
+
+        Message compressed;
+        ASSERT_NOT_OK(compressMessage(kMessageCompressorNoop, original, &compressed));
+        ASSERT_TRUE(compressed.empty());
+    }
+
+    TEST(MessageCompressor, CorruptBodyIsRejected) {
+        Message original;
+        buildMessage(std::string(10000, 'x'), &original);
+
+        Message compressed;
+        ASSERT_OK(compressMessage(kMessageCompressorZlib, original, &compressed));
+
+        // Claim a different uncompressed size than the body actually has.
+        DataView(compressed.singleData().data()).write(tagLittleEndian<int32_t>(5),
+                                                       sizeof(int32_t));
+        Message restored;
+        ASSERT_NOT_OK(decompressMessage(compressed, &restored));
+        ASSERT_TRUE(restored.empty());
+    }
+
+    TEST(MessageCompressor, InvalidCompressorNameIsRejected) {
+        ServerParameter* param =
+            ServerParameterSet::getGlobal()->getMap().find("networkMessageCompressors")->second;
+        ASSERT_NOT_OK(param->setFromString("snappy,lz4"));
+    }
+
+    TEST(MessageCompressor, NegotiatePicksFirstMutuallyEnabledCompressor) {
+        setCompressors("zlib,snappy");
+
+        BSONObjBuilder isMasterCmd;
+        isMasterCmd.append("isMaster", 1);
+        ASSERT_TRUE(appendCompressorsForHandshake(&isMasterCmd));
+        ASSERT_EQUALS(BSON("isMaster" << 1 << "compression" << BSON_ARRAY("zlib" << "snappy")),
+                      isMasterCmd.obj());
+
+        BSONObjBuilder reply;
+        ASSERT_EQUALS(kMessageCompressorSnappy,
+                      negotiateCompressor(BSON("compression" << BSON_ARRAY("lz4" << "snappy")),
+                                          kMessageCompressorNoop,
+                                          &reply));
+        const BSONObj replyObj = reply.obj();
+        ASSERT_EQUALS(BSON("compression" << BSON_ARRAY("snappy")), replyObj);
+        ASSERT_EQUALS(kMessageCompressorSnappy, compressorFromHandshakeReply(replyObj));
+
+        setCompressors("");
+    }
+
+    TEST(MessageCompressor, NegotiationDisabledByDefault) {
+        setCompressors("");
+
+        BSONObjBuilder isMasterCmd;
+        ASSERT_FALSE(appendCompressorsForHandshake(&isMasterCmd));
+        ASSERT_TRUE(isMasterCmd.obj().isEmpty());
+
+        BSONObjBuilder reply;
+        ASSERT_EQUALS(kMessageCompressorNoop,
+                      negotiateCompressor(BSON("compression" << BSON_ARRAY("snappy")),
+                                          kMessageCompressorNoop,
+                                          &reply));
+        ASSERT_TRUE(reply.obj().isEmpty());
+        ASSERT_EQUALS(kMessageCompressorNoop,
+                      compressorFromHandshakeReply(BSON("compression" << BSON_ARRAY("snappy"))));
+    }
+
+    TEST(MessageCompressor, IsMasterWithoutCompressionKeepsNegotiatedCompressor) {
+        setCompressors("zlib,snappy");
+
+        BSONObjBuilder reply;
+        ASSERT_EQUALS(kMessageCompressorZlib,
+                      negotiateCompressor(BSON("isMaster" << 1), kMessageCompressorZlib, &reply));
+        ASSERT_TRUE(reply.obj().isEmpty());
+
+        // A later handshake which does ask for compression renegotiates.
+        BSONObjBuilder renegotiated;
+        ASSERT_EQUALS(kMessageCompressorNoop,
+                      negotiateCompressor(BSON("compression" << BSONArray()),
+                                          kMessageCompressorZlib,
+                                          &renegotiated));
+        ASSERT_EQUALS(kMessageCompressorSnappy,
+                      negotiateCompressor(BSON("compression" << BSON_ARRAY("snappy")),
+                                          kMessageCompressorZlib,
+                                          &renegotiated));
+
+        setCompressors("");
+    }
+
+} // namespace
+} // namespace mongo
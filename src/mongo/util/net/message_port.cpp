@@ -244,6 +244,17 @@ again:
 
             guard.Dismiss();
             m.setData(md.view2ptr(), true);
+
+            if (m.operation() == dbCompressed) {
+                Message decompressed;
+                Status status = decompressMessage(m, &decompressed);
+                m.reset();
+                if (!status.isOK()) {
+                    LOG(0) << "recv(): " << status.reason() << ", remote: " << remote();
+                    return false;
+                }
+                m = decompressed;
+            }
             return true;
 
         }
@@ -303,20 +314,35 @@ again:
         toSend.header().setId(nextMessageId());
         toSend.header().setResponseTo(responseTo);
 
+        Message compressed;
+        if (getCompressor() != kMessageCompressorNoop &&
+            toSend.operation() != dbCompressed &&
+            toSend.size() >= messageCompressionMinSize()) {
+            Status status = compressMessage(getCompressor(), toSend, &compressed);
+            if (!status.isOK()) {
+                LOG(1) << "sending message uncompressed: " << status.reason();
+            }
+            else if (compressed.size() >= toSend.size()) {
+                // Incompressible payload, the original is cheaper to send.
+                compressed.reset();
+            }
+        }
+        Message& wire = compressed.empty() ? toSend : compressed;
+
         if ( piggyBackData && piggyBackData->len() ) {
             mmm( log() << "*     have piggy back" << endl; )
-            if ( ( piggyBackData->len() + toSend.header().getLen() ) > 1300 ) {
+            if ( ( piggyBackData->len() + wire.header().getLen() ) > 1300 ) {
                 // won't fit in a packet - so just send it off
                 piggyBackData->flush();
             }
             else {
-                piggyBackData->append( toSend );
+                piggyBackData->append( wire );
                 piggyBackData->flush();
                 return;
             }
         }
 
-        toSend.send( *this, "say" );
+        wire.send( *this, "say" );
     }
 
     void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
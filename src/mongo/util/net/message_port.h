@@ -35,6 +35,7 @@
 
 #include "mongo/config.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/net/sock.h"
 
 namespace mongo {
@@ -44,7 +45,8 @@ namespace mongo {
 
     class AbstractMessagingPort : boost::noncopyable {
     public:
-        AbstractMessagingPort() : tag(0), _connectionId(0) {}
+        AbstractMessagingPort()
+            : tag(0), _connectionId(0), _compressor(kMessageCompressorNoop) {}
         virtual ~AbstractMessagingPort() { }
         virtual void reply(Message& received, Message& response, MSGID responseTo) = 0; // like the reply below, but doesn't rely on received.data still being available
         virtual void reply(Message& received, Message& response) = 0;
@@ -65,6 +67,13 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /**
+         * Compressor negotiated for this connection in the isMaster handshake. Outgoing
+         * messages of at least messageCompressionMinSize() bytes are compressed with it.
+         */
+        MessageCompressorId getCompressor() const { return _compressor; }
+        void setCompressor(MessageCompressorId compressor) { _compressor = compressor; }
+
     public:
         // TODO make this private with some helpers
 
@@ -74,6 +83,7 @@ namespace mongo {
     private:
         long long _connectionId;
         std::string _x509SubjectName;
+        MessageCompressorId _compressor;
     };
 
     class MessagingPort : public AbstractMessagingPort {
@@ -79,6 +79,28 @@ namespace mongo {
             _cvNoLongerEmpty.notify_one();
         }
 
+        /**
+         * Pushes all of 'objs' as a unit, waiting until they fit together. A group larger than
+         * the max size is pushed once the queue is empty rather than waiting forever.
+         */
+        template<typename Container>
+        void pushAll(const Container& objs) {
+            size_t totalSize = 0;
+            for (typename Container::const_iterator it = objs.begin(); it != objs.end(); ++it) {
+                totalSize += _getSize(*it);
+            }
+
+            boost::unique_lock<boost::mutex> l( _lock );
+            while (_currentSize > 0 && _currentSize + totalSize > _maxSize) {
+                _cvNoLongerFull.wait( l );
+            }
+            for (typename Container::const_iterator it = objs.begin(); it != objs.end(); ++it) {
+                _queue.push( *it );
+            }
+            _currentSize += totalSize;
+            _cvNoLongerEmpty.notify_one();
+        }
+
         bool empty() const {
             boost::lock_guard<boost::mutex> l( _lock );
             return _queue.empty();